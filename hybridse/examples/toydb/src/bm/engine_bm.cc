@@ -134,6 +134,31 @@ static void BM_EngineRunBatchWindowSumFeature5(
     EngineRunBatchWindowSumFeature5(&state, BENCHMARK, state.range(0),
                                     state.range(1));
 }
+static void BM_EngineRunBatchWindowIntAggFeature5(
+    benchmark::State& state) {  // NOLINT
+    EngineRunBatchWindowIntAggFeature5(&state, BENCHMARK, state.range(0),
+                                       state.range(1), true);
+}
+static void BM_EngineRunBatchWindowIntAggFeature5Rescan(
+    benchmark::State& state) {  // NOLINT
+    EngineRunBatchWindowIntAggFeature5(&state, BENCHMARK, state.range(0),
+                                       state.range(1), false);
+}
+static void BM_EngineRunBatchWindowMixedAggFeature5(
+    benchmark::State& state) {  // NOLINT
+    EngineRunBatchWindowMixedAggFeature5(&state, BENCHMARK, state.range(0),
+                                         state.range(1), true);
+}
+static void BM_EngineRunBatchWindowMixedAggFeature5Rescan(
+    benchmark::State& state) {  // NOLINT
+    EngineRunBatchWindowMixedAggFeature5(&state, BENCHMARK, state.range(0),
+                                         state.range(1), false);
+}
+static void BM_EngineRunBatchWindowParallel(
+    benchmark::State& state) {  // NOLINT
+    EngineRunBatchWindowParallel(&state, BENCHMARK, state.range(0),
+                                 state.range(1));
+}
 static void BM_EngineRunBatchWindowSumFeature1ExcludeCurrentTime(
     benchmark::State& state) {  // NOLINT
     EngineRunBatchWindowSumFeature1ExcludeCurrentTime(
@@ -257,6 +282,34 @@ BENCHMARK(BM_EngineRunBatchWindowSumFeature5)
     ->Args({100, 100})
     ->Args({1000, 1000})
     ->Args({10000, 10000});
+// the cost per row is O(1) instead of O(window size) with incremental agg
+BENCHMARK(BM_EngineRunBatchWindowIntAggFeature5)
+    ->Args({100, 100})
+    ->Args({1000, 1000})
+    ->Args({10000, 10000})
+    ->Args({100000, 100000});
+BENCHMARK(BM_EngineRunBatchWindowIntAggFeature5Rescan)
+    ->Args({100, 100})
+    ->Args({1000, 1000})
+    ->Args({10000, 10000})
+    ->Args({100000, 100000});
+// only the floating avg and sum rescan the window
+BENCHMARK(BM_EngineRunBatchWindowMixedAggFeature5)
+    ->Args({100, 100})
+    ->Args({1000, 1000})
+    ->Args({10000, 10000});
+BENCHMARK(BM_EngineRunBatchWindowMixedAggFeature5Rescan)
+    ->Args({100, 100})
+    ->Args({1000, 1000})
+    ->Args({10000, 10000});
+// the partitions are run by 1, 2 and 4 threads
+BENCHMARK(BM_EngineRunBatchWindowParallel)
+    ->Args({10000, 1})
+    ->Args({10000, 2})
+    ->Args({10000, 4})
+    ->Args({100000, 1})
+    ->Args({100000, 2})
+    ->Args({100000, 4});
 BENCHMARK(BM_EngineRunBatchWindowSumFeature5Window5)
     ->Args({1, 2})
     ->Args({1, 10})
@@ -22,6 +22,7 @@
 #include <vector>
 #include "benchmark/benchmark.h"
 #include "codec/type_codec.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "llvm/IR/Function.h"
@@ -38,6 +39,8 @@
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "tablet/tablet_catalog.h"
 
+DECLARE_bool(enable_incremental_window_agg);
+
 namespace hybridse {
 namespace bm {
 using codec::Row;
@@ -283,6 +286,165 @@ void EngineRunBatchWindowSumFeature5ExcludeCurrentTime(
         std::to_string(limit_cnt) + ";";
     EngineBatchMode(sql, mode, limit_cnt, size, state);
 }
+// check the incremental window aggregations by the results of rescanning
+static void CheckIncrementalWindowAgg(const std::string& sql, int64_t size) {
+    bool enable_incremental = FLAGS_enable_incremental_window_agg;
+    std::vector<std::string> results[2];
+    for (int i = 0; i < 2; i++) {
+        FLAGS_enable_incremental_window_agg = i == 0;
+        auto catalog = vm::BuildOnePkTableStorage(size);
+        Engine engine(catalog);
+        BatchRunSession session;
+        base::Status query_status;
+        ASSERT_TRUE(engine.Get(sql, "db", session, query_status));
+        std::vector<Row> outputs;
+        ASSERT_EQ(0, session.Run(outputs));
+        for (auto& row : outputs) {
+            results[i].emplace_back(reinterpret_cast<char*>(row.buf()),
+                                    row.size());
+        }
+    }
+    FLAGS_enable_incremental_window_agg = enable_incremental;
+    ASSERT_EQ(results[0], results[1]);
+}
+
+// the integer aggregations are updated incrementally as the window slides,
+// or rescan the whole window for each row if incremental is false
+void EngineRunBatchWindowIntAggFeature5(benchmark::State* state, MODE mode,
+                                        int64_t limit_cnt, int64_t size,
+                                        bool incremental) {  // NOLINT
+    const std::string sql =
+        "SELECT "
+        "sum(col1) OVER w1 as w1_col1_sum, "
+        "sum(col2) OVER w1 as w1_col2_sum, "
+        "sum(col5) OVER w1 as w1_col5_sum, "
+        "count(col1) OVER w1 as w1_col1_cnt, "
+        "max(col5) OVER w1 as w1_col5_max "
+        "FROM t1 WINDOW w1 AS (PARTITION BY col0 ORDER BY col5 ROWS_RANGE "
+        "BETWEEN "
+        "30d "
+        "PRECEDING AND CURRENT ROW) limit " +
+        std::to_string(limit_cnt) + ";";
+    bool enable_incremental = FLAGS_enable_incremental_window_agg;
+    FLAGS_enable_incremental_window_agg = incremental;
+    EngineBatchMode(sql, mode, limit_cnt, size, state);
+    FLAGS_enable_incremental_window_agg = enable_incremental;
+    if (mode == TEST) {
+        CheckIncrementalWindowAgg(sql, size);
+        // the rows leave the window, and the extremums are rescanned
+        const std::string sliding_sql =
+            "SELECT "
+            "sum(col1) OVER w1 as w1_col1_sum, "
+            "sum(col5) OVER w1 as w1_col5_sum, "
+            "count(col2) OVER w1 as w1_col2_cnt, "
+            "min(col1) OVER w1 as w1_col1_min, "
+            "max(col3) OVER w1 as w1_col3_max "
+            "FROM t1 WINDOW w1 AS (PARTITION BY col0 ORDER BY col5 ROWS "
+            "BETWEEN 10 PRECEDING AND CURRENT ROW) limit " +
+            std::to_string(limit_cnt) + ";";
+        CheckIncrementalWindowAgg(sliding_sql, size);
+    }
+}
+
+// the integer aggregations are incremental, while the avg and sum of the
+// floating columns rescan the window in the same function
+void EngineRunBatchWindowMixedAggFeature5(benchmark::State* state, MODE mode,
+                                          int64_t limit_cnt, int64_t size,
+                                          bool incremental) {  // NOLINT
+    const std::string sql =
+        "SELECT "
+        "sum(col1) OVER w1 as w1_col1_sum, "
+        "avg(col1) OVER w1 as w1_col1_avg, "
+        "avg(col2) OVER w1 as w1_col2_avg, "
+        "sum(col4) OVER w1 as w1_col4_sum, "
+        "avg(col3) OVER w1 as w1_col3_avg, "
+        "count(col5) OVER w1 as w1_col5_cnt, "
+        "max(col5) OVER w1 as w1_col5_max "
+        "FROM t1 WINDOW w1 AS (PARTITION BY col0 ORDER BY col5 ROWS_RANGE "
+        "BETWEEN "
+        "30d "
+        "PRECEDING AND CURRENT ROW) limit " +
+        std::to_string(limit_cnt) + ";";
+    bool enable_incremental = FLAGS_enable_incremental_window_agg;
+    FLAGS_enable_incremental_window_agg = incremental;
+    EngineBatchMode(sql, mode, limit_cnt, size, state);
+    FLAGS_enable_incremental_window_agg = enable_incremental;
+    if (mode == TEST) {
+        CheckIncrementalWindowAgg(sql, size);
+        const std::string sliding_sql =
+            "SELECT "
+            "avg(col1) OVER w1 as w1_col1_avg, "
+            "avg(col5) OVER w1 as w1_col5_avg, "
+            "sum(col3) OVER w1 as w1_col3_sum, "
+            "min(col2) OVER w1 as w1_col2_min "
+            "FROM t1 WINDOW w1 AS (PARTITION BY col0 ORDER BY col5 ROWS "
+            "BETWEEN 10 PRECEDING AND CURRENT ROW) limit " +
+            std::to_string(limit_cnt) + ";";
+        CheckIncrementalWindowAgg(sliding_sql, size);
+    }
+}
+
+// the output of the parallel run is the same as the sequential one
+static void CheckParallelBatchRun(const std::string& sql, int64_t size,
+                                  uint32_t parallelism) {
+    std::vector<std::string> results[2];
+    for (int i = 0; i < 2; i++) {
+        auto catalog = vm::BuildOnePkTableStorage(size);
+        Engine engine(catalog);
+        BatchRunSession session;
+        session.SetParallelism(i == 0 ? parallelism : 1);
+        base::Status query_status;
+        ASSERT_TRUE(engine.Get(sql, "db", session, query_status));
+        std::vector<Row> outputs;
+        ASSERT_EQ(0, session.Run(outputs));
+        for (auto& row : outputs) {
+            results[i].emplace_back(reinterpret_cast<char*>(row.buf()),
+                                    row.size());
+        }
+    }
+    ASSERT_FALSE(results[0].empty());
+    ASSERT_EQ(results[0], results[1]);
+}
+
+// the partitions of the window are run by at most parallelism threads
+void EngineRunBatchWindowParallel(benchmark::State* state, MODE mode,
+                                  int64_t size, uint32_t parallelism) {  // NOLINT
+    const std::string sql =
+        "SELECT "
+        "sum(col1) OVER w1 as w1_col1_sum, "
+        "sum(col4) OVER w1 as w1_col4_sum, "
+        "count(col2) OVER w1 as w1_col2_cnt, "
+        "avg(col3) OVER w1 as w1_col3_avg, "
+        "max(col5) OVER w1 as w1_col5_max "
+        "FROM t1 WINDOW w1 AS (PARTITION BY col6 ORDER BY col5 ROWS_RANGE "
+        "BETWEEN 30d PRECEDING AND CURRENT ROW);";
+    switch (mode) {
+        case BENCHMARK: {
+            InitializeNativeTarget();
+            InitializeNativeTargetAsmPrinter();
+            auto catalog = vm::BuildOnePkTableStorage(size);
+            Engine engine(catalog);
+            BatchRunSession session;
+            session.SetParallelism(parallelism);
+            base::Status query_status;
+            engine.Get(sql, "db", session, query_status);
+            for (auto _ : *state) {
+                std::vector<hybridse::codec::Row> outputs;
+                benchmark::DoNotOptimize(session.Run(outputs));
+            }
+            break;
+        }
+        case TEST: {
+            CheckParallelBatchRun(sql, size, parallelism);
+            CheckParallelBatchRun(
+                "SELECT col6, sum(col1) as col1_sum, count(col2) as col2_cnt "
+                "FROM t1 GROUP BY col6;",
+                size, parallelism);
+            break;
+        }
+    }
+}
+
 void EngineRunBatchWindowSumFeature5Window5(benchmark::State* state, MODE mode,
                                             int64_t limit_cnt,
                                             int64_t size) {  // NOLINT
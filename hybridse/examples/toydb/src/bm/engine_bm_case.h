@@ -62,6 +62,14 @@ void EngineRunBatchWindowSumFeature5ExcludeCurrentTime(benchmark::State* state,
                                                        MODE mode,
                                                        int64_t limit_cnt,
                                                        int64_t size);  // NOLINT
+void EngineRunBatchWindowIntAggFeature5(benchmark::State* state, MODE mode,
+                                        int64_t limit_cnt, int64_t size,
+                                        bool incremental);  // NOLINT
+void EngineRunBatchWindowMixedAggFeature5(benchmark::State* state, MODE mode,
+                                          int64_t limit_cnt, int64_t size,
+                                          bool incremental);  // NOLINT
+void EngineRunBatchWindowParallel(benchmark::State* state, MODE mode,
+                                  int64_t size, uint32_t parallelism);  // NOLINT
 void EngineWindowSumFeature5(benchmark::State* state, MODE mode,
                              int64_t limit_cnt,
                              int64_t size);  // NOLINT
@@ -71,6 +71,19 @@ TEST_F(EngineBMCaseTest, EngineRunBatchWindowSumFeature1_TEST) {
 TEST_F(EngineBMCaseTest, EngineRunBatchWindowSumFeature5Window5_TEST) {
     EngineRunBatchWindowSumFeature5Window5(nullptr, TEST, 100L, 100L);
 }
+TEST_F(EngineBMCaseTest, EngineRunBatchWindowIntAggFeature5_TEST) {
+    EngineRunBatchWindowIntAggFeature5(nullptr, TEST, 100L, 100L, true);
+    EngineRunBatchWindowIntAggFeature5(nullptr, TEST, 1000L, 1000L, true);
+}
+TEST_F(EngineBMCaseTest, EngineRunBatchWindowMixedAggFeature5_TEST) {
+    EngineRunBatchWindowMixedAggFeature5(nullptr, TEST, 100L, 100L, true);
+    EngineRunBatchWindowMixedAggFeature5(nullptr, TEST, 1000L, 1000L, true);
+}
+TEST_F(EngineBMCaseTest, EngineRunBatchWindowParallel_TEST) {
+    EngineRunBatchWindowParallel(nullptr, TEST, 1L, 4);
+    EngineRunBatchWindowParallel(nullptr, TEST, 1000L, 4);
+    EngineRunBatchWindowParallel(nullptr, TEST, 10000L, 3);
+}
 TEST_F(EngineBMCaseTest, EngineWindowMultiAggFeature5_TEST) {
     EngineWindowMultiAggFeature5(nullptr, TEST, 100L, 100L);
 }
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_INCLUDE_BASE_LRU_CACHE_H_
+#define HYBRIDSE_INCLUDE_BASE_LRU_CACHE_H_
+
+#include <list>
+#include <map>
+#include <utility>
+#include "boost/optional.hpp"
+
+namespace hybridse {
+namespace base {
+
+// the same interface as boost::compute::detail::lru_cache, which can also
+// erase a key. insert does nothing if the key exists, as the boost one does
+template <class Key, class Value>
+class LruCache {
+ public:
+    explicit LruCache(size_t capacity) : capacity_(capacity) {}
+    ~LruCache() {}
+
+    size_t size() const { return map_.size(); }
+
+    size_t capacity() const { return capacity_; }
+
+    bool empty() const { return map_.empty(); }
+
+    bool contains(const Key& key) const { return map_.find(key) != map_.end(); }
+
+    void insert(const Key& key, const Value& value) {
+        if (map_.find(key) != map_.end()) {
+            return;
+        }
+        if (map_.size() >= capacity_ && !list_.empty()) {
+            // evict the least recently used one
+            map_.erase(list_.back().first);
+            list_.pop_back();
+        }
+        list_.emplace_front(key, value);
+        map_[key] = list_.begin();
+    }
+
+    boost::optional<Value> get(const Key& key) {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            return boost::none;
+        }
+        // move to the front of the most recently used list
+        list_.splice(list_.begin(), list_, it->second);
+        return it->second->second;
+    }
+
+    bool erase(const Key& key) {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            return false;
+        }
+        list_.erase(it->second);
+        map_.erase(it);
+        return true;
+    }
+
+    void clear() {
+        map_.clear();
+        list_.clear();
+    }
+
+ private:
+    typedef std::list<std::pair<Key, Value>> List;
+
+    List list_;
+    std::map<Key, typename List::iterator> map_;
+    size_t capacity_;
+};
+
+}  // namespace base
+}  // namespace hybridse
+#endif  // HYBRIDSE_INCLUDE_BASE_LRU_CACHE_H_
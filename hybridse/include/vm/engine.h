@@ -17,11 +17,14 @@
 #ifndef HYBRIDSE_INCLUDE_VM_ENGINE_H_
 #define HYBRIDSE_INCLUDE_VM_ENGINE_H_
 
+#include <condition_variable>  //NOLINT
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>  //NOLINT
 #include <set>
 #include <string>
+#include <thread>  //NOLINT
 #include <utility>
 #include <vector>
 #include "base/raw_buffer.h"
@@ -111,6 +114,23 @@ class EngineOptions {
         return enable_batch_window_parallelization_;
     }
 
+    /// Set the max threads to run the partitions of window and group aggregations in batch mode, default `1`.
+    inline EngineOptions* set_batch_run_parallelism(uint32_t parallelism) {
+        batch_run_parallelism_ = parallelism;
+        return this;
+    }
+    /// Return the max threads to run a batch query.
+    inline uint32_t batch_run_parallelism() const { return batch_run_parallelism_; }
+
+    /// Set if the sql of batch mode is compiled without optimization first, and replaced in the cache by the
+    /// optimized compile in background, default `false`.
+    inline EngineOptions* set_enable_tiered_compile(bool flag) {
+        enable_tiered_compile_ = flag;
+        return this;
+    }
+    /// Return if the engine compiles the sql of batch mode in tiers.
+    inline bool is_enable_tiered_compile() const { return enable_tiered_compile_; }
+
     /// Set the maximum number of cache entries, default is `50`.
     inline void set_max_sql_cache_size(uint32_t size) {
         max_sql_cache_size_ = size;
@@ -137,6 +157,8 @@ class EngineOptions {
     bool batch_request_optimized_;
     bool enable_expr_optimize_;
     bool enable_batch_window_parallelization_;
+    uint32_t batch_run_parallelism_;
+    bool enable_tiered_compile_;
     uint32_t max_sql_cache_size_;
     bool enable_spark_unsaferow_format_;
     JitOptions jit_options_;
@@ -176,6 +198,12 @@ class RunSession {
     /// Return if this run session support printing debug information.
     bool IsDebug() { return is_debug_; }
 
+    /// Collect the time spent by each runner into `trace` while running, `nullptr` to disable.
+    ///
+    /// The trace is not owned by the session and is appended by each run.
+    void SetTrace(RunnerTrace* trace) { trace_ = trace; }
+    RunnerTrace* GetTrace() const { return trace_; }
+
     /// Bind this run session with specific procedure
     void SetSpName(const std::string& sp_name) { sp_name_ = sp_name; }
     /// Return the engine mode of this run session
@@ -186,6 +214,7 @@ class RunSession {
     hybridse::vm::EngineMode engine_mode_;
     bool is_debug_;
     std::string sp_name_;
+    RunnerTrace* trace_;
     friend Engine;
 };
 
@@ -193,7 +222,7 @@ class RunSession {
 class BatchRunSession : public RunSession {
  public:
     explicit BatchRunSession(bool mini_batch = false)
-        : RunSession(kBatchMode), parameter_schema_() {}
+        : RunSession(kBatchMode), parameter_schema_(), parallelism_(0) {}
     ~BatchRunSession() {}
     /// \brief Query sql with parameter row in batch mode.
     /// Query results will be returned as std::vector<Row> in output
@@ -208,8 +237,16 @@ class BatchRunSession : public RunSession {
     void SetParameterSchema(const codec::Schema& schema) { parameter_schema_ = schema; }
     /// Return query parameter schema.
     virtual const Schema& GetParameterSchema() const { return parameter_schema_; }
+    /// Set the max threads to run the query, `0` to follow EngineOptions::batch_run_parallelism.
+    ///
+    /// The partitions of window and group aggregations are run in parallel, and the output keeps the
+    /// order of the sequential run.
+    void SetParallelism(uint32_t parallelism) { parallelism_ = parallelism; }
+    /// Return the max threads to run the query.
+    uint32_t GetParallelism() const { return parallelism_; }
  private:
     codec::Schema parameter_schema_;
+    uint32_t parallelism_;
 };
 /// \brief RequestRunSession is a kind of RunSession designed for request mode query.
 ///
@@ -381,10 +418,22 @@ class Engine {
                         EngineMode engine_mode,
                         std::shared_ptr<CompileInfo> info);
 
+    // replace the cached info only if it is still the old one
+    bool ReplaceCacheLocked(const std::string& db, const std::string& sql,
+                            EngineMode engine_mode,
+                            const std::shared_ptr<CompileInfo>& old_info,
+                            std::shared_ptr<CompileInfo> info);
+
     bool IsCompatibleCache(RunSession& session,  // NOLINT
                            std::shared_ptr<CompileInfo> info,
                            base::Status& status);  // NOLINT
 
+    bool Compile(std::shared_ptr<CompileInfo> info, base::Status& status);  // NOLINT
+
+    // compile the info again with optimization in background
+    void SubmitTieredCompile(std::shared_ptr<CompileInfo> info);
+    void RunTieredCompile();
+
     bool Explain(const std::string& sql, const std::string& db,
                  EngineMode engine_mode, const codec::Schema& parameter_schema,
                  const std::set<size_t>& common_column_indices,
@@ -393,6 +442,11 @@ class Engine {
     EngineOptions options_;
     base::SpinMutex mu_;
     EngineLRUCache lru_cache_;
+    std::mutex tiered_mu_;
+    std::condition_variable tiered_cv_;
+    std::deque<std::shared_ptr<CompileInfo>> tiered_tasks_;
+    bool tiered_stop_;
+    std::thread tiered_thread_;
 };
 
 /// \brief Local tablet is responsible to run a task locally.
@@ -19,7 +19,8 @@
 #include <memory>
 #include <set>
 #include <string>
-#include "boost/compute/detail/lru_cache.hpp"
+#include <vector>
+#include "base/lru_cache.h"
 #include "vm/physical_op.h"
 namespace hybridse {
 namespace vm {
@@ -27,6 +28,38 @@ namespace vm {
 enum EngineMode { kBatchMode, kRequestMode, kBatchRequestMode };
 std::string EngineModeName(EngineMode mode);
 
+/// \brief The time spent by each runner of a query, collected if the RunSession enables trace.
+struct RunnerTrace {
+    struct Node {
+        int32_t id;
+        std::string name;
+        /// the time in microsecond spent by the runner itself, excluding the runners it depends on
+        uint64_t time_us;
+        uint32_t run_cnt;
+    };
+    void Add(int32_t id, const std::string& name, uint64_t time_us) {
+        total_us += time_us;
+        auto iter = index.find(id);
+        if (iter == index.end()) {
+            index.emplace(id, nodes.size());
+            nodes.push_back({id, name, time_us, 1});
+        } else {
+            nodes[iter->second].time_us += time_us;
+            nodes[iter->second].run_cnt++;
+        }
+    }
+    void Clear() {
+        nodes.clear();
+        index.clear();
+        total_us = 0;
+    }
+    /// in the order of the first run
+    std::vector<Node> nodes;
+    std::map<int32_t, size_t> index;
+    /// the sum of the time of all the nodes
+    uint64_t total_us = 0;
+};
+
 struct BatchRequestInfo {
     // common column indices in batch request mode
     std::set<size_t> common_column_indices;
@@ -66,8 +99,8 @@ class CompileInfo {
 
 typedef std::map<
     EngineMode,
-    std::map<std::string, boost::compute::detail::lru_cache<
-                              std::string, std::shared_ptr<CompileInfo>>>>
+    std::map<std::string, base::LruCache<std::string,
+                                         std::shared_ptr<CompileInfo>>>>
     EngineLRUCache;
 
 class CompileInfoCache {
@@ -94,11 +127,28 @@ class JitOptions {
     bool is_enable_perf() const { return enable_perf_; }
     void set_enable_perf(bool flag) { enable_perf_ = flag; }
 
+    // the directory to keep the compiled objects across restarts, empty to
+    // disable. mcjit does not use it
+    const std::string& object_cache_dir() const { return object_cache_dir_; }
+    void set_object_cache_dir(const std::string& dir) { object_cache_dir_ = dir; }
+
+    // the max bytes of the objects in object_cache_dir, 0 is unlimited
+    uint64_t object_cache_max_size() const { return object_cache_max_size_; }
+    void set_object_cache_max_size(uint64_t size) { object_cache_max_size_ = size; }
+
+    // run the llvm optimization passes and the optimized machine code
+    // generation, which is only disabled for the fast compile of tiering
+    bool is_enable_optimize() const { return enable_optimize_; }
+    void set_enable_optimize(bool flag) { enable_optimize_ = flag; }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    std::string object_cache_dir_ = "";
+    uint64_t object_cache_max_size_ = 0;
+    bool enable_optimize_ = true;
 };
 }  // namespace vm
 }  // namespace hybridse
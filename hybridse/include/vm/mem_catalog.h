@@ -249,7 +249,10 @@ class Window : public MemTimeTableHandler {
     Window()
         : MemTimeTableHandler(),
           exclude_current_time_(false),
-          instance_not_in_window_(false) {}
+          instance_not_in_window_(false),
+          next_seq_(0),
+          back_seq_(0),
+          removed_begin_(0) {}
     virtual ~Window() {}
 
     std::unique_ptr<RowIterator> GetIterator() override {
@@ -286,9 +289,66 @@ class Window : public MemTimeTableHandler {
         exclude_current_time_ = flag;
     }
 
+    /**
+     * Bind the state of an incremental aggregation to the window.
+     * Return true if the state is carried from the last bind of the key,
+     * then evicted_iter iterates the aggregated rows which have left the
+     * window since then and added_iter iterates the new rows. Otherwise the
+     * state should be reset and added_iter iterates the whole window
+     */
+    bool BindAggState(const int8_t* key, size_t size, int8_t** state,
+                      std::unique_ptr<RowIterator>* evicted_iter,
+                      std::unique_ptr<RowIterator>* added_iter);
+
  protected:
+    // the rows are numbered by the order of adding, so the rows of the
+    // window are always [back_seq_, next_seq_)
+    void AddFrontRow(const uint64_t key, const Row& row) {
+        MemTimeTableHandler::AddFrontRow(key, row);
+        next_seq_++;
+    }
+    void PopBackRow() {
+        if (!agg_states_.empty()) {
+            removed_rows_.emplace_back(back_seq_, false, table_.back());
+        }
+        MemTimeTableHandler::PopBackRow();
+        back_seq_++;
+    }
+    void PopFrontRow() {
+        next_seq_--;
+        if (!agg_states_.empty()) {
+            removed_rows_.emplace_back(next_seq_, true, table_.front());
+        }
+        MemTimeTableHandler::PopFrontRow();
+    }
+
     bool exclude_current_time_;
     bool instance_not_in_window_;
+
+ private:
+    struct RemovedRow {
+        RemovedRow(uint64_t s, bool f, const std::pair<uint64_t, Row>& r)
+            : seq(s), front(f), row(r) {}
+        uint64_t seq;
+        bool front;
+        std::pair<uint64_t, Row> row;
+    };
+    struct AggState {
+        const int8_t* key = nullptr;
+        std::vector<int64_t> buf;
+        // the rows before added_seq have been aggregated
+        uint64_t added_seq = 0;
+        // the position of removed_rows_ to consume
+        uint64_t removed_pos = 0;
+        MemTimeTable evicted;
+    };
+    uint64_t next_seq_;
+    uint64_t back_seq_;
+    // the removed rows are only logged after an aggregation is bound, and
+    // are dropped once all the bound aggregations have consumed them
+    uint64_t removed_begin_;
+    std::deque<RemovedRow> removed_rows_;
+    std::deque<AggState> agg_states_;
 };
 class WindowRange {
  public:
@@ -770,6 +830,9 @@ void RowIterNext(int8_t* iter);
 int8_t* RowIterGetCurSlice(int8_t* iter, size_t idx);
 size_t RowIterGetCurSliceSize(int8_t* iter, size_t idx);
 void RowIterDelete(int8_t* iter);
+bool GetWindowAggState(int8_t* input, int8_t* key, int32_t size,
+                       int8_t** state, int8_t* evicted_iter,
+                       int8_t* added_iter);
 int8_t* RowGetSlice(int8_t* row_ptr, size_t idx);
 size_t RowGetSliceSize(int8_t* row_ptr, size_t idx);
 }  // namespace vm
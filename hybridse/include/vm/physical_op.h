@@ -141,6 +141,7 @@ class FnInfo {
         frames_.clear();
         schemas_ctx_ = nullptr;
         fn_ptr_ = nullptr;
+        batch_fn_ptr_ = nullptr;
     }
 
     const node::FrameNode *GetFrame(size_t idx) const {
@@ -156,6 +157,11 @@ class FnInfo {
     const int8_t *fn_ptr() const { return fn_ptr_; }
     void SetFnPtr(const int8_t *fn) { fn_ptr_ = fn; }
 
+    // the batch kernel of the function, which runs a block of rows per call
+    const std::string batch_fn_name() const { return fn_name_ + "_batch"; }
+    const int8_t *batch_fn_ptr() const { return batch_fn_ptr_; }
+    void SetBatchFnPtr(const int8_t *fn) { batch_fn_ptr_ = fn; }
+
  private:
     std::string fn_name_ = "";
     vm::Schema fn_schema_;
@@ -172,6 +178,9 @@ class FnInfo {
 
     // function ptr
     const int8_t *fn_ptr_ = nullptr;
+
+    // null if the batch kernel is not built
+    const int8_t *batch_fn_ptr_ = nullptr;
 };
 
 class FnComponent {
@@ -20,12 +20,16 @@
 #include <limits>
 #include <map>
 #include <memory>
+#include <set>
 
 #include "codegen/expr_ir_builder.h"
 #include "codegen/ir_base_builder.h"
 #include "codegen/variable_ir_builder.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
+
+DECLARE_bool(enable_incremental_window_agg);
+
 namespace hybridse {
 namespace codegen {
 
@@ -149,44 +153,88 @@ class StatisticalAggGenerator {
           avg_states_(col_num_, nullptr),
           min_states_(col_num_, nullptr),
           max_states_(col_num_, nullptr),
-          count_state_(nullptr) {}
+          count_state_(nullptr),
+          state_slots_(nullptr),
+          slot_cnt_(nullptr) {}
 
-    ::llvm::Value* GenSumInitState(::llvm::IRBuilder<>* builder) {
-        ::llvm::LLVMContext& llvm_ctx = builder->getContext();
-        ::llvm::Type* llvm_ty =
-            AggregateIRBuilder::GetOutputLlvmType(llvm_ctx, "sum", col_type_);
-        ::llvm::Value* accum = CreateAllocaAtHead(builder, llvm_ty, "sum");
+    // the states are on stack, or in the slots of the state buffer which is
+    // carried across the calls
+    ::llvm::Value* GenAllocState(::llvm::IRBuilder<>* builder,
+                                 ::llvm::Type* llvm_ty,
+                                 const std::string& name) {
+        if (state_slots_ == nullptr) {
+            return CreateAllocaAtHead(builder, llvm_ty, name);
+        }
+        ::llvm::Value* slot = builder->CreateGEP(
+            state_slots_, builder->getInt64((*slot_cnt_)++));
+        return builder->CreatePointerCast(slot, llvm_ty->getPointerTo(),
+                                          name);
+    }
+
+    ::llvm::Value* GenSumAllocState(::llvm::IRBuilder<>* builder) {
+        ::llvm::Type* llvm_ty = AggregateIRBuilder::GetOutputLlvmType(
+            builder->getContext(), "sum", col_type_);
+        return GenAllocState(builder, llvm_ty, "sum");
+    }
+
+    void GenSumInitState(::llvm::IRBuilder<>* builder, ::llvm::Value* accum) {
+        ::llvm::Type* llvm_ty = AggregateIRBuilder::GetOutputLlvmType(
+            builder->getContext(), "sum", col_type_);
         if (llvm_ty->isIntegerTy()) {
             builder->CreateStore(::llvm::ConstantInt::get(llvm_ty, 0, true),
                                  accum);
         } else {
             builder->CreateStore(::llvm::ConstantFP::get(llvm_ty, 0.0), accum);
         }
-        return accum;
     }
 
-    ::llvm::Value* GenAvgInitState(::llvm::IRBuilder<>* builder) {
-        ::llvm::LLVMContext& llvm_ctx = builder->getContext();
-        ::llvm::Type* llvm_ty =
-            AggregateIRBuilder::GetOutputLlvmType(llvm_ctx, "avg", col_type_);
-        ::llvm::Value* accum = CreateAllocaAtHead(builder, llvm_ty, "avg");
-        builder->CreateStore(::llvm::ConstantFP::get(llvm_ty, 0.0), accum);
-        return accum;
+    bool IsFloatCol() const {
+        return col_type_ == ::hybridse::node::kFloat ||
+               col_type_ == ::hybridse::node::kDouble;
     }
 
-    ::llvm::Value* GenCountInitState(::llvm::IRBuilder<>* builder) {
-        ::llvm::LLVMContext& llvm_ctx = builder->getContext();
-        ::llvm::Type* int64_ty = ::llvm::Type::getInt64Ty(llvm_ctx);
-        ::llvm::Value* cnt = CreateAllocaAtHead(builder, int64_ty, "cnt");
-        builder->CreateStore(::llvm::ConstantInt::get(int64_ty, 0, true), cnt);
-        return cnt;
+    // the avg of the integers keeps an exact int64 sum, which can be
+    // subtracted as the rows leave the window
+    ::llvm::Type* GetAvgStateType(::llvm::IRBuilder<>* builder) const {
+        if (IsFloatCol()) {
+            return AggregateIRBuilder::GetOutputLlvmType(
+                builder->getContext(), "avg", col_type_);
+        }
+        return builder->getInt64Ty();
+    }
+
+    ::llvm::Value* GenAvgAllocState(::llvm::IRBuilder<>* builder) {
+        return GenAllocState(builder, GetAvgStateType(builder), "avg");
+    }
+
+    void GenAvgInitState(::llvm::IRBuilder<>* builder, ::llvm::Value* accum) {
+        ::llvm::Type* llvm_ty = GetAvgStateType(builder);
+        if (llvm_ty->isIntegerTy()) {
+            builder->CreateStore(::llvm::ConstantInt::get(llvm_ty, 0, true),
+                                 accum);
+        } else {
+            builder->CreateStore(::llvm::ConstantFP::get(llvm_ty, 0.0), accum);
+        }
+    }
+
+    ::llvm::Value* GenCountAllocState(::llvm::IRBuilder<>* builder) {
+        return GenAllocState(builder, builder->getInt64Ty(), "cnt");
+    }
+
+    void GenCountInitState(::llvm::IRBuilder<>* builder, ::llvm::Value* cnt) {
+        builder->CreateStore(builder->getInt64(0), cnt);
+    }
+
+    ::llvm::Value* GenMinAllocState(::llvm::IRBuilder<>* builder) {
+        ::llvm::Type* llvm_ty = AggregateIRBuilder::GetOutputLlvmType(
+            builder->getContext(), "min", col_type_);
+        return GenAllocState(builder, llvm_ty, "min");
     }
 
-    ::llvm::Value* GenMinInitState(::llvm::IRBuilder<>* builder) {
+    void GenMinInitState(::llvm::IRBuilder<>* builder, ::llvm::Value* accum) {
         ::llvm::LLVMContext& llvm_ctx = builder->getContext();
         ::llvm::Type* llvm_ty =
             AggregateIRBuilder::GetOutputLlvmType(llvm_ctx, "min", col_type_);
-        ::llvm::Value* accum = CreateAllocaAtHead(builder, llvm_ty, "min");
         ::llvm::Value* min;
         if (llvm_ty == ::llvm::Type::getInt16Ty(llvm_ctx)) {
             min = ::llvm::ConstantInt::get(
@@ -205,14 +253,18 @@ class StatisticalAggGenerator {
                                           std::numeric_limits<double>::max());
         }
         builder->CreateStore(min, accum);
-        return accum;
     }
 
-    ::llvm::Value* GenMaxInitState(::llvm::IRBuilder<>* builder) {
+    ::llvm::Value* GenMaxAllocState(::llvm::IRBuilder<>* builder) {
+        ::llvm::Type* llvm_ty = AggregateIRBuilder::GetOutputLlvmType(
+            builder->getContext(), "max", col_type_);
+        return GenAllocState(builder, llvm_ty, "max");
+    }
+
+    void GenMaxInitState(::llvm::IRBuilder<>* builder, ::llvm::Value* accum) {
         ::llvm::LLVMContext& llvm_ctx = builder->getContext();
         ::llvm::Type* llvm_ty =
             AggregateIRBuilder::GetOutputLlvmType(llvm_ctx, "max", col_type_);
-        ::llvm::Value* accum = CreateAllocaAtHead(builder, llvm_ty, "max");
         ::llvm::Value* max;
         if (llvm_ty == ::llvm::Type::getInt16Ty(llvm_ctx)) {
             max = ::llvm::ConstantInt::get(
@@ -231,42 +283,100 @@ class StatisticalAggGenerator {
                 llvm_ty, std::numeric_limits<double>::lowest());
         }
         builder->CreateStore(max, accum);
-        return accum;
     }
 
-    void GenInitState(::llvm::IRBuilder<>* builder) {
+    // alloc the states on stack if state_slots is null, otherwise take the
+    // slots of 8 bytes from slot_cnt
+    void GenAllocStates(::llvm::IRBuilder<>* builder,
+                        ::llvm::Value* state_slots, size_t* slot_cnt) {
+        state_slots_ = state_slots;
+        slot_cnt_ = slot_cnt;
         for (size_t i = 0; i < col_num_; ++i) {
             if (!sum_idxs_[i].empty()) {
-                sum_states_[i] = GenSumInitState(builder);
+                sum_states_[i] = GenSumAllocState(builder);
             }
             if (!avg_idxs_[i].empty()) {
                 if (col_type_ == ::hybridse::node::kDouble) {
-                    sum_states_[i] = GenSumInitState(builder);
+                    if (sum_states_[i] == nullptr) {
+                        sum_states_[i] = GenSumAllocState(builder);
+                    }
                 } else {
-                    avg_states_[i] = GenAvgInitState(builder);
-                }
-                if (count_state_ == nullptr) {
-                    count_state_ = GenCountInitState(builder);
+                    avg_states_[i] = GenAvgAllocState(builder);
                 }
             }
-            if (!count_idxs_[i].empty()) {
+            if (!avg_idxs_[i].empty() || !count_idxs_[i].empty() ||
+                !min_idxs_[i].empty() || !max_idxs_[i].empty()) {
                 if (count_state_ == nullptr) {
-                    count_state_ = GenCountInitState(builder);
+                    count_state_ = GenCountAllocState(builder);
                 }
             }
             if (!min_idxs_[i].empty()) {
-                if (count_state_ == nullptr) {
-                    count_state_ = GenCountInitState(builder);
-                }
-                min_states_[i] = GenMinInitState(builder);
+                min_states_[i] = GenMinAllocState(builder);
             }
             if (!max_idxs_[i].empty()) {
-                if (count_state_ == nullptr) {
-                    count_state_ = GenCountInitState(builder);
-                }
-                max_states_[i] = GenMaxInitState(builder);
+                max_states_[i] = GenMaxAllocState(builder);
+            }
+        }
+    }
+
+    // the slots taken by GenAllocStates
+    size_t GetStateSlotCnt() const {
+        size_t cnt = 0;
+        bool has_count = false;
+        for (size_t i = 0; i < col_num_; ++i) {
+            if (!sum_idxs_[i].empty() ||
+                (!avg_idxs_[i].empty() && col_type_ == node::kDouble)) {
+                cnt++;
+            }
+            if (!avg_idxs_[i].empty() && col_type_ != node::kDouble) {
+                cnt++;
+            }
+            if (!min_idxs_[i].empty()) {
+                cnt++;
+            }
+            if (!max_idxs_[i].empty()) {
+                cnt++;
+            }
+            has_count = has_count || !avg_idxs_[i].empty() ||
+                        !count_idxs_[i].empty() || !min_idxs_[i].empty() ||
+                        !max_idxs_[i].empty();
+        }
+        return has_count ? cnt + 1 : cnt;
+    }
+
+    void GenInitState(::llvm::IRBuilder<>* builder) {
+        for (size_t i = 0; i < col_num_; ++i) {
+            if (sum_states_[i] != nullptr) {
+                GenSumInitState(builder, sum_states_[i]);
+            }
+            if (avg_states_[i] != nullptr) {
+                GenAvgInitState(builder, avg_states_[i]);
+            }
+            if (min_states_[i] != nullptr) {
+                GenMinInitState(builder, min_states_[i]);
+            }
+            if (max_states_[i] != nullptr) {
+                GenMaxInitState(builder, max_states_[i]);
+            }
+        }
+        if (count_state_ != nullptr) {
+            GenCountInitState(builder, count_state_);
+        }
+    }
+
+    // the states can be updated by subtracting the rows leaving the window,
+    // except the floating sums and avgs which may drift from the results of
+    // rescanning
+    bool IsInvertible() const {
+        if (!IsFloatCol()) {
+            return true;
+        }
+        for (size_t i = 0; i < col_num_; ++i) {
+            if (!avg_idxs_[i].empty() || !sum_idxs_[i].empty()) {
+                return false;
             }
         }
+        return true;
     }
 
     void GenSumUpdate(size_t i, ::llvm::Value* input, ::llvm::Value* is_null,
@@ -285,12 +395,14 @@ class StatisticalAggGenerator {
     void GenAvgUpdate(size_t i, ::llvm::Value* input, ::llvm::Value* is_null,
                       ::llvm::IRBuilder<>* builder) {
         ::llvm::Value* accum = builder->CreateLoad(avg_states_[i]);
-        if (input->getType()->isIntegerTy()) {
-            input = builder->CreateSIToFP(input, accum->getType());
+        ::llvm::Value* sum;
+        if (accum->getType()->isIntegerTy()) {
+            sum = builder->CreateAdd(
+                accum, builder->CreateSExt(input, accum->getType()));
         } else {
-            input = builder->CreateFPCast(input, accum->getType());
+            sum = builder->CreateFAdd(
+                accum, builder->CreateFPCast(input, accum->getType()));
         }
-        ::llvm::Value* sum = builder->CreateFAdd(accum, input);
         sum = builder->CreateSelect(is_null, accum, sum);
         builder->CreateStore(sum, avg_states_[i]);
     }
@@ -363,6 +475,85 @@ class StatisticalAggGenerator {
         }
     }
 
+    void GenSumSubtract(size_t i, ::llvm::Value* input, ::llvm::Value* is_null,
+                        ::llvm::IRBuilder<>* builder) {
+        // only the integer sums are subtracted
+        ::llvm::Value* accum = builder->CreateLoad(sum_states_[i]);
+        ::llvm::Value* sub = builder->CreateSub(accum, input);
+        sub = builder->CreateSelect(is_null, accum, sub);
+        builder->CreateStore(sub, sum_states_[i]);
+    }
+
+    void GenAvgSubtract(size_t i, ::llvm::Value* input, ::llvm::Value* is_null,
+                        ::llvm::IRBuilder<>* builder) {
+        // only the int64 sums of the integer avgs are subtracted
+        ::llvm::Value* accum = builder->CreateLoad(avg_states_[i]);
+        ::llvm::Value* sub = builder->CreateSub(
+            accum, builder->CreateSExt(input, accum->getType()));
+        sub = builder->CreateSelect(is_null, accum, sub);
+        builder->CreateStore(sub, avg_states_[i]);
+    }
+
+    void GenCountSubtract(::llvm::IRBuilder<>* builder,
+                          ::llvm::Value* is_null) {
+        ::llvm::Value* cnt = builder->CreateLoad(count_state_);
+        ::llvm::Value* new_cnt = builder->CreateSub(cnt, builder->getInt64(1));
+        new_cnt = builder->CreateSelect(is_null, cnt, new_cnt);
+        builder->CreateStore(new_cnt, count_state_);
+    }
+
+    // min and max can not be subtracted, the window is rescanned if the
+    // extremum leaves. nan is taken as equal, since it is sticky in the state.
+    // So a row is O(w) rather than O(1) when the extremum keeps leaving, e.g.
+    // max over a window ordered by the descending values. A monotonic deque
+    // per key would bound it, but the states are fixed slots of the window
+    // and the generated code has no container to keep the deque in
+    void GenExtremumSubtract(::llvm::Value* state, ::llvm::Value* input,
+                             ::llvm::Value* is_null, ::llvm::Value* dirty,
+                             ::llvm::IRBuilder<>* builder) {
+        ::llvm::Value* accum = builder->CreateLoad(state);
+        ::llvm::Value* eq;
+        if (accum->getType()->isIntegerTy()) {
+            eq = builder->CreateICmpEQ(accum, input);
+        } else {
+            eq = builder->CreateFCmpUEQ(accum, input);
+        }
+        eq = builder->CreateAnd(eq, builder->CreateNot(is_null));
+        builder->CreateStore(
+            builder->CreateOr(builder->CreateLoad(dirty), eq), dirty);
+    }
+
+    // the reverse of GenUpdate for the invertible generators, dirty is set if
+    // the states must be rebuilt
+    void GenSubtract(::llvm::IRBuilder<>* builder,
+                     const std::vector<::llvm::Value*>& inputs,
+                     const std::vector<::llvm::Value*>& is_null,
+                     ::llvm::Value* dirty) {
+        bool count_updated = false;
+        for (size_t i = 0; i < col_num_; ++i) {
+            if (!sum_idxs_[i].empty()) {
+                GenSumSubtract(i, inputs[i], is_null[i], builder);
+            }
+            if (!avg_idxs_[i].empty()) {
+                GenAvgSubtract(i, inputs[i], is_null[i], builder);
+            }
+            if ((!avg_idxs_[i].empty() || !count_idxs_[i].empty() ||
+                 !min_idxs_[i].empty() || !max_idxs_[i].empty()) &&
+                !count_updated) {
+                GenCountSubtract(builder, is_null[i]);
+                count_updated = true;
+            }
+            if (!min_idxs_[i].empty()) {
+                GenExtremumSubtract(min_states_[i], inputs[i], is_null[i],
+                                    dirty, builder);
+            }
+            if (!max_idxs_[i].empty()) {
+                GenExtremumSubtract(max_states_[i], inputs[i], is_null[i],
+                                    dirty, builder);
+            }
+        }
+    }
+
     void GenOutputs(::llvm::IRBuilder<>* builder,
                     std::vector<std::pair<size_t, NativeValue>>* outputs) {
         for (size_t i = 0; i < col_num_; ++i) {
@@ -385,6 +576,9 @@ class StatisticalAggGenerator {
                     sum = builder->CreateLoad(sum_states_[i]);
                 } else {
                     sum = builder->CreateLoad(avg_states_[i]);
+                    if (sum->getType()->isIntegerTy()) {
+                        sum = builder->CreateSIToFP(sum, avg_ty);
+                    }
                 }
                 ::llvm::Value* avg = builder->CreateFDiv(
                     sum, builder->CreateSIToFP(cnt, avg_ty));
@@ -459,6 +653,8 @@ class StatisticalAggGenerator {
     std::vector<::llvm::Value*> min_states_;
     std::vector<::llvm::Value*> max_states_;
     ::llvm::Value* count_state_;
+    ::llvm::Value* state_slots_;
+    size_t* slot_cnt_;
 };
 
 llvm::Type* AggregateIRBuilder::GetOutputLlvmType(
@@ -589,6 +785,93 @@ base::Status ScheduleAggGenerators(
     return base::Status::OK();
 }
 
+// fetch the agg columns of the current row of the iterator, then update the
+// states, or subtract from the states if dirty is not null
+static base::Status GenIterRowAgg(
+    const vm::SchemasContext* schema_context, ::llvm::Module* module,
+    std::unordered_map<std::string, AggColumnInfo>& agg_col_infos,  // NOLINT
+    ::llvm::Value* iter_ptr, ::llvm::BasicBlock* body_block,
+    ::llvm::IRBuilder<>* builder,
+    std::vector<StatisticalAggGenerator>* generators, ::llvm::Value* dirty) {
+    auto int64_ty = builder->getInt64Ty();
+    auto ptr_ty = builder->getInt8PtrTy();
+    auto get_slice_func = module->getOrInsertFunction(
+        "hybridse_storage_row_iter_get_cur_slice",
+        ::llvm::FunctionType::get(ptr_ty, {ptr_ty, int64_ty}, false));
+    auto get_slice_size_func = module->getOrInsertFunction(
+        "hybridse_storage_row_iter_get_cur_slice_size",
+        ::llvm::FunctionType::get(int64_ty, {ptr_ty, int64_ty}, false));
+    std::unordered_map<size_t, std::pair<::llvm::Value*, ::llvm::Value*>>
+        used_slices;
+
+    // only the columns of the generators are fetched
+    std::set<std::string> used_col_keys;
+    for (auto& agg_generator : *generators) {
+        used_col_keys.insert(agg_generator.GetColKeys().begin(),
+                             agg_generator.GetColKeys().end());
+    }
+
+    // compute current row's slices
+    for (auto& pair : agg_col_infos) {
+        if (used_col_keys.count(pair.second.GetColKey()) == 0) {
+            continue;
+        }
+        size_t schema_idx = pair.second.schema_idx;
+        auto iter = used_slices.find(schema_idx);
+        if (iter == used_slices.end()) {
+            ::llvm::Value* idx_value =
+                llvm::ConstantInt::get(int64_ty, schema_idx, true);
+            ::llvm::Value* buf_ptr =
+                builder->CreateCall(get_slice_func, {iter_ptr, idx_value});
+            ::llvm::Value* buf_size = builder->CreateCall(
+                get_slice_size_func, {iter_ptr, idx_value});
+            used_slices[schema_idx] = {buf_ptr, buf_size};
+        }
+    }
+
+    // compute row field fetches
+    std::unordered_map<std::string, NativeValue> cur_row_fields_dict;
+    for (auto& pair : agg_col_infos) {
+        auto& info = pair.second;
+        std::string col_key = info.GetColKey();
+        if (used_col_keys.count(col_key) == 0) {
+            continue;
+        }
+        if (cur_row_fields_dict.find(col_key) == cur_row_fields_dict.end()) {
+            size_t schema_idx = info.schema_idx;
+            auto& slice_info = used_slices[schema_idx];
+
+            ScopeVar dummy_scope_var;
+            BufNativeIRBuilder buf_builder(
+                schema_idx, schema_context->GetRowFormat(schema_idx),
+                body_block, &dummy_scope_var);
+            NativeValue field_value;
+            CHECK_TRUE(buf_builder.BuildGetField(info.col_idx, slice_info.first, slice_info.second, &field_value),
+                       common::kCodegenGetFieldError, "fail to gen fetch column")
+            cur_row_fields_dict[col_key] = field_value;
+        }
+    }
+
+    // compute accumulation
+    for (auto& agg_generator : *generators) {
+        std::vector<::llvm::Value*> fields;
+        std::vector<::llvm::Value*> fields_is_null;
+        for (auto& key : agg_generator.GetColKeys()) {
+            auto iter = cur_row_fields_dict.find(key);
+            CHECK_TRUE(iter != cur_row_fields_dict.end(), common::kCodegenUdafError, "Fail to find row field of ", key)
+            auto& field_value = iter->second;
+            fields.push_back(field_value.GetValue(builder));
+            fields_is_null.push_back(field_value.GetIsNull(builder));
+        }
+        if (dirty == nullptr) {
+            agg_generator.GenUpdate(builder, fields, fields_is_null);
+        } else {
+            agg_generator.GenSubtract(builder, fields, fields_is_null, dirty);
+        }
+    }
+    return base::Status::OK();
+}
+
 base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
                                     ExprIRBuilder* expr_ir_builder,
                                     VariableIRBuilder* variable_ir_builder,
@@ -635,110 +918,202 @@ base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
     CHECK_STATUS(ScheduleAggGenerators(agg_col_infos_, &generators), common::kCodegenUdafError,
                  "Schedule agg ops failed")
 
-    // gen head
-    builder.SetInsertPoint(head_block);
-    for (auto& agg_generator : generators) {
-        agg_generator.GenInitState(&builder);
+    // the states of the invertible generators are carried across the rows of
+    // a window, and only the rows leaving or entering the window are
+    // aggregated. The others rescan the whole window on their own
+    bool incremental = false;
+    std::vector<StatisticalAggGenerator> rescan_generators;
+    if (FLAGS_enable_incremental_window_agg) {
+        std::vector<StatisticalAggGenerator> invertible_generators;
+        for (auto& agg_generator : generators) {
+            if (agg_generator.IsInvertible()) {
+                invertible_generators.push_back(agg_generator);
+            } else {
+                rescan_generators.push_back(agg_generator);
+            }
+        }
+        if (!invertible_generators.empty()) {
+            generators.swap(invertible_generators);
+            incremental = true;
+        } else {
+            rescan_generators.clear();
+        }
     }
 
     ::llvm::Value* input_arg = fn->arg_begin();
     ::llvm::Value* output_arg = fn->arg_begin() + 1;
+    auto bool_ty = llvm::Type::getInt1Ty(llvm_ctx);
+    auto has_next_func = module_->getOrInsertFunction(
+        "hybridse_storage_row_iter_has_next",
+        ::llvm::FunctionType::get(bool_ty, {ptr_ty}, false));
+    auto next_func = module_->getOrInsertFunction(
+        "hybridse_storage_row_iter_next",
+        ::llvm::FunctionType::get(void_ty, {ptr_ty}, false));
+    auto delete_iter_func = module_->getOrInsertFunction(
+        "hybridse_storage_row_iter_delete",
+        ::llvm::FunctionType::get(void_ty, {ptr_ty}, false));
+    auto get_iter_func = module_->getOrInsertFunction(
+        "hybridse_storage_get_row_iter", void_ty, ptr_ty, ptr_ty);
 
     // on stack unique pointer
     size_t iter_bytes = sizeof(std::unique_ptr<codec::RowIterator>);
+    builder.SetInsertPoint(head_block);
     ::llvm::Value* iter_ptr = CreateAllocaAtHead(
         &builder, ::llvm::Type::getInt8Ty(llvm_ctx), "row_iter",
         ::llvm::ConstantInt::get(int64_ty, iter_bytes, true));
-    auto get_iter_func = module_->getOrInsertFunction(
-        "hybridse_storage_get_row_iter", void_ty, ptr_ty, ptr_ty);
-    builder.CreateCall(get_iter_func, {input_arg, iter_ptr});
-    builder.CreateBr(enter_block);
+    ::llvm::Value* evicted_iter_ptr = nullptr;
+    if (!incremental) {
+        // gen head
+        size_t slot_cnt = 0;
+        for (auto& agg_generator : generators) {
+            agg_generator.GenAllocStates(&builder, nullptr, &slot_cnt);
+            agg_generator.GenInitState(&builder);
+        }
+        builder.CreateCall(get_iter_func, {input_arg, iter_ptr});
+        builder.CreateBr(enter_block);
+    } else {
+        ::llvm::BasicBlock* init_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "init_state", fn);
+        ::llvm::BasicBlock* evicted_enter_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "enter_evicted_iter", fn);
+        ::llvm::BasicBlock* evicted_body_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "evicted_iter_body", fn);
+        ::llvm::BasicBlock* evicted_exit_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "exit_evicted_iter", fn);
+        ::llvm::BasicBlock* rescan_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "rescan", fn);
+
+        // gen head: the states live in the slots bound to the window, or on
+        // stack if the input is not a window
+        size_t slot_cnt = 0;
+        for (auto& agg_generator : generators) {
+            slot_cnt += agg_generator.GetStateSlotCnt();
+        }
+        ::llvm::Value* local_slots = CreateAllocaAtHead(
+            &builder, int64_ty, "local_agg_state",
+            ::llvm::ConstantInt::get(int64_ty, slot_cnt, true));
+        evicted_iter_ptr = CreateAllocaAtHead(
+            &builder, ::llvm::Type::getInt8Ty(llvm_ctx), "evicted_row_iter",
+            ::llvm::ConstantInt::get(int64_ty, iter_bytes, true));
+        ::llvm::Value* dirty = CreateAllocaAtHead(&builder, bool_ty, "dirty");
+        builder.CreateStore(builder.getInt1(false), dirty);
+        // the key identifies the aggregation among the ones on the window
+        auto state_key = new ::llvm::GlobalVariable(
+            *module_, builder.getInt8Ty(), false,
+            ::llvm::GlobalValue::InternalLinkage, builder.getInt8(0),
+            fn_name + "state_key");
+        ::llvm::Value* state_ptr =
+            CreateAllocaAtHead(&builder, ptr_ty, "agg_state");
+        builder.CreateStore(builder.CreatePointerCast(local_slots, ptr_ty),
+                            state_ptr);
+        auto get_state_func = module_->getOrInsertFunction(
+            "hybridse_storage_get_window_agg_state",
+            ::llvm::FunctionType::get(
+                bool_ty,
+                {ptr_ty, ptr_ty, builder.getInt32Ty(), ptr_ty->getPointerTo(),
+                 ptr_ty, ptr_ty},
+                false));
+        ::llvm::Value* carried = builder.CreateCall(
+            get_state_func,
+            {input_arg, state_key,
+             builder.getInt32(slot_cnt * sizeof(int64_t)), state_ptr,
+             evicted_iter_ptr, iter_ptr});
+        ::llvm::Value* state_base = builder.CreatePointerCast(
+            builder.CreateLoad(state_ptr), int64_ty->getPointerTo());
+        size_t slot_idx = 0;
+        for (auto& agg_generator : generators) {
+            agg_generator.GenAllocStates(&builder, state_base, &slot_idx);
+        }
+        CHECK_TRUE(slot_idx == slot_cnt, common::kCodegenUdafError,
+                   "Agg state slots mismatch: ", slot_idx, " vs ", slot_cnt)
+        builder.CreateCondBr(carried, evicted_enter_block, init_block);
+
+        builder.SetInsertPoint(init_block);
+        for (auto& agg_generator : generators) {
+            agg_generator.GenInitState(&builder);
+        }
+        builder.CreateBr(enter_block);
+
+        // subtract the rows leaving the window
+        builder.SetInsertPoint(evicted_enter_block);
+        builder.CreateCondBr(
+            builder.CreateCall(has_next_func, evicted_iter_ptr),
+            evicted_body_block, evicted_exit_block);
+        builder.SetInsertPoint(evicted_body_block);
+        CHECK_STATUS(GenIterRowAgg(schema_context_, module_, agg_col_infos_,
+                                   evicted_iter_ptr, evicted_body_block,
+                                   &builder, &generators, dirty))
+        builder.CreateCall(next_func, {evicted_iter_ptr});
+        builder.CreateBr(evicted_enter_block);
+
+        builder.SetInsertPoint(evicted_exit_block);
+        builder.CreateCondBr(builder.CreateLoad(dirty), rescan_block,
+                             enter_block);
+
+        // an extremum has left, rebuild the states from the whole window
+        builder.SetInsertPoint(rescan_block);
+        builder.CreateCall(delete_iter_func, {iter_ptr});
+        builder.CreateCall(get_iter_func, {input_arg, iter_ptr});
+        builder.CreateBr(init_block);
+    }
 
     // gen iter begin
     builder.SetInsertPoint(enter_block);
-    auto bool_ty = llvm::Type::getInt1Ty(llvm_ctx);
-    auto has_next_func = module_->getOrInsertFunction(
-        "hybridse_storage_row_iter_has_next",
-        ::llvm::FunctionType::get(bool_ty, {ptr_ty}, false));
     ::llvm::Value* has_next = builder.CreateCall(has_next_func, iter_ptr);
     builder.CreateCondBr(has_next, body_block, exit_block);
 
     // gen iter body
     builder.SetInsertPoint(body_block);
-    auto get_slice_func = module_->getOrInsertFunction(
-        "hybridse_storage_row_iter_get_cur_slice",
-        ::llvm::FunctionType::get(ptr_ty, {ptr_ty, int64_ty}, false));
-    auto get_slice_size_func = module_->getOrInsertFunction(
-        "hybridse_storage_row_iter_get_cur_slice_size",
-        ::llvm::FunctionType::get(int64_ty, {ptr_ty, int64_ty}, false));
-    std::unordered_map<size_t, std::pair<::llvm::Value*, ::llvm::Value*>>
-        used_slices;
-
-    // compute current row's slices
-    for (auto& pair : agg_col_infos_) {
-        size_t schema_idx = pair.second.schema_idx;
-        auto iter = used_slices.find(schema_idx);
-        if (iter == used_slices.end()) {
-            ::llvm::Value* idx_value =
-                llvm::ConstantInt::get(int64_ty, schema_idx, true);
-            ::llvm::Value* buf_ptr =
-                builder.CreateCall(get_slice_func, {iter_ptr, idx_value});
-            ::llvm::Value* buf_size =
-                builder.CreateCall(get_slice_size_func, {iter_ptr, idx_value});
-            used_slices[schema_idx] = {buf_ptr, buf_size};
-        }
-    }
-
-    // compute row field fetches
-    std::unordered_map<std::string, NativeValue> cur_row_fields_dict;
-    for (auto& pair : agg_col_infos_) {
-        auto& info = pair.second;
-        std::string col_key = info.GetColKey();
-        if (cur_row_fields_dict.find(col_key) == cur_row_fields_dict.end()) {
-            size_t schema_idx = info.schema_idx;
-            auto& slice_info = used_slices[schema_idx];
-
-            ScopeVar dummy_scope_var;
-            BufNativeIRBuilder buf_builder(
-                schema_idx, schema_context_->GetRowFormat(schema_idx),
-                body_block, &dummy_scope_var);
-            NativeValue field_value;
-            CHECK_TRUE(buf_builder.BuildGetField(info.col_idx, slice_info.first, slice_info.second, &field_value),
-                       common::kCodegenGetFieldError, "fail to gen fetch column")
-            cur_row_fields_dict[col_key] = field_value;
-        }
-    }
-
-    // compute accumulation
-    for (auto& agg_generator : generators) {
-        std::vector<::llvm::Value*> fields;
-        std::vector<::llvm::Value*> fields_is_null;
-        for (auto& key : agg_generator.GetColKeys()) {
-            auto iter = cur_row_fields_dict.find(key);
-            CHECK_TRUE(iter != cur_row_fields_dict.end(), common::kCodegenUdafError, "Fail to find row field of ", key)
-            auto& field_value = iter->second;
-            fields.push_back(field_value.GetValue(&builder));
-            fields_is_null.push_back(field_value.GetIsNull(&builder));
-        }
-        agg_generator.GenUpdate(&builder, fields, fields_is_null);
-    }
-    auto next_func = module_->getOrInsertFunction(
-        "hybridse_storage_row_iter_next",
-        ::llvm::FunctionType::get(void_ty, {ptr_ty}, false));
+    CHECK_STATUS(GenIterRowAgg(schema_context_, module_, agg_col_infos_,
+                               iter_ptr, body_block, &builder, &generators,
+                               nullptr))
     builder.CreateCall(next_func, {iter_ptr});
     builder.CreateBr(enter_block);
 
     // gen iter end
     builder.SetInsertPoint(exit_block);
-    auto delete_iter_func = module_->getOrInsertFunction(
-        "hybridse_storage_row_iter_delete",
-        ::llvm::FunctionType::get(void_ty, {ptr_ty}, false));
     builder.CreateCall(delete_iter_func, {iter_ptr});
+    if (evicted_iter_ptr != nullptr) {
+        builder.CreateCall(delete_iter_func, {evicted_iter_ptr});
+    }
+
+    // the non invertible generators scan the whole window
+    ::llvm::BasicBlock* output_block = exit_block;
+    if (!rescan_generators.empty()) {
+        ::llvm::BasicBlock* rescan_enter_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "enter_rescan_iter", fn);
+        ::llvm::BasicBlock* rescan_body_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "rescan_iter_body", fn);
+        output_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "exit_rescan_iter", fn);
+        size_t slot_cnt = 0;
+        for (auto& agg_generator : rescan_generators) {
+            agg_generator.GenAllocStates(&builder, nullptr, &slot_cnt);
+            agg_generator.GenInitState(&builder);
+        }
+        builder.CreateCall(get_iter_func, {input_arg, iter_ptr});
+        builder.CreateBr(rescan_enter_block);
+
+        builder.SetInsertPoint(rescan_enter_block);
+        builder.CreateCondBr(builder.CreateCall(has_next_func, iter_ptr),
+                             rescan_body_block, output_block);
+        builder.SetInsertPoint(rescan_body_block);
+        CHECK_STATUS(GenIterRowAgg(schema_context_, module_, agg_col_infos_,
+                                   iter_ptr, rescan_body_block, &builder,
+                                   &rescan_generators, nullptr))
+        builder.CreateCall(next_func, {iter_ptr});
+        builder.CreateBr(rescan_enter_block);
+
+        builder.SetInsertPoint(output_block);
+        builder.CreateCall(delete_iter_func, {iter_ptr});
+        generators.insert(generators.end(), rescan_generators.begin(),
+                          rescan_generators.end());
+    }
 
     // store results to output row
     std::map<uint32_t, NativeValue> dummy_map;
     BufNativeEncoderIRBuilder output_encoder(&dummy_map, &output_schema,
-                                             exit_block);
+                                             output_block);
     for (auto& agg_generator : generators) {
         std::vector<std::pair<size_t, NativeValue>> outputs;
         agg_generator.GenOutputs(&builder, &outputs);
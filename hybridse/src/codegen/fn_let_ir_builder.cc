@@ -155,6 +155,74 @@ Status RowFnLetIRBuilder::Build(
     return Status::OK();
 }
 
+Status RowFnLetIRBuilder::BuildBatch(const std::string& name,
+                                     const std::string& batch_name) {
+    ::llvm::Module* module = ctx_->GetModule();
+    ::llvm::Function* row_fn = module->getFunction(name);
+    CHECK_TRUE(row_fn != nullptr, kCodegenError, "function ", name,
+               " not exists");
+    CHECK_TRUE(module->getFunction(batch_name) == nullptr, kCodegenError,
+               "function ", batch_name, " already exists");
+
+    ::llvm::LLVMContext& llvm_ctx = module->getContext();
+    ::llvm::Type* i8_ptr_ty = ::llvm::Type::getInt8PtrTy(llvm_ctx);
+    ::llvm::Type* i64_ty = ::llvm::Type::getInt64Ty(llvm_ctx);
+    std::vector<::llvm::Type*> args_llvm_type = {
+        i8_ptr_ty, i64_ty, i8_ptr_ty, i8_ptr_ty->getPointerTo()};
+    ::llvm::Function* fn = nullptr;
+    bool ok = BuildFnHeader(batch_name, args_llvm_type,
+                            ::llvm::Type::getInt32Ty(llvm_ctx), &fn);
+    CHECK_TRUE(ok && fn != nullptr, kCodegenError,
+               "Fail to build fn header for name ", batch_name);
+    auto arg_iter = fn->arg_begin();
+    ::llvm::Value* rows = &*arg_iter++;
+    ::llvm::Value* cnt = &*arg_iter++;
+    ::llvm::Value* parameter = &*arg_iter++;
+    ::llvm::Value* outputs = &*arg_iter++;
+
+    auto entry_block = ::llvm::BasicBlock::Create(llvm_ctx, "entry", fn);
+    auto loop_block = ::llvm::BasicBlock::Create(llvm_ctx, "loop", fn);
+    auto body_block = ::llvm::BasicBlock::Create(llvm_ctx, "body", fn);
+    auto exit_block = ::llvm::BasicBlock::Create(llvm_ctx, "exit", fn);
+    ::llvm::IRBuilder<> builder(entry_block);
+    builder.CreateBr(loop_block);
+
+    builder.SetInsertPoint(loop_block);
+    auto idx = builder.CreatePHI(i64_ty, 2, "idx");
+    idx->addIncoming(builder.getInt64(0), entry_block);
+    builder.CreateCondBr(builder.CreateICmpSLT(idx, cnt), body_block,
+                         exit_block);
+
+    // the rows are laid out as an array of codec::Row
+    builder.SetInsertPoint(body_block);
+    ::llvm::Value* row_ptr = builder.CreateInBoundsGEP(
+        rows, builder.CreateMul(idx, builder.getInt64(sizeof(codec::Row))));
+    ::llvm::Value* output_ptr = builder.CreateInBoundsGEP(outputs, idx);
+    // inline the row function, so the work on the parameter and constants
+    // can be shared by the rows of the block
+    auto call = builder.CreateCall(
+        row_fn, {builder.getInt64(0), row_ptr,
+                 ::llvm::ConstantPointerNull::get(
+                     ::llvm::cast<::llvm::PointerType>(i8_ptr_ty)),
+                 parameter, output_ptr});
+    call->addAttribute(::llvm::AttributeList::FunctionIndex,
+                       ::llvm::Attribute::AlwaysInline);
+    ::llvm::Value* failed = builder.CreateICmpNE(call, builder.getInt32(0));
+    ::llvm::Value* output = builder.CreateLoad(output_ptr);
+    builder.CreateStore(
+        builder.CreateSelect(failed,
+                             ::llvm::ConstantPointerNull::get(
+                                 ::llvm::cast<::llvm::PointerType>(i8_ptr_ty)),
+                             output),
+        output_ptr);
+    idx->addIncoming(builder.CreateAdd(idx, builder.getInt64(1)), body_block);
+    builder.CreateBr(loop_block);
+
+    builder.SetInsertPoint(exit_block);
+    builder.CreateRet(builder.getInt32(0));
+    return Status::OK();
+}
+
 base::Status RowFnLetIRBuilder::EncodeBuf(
     const std::map<uint32_t, NativeValue>* values, const vm::Schema& schema,
     VariableIRBuilder& variable_ir_builder,  // NOLINT (runtime/references)
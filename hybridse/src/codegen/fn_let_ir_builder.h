@@ -45,6 +45,12 @@ class RowFnLetIRBuilder {
                  const std::vector<const node::FrameNode*>& project_frames,
                  const vm::Schema& output_schema);
 
+    // build the batch kernel of the row function `name`, which projects the
+    // rows one block at a time: int32_t (const Row* rows, int64_t cnt,
+    // const Row* parameter, int8_t** outputs). the output is null if the
+    // row fails
+    Status BuildBatch(const std::string& name, const std::string& batch_name);
+
  private:
     bool BuildFnHeader(const std::string& name,
                        const std::vector<::llvm::Type*>& args_type,
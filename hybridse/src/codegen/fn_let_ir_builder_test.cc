@@ -220,6 +220,73 @@ TEST_F(FnLetIRBuilderTest, test_extern_udf_project) {
     free(ptr);
 }
 
+TEST_F(FnLetIRBuilderTest, test_batch_project) {
+    std::string sql = "SELECT inc(col1), col1 + 1 FROM t1 limit 10;";
+    int8_t* ptr = NULL;
+    uint32_t size = 0;
+    type::TableDef table1;
+    ASSERT_TRUE(BuildT1Buf(table1, &ptr, &size));
+
+    auto ctx = llvm::make_unique<LLVMContext>();
+    auto m = make_unique<Module>("test_project", *ctx);
+    ::hybridse::base::Status status;
+    ::hybridse::node::PlanNodeList plan;
+    ASSERT_TRUE(plan::PlanAPI::CreatePlanTreeFromScript(sql, plan, &manager, status)) << status;
+    hybridse::node::ProjectListNode* pp_node_ptr = GetPlanNodeList(plan);
+    vm::SchemasContext schemas_ctx;
+    auto source = schemas_ctx.AddSource();
+    source->SetSourceName(table1.name());
+    source->SetSchema(&table1.columns());
+    for (int i = 0; i < table1.columns().size(); ++i) {
+        source->SetColumnID(i, i);
+    }
+    schemas_ctx.Build();
+    vm::ColumnProjects column_projects;
+    ASSERT_TRUE(vm::ExtractProjectInfos(pp_node_ptr->GetProjects(), nullptr, &schemas_ctx, &manager,
+                                        &column_projects)
+                    .isOK());
+    vm::PhysicalPlanContext plan_ctx(&manager, udf::DefaultUdfLibrary::get(), "db",
+                                     std::make_shared<vm::SimpleCatalog>(), nullptr, false);
+    ASSERT_TRUE(plan_ctx.InitFnDef(column_projects, &schemas_ctx, true, &column_projects).isOK());
+
+    const auto& fn_info = column_projects.fn_info();
+    codegen::CodeGenContext codegen_ctx(m.get(), fn_info.schemas_ctx(), nullptr, &manager);
+    codegen::RowFnLetIRBuilder builder(&codegen_ctx);
+    ASSERT_TRUE(builder.Build("test_at_fn", fn_info.fn_def(), fn_info.GetPrimaryFrame(), fn_info.GetFrames(),
+                              *fn_info.fn_schema())
+                    .isOK());
+    ASSERT_TRUE(builder.BuildBatch("test_at_fn", "test_at_fn_batch").isOK());
+    // the batch kernel is built only once
+    ASSERT_FALSE(builder.BuildBatch("test_at_fn", "test_at_fn_batch").isOK());
+
+    auto jit = std::unique_ptr<vm::HybridSeJitWrapper>(vm::HybridSeJitWrapper::Create());
+    jit->Init();
+    vm::HybridSeJitWrapper::InitJitSymbols(jit.get());
+    ASSERT_TRUE(jit->AddModule(std::move(m), std::move(ctx)));
+    auto fn = reinterpret_cast<int32_t (*)(int64_t, int8_t*, int8_t*, int8_t*, int8_t**)>(
+        const_cast<int8_t*>(jit->FindFunction("test_at_fn")));
+    auto batch_fn = reinterpret_cast<int32_t (*)(int8_t*, int64_t, int8_t*, int8_t**)>(
+        const_cast<int8_t*>(jit->FindFunction("test_at_fn_batch")));
+    ASSERT_TRUE(fn != nullptr && batch_fn != nullptr);
+
+    std::vector<Row> rows(3, Row(base::RefCountedSlice::Create(ptr, size)));
+    int8_t* expect = nullptr;
+    ASSERT_EQ(0, fn(0, reinterpret_cast<int8_t*>(&rows[0]), nullptr, nullptr, &expect));
+    std::vector<int8_t*> outputs(rows.size(), nullptr);
+    ASSERT_EQ(0, batch_fn(reinterpret_cast<int8_t*>(rows.data()), rows.size(), nullptr, outputs.data()));
+    uint32_t expect_size = *reinterpret_cast<uint32_t*>(expect + 2);
+    for (auto output : outputs) {
+        ASSERT_TRUE(output != nullptr);
+        ASSERT_EQ(expect_size, *reinterpret_cast<uint32_t*>(output + 2));
+        ASSERT_EQ(0, memcmp(expect, output, expect_size));
+        free(output);
+    }
+    // no row in the batch
+    ASSERT_EQ(0, batch_fn(nullptr, 0, nullptr, nullptr));
+    free(expect);
+    free(ptr);
+}
+
 TEST_F(FnLetIRBuilderTest, test_extern_agg_sum_project) {
     std::string sql =
         "SELECT "
@@ -22,3 +22,11 @@ DEFINE_string(default_db_name, "_hybridse",
 // Offline Spark config
 DEFINE_bool(enable_spark_unsaferow_format, false,
             "config if codec uses Spark UnsafeRow format");
+
+// Codegen config
+DEFINE_bool(enable_incremental_window_agg, true,
+            "config if the window aggregations update the states with the "
+            "rows entering and leaving the window instead of rescanning it");
+DEFINE_bool(enable_batch_project, true,
+            "config if the table projects run the rows by blocks with the "
+            "batch kernels of the project functions");
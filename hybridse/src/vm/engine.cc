@@ -49,6 +49,8 @@ EngineOptions::EngineOptions()
       batch_request_optimized_(true),
       enable_expr_optimize_(true),
       enable_batch_window_parallelization_(false),
+      batch_run_parallelism_(1),
+      enable_tiered_compile_(false),
       max_sql_cache_size_(50),
       enable_spark_unsaferow_format_(false) {
     // TODO(chendihao): Pass the parameter to avoid global gflag
@@ -61,10 +63,20 @@ EngineOptions* EngineOptions::set_enable_spark_unsaferow_format(bool flag) {
     return this;
 }
 
-Engine::Engine(const std::shared_ptr<Catalog>& catalog) : cl_(catalog), options_(), mu_(), lru_cache_() {}
+Engine::Engine(const std::shared_ptr<Catalog>& catalog)
+    : cl_(catalog), options_(), mu_(), lru_cache_(), tiered_stop_(false) {}
 Engine::Engine(const std::shared_ptr<Catalog>& catalog, const EngineOptions& options)
-    : cl_(catalog), options_(options), mu_(), lru_cache_() {}
-Engine::~Engine() {}
+    : cl_(catalog), options_(options), mu_(), lru_cache_(), tiered_stop_(false) {}
+Engine::~Engine() {
+    {
+        std::lock_guard<std::mutex> lock(tiered_mu_);
+        tiered_stop_ = true;
+    }
+    tiered_cv_.notify_all();
+    if (tiered_thread_.joinable()) {
+        tiered_thread_.join();
+    }
+}
 void Engine::InitializeGlobalLLVM() {
     if (LLVM_IS_INITIALIZED) return;
     LLVMInitializeNativeTarget();
@@ -181,6 +193,12 @@ bool Engine::IsCompatibleCache(RunSession& session,  // NOLINT
 
 bool Engine::Get(const std::string& sql, const std::string& db, RunSession& session,
                  base::Status& status) {  // NOLINT (runtime/references)
+    if (session.engine_mode() == kBatchMode) {
+        auto batch_sess = dynamic_cast<BatchRunSession*>(&session);
+        if (batch_sess->GetParallelism() == 0) {
+            batch_sess->SetParallelism(options_.batch_run_parallelism());
+        }
+    }
     std::shared_ptr<CompileInfo> cached_info = GetCacheLocked(db, sql, session.engine_mode());
     if (cached_info && IsCompatibleCache(session, cached_info, status)) {
         session.SetCompileInfo(cached_info);
@@ -210,22 +228,20 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
         auto batch_req_sess = dynamic_cast<BatchRequestRunSession*>(&session);
         sql_context.batch_request_info.common_column_indices = batch_req_sess->common_column_indices();
     }
+    // only the batch queries are tiered, the request infos may be kept out of the cache, e.g. by procedures
+    bool tiered = options_.is_enable_tiered_compile() && session.engine_mode() == kBatchMode &&
+                  !options_.is_plan_only();
+    if (tiered) {
+        sql_context.jit_options.set_enable_optimize(false);
+    }
 
-    SqlCompiler compiler(std::atomic_load_explicit(&cl_, std::memory_order_acquire), options_.is_keep_ir(), false,
-                         options_.is_plan_only());
-    bool ok = compiler.Compile(info->get_sql_context(), status);
-    if (!ok || 0 != status.code) {
+    if (!Compile(info, status)) {
         return false;
     }
-    if (!options_.is_compile_only()) {
-        ok = compiler.BuildClusterJob(info->get_sql_context(), status);
-        if (!ok || 0 != status.code) {
-            LOG(WARNING) << "fail to build cluster job: " << status.msg;
-            return false;
-        }
-    }
 
-    SetCacheLocked(db, sql, session.engine_mode(), info);
+    if (SetCacheLocked(db, sql, session.engine_mode(), info) && tiered) {
+        SubmitTieredCompile(info);
+    }
     session.SetCompileInfo(info);
     if (session.is_debug_) {
         std::ostringstream plan_oss;
@@ -240,6 +256,77 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     return true;
 }
 
+bool Engine::Compile(std::shared_ptr<CompileInfo> info, base::Status& status) {
+    auto& sql_context = std::dynamic_pointer_cast<SqlCompileInfo>(info)->get_sql_context();
+    SqlCompiler compiler(std::atomic_load_explicit(&cl_, std::memory_order_acquire), options_.is_keep_ir(), false,
+                         options_.is_plan_only());
+    bool ok = compiler.Compile(sql_context, status);
+    if (!ok || 0 != status.code) {
+        return false;
+    }
+    if (!options_.is_compile_only()) {
+        ok = compiler.BuildClusterJob(sql_context, status);
+        if (!ok || 0 != status.code) {
+            LOG(WARNING) << "fail to build cluster job: " << status.msg;
+            return false;
+        }
+    }
+    return true;
+}
+
+void Engine::SubmitTieredCompile(std::shared_ptr<CompileInfo> info) {
+    {
+        std::lock_guard<std::mutex> lock(tiered_mu_);
+        if (tiered_stop_) {
+            return;
+        }
+        if (!tiered_thread_.joinable()) {
+            tiered_thread_ = std::thread(&Engine::RunTieredCompile, this);
+        }
+        tiered_tasks_.push_back(info);
+    }
+    tiered_cv_.notify_one();
+}
+
+void Engine::RunTieredCompile() {
+    while (true) {
+        std::shared_ptr<CompileInfo> fast_info;
+        {
+            std::unique_lock<std::mutex> lock(tiered_mu_);
+            tiered_cv_.wait(lock, [this] { return tiered_stop_ || !tiered_tasks_.empty(); });
+            if (tiered_stop_) {
+                return;
+            }
+            fast_info = tiered_tasks_.front();
+            tiered_tasks_.pop_front();
+        }
+        auto& fast_ctx = std::dynamic_pointer_cast<SqlCompileInfo>(fast_info)->get_sql_context();
+        auto info = std::make_shared<SqlCompileInfo>();
+        auto& sql_context = info->get_sql_context();
+        sql_context.sql = fast_ctx.sql;
+        sql_context.db = fast_ctx.db;
+        sql_context.engine_mode = fast_ctx.engine_mode;
+        sql_context.is_performance_sensitive = fast_ctx.is_performance_sensitive;
+        sql_context.is_cluster_optimized = fast_ctx.is_cluster_optimized;
+        sql_context.is_batch_request_optimized = fast_ctx.is_batch_request_optimized;
+        sql_context.enable_batch_window_parallelization = fast_ctx.enable_batch_window_parallelization;
+        sql_context.enable_expr_optimize = fast_ctx.enable_expr_optimize;
+        sql_context.jit_options = fast_ctx.jit_options;
+        sql_context.jit_options.set_enable_optimize(true);
+        sql_context.parameter_types = fast_ctx.parameter_types;
+        sql_context.batch_request_info.common_column_indices = fast_ctx.batch_request_info.common_column_indices;
+        base::Status status;
+        if (!Compile(info, status)) {
+            // keep the unoptimized one, e.g. the catalog is changed
+            LOG(WARNING) << "fail to compile sql with optimization: " << status;
+            continue;
+        }
+        if (ReplaceCacheLocked(sql_context.db, sql_context.sql, sql_context.engine_mode, fast_info, info)) {
+            DLOG(INFO) << "replace cache with the optimized compile of sql " << sql_context.sql;
+        }
+    }
+}
+
 bool Engine::Explain(const std::string& sql, const std::string& db, EngineMode engine_mode,
                      const codec::Schema& parameter_schema,
                      const std::set<size_t>& common_column_indices, ExplainOutput* explain_output,
@@ -348,19 +435,18 @@ std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db, const
     auto value = lru.get(sql);
     if (value == boost::none) {
         return nullptr;
-    } else {
-        return value.value();
     }
+    return value.value();
 }
 
 bool Engine::SetCacheLocked(const std::string& db, const std::string& sql, EngineMode engine_mode,
                             std::shared_ptr<CompileInfo> info) {
     std::lock_guard<base::SpinMutex> lock(mu_);
     auto& mode_cache = lru_cache_[engine_mode];
-    using BoostLRU = boost::compute::detail::lru_cache<std::string, std::shared_ptr<CompileInfo>>;
-    std::map<std::string, BoostLRU>::iterator db_iter = mode_cache.find(db);
+    using LRU = base::LruCache<std::string, std::shared_ptr<CompileInfo>>;
+    std::map<std::string, LRU>::iterator db_iter = mode_cache.find(db);
     if (db_iter == mode_cache.end()) {
-        db_iter = mode_cache.insert(db_iter, {db, BoostLRU(options_.max_sql_cache_size())});
+        db_iter = mode_cache.insert(db_iter, {db, LRU(options_.max_sql_cache_size())});
     }
     auto& lru = db_iter->second;
     auto value = lru.get(sql);
@@ -374,7 +460,31 @@ bool Engine::SetCacheLocked(const std::string& db, const std::string& sql, Engin
     }
 }
 
-RunSession::RunSession(EngineMode engine_mode) : engine_mode_(engine_mode), is_debug_(false), sp_name_("") {}
+bool Engine::ReplaceCacheLocked(const std::string& db, const std::string& sql, EngineMode engine_mode,
+                                const std::shared_ptr<CompileInfo>& old_info, std::shared_ptr<CompileInfo> info) {
+    std::lock_guard<base::SpinMutex> lock(mu_);
+    auto mode_iter = lru_cache_.find(engine_mode);
+    if (mode_iter == lru_cache_.end()) {
+        return false;
+    }
+    auto db_iter = mode_iter->second.find(db);
+    if (db_iter == mode_iter->second.end()) {
+        return false;
+    }
+    auto& lru = db_iter->second;
+    // the old one may be evicted or cleared by the changes of the tables
+    auto value = lru.get(sql);
+    if (value == boost::none || value.value() != old_info) {
+        return false;
+    }
+    // insert does not overwrite the key, and the old one is released with its jit once the running sessions end
+    lru.erase(sql);
+    lru.insert(sql, info);
+    return true;
+}
+
+RunSession::RunSession(EngineMode engine_mode)
+    : engine_mode_(engine_mode), is_debug_(false), sp_name_(""), trace_(nullptr) {}
 RunSession::~RunSession() {}
 
 bool RunSession::SetCompileInfo(const std::shared_ptr<CompileInfo>& compile_info) {
@@ -399,6 +509,7 @@ int32_t RequestRunSession::Run(const uint32_t task_id, const Row& in_row, Row* o
     DLOG(INFO) << "Request Row Run with task_id " << task_id;
     RunnerContext ctx(&std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job, in_row,
                       sp_name_, is_debug_);
+    ctx.SetTrace(trace_);
     auto output = task->RunWithCache(ctx);
     if (!output) {
         LOG(WARNING) << "Run request plan output is null";
@@ -419,6 +530,7 @@ int32_t BatchRequestRunSession::Run(const uint32_t id, const std::vector<Row>& r
                                     std::vector<Row>& output) {
     RunnerContext ctx(&std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job,
                       request_batch, sp_name_, is_debug_);
+    ctx.SetTrace(trace_);
     auto task =
         std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job.GetTask(id).GetRoot();
     if (nullptr == task) {
@@ -443,6 +555,8 @@ int32_t BatchRunSession::Run(std::vector<Row>& rows, uint64_t limit) {
 int32_t BatchRunSession::Run(const Row& parameter_row, std::vector<Row>& rows, uint64_t limit) {
     auto& sql_ctx = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context();
     RunnerContext ctx(&sql_ctx.cluster_job, parameter_row, is_debug_);
+    ctx.SetTrace(trace_);
+    ctx.SetParallelism(parallelism_ == 0 ? 1 : parallelism_);
     auto output = sql_ctx.cluster_job.GetTask(0).GetRoot()->RunWithCache(ctx);
     if (!output) {
         LOG(WARNING) << "Run batch plan output is null";
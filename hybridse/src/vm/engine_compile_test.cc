@@ -14,10 +14,12 @@
  * limitations under the License.
  */
 
+#include <unistd.h>
 #include "case/case_data_mock.h"
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
 #include "testing/engine_test_base.h"
+#include "vm/sql_compiler.h"
 
 using namespace llvm;       // NOLINT (build/namespaces)
 using namespace llvm::orc;  // NOLINT (build/namespaces)
@@ -158,6 +160,64 @@ TEST_F(EngineCompileTest, EngineWithParameterizedLRUCacheTest) {
     }
 }
 
+TEST_F(EngineCompileTest, EngineTieredCompileTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    ::hybridse::type::IndexDef* index = table_def.add_indexes();
+    index->set_name("index12");
+    index->add_first_keys("col1");
+    index->set_second_key("col5");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    EngineOptions options;
+    options.set_enable_tiered_compile(true);
+    Engine engine(catalog, options);
+    std::string sql =
+        "select col1, sum(col2) over w1 as w1_col2_sum from t1 "
+        "window w1 as (partition by col1 order by col5 rows between 10 preceding and current row);";
+    base::Status get_status;
+    BatchRunSession bsession1;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", bsession1, get_status)) << get_status;
+    auto fast_info = std::dynamic_pointer_cast<SqlCompileInfo>(bsession1.GetCompileInfo());
+    ASSERT_FALSE(fast_info->get_sql_context().jit_options.is_enable_optimize());
+
+    // the optimized compile replaces the cached one in background
+    std::shared_ptr<SqlCompileInfo> info;
+    for (int i = 0; i < 1000; i++) {
+        BatchRunSession bsession2;
+        ASSERT_TRUE(engine.Get(sql, "simple_db", bsession2, get_status)) << get_status;
+        info = std::dynamic_pointer_cast<SqlCompileInfo>(bsession2.GetCompileInfo());
+        if (info != fast_info) {
+            break;
+        }
+        usleep(10 * 1000);
+    }
+    ASSERT_NE(fast_info, info);
+    ASSERT_TRUE(info->get_sql_context().jit_options.is_enable_optimize());
+    ASSERT_TRUE(info->get_sql_context().jit != nullptr);
+    BatchRunSession bsession3;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", bsession3, get_status)) << get_status;
+    ASSERT_EQ(info, bsession3.GetCompileInfo());
+
+    // the cache no longer refers to the fast one, which is kept by the test
+    // and bsession1 only, once the background compile drops it
+    for (int i = 0; i < 1000 && fast_info.use_count() > 2; i++) {
+        usleep(1000);
+    }
+    ASSERT_EQ(2, fast_info.use_count());
+
+    // the other modes are not tiered
+    RequestRunSession rsession;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", rsession, get_status)) << get_status;
+    auto request_info = std::dynamic_pointer_cast<SqlCompileInfo>(rsession.GetCompileInfo());
+    ASSERT_TRUE(request_info->get_sql_context().jit_options.is_enable_optimize());
+}
+
 TEST_F(EngineCompileTest, EngineCompileOnlyTest) {
     // Build Simple Catalog
     auto catalog = BuildSimpleCatalog();
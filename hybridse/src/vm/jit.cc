@@ -15,8 +15,11 @@
  */
 
 #include "vm/jit.h"
+#include <utime.h>
+#include <algorithm>
 #include <string>
 #include <utility>
+#include <vector>
 extern "C" {
 #include <cmath>
 #include <cstdlib>
@@ -36,6 +39,12 @@ extern "C" {
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
@@ -48,11 +57,20 @@ namespace hybridse {
 namespace vm {
 using ::llvm::orc::LLJIT;
 
+// the prefix of the module identifiers whose objects are cached
+static constexpr char OBJECT_CACHE_KEY_PREFIX[] = "hybridse_obj_";
+
 HybridSeJit::HybridSeJit(::llvm::orc::LLJITBuilderState& s, ::llvm::Error& e)
     : LLJIT(s, e) {}
 HybridSeJit::~HybridSeJit() {}
 
 static void RunDefaultOptPasses(::llvm::Module* m) {
+    // inline the calls marked always inline, e.g. the row function called by
+    // its batch kernel
+    ::llvm::legacy::PassManager mpm;
+    mpm.add(::llvm::createAlwaysInlinerLegacyPass());
+    mpm.run(*m);
+
     ::llvm::legacy::FunctionPassManager fpm(m);
     // Add some optimizations.
     fpm.add(::llvm::createInstructionCombiningPass());
@@ -148,10 +166,162 @@ bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
     }
 }
 
+std::string JitObjectCache::GetKey(const ::llvm::Module& m) {
+    std::string ir;
+    ::llvm::raw_string_ostream ss(ir);
+    ss << m;
+    ss.flush();
+    ::llvm::SHA1 sha1;
+    sha1.update(ir);
+    sha1.update(LLVM_VERSION_STRING);
+    sha1.update(::llvm::sys::getProcessTriple());
+    sha1.update(::llvm::sys::getHostCPUName());
+    return OBJECT_CACHE_KEY_PREFIX + ::llvm::toHex(sha1.final(), true);
+}
+
+bool JitObjectCache::Load(const std::string& key) {
+    if (key.compare(0, strlen(OBJECT_CACHE_KEY_PREFIX),
+                    OBJECT_CACHE_KEY_PREFIX) != 0) {
+        return false;
+    }
+    auto buf = ::llvm::MemoryBuffer::getFile(GetPath(key), -1, false);
+    if (!buf) {
+        return false;
+    }
+    // touch the file, so the eviction keeps the recently used objects
+    ::utime(GetPath(key).c_str(), nullptr);
+    loaded_[key] = ::llvm::MemoryBuffer::getMemBufferCopy((*buf)->getBuffer());
+    return true;
+}
+
+void JitObjectCache::notifyObjectCompiled(const ::llvm::Module* m,
+                                          ::llvm::MemoryBufferRef obj) {
+    const std::string& key = m->getModuleIdentifier();
+    if (key.compare(0, strlen(OBJECT_CACHE_KEY_PREFIX),
+                    OBJECT_CACHE_KEY_PREFIX) != 0) {
+        return;
+    }
+    if (auto ec = ::llvm::sys::fs::create_directories(dir_)) {
+        LOG(WARNING) << "fail to create object cache dir " << dir_ << ": "
+                     << ec.message();
+        return;
+    }
+    // write to a temp file first, so the others never read a partial object
+    int fd = -1;
+    ::llvm::SmallString<128> tmp_path;
+    if (auto ec = ::llvm::sys::fs::createUniqueFile(
+            dir_ + "/" + key + "-%%%%%%.tmp", fd, tmp_path)) {
+        LOG(WARNING) << "fail to create object cache file in " << dir_ << ": "
+                     << ec.message();
+        return;
+    }
+    {
+        ::llvm::raw_fd_ostream os(fd, true);
+        os << obj.getBuffer();
+        os.close();
+        if (os.has_error()) {
+            os.clear_error();
+            LOG(WARNING) << "fail to write object cache file " << tmp_path.str().str();
+            ::llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+    }
+    if (auto ec = ::llvm::sys::fs::rename(tmp_path, GetPath(key))) {
+        LOG(WARNING) << "fail to rename object cache file "
+                     << tmp_path.str().str() << ": " << ec.message();
+        ::llvm::sys::fs::remove(tmp_path);
+        return;
+    }
+    DLOG(INFO) << "cache object " << key << " with size " << obj.getBufferSize();
+    if (max_size_ > 0) {
+        Evict(key);
+    }
+}
+
+void JitObjectCache::Evict(const std::string& keep_key) {
+    std::vector<std::pair<::llvm::sys::TimePoint<>, std::string>> objects;
+    uint64_t total_size = 0;
+    std::error_code ec;
+    for (::llvm::sys::fs::directory_iterator it(dir_, ec), end; it != end && !ec; it.increment(ec)) {
+        const std::string& path = it->path();
+        if (::llvm::sys::path::extension(path) != ".o") {
+            continue;
+        }
+        ::llvm::sys::fs::file_status status;
+        if (::llvm::sys::fs::status(path, status)) {
+            continue;
+        }
+        total_size += status.getSize();
+        if (path == GetPath(keep_key)) {
+            continue;
+        }
+        objects.emplace_back(status.getLastModificationTime(), path);
+    }
+    if (ec) {
+        LOG(WARNING) << "fail to list object cache dir " << dir_ << ": " << ec.message();
+        return;
+    }
+    std::sort(objects.begin(), objects.end());
+    for (auto& object : objects) {
+        if (total_size <= max_size_) {
+            break;
+        }
+        uint64_t size = 0;
+        if (::llvm::sys::fs::file_size(object.second, size) || ::llvm::sys::fs::remove(object.second)) {
+            continue;
+        }
+        total_size -= size;
+        DLOG(INFO) << "evict cached object " << object.second;
+    }
+}
+
+std::unique_ptr<::llvm::MemoryBuffer> JitObjectCache::getObject(
+    const ::llvm::Module* m) {
+    const std::string& key = m->getModuleIdentifier();
+    auto it = loaded_.find(key);
+    if (it == loaded_.end() && !Load(key)) {
+        return nullptr;
+    }
+    it = loaded_.find(key);
+    auto buf = std::move(it->second);
+    loaded_.erase(it);
+    DLOG(INFO) << "load cached object " << key;
+    return buf;
+}
+
 bool HybridSeLlvmJitWrapper::Init() {
     DLOG(INFO) << "Start to initialize hybridse jit";
-    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
-        HybridSeJitBuilder().create());
+    HybridSeJitBuilder builder;
+    if (!jit_options_.is_enable_optimize()) {
+        auto jtmb = ::llvm::orc::JITTargetMachineBuilder::detectHost();
+        if (!jtmb) {
+            ::llvm::consumeError(jtmb.takeError());
+            LOG(WARNING) << "fail to detect host of jit";
+            return false;
+        }
+        jtmb->setCodeGenOptLevel(::llvm::CodeGenOpt::None);
+        builder.setJITTargetMachineBuilder(std::move(*jtmb));
+    }
+    // the unoptimized objects are not cached, as they share the keys with
+    // the optimized ones
+    if (!jit_options_.object_cache_dir().empty() &&
+        jit_options_.is_enable_optimize()) {
+        object_cache_.reset(new JitObjectCache(
+            jit_options_.object_cache_dir(),
+            jit_options_.object_cache_max_size()));
+        auto cache = object_cache_.get();
+        builder.setCompileFunctionCreator(
+            [cache](::llvm::orc::JITTargetMachineBuilder jtmb)
+                -> ::llvm::Expected<::llvm::orc::IRCompileLayer::CompileFunction> {
+                auto tm = jtmb.createTargetMachine();
+                if (!tm) {
+                    return tm.takeError();
+                }
+                return ::llvm::orc::IRCompileLayer::CompileFunction(
+                    ::llvm::orc::TMOwningSimpleCompiler(std::move(*tm), cache));
+            });
+    }
+    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(builder.create());
     {
         ::llvm::Error e = jit.takeError();
         if (e) {
@@ -169,6 +339,13 @@ bool HybridSeLlvmJitWrapper::Init() {
 }
 
 bool HybridSeLlvmJitWrapper::OptModule(::llvm::Module* module) {
+    // the optimization is skipped only if the cached object is in memory,
+    // which the compile of the module then takes. so an unoptimized module is
+    // never compiled, nor cached under the key of the optimized one
+    if (object_cache_ != nullptr &&
+        object_cache_->Load(module->getModuleIdentifier())) {
+        return true;
+    }
     return jit_->OptModule(module);
 }
 
@@ -21,6 +21,7 @@
 #include <memory>
 #include <string>
 #include "llvm/ExecutionEngine/GenericValue.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "vm/jit_wrapper.h"
 
@@ -85,9 +86,49 @@ std::string LlvmToString(const T& value) {
     return str;
 }
 
+// the objects compiled from the modules, which are kept as files in the
+// directory across restarts. only the modules identified by GetKey are cached.
+// the least recently used files are removed once the directory holds more
+// than max_size bytes, 0 is unlimited
+class JitObjectCache : public ::llvm::ObjectCache {
+ public:
+    JitObjectCache(const std::string& dir, uint64_t max_size)
+        : dir_(dir), max_size_(max_size) {}
+    ~JitObjectCache() {}
+
+    // the key changes with the ir of the module, the llvm version and the
+    // host cpu, so a cached object is only used for the same code
+    static std::string GetKey(const ::llvm::Module& m);
+
+    // read the object of the key into memory, which is returned by the next
+    // getObject of the key even if the file is removed in between
+    bool Load(const std::string& key);
+
+    void notifyObjectCompiled(const ::llvm::Module* m,
+                              ::llvm::MemoryBufferRef obj) override;
+
+    std::unique_ptr<::llvm::MemoryBuffer> getObject(
+        const ::llvm::Module* m) override;
+
+ private:
+    std::string GetPath(const std::string& key) const {
+        return dir_ + "/" + key + ".o";
+    }
+
+    // remove the least recently used objects until the size is in bound,
+    // except the object of keep_key which is just compiled
+    void Evict(const std::string& keep_key);
+
+    const std::string dir_;
+    const uint64_t max_size_;
+    std::map<std::string, std::unique_ptr<::llvm::MemoryBuffer>> loaded_;
+};
+
 class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
  public:
     HybridSeLlvmJitWrapper() {}
+    explicit HybridSeLlvmJitWrapper(const JitOptions& jit_options)
+        : jit_options_(jit_options) {}
     ~HybridSeLlvmJitWrapper() {}
 
     bool Init() override;
@@ -103,6 +144,9 @@ class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
         const std::string& funcname) override;
 
  private:
+    const JitOptions jit_options_;
+    // used by the compiler of jit_, so it is released after jit_
+    std::unique_ptr<JitObjectCache> object_cache_;
     std::unique_ptr<HybridSeJit> jit_;
     std::unique_ptr<::llvm::orc::MangleAndInterner> mi_;
 };
@@ -83,7 +83,7 @@ HybridSeJitWrapper* HybridSeJitWrapper::Create(const JitOptions& jit_options) {
             jit_options.is_enable_gdb()) {
             LOG(WARNING) << "LLJIT do not support jit events";
         }
-        return new HybridSeLlvmJitWrapper();
+        return new HybridSeLlvmJitWrapper(jit_options);
     }
 }
 
@@ -197,6 +197,9 @@ void InitBuiltinJitSymbols(HybridSeJitWrapper* jit) {
     jit->AddExternalFunction(
         "hybridse_storage_row_iter_delete",
         reinterpret_cast<void*>(&hybridse::vm::RowIterDelete));
+    jit->AddExternalFunction(
+        "hybridse_storage_get_window_agg_state",
+        reinterpret_cast<void*>(&hybridse::vm::GetWindowAggState));
     jit->AddExternalFunction(
         "hybridse_storage_get_row_slice",
         reinterpret_cast<void*>(&hybridse::vm::RowGetSlice));
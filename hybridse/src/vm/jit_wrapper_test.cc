@@ -15,6 +15,9 @@
  */
 
 #include "vm/jit_wrapper.h"
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "boost/filesystem.hpp"
 #include "codec/fe_row_codec.h"
 #include "gtest/gtest.h"
 #include "udf/udf.h"
@@ -117,6 +120,101 @@ TEST_F(JitWrapperTest, test_mcjit) {
 }
 #endif
 
+TEST_F(JitWrapperTest, test_object_cache) {
+    char dir[] = "/tmp/hybridse_object_cache_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != nullptr);
+    EngineOptions options;
+    options.jit_options().set_object_cache_dir(dir);
+    auto catalog = GetTestCatalog();
+    std::string sql = "select col_1 + 1.0, col_2 from t1;";
+    auto compile_info = Compile(sql, options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    size_t obj_cnt = 0;
+    boost::filesystem::path obj_path;
+    for (auto &entry : boost::filesystem::directory_iterator(dir)) {
+        ASSERT_EQ(".o", entry.path().extension().string());
+        obj_path = entry.path();
+        obj_cnt++;
+    }
+    ASSERT_EQ(1u, obj_cnt);
+    // the object is written through a temp file and a rename, so a write of
+    // the same key replaces the inode
+    struct stat obj_stat;
+    ASSERT_EQ(0, stat(obj_path.c_str(), &obj_stat));
+
+    // the engine of a restart loads the object from the cache, and writes
+    // nothing
+    compile_info = Compile(sql, options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    obj_cnt = 0;
+    for (auto &entry : boost::filesystem::directory_iterator(dir)) {
+        ASSERT_EQ(obj_path, entry.path());
+        obj_cnt++;
+    }
+    ASSERT_EQ(1u, obj_cnt);
+    struct stat hit_stat;
+    ASSERT_EQ(0, stat(obj_path.c_str(), &hit_stat));
+    ASSERT_EQ(obj_stat.st_ino, hit_stat.st_ino);
+    auto &sql_context = compile_info->get_sql_context();
+    auto fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+    auto fn = sql_context.jit->FindFunction(fn_name);
+    ASSERT_TRUE(fn != nullptr);
+
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+    hybridse::codec::Row empty_parameter;
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+    hybridse::codec::Row output =
+        CoreAPI::RowProject(fn, row, empty_parameter);
+    codec::RowView row_view(*schema, output.buf(), output.size());
+    double c1;
+    int64_t c2;
+    ASSERT_EQ(row_view.GetDouble(0, &c1), 0);
+    ASSERT_EQ(row_view.GetInt64(1, &c2), 0);
+    ASSERT_EQ(c1, 4.14);
+    ASSERT_EQ(c2, 42);
+    boost::filesystem::remove_all(dir);
+}
+
+TEST_F(JitWrapperTest, test_object_cache_evict) {
+    char dir[] = "/tmp/hybridse_object_cache_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != nullptr);
+    EngineOptions options;
+    options.jit_options().set_object_cache_dir(dir);
+    // every object is larger than the bound, so only the last one is kept
+    options.jit_options().set_object_cache_max_size(1);
+    auto catalog = GetTestCatalog();
+    boost::filesystem::path last_obj;
+    for (auto &sql : {"select col_1 + 1.0, col_2 from t1;",
+                      "select col_1 + 2.0, col_2 from t1;"}) {
+        auto compile_info = Compile(sql, options, catalog);
+        ASSERT_TRUE(compile_info != nullptr);
+        size_t obj_cnt = 0;
+        for (auto &entry : boost::filesystem::directory_iterator(dir)) {
+            ASSERT_NE(last_obj, entry.path());
+            last_obj = entry.path();
+            obj_cnt++;
+        }
+        ASSERT_EQ(1u, obj_cnt);
+    }
+
+    // the evicted object is compiled and cached again
+    auto compile_info =
+        Compile("select col_1 + 1.0, col_2 from t1;", options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    size_t obj_cnt = 0;
+    for (auto &entry : boost::filesystem::directory_iterator(dir)) {
+        ASSERT_NE(last_obj, entry.path());
+        obj_cnt++;
+    }
+    ASSERT_EQ(1u, obj_cnt);
+    boost::filesystem::remove_all(dir);
+}
+
 TEST_F(JitWrapperTest, test_window) {
     EngineOptions options;
     options.set_keep_ir(true);
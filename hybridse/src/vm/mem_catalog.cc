@@ -382,6 +382,59 @@ RowIterator* RequestUnionTableHandler::GetRawIterator() {
     return new RequestUnionIterator(request_ts_, &request_row_, window_iter);
 }
 
+bool Window::BindAggState(const int8_t* key, size_t size, int8_t** state,
+                          std::unique_ptr<RowIterator>* evicted_iter,
+                          std::unique_ptr<RowIterator>* added_iter) {
+    uint64_t removed_end = removed_begin_ + removed_rows_.size();
+    AggState* agg_state = nullptr;
+    for (auto& s : agg_states_) {
+        if (s.key == key) {
+            agg_state = &s;
+            break;
+        }
+    }
+    bool carried = agg_state != nullptr;
+    uint64_t added_cnt = table_.size();
+    if (carried) {
+        agg_state->evicted.clear();
+        for (uint64_t pos = agg_state->removed_pos; pos < removed_end; pos++) {
+            const auto& removed = removed_rows_[pos - removed_begin_];
+            if (removed.seq >= agg_state->added_seq) {
+                // added and removed between the binds
+                continue;
+            }
+            agg_state->evicted.push_back(removed.row);
+            if (removed.front) {
+                // the seq will be reused by the next added row
+                agg_state->added_seq = removed.seq;
+            }
+        }
+        added_cnt = next_seq_ - std::max(agg_state->added_seq, back_seq_);
+        evicted_iter->reset(
+            new MemTimeTableIterator(&agg_state->evicted, schema_));
+    } else {
+        agg_states_.emplace_back();
+        agg_state = &agg_states_.back();
+        agg_state->key = key;
+        agg_state->buf.resize((size + sizeof(int64_t) - 1) / sizeof(int64_t));
+    }
+    agg_state->added_seq = next_seq_;
+    agg_state->removed_pos = removed_end;
+    added_iter->reset(new MemTimeTableIterator(
+        &table_, schema_, 0, static_cast<int32_t>(added_cnt)));
+
+    uint64_t min_pos = removed_end;
+    for (const auto& s : agg_states_) {
+        min_pos = std::min(min_pos, s.removed_pos);
+    }
+    while (removed_begin_ < min_pos) {
+        removed_rows_.pop_front();
+        removed_begin_++;
+    }
+    *state = reinterpret_cast<int8_t*>(agg_state->buf.data());
+    return carried;
+}
+
 // row iter interfaces for llvm
 void GetRowIter(int8_t* input, int8_t* iter_addr) {
     auto list_ref = reinterpret_cast<codec::ListRef<Row>*>(input);
@@ -417,6 +470,25 @@ void RowIterDelete(int8_t* iter_ptr) {
         *reinterpret_cast<std::unique_ptr<RowIterator>*>(iter_ptr);
     local_iter = nullptr;
 }
+// bind the state of the incremental aggregation if the input is a window,
+// otherwise the state is left as the local one and should be reset
+bool GetWindowAggState(int8_t* input, int8_t* key, int32_t size,
+                       int8_t** state, int8_t* evicted_iter,
+                       int8_t* added_iter) {
+    auto list_ref = reinterpret_cast<codec::ListRef<Row>*>(input);
+    auto handler = reinterpret_cast<codec::ListV<Row>*>(list_ref->list);
+    auto local_evicted_iter =
+        new (evicted_iter) std::unique_ptr<RowIterator>();
+    auto local_added_iter = new (added_iter) std::unique_ptr<RowIterator>();
+    auto window = dynamic_cast<Window*>(handler);
+    if (window == nullptr) {
+        *local_added_iter = handler->GetIterator();
+        (*local_added_iter)->SeekToFirst();
+        return false;
+    }
+    return window->BindAggState(key, size, state, local_evicted_iter,
+                                local_added_iter);
+}
 int8_t* RowGetSlice(int8_t* row_ptr, size_t idx) {
     auto row = reinterpret_cast<Row*>(row_ptr);
     return row->buf(idx);
@@ -15,8 +15,13 @@
  */
 
 #include "vm/runner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <functional>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 #include "base/texttable.h"
@@ -28,7 +33,74 @@
 
 namespace hybridse {
 namespace vm {
+
+// add the time of the scope to the runner in trace, excluding the runners run inside the scope
+class RunnerTraceScope {
+ public:
+    RunnerTraceScope(RunnerTrace* trace, int32_t id, RunnerType type)
+        : trace_(trace), id_(id), type_(type), start_us_(0), traced_us_(0) {
+        if (trace_ != nullptr) {
+            start_us_ = NowUs();
+            traced_us_ = trace_->total_us;
+        }
+    }
+    ~RunnerTraceScope() {
+        if (trace_ != nullptr) {
+            uint64_t elapsed_us = NowUs() - start_us_;
+            uint64_t nested_us = trace_->total_us - traced_us_;
+            trace_->Add(id_, RunnerTypeName(type_),
+                        elapsed_us > nested_us ? elapsed_us - nested_us : 0);
+        }
+    }
+
+ private:
+    static uint64_t NowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+    RunnerTrace* trace_;
+    int32_t id_;
+    RunnerType type_;
+    uint64_t start_us_;
+    uint64_t traced_us_;
+};
+
+// run fn on the tasks [0, task_cnt) with at most parallelism threads, including the current one. the
+// tasks are taken one by one, so the threads that finish early take more of the rest
+static void ParallelFor(uint32_t parallelism, size_t task_cnt, const std::function<void(size_t)>& fn) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t idx = next.fetch_add(1); idx < task_cnt; idx = next.fetch_add(1)) {
+            fn(idx);
+        }
+    };
+    size_t thread_cnt = std::min(static_cast<size_t>(parallelism), task_cnt);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_cnt; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+static void AppendRows(std::shared_ptr<TableHandler> input, std::shared_ptr<MemTableHandler> output) {
+    auto iter = input->GetIterator();
+    if (!iter) {
+        return;
+    }
+    iter->SeekToFirst();
+    while (iter->Valid()) {
+        output->AddRow(iter->GetValue());
+        iter->Next();
+    }
+}
+
 #define MAX_DEBUG_BATCH_SiZE 5
+// the rows projected by a call of the batch kernel
+#define PROJECT_BLOCK_SIZE 1024
 #define MAX_DEBUG_LINES_CNT 20
 #define MAX_DEBUG_COLUMN_MAX 20
 
@@ -988,6 +1060,7 @@ std::shared_ptr<DataHandlerList> Runner::BatchRequestRun(RunnerContext& ctx) {
         batch_inputs[idx - 1] = producers_[idx - 1]->BatchRequestRun(ctx);
     }
 
+    RunnerTraceScope trace_scope(ctx.trace(), id_, type_);
     for (size_t idx = 0; idx < ctx.GetRequestSize(); idx++) {
         inputs.clear();
         for (size_t producer_idx = 0; producer_idx < producers_.size();
@@ -1044,7 +1117,11 @@ std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
         inputs[idx - 1] = producers_[idx - 1]->RunWithCache(ctx);
     }
 
-    auto res = Run(ctx, inputs);
+    std::shared_ptr<DataHandler> res;
+    {
+        RunnerTraceScope trace_scope(ctx.trace(), id_, type_);
+        res = Run(ctx, inputs);
+    }
     if (ctx.is_debug()) {
         std::ostringstream oss;
         oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_
@@ -1187,6 +1264,42 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
     auto& parameter = ctx.GetParameterRow();
     iter->SeekToFirst();
     int32_t cnt = 0;
+    if (project_gen_.BatchValid()) {
+        std::vector<Row> rows;
+        std::vector<Row> outputs;
+        rows.reserve(PROJECT_BLOCK_SIZE);
+        outputs.reserve(PROJECT_BLOCK_SIZE);
+        auto flush = [&]() {
+            if (rows.empty()) {
+                return;
+            }
+            project_gen_.Gen(rows, parameter, &outputs);
+            for (auto& output : outputs) {
+                output_table->AddRow(output);
+            }
+            rows.clear();
+            outputs.clear();
+        };
+        while (iter->Valid()) {
+            if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
+                break;
+            }
+            auto& row = iter->GetValue();
+            if (row.empty()) {
+                // the empty row is not projected
+                flush();
+                output_table->AddRow(Row());
+            } else {
+                rows.push_back(row);
+                if (rows.size() >= PROJECT_BLOCK_SIZE) {
+                    flush();
+                }
+            }
+            iter->Next();
+        }
+        flush();
+        return output_table;
+    }
     while (iter->Valid()) {
         if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
             break;
@@ -1331,6 +1444,24 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
     // Compute output
     std::shared_ptr<MemTableHandler> output_table =
         std::shared_ptr<MemTableHandler>(new MemTableHandler());
+    if (ctx.parallelism() > 1 && limit_cnt_ <= 0) {
+        std::vector<std::string> keys;
+        while (instance_partition_iter->Valid()) {
+            keys.push_back(instance_partition_iter->GetKey().ToString());
+            instance_partition_iter->Next();
+        }
+        // each key has its own output, which are merged in the order of keys
+        std::vector<std::shared_ptr<MemTableHandler>> key_outputs(keys.size());
+        ParallelFor(ctx.parallelism(), keys.size(), [&](size_t idx) {
+            key_outputs[idx] = std::make_shared<MemTableHandler>();
+            RunWindowAggOnKey(parameter, instance_partition, union_partitions, join_right_tables, keys[idx],
+                              key_outputs[idx]);
+        });
+        for (auto& key_output : key_outputs) {
+            AppendRows(key_output, output_table);
+        }
+        return output_table;
+    }
     while (instance_partition_iter->Valid()) {
         auto key = instance_partition_iter->GetKey().ToString();
         RunWindowAggOnKey(parameter, instance_partition, union_partitions,
@@ -2481,6 +2612,31 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
             return std::shared_ptr<DataHandler>();
         }
         iter->SeekToFirst();
+        if (ctx.parallelism() > 1 && limit_cnt_ <= 0) {
+            std::vector<std::string> keys;
+            while (iter->Valid()) {
+                keys.push_back(iter->GetKey().ToString());
+                iter->Next();
+            }
+            std::vector<Row> rows(keys.size());
+            std::atomic<bool> ok(true);
+            ParallelFor(ctx.parallelism(), keys.size(), [&](size_t idx) {
+                auto segment = partition->GetSegment(keys[idx]);
+                if (!segment) {
+                    ok = false;
+                    return;
+                }
+                rows[idx] = agg_gen_.Gen(parameter, segment);
+            });
+            if (!ok) {
+                LOG(WARNING) << "group aggregation fail: segment segment is null";
+                return std::shared_ptr<DataHandler>();
+            }
+            for (auto& row : rows) {
+                output_table->AddRow(row);
+            }
+            return output_table;
+        }
         int32_t cnt = 0;
         while (iter->Valid()) {
             if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
@@ -2713,6 +2869,7 @@ std::shared_ptr<DataHandlerList> ProxyRequestRunner::BatchRequestRun(
                 std::make_shared<DataHandlerVector>();
             one_index_key_input->Add(index_key_input->Get(0));
         }
+        RunnerTraceScope trace_scope(ctx.trace(), id_, type_);
         auto res =
             RunBatchInput(ctx, proxy_one_row_batch_input, one_index_key_input);
 
@@ -2734,6 +2891,7 @@ std::shared_ptr<DataHandlerList> ProxyRequestRunner::BatchRequestRun(
 
     // if not need batch cache
     // compute each line
+    RunnerTraceScope trace_scope(ctx.trace(), id_, type_);
     auto outputs = RunBatchInput(ctx, proxy_batch_input, index_key_input);
     if (ctx.is_debug()) {
         std::ostringstream oss;
@@ -3174,6 +3332,24 @@ const bool ConditionGenerator::Gen(const Row& row, const Row& parameter) const {
 const Row ProjectGenerator::Gen(const Row& row, const Row& parameter) {
     return CoreAPI::RowProject(fn_, row, parameter, false);
 }
+void ProjectGenerator::Gen(const std::vector<Row>& rows, const Row& parameter, std::vector<Row>* outputs) {
+    auto udf = reinterpret_cast<int32_t (*)(const int8_t*, int64_t, const int8_t*, int8_t**)>(
+        const_cast<int8_t*>(batch_fn_));
+    std::vector<int8_t*> bufs(rows.size(), nullptr);
+    // the runtime resources are released once a block
+    JitRuntime::get()->InitRunStep();
+    udf(reinterpret_cast<const int8_t*>(rows.data()), static_cast<int64_t>(rows.size()),
+        reinterpret_cast<const int8_t*>(&parameter), bufs.data());
+    JitRuntime::get()->ReleaseRunStep();
+    for (auto buf : bufs) {
+        if (buf == nullptr) {
+            LOG(WARNING) << "fail to run udf";
+            outputs->push_back(Row());
+            continue;
+        }
+        outputs->push_back(Row(base::RefCountedSlice::CreateManaged(buf, RowView::GetSize(buf))));
+    }
+}
 
 const Row ConstProjectGenerator::Gen(const Row& parameter) {
     return CoreAPI::RowConstProject(fn_, parameter, false);
@@ -30,6 +30,7 @@
 #include "vm/catalog.h"
 #include "vm/catalog_wrapper.h"
 #include "vm/core_api.h"
+#include "vm/engine_context.h"
 #include "vm/mem_catalog.h"
 #include "vm/physical_op.h"
 namespace hybridse {
@@ -77,10 +78,14 @@ class RowProjectFun : public ProjectFun {
 class ProjectGenerator : public FnGenerator {
  public:
     explicit ProjectGenerator(const FnInfo& info)
-        : FnGenerator(info), fun_(info.fn_ptr()) {}
+        : FnGenerator(info), fun_(info.fn_ptr()), batch_fn_(info.batch_fn_ptr()) {}
     virtual ~ProjectGenerator() {}
     const Row Gen(const Row& row, const Row& parameter);
+    inline const bool BatchValid() const { return nullptr != batch_fn_; }
+    // project the non-empty rows with one call of the batch kernel
+    void Gen(const std::vector<Row>& rows, const Row& parameter, std::vector<Row>* outputs);
     RowProjectFun fun_;
+    const int8_t* batch_fn_;
 };
 
 class ConstProjectGenerator : public FnGenerator {
@@ -1437,7 +1442,9 @@ class RunnerContext {
           requests_(),
           parameter_(parameter),
           is_debug_(is_debug),
-          batch_cache_() {}
+          batch_cache_(),
+          trace_(nullptr),
+          parallelism_(1) {}
     explicit RunnerContext(hybridse::vm::ClusterJob* cluster_job,
                            const hybridse::codec::Row& request,
                            const std::string& sp_name = "",
@@ -1448,7 +1455,9 @@ class RunnerContext {
           requests_(),
           parameter_(),
           is_debug_(is_debug),
-          batch_cache_() {}
+          batch_cache_(),
+          trace_(nullptr),
+          parallelism_(1) {}
     explicit RunnerContext(hybridse::vm::ClusterJob* cluster_job,
                            const std::vector<Row>& request_batch,
                            const std::string& sp_name = "",
@@ -1459,7 +1468,9 @@ class RunnerContext {
           requests_(request_batch),
           parameter_(),
           is_debug_(is_debug),
-          batch_cache_() {}
+          batch_cache_(),
+          trace_(nullptr),
+          parallelism_(1) {}
 
     const size_t GetRequestSize() const { return requests_.size(); }
     const hybridse::codec::Row& GetRequest() const { return request_; }
@@ -1471,6 +1482,12 @@ class RunnerContext {
     void SetRequest(const hybridse::codec::Row& request);
     void SetRequests(const std::vector<hybridse::codec::Row>& requests);
     bool is_debug() const { return is_debug_; }
+    // null if trace is disabled
+    RunnerTrace* trace() const { return trace_; }
+    void SetTrace(RunnerTrace* trace) { trace_ = trace; }
+    // the max threads to run the partitions of a batch runner
+    uint32_t parallelism() const { return parallelism_; }
+    void SetParallelism(uint32_t parallelism) { parallelism_ = parallelism; }
 
     const std::string& sp_name() { return sp_name_; }
     std::shared_ptr<DataHandler> GetCache(int64_t id) const;
@@ -1490,6 +1507,8 @@ class RunnerContext {
     // TODO(chenjing): optimize
     std::map<int64_t, std::shared_ptr<DataHandler>> cache_;
     std::map<int64_t, std::shared_ptr<DataHandlerList>> batch_cache_;
+    RunnerTrace* trace_;
+    uint32_t parallelism_;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -25,14 +25,18 @@
 #include "codegen/block_ir_builder.h"
 #include "codegen/fn_ir_builder.h"
 #include "codegen/ir_base_builder.h"
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/raw_ostream.h"
 #include "plan/plan_api.h"
 #include "udf/default_udf_library.h"
+#include "vm/jit.h"
 #include "vm/runner.h"
 #include "vm/transform.h"
 
+DECLARE_bool(enable_batch_project);
+
 using ::hybridse::base::Status;
 using hybridse::common::kPlanError;
 
@@ -124,7 +128,14 @@ bool SqlCompiler::Compile(SqlContext& ctx, Status& status) {  // NOLINT
     }
     InitBuiltinJitSymbols(jit.get());
     ctx.udf_library->InitJITSymbols(jit.get());
-    if (!jit->OptModule(m.get())) {
+    // the module is identified by its unoptimized ir, and the jit skips the
+    // optimization if it loads the object of the same ir from the cache
+    if (!ctx.jit_options.object_cache_dir().empty() &&
+        !ctx.jit_options.is_enable_mcjit() &&
+        ctx.jit_options.is_enable_optimize()) {
+        m->setModuleIdentifier(JitObjectCache::GetKey(*m));
+    }
+    if (ctx.jit_options.is_enable_optimize() && !jit->OptModule(m.get())) {
         LOG(WARNING) << "fail to opt ir module for sql " << ctx.sql;
         return false;
     }
@@ -388,6 +399,13 @@ bool SqlCompiler::ResolvePlanFnAddress(vm::PhysicalOpNode* node,
             }
         }
     }
+    if (FLAGS_enable_batch_project && kPhysicalOpProject == node->GetOpType() &&
+        kTableProject == dynamic_cast<PhysicalProjectNode*>(node)->project_type_) {
+        auto& fn_info = dynamic_cast<PhysicalProjectNode*>(node)->project().fn_info();
+        if (!fn_info.fn_name().empty()) {
+            const_cast<FnInfo&>(fn_info).SetBatchFnPtr(jit->FindFunction(fn_info.batch_fn_name()));
+        }
+    }
     return true;
 }
 
@@ -22,6 +22,7 @@
 #include "codegen/context.h"
 #include "codegen/fn_ir_builder.h"
 #include "codegen/fn_let_ir_builder.h"
+#include "gflags/gflags.h"
 #include "passes/physical/transform_up_physical_pass.h"
 #include "vm/physical_op.h"
 #include "vm/schemas_context.h"
@@ -41,6 +42,8 @@ using ::hybridse::base::Status;
 using ::hybridse::common::kPlanError;
 using ::hybridse::common::kCodegenError;
 
+DECLARE_bool(enable_batch_project);
+
 namespace hybridse {
 namespace vm {
 
@@ -288,6 +291,15 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
                      "th native function \"", fn_info->fn_name(),
                      "\" failed at node:\n", node->GetTreeString());
     }
+    // the table project runs the rows by blocks
+    if (FLAGS_enable_batch_project && kPhysicalOpProject == node->GetOpType()) {
+        auto project_op = dynamic_cast<PhysicalProjectNode*>(node);
+        if (kTableProject == project_op->project_type_ &&
+            !project_op->project().fn_info().fn_name().empty()) {
+            CHECK_STATUS(InstantiateLLVMBatchFunction(project_op->project().fn_info()),
+                         "Instantiate batch function failed at node:\n", node->GetTreeString());
+        }
+    }
     return Status::OK();
 }
 
@@ -913,6 +925,12 @@ Status BatchModeTransformer::InstantiateLLVMFunction(const FnInfo& fn_info) {
                          *fn_info.fn_schema());
 }
 
+Status BatchModeTransformer::InstantiateLLVMBatchFunction(const FnInfo& fn_info) {
+    codegen::CodeGenContext codegen_ctx(module_, fn_info.schemas_ctx(), plan_ctx_.parameter_types(), node_manager_);
+    codegen::RowFnLetIRBuilder builder(&codegen_ctx);
+    return builder.BuildBatch(fn_info.fn_name(), fn_info.batch_fn_name());
+}
+
 bool BatchModeTransformer::AddDefaultPasses() {
     AddPass(PhysicalPlanPassType::kPassColumnProjectsOptimized);
     AddPass(PhysicalPlanPassType::kPassFilterOptimized);
@@ -209,6 +209,7 @@ class BatchModeTransformer {
      * Instantiate underlying llvm function with specified fn info.
      */
     Status InstantiateLLVMFunction(const FnInfo& fn_info);
+    Status InstantiateLLVMBatchFunction(const FnInfo& fn_info);
 
     Status GenWindowJoinList(PhysicalWindowAggrerationNode* window_agg_op,
                              PhysicalOpNode* in);
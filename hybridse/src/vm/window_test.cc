@@ -630,6 +630,77 @@ TEST_F(WindowIteratorTest, PureHistoryWindowTest) {
     window.BufferData(1590739001000, row);
     window.BufferData(1590739002000, row);
 }
+// sum the keys of the window incrementally
+static void CheckWindowAggState(Window* window, const int8_t* key) {
+    int8_t* state = nullptr;
+    std::unique_ptr<RowIterator> evicted_iter;
+    std::unique_ptr<RowIterator> added_iter;
+    bool carried = window->BindAggState(key, sizeof(int64_t), &state,
+                                        &evicted_iter, &added_iter);
+    int64_t* sum = reinterpret_cast<int64_t*>(state);
+    if (carried) {
+        for (; evicted_iter->Valid(); evicted_iter->Next()) {
+            *sum -= evicted_iter->GetKey();
+        }
+    } else {
+        *sum = 0;
+    }
+    for (; added_iter->Valid(); added_iter->Next()) {
+        *sum += added_iter->GetKey();
+    }
+    int64_t expect = 0;
+    auto iter = window->GetIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        expect += iter->GetKey();
+    }
+    ASSERT_EQ(expect, *sum);
+}
+
+TEST_F(WindowIteratorTest, WindowAggStateTest) {
+    int8_t* ptr = reinterpret_cast<int8_t*>(malloc(28));
+    *(reinterpret_cast<int32_t*>(ptr + 2)) = 1;
+    *(reinterpret_cast<int64_t*>(ptr + 2 + 4)) = 1;
+    Row row(base::RefCountedSlice::Create(ptr, 28));
+    int8_t key1 = 0;
+    int8_t key2 = 0;
+    {
+        vm::CurrentHistoryWindow window(vm::Window::kFrameRowsRange, -5L, 0);
+        for (uint64_t ts = 1; ts < 50; ts++) {
+            window.BufferData(ts, row);
+            CheckWindowAggState(&window, &key1);
+            // bound less often, the evicted rows are kept for it
+            if (ts % 7 == 0) {
+                CheckWindowAggState(&window, &key2);
+            }
+        }
+    }
+    {
+        // the rows of the current time are popped from the front
+        vm::CurrentHistoryWindow window(vm::Window::kFrameRowsRange, -5L, 0);
+        window.set_exclude_current_time(true);
+        for (uint64_t ts = 1; ts < 50; ts++) {
+            window.BufferData(ts / 3, row);
+            CheckWindowAggState(&window, &key1);
+            if (ts % 4 == 0) {
+                CheckWindowAggState(&window, &key2);
+            }
+        }
+    }
+    {
+        // the instance rows are popped after the aggregation
+        vm::CurrentHistoryWindow window(vm::Window::kFrameRowsRange, -10L, 3);
+        window.set_instance_not_in_window(true);
+        for (uint64_t ts = 1; ts < 50; ts++) {
+            window.BufferData(ts, row);
+            if (ts % 2 == 0) {
+                window.BufferData(ts, row);
+                CheckWindowAggState(&window, &key1);
+                window.PopFrontData();
+            }
+        }
+    }
+}
+
 TEST_F(WindowIteratorTest, PureHistoryWindowWithMaxSizeTest) {
     std::vector<std::pair<uint64_t, Row>> rows;
     int8_t* ptr = reinterpret_cast<int8_t*>(malloc(28));
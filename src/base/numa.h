@@ -0,0 +1,191 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_NUMA_H_
+#define SRC_BASE_NUMA_H_
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace openmldb {
+namespace base {
+
+// the numa nodes and their cpus read from sysfs, so libnuma is not required
+class NumaTopology {
+ public:
+    NumaTopology() {}
+
+    // the topology of this machine, which has one node if sysfs is not available
+    static const NumaTopology& Get() {
+        static const NumaTopology topology = Load("/sys/devices/system/node");
+        return topology;
+    }
+
+    // load from the directory of node<N>/cpulist files
+    static NumaTopology Load(const std::string& dir) {
+        NumaTopology topology;
+        DIR* dp = opendir(dir.c_str());
+        if (dp != NULL) {
+            struct dirent* entry = NULL;
+            while ((entry = readdir(dp)) != NULL) {
+                std::string name(entry->d_name);
+                if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+                    name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                    continue;
+                }
+                uint32_t node = strtoul(name.c_str() + 4, NULL, 10);
+                std::ifstream file(dir + "/" + name + "/cpulist");
+                std::string cpulist;
+                std::vector<int> cpus;
+                if (!std::getline(file, cpulist) || !ParseCpuList(cpulist, &cpus)) {
+                    continue;
+                }
+                if (topology.node_cpus_.size() <= node) {
+                    topology.node_cpus_.resize(node + 1);
+                }
+                topology.node_cpus_[node] = cpus;
+                for (int cpu : cpus) {
+                    if (topology.cpu_nodes_.size() <= static_cast<uint32_t>(cpu)) {
+                        topology.cpu_nodes_.resize(cpu + 1, -1);
+                    }
+                    topology.cpu_nodes_[cpu] = node;
+                }
+            }
+            closedir(dp);
+        }
+        if (topology.node_cpus_.empty()) {
+            topology.node_cpus_.resize(1);
+        }
+        return topology;
+    }
+
+    // parse the list like "0-3,8,10-11"
+    static bool ParseCpuList(const std::string& str, std::vector<int>* cpus) {
+        cpus->clear();
+        size_t pos = 0;
+        while (pos < str.size() && str[pos] != '\n') {
+            char* end = NULL;
+            long first = strtol(str.c_str() + pos, &end, 10);  // NOLINT
+            if (end == str.c_str() + pos || first < 0) {
+                return false;
+            }
+            long last = first;  // NOLINT
+            pos = end - str.c_str();
+            if (pos < str.size() && str[pos] == '-') {
+                last = strtol(str.c_str() + pos + 1, &end, 10);
+                if (end == str.c_str() + pos + 1 || last < first) {
+                    return false;
+                }
+                pos = end - str.c_str();
+            }
+            for (long cpu = first; cpu <= last; cpu++) {  // NOLINT
+                cpus->push_back(cpu);
+            }
+            if (pos < str.size() && str[pos] == ',') {
+                pos++;
+            }
+        }
+        return !cpus->empty();
+    }
+
+    inline uint32_t GetNodeCnt() const { return node_cpus_.size(); }
+
+    // return -1 if the cpu is unknown
+    inline int GetNode(int cpu) const {
+        if (cpu < 0 || static_cast<uint32_t>(cpu) >= cpu_nodes_.size()) {
+            return -1;
+        }
+        return cpu_nodes_[cpu];
+    }
+
+    inline const std::vector<int>& GetCpus(uint32_t node) const { return node_cpus_[node]; }
+
+ private:
+    std::vector<std::vector<int>> node_cpus_;
+    std::vector<int> cpu_nodes_;
+};
+
+// the node of the cpu running the current thread, -1 if unknown
+inline int GetCurrentNumaNode() { return NumaTopology::Get().GetNode(sched_getcpu()); }
+
+// run the current thread only on the cpus of the node
+inline bool PinThreadToNumaNode(int node) {
+    const auto& topology = NumaTopology::Get();
+    if (node < 0 || static_cast<uint32_t>(node) >= topology.GetNodeCnt() || topology.GetCpus(node).empty()) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : topology.GetCpus(node)) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+}
+
+// pin the current thread to the node in the scope, and restore the cpus it ran on before
+class ScopedNumaPin {
+ public:
+    // do nothing if node is negative
+    explicit ScopedNumaPin(int node) : pinned_(false) {
+        CPU_ZERO(&old_cpu_set_);
+        if (node >= 0 && pthread_getaffinity_np(pthread_self(), sizeof(old_cpu_set_), &old_cpu_set_) == 0) {
+            pinned_ = PinThreadToNumaNode(node);
+        }
+    }
+
+    ~ScopedNumaPin() {
+        if (pinned_) {
+            pthread_setaffinity_np(pthread_self(), sizeof(old_cpu_set_), &old_cpu_set_);
+        }
+    }
+
+    inline bool IsPinned() const { return pinned_; }
+
+    ScopedNumaPin(const ScopedNumaPin&) = delete;
+    ScopedNumaPin& operator=(const ScopedNumaPin&) = delete;
+
+ private:
+    cpu_set_t old_cpu_set_;
+    bool pinned_;
+};
+
+// prefer the node for the pages of a mapping which are not touched yet. the policy belongs to
+// the mapping, so addr and len should cover a whole mapping of its own, e.g. from mmap
+inline bool BindMemoryToNumaNode(void* addr, size_t len, int node) {
+    // the value of MPOL_PREFERRED in numaif.h
+    const int mode = 1;
+    if (node < 0 || node >= 64 || static_cast<uint32_t>(node) >= NumaTopology::Get().GetNodeCnt()) {
+        return false;
+    }
+    unsigned long mask = 1ul << node;  // NOLINT
+    return syscall(SYS_mbind, addr, len, mode, &mask, sizeof(mask) * 8 + 1, 0) == 0;
+}
+
+}  // namespace base
+}  // namespace openmldb
+
+#endif  // SRC_BASE_NUMA_H_
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/numa.h"
+
+#include <stdio.h>
+
+#include "base/file_util.h"
+#include "base/slab.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace base {
+
+class NumaTest : public ::testing::Test {
+ public:
+    NumaTest() {}
+    ~NumaTest() {}
+};
+
+TEST_F(NumaTest, ParseCpuList) {
+    std::vector<int> cpus;
+    ASSERT_TRUE(NumaTopology::ParseCpuList("0-3,8,10-11\n", &cpus));
+    ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}), cpus);
+    ASSERT_TRUE(NumaTopology::ParseCpuList("5", &cpus));
+    ASSERT_EQ(std::vector<int>({5}), cpus);
+    ASSERT_FALSE(NumaTopology::ParseCpuList("", &cpus));
+    ASSERT_FALSE(NumaTopology::ParseCpuList("3-1", &cpus));
+    ASSERT_FALSE(NumaTopology::ParseCpuList("a", &cpus));
+}
+
+TEST_F(NumaTest, Load) {
+    std::string dir = "/tmp/gtest/numa_test";
+    ASSERT_TRUE(MkdirRecur(dir + "/node0/"));
+    ASSERT_TRUE(MkdirRecur(dir + "/node1/"));
+    ASSERT_TRUE(MkdirRecur(dir + "/power/"));
+    FILE* f = fopen((dir + "/node0/cpulist").c_str(), "w");
+    ASSERT_TRUE(f != NULL);
+    fputs("0-1,4\n", f);
+    fclose(f);
+    f = fopen((dir + "/node1/cpulist").c_str(), "w");
+    ASSERT_TRUE(f != NULL);
+    fputs("2-3\n", f);
+    fclose(f);
+    NumaTopology topology = NumaTopology::Load(dir);
+    ASSERT_EQ(2u, topology.GetNodeCnt());
+    ASSERT_EQ(0, topology.GetNode(4));
+    ASSERT_EQ(1, topology.GetNode(3));
+    ASSERT_EQ(-1, topology.GetNode(5));
+    ASSERT_EQ(std::vector<int>({2, 3}), topology.GetCpus(1));
+    // no numa info
+    ASSERT_EQ(1u, NumaTopology::Load("/tmp/gtest/not_exist").GetNodeCnt());
+}
+
+TEST_F(NumaTest, Bind) {
+    const auto& topology = NumaTopology::Get();
+    ASSERT_GE(topology.GetNodeCnt(), 1u);
+    ASSERT_FALSE(PinThreadToNumaNode(topology.GetNodeCnt()));
+    if (PinThreadToNumaNode(0)) {
+        ASSERT_EQ(0, GetCurrentNumaNode());
+    }
+    // the slabs are still allocated if the memory can not be bound
+    SlabArena arena(4096, 0);
+    ASSERT_EQ(0, arena.GetNumaNode());
+    char* ptr = reinterpret_cast<char*>(arena.Allocate(100));
+    ASSERT_TRUE(ptr != NULL);
+    memset(ptr, 1, 100);
+    char* large = reinterpret_cast<char*>(arena.Allocate(8192));
+    ASSERT_TRUE(large != NULL);
+    memset(large, 1, 8192);
+    SlabArena::Free(ptr);
+    SlabArena::Free(large);
+    // the dedicated slab of the large object is released, the current one is kept
+    ASSERT_EQ(1u, arena.GetSlabCnt());
+}
+
+TEST_F(NumaTest, SlabPool) {
+    ASSERT_TRUE(NumaSlabPool::Get(0) != NULL);
+    ASSERT_TRUE(NumaSlabPool::Get(-1) == NULL);
+    ASSERT_TRUE(NumaSlabPool::Get(NumaTopology::Get().GetNodeCnt()) == NULL);
+    SlabArena arena(4096, 0);
+    std::vector<char*> ptrs;
+    for (uint32_t i = 0; i < 1000; i++) {
+        char* ptr = reinterpret_cast<char*>(arena.Allocate(1000));
+        ASSERT_TRUE(ptr != NULL);
+        memset(ptr, 1, 1000);
+        ptrs.push_back(ptr);
+    }
+    // the object no larger than a slab shares the slabs with the small ones
+    char* medium = reinterpret_cast<char*>(arena.Allocate(3000));
+    ASSERT_TRUE(medium != NULL);
+    memset(medium, 1, 3000);
+    ptrs.push_back(medium);
+    uint64_t slab_cnt = arena.GetSlabCnt();
+    ASSERT_GT(slab_cnt, 200u);
+    // the slabs are carved from the regions instead of a mapping for each
+    uint64_t region_cnt = NumaSlabPool::Get(0)->GetRegionCnt();
+    ASSERT_GE(region_cnt, 1u);
+    ASSERT_LT(region_cnt, slab_cnt);
+    for (auto ptr : ptrs) {
+        SlabArena::Free(ptr);
+    }
+    ASSERT_EQ(1u, arena.GetSlabCnt());
+    // the freed slabs are reused
+    ptrs.clear();
+    for (uint32_t i = 0; i < 1000; i++) {
+        char* ptr = reinterpret_cast<char*>(arena.Allocate(1000));
+        ASSERT_TRUE(ptr != NULL);
+        memset(ptr, 2, 1000);
+        ptrs.push_back(ptr);
+    }
+    ASSERT_EQ(region_cnt, NumaSlabPool::Get(0)->GetRegionCnt());
+    for (auto ptr : ptrs) {
+        SlabArena::Free(ptr);
+    }
+}
+
+TEST_F(NumaTest, ScopedPin) {
+    cpu_set_t before;
+    ASSERT_EQ(0, pthread_getaffinity_np(pthread_self(), sizeof(before), &before));
+    {
+        ScopedNumaPin pin(-1);
+        ASSERT_FALSE(pin.IsPinned());
+    }
+    {
+        ScopedNumaPin pin(0);
+        if (pin.IsPinned()) {
+            ASSERT_EQ(0, GetCurrentNumaNode());
+        }
+    }
+    // the cpus are restored after the scope
+    cpu_set_t after;
+    ASSERT_EQ(0, pthread_getaffinity_np(pthread_self(), sizeof(after), &after));
+    ASSERT_TRUE(CPU_EQUAL(&before, &after));
+}
+
+}  // namespace base
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
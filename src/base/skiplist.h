@@ -24,6 +24,7 @@
 #include <iostream>
 
 #include "base/random.h"
+#include "base/slab.h"
 
 namespace openmldb {
 namespace base {
@@ -45,14 +46,41 @@ class Node {
  public:
     // Set data reference and Node height
     Node(const K& key, V& value, uint8_t height)  // NOLINT
-        : height_(height), key_(key), value_(value) {
+        : height_(height), in_arena_(false), key_(key), value_(value) {
         nexts_ = new std::atomic<Node<K, V>*>[height];
     }
 
-    Node(uint8_t height) : height_(height), key_(), value_() {  // NOLINT
+    Node(uint8_t height) : height_(height), in_arena_(false), key_(), value_() {  // NOLINT
         nexts_ = new std::atomic<Node<K, V>*>[height];
     }
 
+    // Node and its next pointers in one arena allocation
+    static Node<K, V>* NewInArena(SlabArena* arena, const K& key, V& value, uint8_t height) {  // NOLINT
+        char* mem =
+            reinterpret_cast<char*>(arena->Allocate(sizeof(Node<K, V>) + sizeof(std::atomic<Node<K, V>*>) * height));
+        if (mem == NULL) {
+            return NULL;
+        }
+        auto* nexts = reinterpret_cast<std::atomic<Node<K, V>*>*>(mem + sizeof(Node<K, V>));
+        for (uint8_t i = 0; i < height; i++) {
+            new (&nexts[i]) std::atomic<Node<K, V>*>(NULL);
+        }
+        return new (mem) Node<K, V>(key, value, height, nexts);
+    }
+
+    // Free the node which is created by new or NewInArena
+    static void Delete(Node<K, V>* node) {
+        if (node == NULL) {
+            return;
+        }
+        if (node->in_arena_) {
+            node->~Node<K, V>();
+            SlabArena::Free(node);
+        } else {
+            delete node;
+        }
+    }
+
     // Set the next node with memory barrier
     void SetNext(uint8_t level, Node<K, V>* node) {
         assert(level < height_ && level >= 0);
@@ -81,10 +109,19 @@ class Node {
 
     const K& GetKey() const { return key_; }
 
-    ~Node() { delete[] nexts_; }
+    ~Node() {
+        if (!in_arena_) {
+            delete[] nexts_;
+        }
+    }
+
+ private:
+    Node(const K& key, V& value, uint8_t height, std::atomic<Node<K, V>*>* nexts)  // NOLINT
+        : height_(height), in_arena_(true), key_(key), value_(value), nexts_(nexts) {}
 
  private:
     uint8_t const height_;
+    bool const in_arena_;
     K const key_;
     V value_;
     std::atomic<Node<K, V>*>* nexts_;
@@ -109,8 +146,10 @@ class Skiplist {
     }
     ~Skiplist() { delete head_; }
 
-    // Insert need external synchronized
-    uint8_t Insert(const K& key, V& value) {  // NOLINT
+    // Insert need external synchronized. The node is allocated from arena if
+    // it is not NULL and returned by inserted if it is not NULL
+    uint8_t Insert(const K& key, V& value, SlabArena* arena = NULL,  // NOLINT
+                   Node<K, V>** inserted = NULL) {
         uint8_t height = RandomHeight();
         Node<K, V>* pre[MaxHeight];
         FindLessOrEqual(key, pre);
@@ -120,7 +159,7 @@ class Skiplist {
             }
             max_height_.store(height, std::memory_order_relaxed);
         }
-        Node<K, V>* node = NewNode(key, value, height);
+        Node<K, V>* node = NewNode(key, value, height, arena);
         if (pre[0]->GetNext(0) == NULL) {
             tail_.store(node, std::memory_order_release);
         }
@@ -128,6 +167,9 @@ class Skiplist {
             node->SetNextNoBarrier(i, pre[i]->GetNextNoBarrier(i));
             pre[i]->SetNext(i, node);
         }
+        if (inserted != NULL) {
+            *inserted = node;
+        }
         return height;
     }
 
@@ -286,7 +328,7 @@ class Skiplist {
             for (uint8_t i = 0; i < tmp->Height(); i++) {
                 tmp->SetNextNoBarrier(i, NULL);
             }
-            delete tmp;
+            Node<K, V>::Delete(tmp);
         }
         return cnt;
     }
@@ -363,7 +405,13 @@ class Skiplist {
     Iterator* NewIterator() { return new Iterator(this); }
 
  private:
-    Node<K, V>* NewNode(const K& key, V& value, uint8_t height) {  // NOLINT
+    Node<K, V>* NewNode(const K& key, V& value, uint8_t height, SlabArena* arena = NULL) {  // NOLINT
+        if (arena != NULL) {
+            Node<K, V>* node = Node<K, V>::NewInArena(arena, key, value, height);
+            if (node != NULL) {
+                return node;
+            }
+        }
         Node<K, V>* node = new Node<K, V>(key, value, height);
         return node;
     }
@@ -663,6 +663,61 @@ TEST_F(SkiplistTest, Duplicate) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SkiplistTest, InsertWithArena) {
+    DescComparator cmp;
+    SlabArena* arena = new SlabArena(4096);
+    Skiplist<uint32_t, uint32_t, DescComparator>* sl = new Skiplist<uint32_t, uint32_t, DescComparator>(12, 4, cmp);
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t value = i * 2;
+        sl->Insert(i, value, arena);
+    }
+    ASSERT_EQ(1000u, sl->GetSize());
+    ASSERT_GT(arena->GetSlabCnt(), 1u);
+    uint32_t value = 0;
+    ASSERT_EQ(0, sl->Get(500, value));
+    ASSERT_EQ(1000u, value);
+    Node<uint32_t, uint32_t>* node = sl->Split(500);
+    uint32_t cnt = 0;
+    while (node != NULL) {
+        Node<uint32_t, uint32_t>* tmp = node;
+        node = node->GetNextNoBarrier(0);
+        Node<uint32_t, uint32_t>::Delete(tmp);
+        cnt++;
+    }
+    ASSERT_EQ(501u, cnt);
+    ASSERT_EQ(499u, sl->GetSize());
+    // nodes may outlive arena
+    delete arena;
+    ASSERT_EQ(0, sl->Get(999, value));
+    ASSERT_EQ(1998u, value);
+    ASSERT_EQ(499u, sl->Clear());
+    delete sl;
+}
+
+TEST_F(SkiplistTest, SlabArena) {
+    SlabArena arena(4096);
+    ASSERT_EQ(0u, arena.GetSlabCnt());
+    std::vector<void*> ptrs;
+    for (uint32_t i = 0; i < 100; i++) {
+        void* ptr = arena.Allocate(100);
+        ASSERT_TRUE(ptr != NULL);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % 8);
+        ptrs.push_back(ptr);
+    }
+    uint64_t slab_cnt = arena.GetSlabCnt();
+    ASSERT_GT(slab_cnt, 1u);
+    // large object has its own slab
+    void* large = arena.Allocate(4096);
+    ASSERT_EQ(slab_cnt + 1, arena.GetSlabCnt());
+    SlabArena::Free(large);
+    ASSERT_EQ(slab_cnt, arena.GetSlabCnt());
+    for (auto ptr : ptrs) {
+        SlabArena::Free(ptr);
+    }
+    // the current slab is hold by arena
+    ASSERT_EQ(1u, arena.GetSlabCnt());
+}
+
 }  // namespace base
 }  // namespace openmldb
 
@@ -0,0 +1,327 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_SLAB_H_
+#define SRC_BASE_SLAB_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <new>
+#include <vector>
+
+#include "base/numa.h"
+#include "base/spinlock.h"
+
+namespace openmldb {
+namespace base {
+
+struct SlabStat {
+    SlabStat() : slab_cnt(0), slab_byte_size(0) {}
+    std::atomic<uint64_t> slab_cnt;
+    std::atomic<uint64_t> slab_byte_size;
+};
+
+// NumaSlabPool carves the slabs of a numa node from large regions bound to
+// the node, so creating a slab is not a mmap plus mbind and the mappings of
+// the process do not grow with the slabs. A freed slab keeps its address
+// range for the next slab of the same size and its pages go back to the os.
+class NumaSlabPool {
+ public:
+    // the pool of the node, NULL if the node does not exist. the pools are
+    // never deleted as the slabs may be freed by the static destructors
+    static NumaSlabPool* Get(int numa_node) {
+        static const std::vector<NumaSlabPool*> pools = NewPools();
+        if (numa_node < 0 || static_cast<uint32_t>(numa_node) >= pools.size()) {
+            return NULL;
+        }
+        return pools[numa_node];
+    }
+
+    // size is a multiple of pages. return NULL if there is no memory
+    char* Allocate(size_t size) {
+        if (size > MAX_POOLED_SIZE) {
+            return MapRegion(size);
+        }
+        std::lock_guard<std::mutex> lock(mu_);
+        std::vector<char*>& free_list = free_slabs_[size];
+        if (!free_list.empty()) {
+            char* ptr = free_list.back();
+            free_list.pop_back();
+            return ptr;
+        }
+        if (region_ == NULL || REGION_SIZE - region_used_ < size) {
+            // the tail of the former region is left unused
+            char* region = MapRegion(REGION_SIZE);
+            if (region == NULL) {
+                return NULL;
+            }
+            region_ = region;
+            region_used_ = 0;
+            region_cnt_.fetch_add(1, std::memory_order_relaxed);
+        }
+        char* ptr = region_ + region_used_;
+        region_used_ += size;
+        return ptr;
+    }
+
+    void Free(char* ptr, size_t size) {
+        if (size > MAX_POOLED_SIZE) {
+            munmap(ptr, size);
+            return;
+        }
+        // the range stays in the region, so the node policy is kept for the pages faulted in later
+        madvise(ptr, size, MADV_DONTNEED);
+        std::lock_guard<std::mutex> lock(mu_);
+        free_slabs_[size].push_back(ptr);
+    }
+
+    inline uint64_t GetRegionCnt() const { return region_cnt_.load(std::memory_order_relaxed); }
+
+ private:
+    explicit NumaSlabPool(int numa_node)
+        : numa_node_(numa_node), mu_(), region_(NULL), region_used_(0), region_cnt_(0), free_slabs_() {}
+
+    static std::vector<NumaSlabPool*> NewPools() {
+        std::vector<NumaSlabPool*> pools;
+        for (uint32_t node = 0; node < NumaTopology::Get().GetNodeCnt(); node++) {
+            pools.push_back(new NumaSlabPool(node));
+        }
+        return pools;
+    }
+
+    char* MapRegion(size_t size) {
+        void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            return NULL;
+        }
+        // best effort, the memory is still usable if it fails
+        BindMemoryToNumaNode(mem, size, numa_node_);
+        return reinterpret_cast<char*>(mem);
+    }
+
+ private:
+    static const size_t REGION_SIZE = 64 * 1024 * 1024;
+    // a larger slab is a mapping of its own
+    static const size_t MAX_POOLED_SIZE = REGION_SIZE / 16;
+    int const numa_node_;
+    std::mutex mu_;
+    char* region_;
+    size_t region_used_;
+    std::atomic<uint64_t> region_cnt_;
+    std::map<size_t, std::vector<char*>> free_slabs_;
+};
+
+// A slab is one malloc chunk that objects are bump allocated from.
+// refs_ counts the live objects plus one while the slab is still the
+// current slab of its arena, so the chunk is released as a whole when
+// the last object in it is freed.
+class Slab {
+ public:
+    // the memory prefers the numa node if it is not negative. such a slab is
+    // not in the heap, so the memory policy does not split or move the pages
+    // of the heap. it is carved from the regions of the node if pooled, which
+    // should be the slabs of the same size, or else it is a mapping of its own
+    static Slab* New(uint32_t capacity, const std::shared_ptr<SlabStat>& stat, int numa_node = -1,
+                     bool pooled = false) {
+        if (numa_node < 0) {
+            void* mem = malloc(sizeof(Slab) + capacity);
+            if (mem == NULL) {
+                return NULL;
+            }
+            return new (mem) Slab(capacity, stat, false, NULL);
+        }
+        NumaSlabPool* pool = pooled ? NumaSlabPool::Get(numa_node) : NULL;
+        if (pool != NULL) {
+            char* mem = pool->Allocate(MapSize(capacity));
+            if (mem == NULL) {
+                return NULL;
+            }
+            return new (mem) Slab(capacity, stat, true, pool);
+        }
+        void* mem = mmap(NULL, MapSize(capacity), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            return NULL;
+        }
+        // best effort, the memory is still usable if it fails
+        BindMemoryToNumaNode(mem, MapSize(capacity), numa_node);
+        return new (mem) Slab(capacity, stat, true, NULL);
+    }
+
+    // Return NULL if there is no enough space in this slab
+    char* Allocate(uint32_t size) {
+        if (capacity_ - used_ < size) {
+            return NULL;
+        }
+        char* ptr = reinterpret_cast<char*>(this) + sizeof(Slab) + used_;
+        used_ += size;
+        refs_.fetch_add(1, std::memory_order_relaxed);
+        return ptr;
+    }
+
+    inline uint32_t GetFreeSize() const { return capacity_ - used_; }
+
+    void UnRef() {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            stat_->slab_cnt.fetch_sub(1, std::memory_order_relaxed);
+            stat_->slab_byte_size.fetch_sub(sizeof(Slab) + capacity_, std::memory_order_relaxed);
+            bool mapped = mapped_;
+            NumaSlabPool* pool = pool_;
+            uint32_t capacity = capacity_;
+            this->~Slab();
+            if (pool != NULL) {
+                pool->Free(reinterpret_cast<char*>(this), MapSize(capacity));
+            } else if (mapped) {
+                munmap(this, MapSize(capacity));
+            } else {
+                free(this);
+            }
+        }
+    }
+
+ private:
+    Slab(uint32_t capacity, const std::shared_ptr<SlabStat>& stat, bool mapped, NumaSlabPool* pool)
+        : capacity_(capacity), used_(0), refs_(1), mapped_(mapped), pool_(pool), stat_(stat) {
+        stat_->slab_cnt.fetch_add(1, std::memory_order_relaxed);
+        stat_->slab_byte_size.fetch_add(sizeof(Slab) + capacity_, std::memory_order_relaxed);
+    }
+    ~Slab() {}
+
+    // the byte size of the mapping, rounded up to pages
+    static inline size_t MapSize(uint32_t capacity) {
+        static const size_t page_size = sysconf(_SC_PAGESIZE);
+        return (sizeof(Slab) + capacity + page_size - 1) / page_size * page_size;
+    }
+
+ private:
+    uint32_t const capacity_;
+    uint32_t used_;
+    std::atomic<uint32_t> refs_;
+    // allocated by mmap instead of malloc
+    bool const mapped_;
+    // the pool the memory goes back to if not NULL
+    NumaSlabPool* const pool_;
+    // the stat is shared with arena as slab may outlive its arena
+    std::shared_ptr<SlabStat> stat_;
+};
+
+// SlabArena packs small objects into large slabs. Every object carries
+// an 8 bytes header pointing to its slab, so an object can be freed from
+// any thread without knowing the arena it came from. Memory goes back to
+// the allocator only when a whole slab is empty.
+class SlabArena {
+ public:
+    // the slabs prefer the numa node if it is not negative
+    explicit SlabArena(uint32_t slab_size, int numa_node = -1)
+        : slab_size_(slab_size < 4096 ? 4096 : slab_size),
+          numa_node_(numa_node),
+          mu_(),
+          cur_(NULL),
+          stat_(std::make_shared<SlabStat>()) {}
+
+    ~SlabArena() {
+        if (cur_ != NULL) {
+            cur_->UnRef();
+            cur_ = NULL;
+        }
+    }
+
+    SlabArena(const SlabArena&) = delete;
+    SlabArena& operator=(const SlabArena&) = delete;
+
+    // thread safe
+    void* Allocate(uint32_t size) {
+        uint32_t real_size = AlignSize(size + HEADER_SIZE);
+        Slab* slab = NULL;
+        char* ptr = NULL;
+        // a numa slab is not cheap as malloc, so only the object larger than a slab is mapped for itself
+        if (real_size > slab_size_ / 4 && (numa_node_ < 0 || real_size > slab_size_)) {
+            // large object gets a dedicated slab
+            slab = Slab::New(real_size, stat_, numa_node_);
+            if (slab == NULL) {
+                return NULL;
+            }
+            ptr = slab->Allocate(real_size);
+            // drop the creation ref, the slab is owned by the object
+            slab->UnRef();
+        } else {
+            std::lock_guard<SpinMutex> lock(mu_);
+            if (cur_ != NULL) {
+                ptr = cur_->Allocate(real_size);
+            }
+            if (ptr != NULL) {
+                slab = cur_;
+            } else {
+                Slab* new_slab = Slab::New(slab_size_, stat_, numa_node_, true);
+                if (new_slab == NULL) {
+                    return NULL;
+                }
+                ptr = new_slab->Allocate(real_size);
+                slab = new_slab;
+                // keep the slab with more room as the current one
+                if (cur_ == NULL || new_slab->GetFreeSize() > cur_->GetFreeSize()) {
+                    if (cur_ != NULL) {
+                        cur_->UnRef();
+                    }
+                    cur_ = new_slab;
+                } else {
+                    new_slab->UnRef();
+                }
+            }
+        }
+        *reinterpret_cast<Slab**>(ptr) = slab;
+        return ptr + HEADER_SIZE;
+    }
+
+    // free the object allocated by any arena
+    static void Free(void* ptr) {
+        if (ptr == NULL) {
+            return;
+        }
+        Slab* slab = *reinterpret_cast<Slab**>(reinterpret_cast<char*>(ptr) - HEADER_SIZE);
+        slab->UnRef();
+    }
+
+    inline uint64_t GetSlabCnt() const { return stat_->slab_cnt.load(std::memory_order_relaxed); }
+
+    inline uint64_t GetSlabByteSize() const { return stat_->slab_byte_size.load(std::memory_order_relaxed); }
+
+    inline uint32_t GetSlabSize() const { return slab_size_; }
+
+    inline int GetNumaNode() const { return numa_node_; }
+
+ private:
+    static inline uint32_t AlignSize(uint32_t size) { return (size + 7) & ~7u; }
+
+ private:
+    static const uint32_t HEADER_SIZE = sizeof(Slab*);
+    uint32_t const slab_size_;
+    int const numa_node_;
+    SpinMutex mu_;
+    Slab* cur_;
+    std::shared_ptr<SlabStat> stat_;
+};
+
+}  // namespace base
+}  // namespace openmldb
+
+#endif  // SRC_BASE_SLAB_H_
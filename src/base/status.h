@@ -93,6 +93,7 @@ enum ReturnCode {
     kSdkEndpointDuplicate = 156,
     kProcedureAlreadyExists = 157,
     kProcedureNotFound = 158,
+    kServerIsBusy = 159,
     kNameserverIsNotLeader = 300,
     kAutoFailoverIsEnabled = 301,
     kEndpointIsNotExist = 302,
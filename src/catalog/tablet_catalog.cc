@@ -16,6 +16,9 @@
 
 #include "catalog/tablet_catalog.h"
 
+#include <bthread/bthread.h>
+#include <pthread.h>
+
 #include <map>
 #include <memory>
 #include <set>
@@ -23,6 +26,7 @@
 #include <utility>
 
 #include "catalog/distribute_iterator.h"
+#include "base/hash.h"
 #include "catalog/schema_adapter.h"
 #include "codec/list_iterator_codec.h"
 #include "glog/logging.h"
@@ -31,6 +35,31 @@ DECLARE_bool(enable_localtablet);
 namespace openmldb {
 namespace catalog {
 
+static bthread_key_t seek_key_recorder_key;
+static pthread_once_t seek_key_recorder_once = PTHREAD_ONCE_INIT;
+
+static void CreateSeekKeyRecorderKey() { bthread_key_create(&seek_key_recorder_key, nullptr); }
+
+SeekKeyRecorder* SeekKeyRecorder::Current() {
+    pthread_once(&seek_key_recorder_once, CreateSeekKeyRecorderKey);
+    return static_cast<SeekKeyRecorder*>(bthread_getspecific(seek_key_recorder_key));
+}
+
+void SeekKeyRecorder::SetCurrent(SeekKeyRecorder* recorder) {
+    pthread_once(&seek_key_recorder_once, CreateSeekKeyRecorderKey);
+    // bthread local, the recorder is kept if the bthread is moved to another worker
+    bthread_setspecific(seek_key_recorder_key, recorder);
+}
+
+uint64_t SeekKeyRecorder::Hash(const std::string& db, const std::string& table, const std::string& key) {
+    std::string combined;
+    combined.reserve(db.size() + table.size() + key.size() + 2);
+    combined.append(db).push_back('\0');
+    combined.append(table).push_back('\0');
+    combined.append(key);
+    return ::openmldb::base::MurmurHash64A(combined.c_str(), combined.size(), 0xe17a1465);
+}
+
 TabletTableHandler::TabletTableHandler(const ::openmldb::api::TableMeta& meta,
                                        std::shared_ptr<hybridse::vm::Tablet> local_tablet)
     : schema_(),
@@ -108,6 +137,7 @@ bool TabletTableHandler::Init(const ClientManager& client_manager) {
 }
 
 std::unique_ptr<::hybridse::codec::RowIterator> TabletTableHandler::GetIterator() {
+    RecordTable();
     auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
     if (!tables->empty()) {
         return std::unique_ptr<catalog::FullTableIterator>(new catalog::FullTableIterator(tables));
@@ -130,6 +160,13 @@ std::unique_ptr<::hybridse::codec::WindowIterator> TabletTableHandler::GetWindow
     return std::unique_ptr<::hybridse::codec::WindowIterator>();
 }
 
+void TabletTableHandler::RecordTable() {
+    auto* recorder = SeekKeyRecorder::Current();
+    if (recorder != nullptr) {
+        recorder->Add(GetDatabase(), GetName(), "");
+    }
+}
+
 // TODO(chenjing): 基于segment 优化Get(int pos) 操作
 const ::hybridse::codec::Row TabletTableHandler::Get(int32_t pos) {
     auto iter = GetIterator();
@@ -140,6 +177,7 @@ const ::hybridse::codec::Row TabletTableHandler::Get(int32_t pos) {
 }
 
 ::hybridse::codec::RowIterator* TabletTableHandler::GetRawIterator() {
+    RecordTable();
     auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
     if (!tables->empty()) {
         return new catalog::FullTableIterator(tables);
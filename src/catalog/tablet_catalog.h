@@ -38,6 +38,31 @@ class TabletPartitionHandler;
 class TabletTableHandler;
 class TabletSegmentHandler;
 
+// collect the keys read by the handlers in the current bthread, so that the cached results of procedures can be
+// invalidated by the puts to the keys their runs read
+class SeekKeyRecorder {
+ public:
+    SeekKeyRecorder() : keys_() {}
+
+    // null if no recorder is set in the current bthread
+    static SeekKeyRecorder* Current();
+
+    // set null to stop recording
+    static void SetCurrent(SeekKeyRecorder* recorder);
+
+    // the key is empty if the whole table is read
+    static uint64_t Hash(const std::string& db, const std::string& table, const std::string& key);
+
+    void Add(const std::string& db, const std::string& table, const std::string& key) {
+        keys_.push_back(Hash(db, table, key));
+    }
+
+    const std::vector<uint64_t>& GetKeys() const { return keys_; }
+
+ private:
+    std::vector<uint64_t> keys_;
+};
+
 class TabletSegmentHandler : public ::hybridse::vm::TableHandler {
  public:
     TabletSegmentHandler(std::shared_ptr<::hybridse::vm::PartitionHandler> partition_handler, const std::string &key)
@@ -58,6 +83,7 @@ class TabletSegmentHandler : public ::hybridse::vm::TableHandler {
     const ::hybridse::vm::OrderType GetOrderType() const override { return partition_handler_->GetOrderType(); }
 
     std::unique_ptr<::hybridse::vm::RowIterator> GetIterator() override {
+        RecordKey();
         auto iter = partition_handler_->GetWindowIterator();
         if (iter) {
             DLOG(INFO) << "seek to pk " << key_;
@@ -72,6 +98,7 @@ class TabletSegmentHandler : public ::hybridse::vm::TableHandler {
     }
 
     ::hybridse::vm::RowIterator *GetRawIterator() override {
+        RecordKey();
         auto iter = partition_handler_->GetWindowIterator();
         if (iter) {
             DLOG(INFO) << "seek to pk " << key_;
@@ -111,6 +138,13 @@ class TabletSegmentHandler : public ::hybridse::vm::TableHandler {
     const std::string GetHandlerTypeName() override { return "TabletSegmentHandler"; }
 
  private:
+    void RecordKey() {
+        auto *recorder = SeekKeyRecorder::Current();
+        if (recorder != nullptr) {
+            recorder->Add(partition_handler_->GetDatabase(), partition_handler_->GetName(), key_);
+        }
+    }
+
     std::shared_ptr<::hybridse::vm::PartitionHandler> partition_handler_;
     std::string key_;
 };
@@ -221,6 +255,9 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
         return -1;
     }
 
+    // record the read of the whole table
+    void RecordTable();
+
  private:
     ::hybridse::vm::Schema schema_;
     ::openmldb::storage::TableSt table_st_;
@@ -180,6 +180,31 @@ TEST_F(TabletCatalogTest, segment_handler_test) {
     delete args;
 }
 
+TEST_F(TabletCatalogTest, seek_key_recorder_test) {
+    TestArgs *args = PrepareTable("t1");
+    auto handler = std::shared_ptr<TabletTableHandler>(
+        new TabletTableHandler(args->meta[0], std::shared_ptr<hybridse::vm::Tablet>()));
+    ClientManager client_manager;
+    ASSERT_TRUE(handler->Init(client_manager));
+    handler->AddTable(args->tables[0]);
+    auto partition = handler->GetPartition(args->idx_name);
+    // nothing is recorded without a recorder
+    ASSERT_TRUE(partition->GetSegment(args->pk)->GetIterator());
+    SeekKeyRecorder recorder;
+    SeekKeyRecorder::SetCurrent(&recorder);
+    ASSERT_EQ(&recorder, SeekKeyRecorder::Current());
+    ASSERT_TRUE(partition->GetSegment(args->pk)->GetIterator());
+    ASSERT_FALSE(partition->GetSegment("KEY_NOT_EXIST")->GetIterator());
+    ASSERT_TRUE(handler->GetIterator());
+    SeekKeyRecorder::SetCurrent(nullptr);
+    ASSERT_TRUE(SeekKeyRecorder::Current() == nullptr);
+    const std::string &db = handler->GetDatabase();
+    std::vector<uint64_t> keys = {SeekKeyRecorder::Hash(db, "t1", args->pk),
+                                  SeekKeyRecorder::Hash(db, "t1", "KEY_NOT_EXIST"), SeekKeyRecorder::Hash(db, "t1", "")};
+    ASSERT_EQ(keys, recorder.GetKeys());
+    delete args;
+}
+
 TEST_F(TabletCatalogTest, segment_handler_pk_not_exist_test) {
     TestArgs *args = PrepareTable("t1");
     auto handler = std::shared_ptr<TabletTableHandler>(
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "client/stream_kv_iterator.h"
+
+#include <mutex>  // NOLINT
+#include <utility>
+
+#include "base/endianconv.h"
+#include "base/glog_wapper.h"
+
+namespace openmldb {
+namespace client {
+
+StreamKvIterator::StreamKvIterator(bool has_pk, uint32_t max_pending_chunks)
+    : has_pk_(has_pk),
+      max_pending_chunks_(max_pending_chunks == 0 ? 1 : max_pending_chunks),
+      stream_id_(brpc::INVALID_STREAM_ID),
+      mu_(),
+      cv_(),
+      chunks_(),
+      finished_(false),
+      closed_(false),
+      stopping_(false),
+      code_(0),
+      msg_(),
+      buf_(),
+      valid_(false),
+      started_(false),
+      time_(0),
+      pk_(),
+      value_(),
+      count_(0) {}
+
+StreamKvIterator::~StreamKvIterator() {
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (stream_id_ == brpc::INVALID_STREAM_ID) {
+        return;
+    }
+    brpc::StreamClose(stream_id_);
+    // the handler must outlive the stream
+    std::unique_lock<bthread::Mutex> lock(mu_);
+    while (!closed_) {
+        cv_.wait(lock);
+    }
+}
+
+int StreamKvIterator::on_received_messages(brpc::StreamId id, butil::IOBuf* const messages[], size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        char type = 0;
+        if (messages[i]->cut1(&type) != 0) {
+            continue;
+        }
+        std::unique_lock<bthread::Mutex> lock(mu_);
+        if (type == kStreamData) {
+            // hold the message until a chunk is consumed, so that the window of the stream
+            // is not released and the tablet waits for us
+            while (!stopping_ && chunks_.size() >= max_pending_chunks_) {
+                cv_.wait(lock);
+            }
+            if (stopping_) {
+                continue;
+            }
+            chunks_.emplace_back();
+            chunks_.back().swap(*messages[i]);
+        } else if (type == kStreamEnd) {
+            int32_t code = -1;
+            if (messages[i]->cutn(&code, sizeof(code)) == sizeof(code)) {
+                memrev32ifbe(&code);
+            }
+            code_ = code;
+            msg_ = messages[i]->to_string();
+            finished_ = true;
+        } else {
+            PDLOG(WARNING, "unknown stream message type %d", type);
+            continue;
+        }
+        cv_.notify_all();
+    }
+    return 0;
+}
+
+void StreamKvIterator::on_idle_timeout(brpc::StreamId id) {}
+
+void StreamKvIterator::on_closed(brpc::StreamId id) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    closed_ = true;
+    cv_.notify_all();
+}
+
+bool StreamKvIterator::NextChunk() {
+    std::unique_lock<bthread::Mutex> lock(mu_);
+    while (chunks_.empty() && !finished_ && !closed_) {
+        cv_.wait(lock);
+    }
+    if (chunks_.empty()) {
+        return false;
+    }
+    buf_.swap(chunks_.front());
+    chunks_.pop_front();
+    cv_.notify_all();
+    return true;
+}
+
+bool StreamKvIterator::ParseRecord() {
+    while (buf_.empty()) {
+        if (!NextChunk()) {
+            return false;
+        }
+    }
+    // a record never crosses two chunks
+    uint32_t total_size = 0;
+    uint32_t pk_size = 0;
+    if (buf_.cutn(&total_size, 4) != 4) {
+        return false;
+    }
+    memrev32ifbe(&total_size);
+    if (has_pk_) {
+        if (buf_.cutn(&pk_size, 4) != 4) {
+            return false;
+        }
+        memrev32ifbe(&pk_size);
+    }
+    if (total_size < 8 + pk_size || buf_.cutn(&time_, 8) != 8) {
+        PDLOG(WARNING, "invalid record in stream. total size %u pk size %u", total_size, pk_size);
+        return false;
+    }
+    memrev64ifbe(&time_);
+    pk_.clear();
+    value_.clear();
+    if (has_pk_ && buf_.cutn(&pk_, pk_size) != pk_size) {
+        return false;
+    }
+    uint32_t value_size = total_size - 8 - pk_size;
+    if (buf_.cutn(&value_, value_size) != value_size) {
+        return false;
+    }
+    count_++;
+    return true;
+}
+
+bool StreamKvIterator::Valid() {
+    if (!started_) {
+        started_ = true;
+        valid_ = ParseRecord();
+    }
+    return valid_;
+}
+
+void StreamKvIterator::Next() {
+    if (!started_) {
+        Valid();
+    }
+    if (valid_) {
+        valid_ = ParseRecord();
+    }
+}
+
+int32_t StreamKvIterator::GetCode() {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    if (!finished_) {
+        return -1;
+    }
+    return code_;
+}
+
+}  // namespace client
+}  // namespace openmldb
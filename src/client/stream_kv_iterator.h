@@ -0,0 +1,106 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_CLIENT_STREAM_KV_ITERATOR_H_
+#define SRC_CLIENT_STREAM_KV_ITERATOR_H_
+
+#include <brpc/stream.h>
+#include <bthread/condition_variable.h>
+#include <bthread/mutex.h>
+
+#include <deque>
+#include <string>
+
+#include "base/slice.h"
+#include "butil/iobuf.h"
+
+namespace openmldb {
+namespace client {
+
+// the first byte of every message of a streaming scan/traverse.
+// a data message carries records encoded as the pairs of ScanResponse/TraverseResponse,
+// the end message carries the int32 return code followed by the error msg
+enum StreamMsgType : char {
+    kStreamData = 1,
+    kStreamEnd = 2,
+};
+
+// iterate the records pushed by the tablet through a brpc stream. the chunks are
+// decoded lazily and at most max_pending_chunks of them are buffered, the tablet
+// stops reading the table once the window of the stream is full. the handler runs in
+// bthread, so it waits on bthread primitives which do not block the worker thread
+class StreamKvIterator : public brpc::StreamInputHandler {
+ public:
+    StreamKvIterator(bool has_pk, uint32_t max_pending_chunks);
+
+    ~StreamKvIterator();
+
+    int on_received_messages(brpc::StreamId id, butil::IOBuf* const messages[], size_t size) override;
+
+    void on_idle_timeout(brpc::StreamId id) override;
+
+    void on_closed(brpc::StreamId id) override;
+
+    void SetStreamId(brpc::StreamId id) { stream_id_ = id; }
+
+    // block until the first record is available
+    bool Valid();
+
+    void Next();
+
+    uint64_t GetKey() const { return time_; }
+
+    const std::string& GetPK() const { return pk_; }
+
+    ::openmldb::base::Slice GetValue() const { return ::openmldb::base::Slice(value_); }
+
+    // 0 if all the records have been received, or the code sent by the tablet.
+    // -1 if the stream is closed before the end message
+    int32_t GetCode();
+
+    const std::string& GetMsg() const { return msg_; }
+
+    uint64_t GetCount() const { return count_; }
+
+ private:
+    // block until a chunk arrives or the stream ends
+    bool NextChunk();
+    bool ParseRecord();
+
+ private:
+    bool has_pk_;
+    uint32_t max_pending_chunks_;
+    brpc::StreamId stream_id_;
+    bthread::Mutex mu_;
+    bthread::ConditionVariable cv_;
+    std::deque<butil::IOBuf> chunks_;
+    bool finished_;
+    bool closed_;
+    bool stopping_;
+    int32_t code_;
+    std::string msg_;
+    butil::IOBuf buf_;
+    bool valid_;
+    bool started_;
+    uint64_t time_;
+    std::string pk_;
+    std::string value_;
+    uint64_t count_;
+};
+
+}  // namespace client
+}  // namespace openmldb
+#endif  // SRC_CLIENT_STREAM_KV_ITERATOR_H_
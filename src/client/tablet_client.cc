@@ -32,6 +32,7 @@ DECLARE_int32(request_timeout_ms);
 DECLARE_uint32(latest_ttl_max);
 DECLARE_uint32(absolute_ttl_max);
 DECLARE_bool(enable_show_tp);
+DECLARE_uint32(stream_scan_client_queue_size);
 
 namespace openmldb {
 namespace client {
@@ -1040,6 +1041,58 @@ bool TabletClient::DeleteBinlog(uint32_t tid, uint32_t pid) {
     return kv_it;
 }
 
+std::shared_ptr<StreamKvIterator> TabletClient::TraverseStream(uint32_t tid, uint32_t pid,
+                                                               const std::string& idx_name, uint32_t limit,
+                                                               std::string* msg) {
+    ::openmldb::api::TraverseRequest request;
+    ::openmldb::api::TraverseResponse response;
+    request.set_tid(tid);
+    request.set_pid(pid);
+    request.set_limit(limit);
+    if (!idx_name.empty()) {
+        request.set_idx_name(idx_name);
+    }
+    auto it = std::make_shared<StreamKvIterator>(true, FLAGS_stream_scan_client_queue_size);
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+    brpc::StreamOptions options;
+    options.handler = it.get();
+    brpc::StreamId stream_id;
+    if (brpc::StreamCreate(&stream_id, cntl, &options) != 0) {
+        *msg = "fail to create stream";
+        return std::shared_ptr<StreamKvIterator>();
+    }
+    it->SetStreamId(stream_id);
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::TraverseStream, &cntl, &request, &response);
+    if (!ok || response.code() != 0) {
+        *msg = ok ? response.msg() : cntl.ErrorText();
+        return std::shared_ptr<StreamKvIterator>();
+    }
+    return it;
+}
+
+std::shared_ptr<StreamKvIterator> TabletClient::ScanStream(const ::openmldb::api::ScanRequest& request,
+                                                           std::string* msg) {
+    ::openmldb::api::ScanResponse response;
+    auto it = std::make_shared<StreamKvIterator>(false, FLAGS_stream_scan_client_queue_size);
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+    brpc::StreamOptions options;
+    options.handler = it.get();
+    brpc::StreamId stream_id;
+    if (brpc::StreamCreate(&stream_id, cntl, &options) != 0) {
+        *msg = "fail to create stream";
+        return std::shared_ptr<StreamKvIterator>();
+    }
+    it->SetStreamId(stream_id);
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::ScanStream, &cntl, &request, &response);
+    if (!ok || response.code() != 0) {
+        *msg = ok ? response.msg() : cntl.ErrorText();
+        return std::shared_ptr<StreamKvIterator>();
+    }
+    return it;
+}
+
 bool TabletClient::SetMode(bool mode) {
     ::openmldb::api::SetModeRequest request;
     ::openmldb::api::GeneralResponse response;
@@ -1052,6 +1105,17 @@ bool TabletClient::SetMode(bool mode) {
     return true;
 }
 
+bool TabletClient::SetSchedulerConfig(const ::openmldb::api::SetSchedulerConfigRequest& request, std::string* msg) {
+    ::openmldb::api::GeneralResponse response;
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::SetSchedulerConfig, &request, &response,
+                                  FLAGS_request_timeout_ms, FLAGS_request_max_retry);
+    if (!ok || response.code() != 0) {
+        *msg = response.msg();
+        return false;
+    }
+    return true;
+}
+
 bool TabletClient::GetAllSnapshotOffset(std::map<uint32_t, std::map<uint32_t, uint64_t>>& tid_pid_offset) {
     ::openmldb::api::EmptyRequest request;
     ::openmldb::api::TableSnapshotOffsetResponse response;
@@ -1255,6 +1319,15 @@ bool TabletClient::AsyncScan(const ::openmldb::api::ScanRequest& request,
                                callback->GetResponse().get(), callback);
 }
 
+bool TabletClient::AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                                 openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::PutBatch, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::Scan(const ::openmldb::api::ScanRequest& request, brpc::Controller* cntl,
                         ::openmldb::api::ScanResponse* response) {
     bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Scan, cntl, &request, response);
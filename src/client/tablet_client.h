@@ -26,6 +26,7 @@
 #include "base/kv_iterator.h"
 #include "brpc/channel.h"
 #include "client/client.h"
+#include "client/stream_kv_iterator.h"
 #include "codec/schema_codec.h"
 #include "proto/tablet.pb.h"
 #include "rpc/rpc_client.h"
@@ -139,6 +140,9 @@ class TabletClient : public Client {
     bool AsyncScan(const ::openmldb::api::ScanRequest& request,
                    openmldb::RpcCallback<openmldb::api::ScanResponse>* callback);
 
+    bool AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                       openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback);
+
     bool GetTableSchema(uint32_t tid, uint32_t pid,
                         ::openmldb::api::TableMeta& table_meta);  // NOLINT
 
@@ -218,10 +222,20 @@ class TabletClient : public Client {
                                            const std::string& pk, uint64_t ts, uint32_t limit,
                                            uint32_t& count);  // NOLINT
 
+    // push all the records of the index through a stream. the returned iterator pulls them lazily,
+    // limit 0 means no limit. return NULL if the stream fails to open
+    std::shared_ptr<StreamKvIterator> TraverseStream(uint32_t tid, uint32_t pid, const std::string& idx_name,
+                                                     uint32_t limit, std::string* msg);
+
+    // the streaming version of Scan which is not bounded by scan_max_bytes_size
+    std::shared_ptr<StreamKvIterator> ScanStream(const ::openmldb::api::ScanRequest& request, std::string* msg);
+
     void ShowTp();
 
     bool SetMode(bool mode);
 
+    bool SetSchedulerConfig(const ::openmldb::api::SetSchedulerConfigRequest& request, std::string* msg);
+
     bool DeleteIndex(uint32_t tid, uint32_t pid, const std::string& idx_name, std::string* msg);
 
     bool AddIndex(uint32_t tid, uint32_t pid, const ::openmldb::common::ColumnKey& column_key,
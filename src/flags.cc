@@ -49,6 +49,12 @@ DEFINE_int32(gc_pool_size, 2, "the size of tablet gc thread pool");
 DEFINE_int32(gc_safe_offset, 1, "the safe offset of tablet gc in minute");
 DEFINE_uint64(gc_on_table_recover_count, 10000000, "make a gc on recover count");
 DEFINE_uint32(gc_deleted_pk_version_delta, 2, "config the gc version delta");
+DEFINE_uint32(gc_slice_key_num, 0,
+              "config the max keys scanned in a segment by one incremental gc slice. "
+              "0 means gc the whole table every gc_interval");
+DEFINE_uint32(gc_slice_free_num, 100000, "config the max records freed in a segment by one incremental gc slice");
+DEFINE_uint32(gc_slice_time_us, 5000, "config the max time in microsecond of one incremental gc slice");
+DEFINE_uint32(gc_cpu_budget, 10, "config the percentage of a gc thread's time spent by incremental gc of one table");
 DEFINE_double(mem_release_rate, 5, "specify memory release rate, which should be in 0 ~ 10");
 DEFINE_int32(task_pool_size, 3, "the size of tablet task thread pool");
 DEFINE_int32(io_pool_size, 2, "the size of tablet io task thread pool");
@@ -60,16 +66,36 @@ DEFINE_bool(enable_localtablet, true, "enable or disable local tablet opt when d
 // scan configuration
 DEFINE_uint32(scan_max_bytes_size, 2 * 1024 * 1024, "config the max size of scan bytes size");
 DEFINE_uint32(scan_reserve_size, 1024, "config the size of vec reserve");
+DEFINE_uint32(scan_zero_copy_min_row_size, 4096,
+              "the scan responses reference the rows not smaller than the size in the table memory instead of "
+              "copying them, 0 means always copying");
 DEFINE_uint32(preview_limit_max_num, 1000, "config the max num of preview limit");
 DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview");
 // binlog configuration
 DEFINE_int32(binlog_single_file_max_size, 1024 * 4, "the max size of single binlog file");
 DEFINE_int32(binlog_sync_batch_size, 32, "the batch size of sync binlog");
+DEFINE_bool(binlog_sync_raw_record, false,
+            "ship the binlog records to followers as raw bytes in the rpc attachment without parsing them. "
+            "all the tablets must support it");
+DEFINE_uint32(replication_scheduler_thread_num, 0,
+              "the thread num of the scheduler which syncs the binlog of all partitions to followers in shared "
+              "threads and batches the partitions of the same follower in one rpc. 0 means one sync thread per "
+              "replica");
+DEFINE_uint32(replication_batch_max_bytes, 4 * 1024 * 1024, "the max byte size of one batched replication rpc");
+DEFINE_uint32(replication_latency_target_ms, 20,
+              "the batch size of replication rpc shrinks if the rpc latency exceeds it and grows otherwise");
+DEFINE_uint32(follower_apply_thread_num, 0,
+              "the thread num shared by all partitions to put the replicated entries to table in parallel on "
+              "follower. 0 means the entries are put by the rpc thread one by one");
 DEFINE_bool(binlog_notify_on_put, false, "config the sync log to follower strategy");
 DEFINE_bool(binlog_enable_crc, false, "enable crc");
 DEFINE_int32(binlog_coffee_time, 1000, "config the coffee time");
 DEFINE_int32(binlog_sync_wait_time, 100, "config the sync log wait time");
 DEFINE_int32(binlog_sync_to_disk_interval, 20000, "config the interval of sync binlog to disk time");
+DEFINE_bool(binlog_group_commit, false,
+            "write binlog of put by a commit task which syncs once per batch, and respond after the entry is "
+            "synced to disk");
+DEFINE_uint32(binlog_group_commit_thread_num, 4, "the threads shared by the group commits of all the partitions");
 DEFINE_int32(binlog_delete_interval, 60000, "config the interval of delete binlog");
 DEFINE_int32(binlog_match_logoffset_interval, 1000, "config the interval of match log offset ");
 DEFINE_int32(binlog_name_length, 8, "binlog name length");
@@ -78,6 +104,34 @@ DEFINE_uint32(go_back_max_try_cnt, 10, "config max try time of go back");
 
 DEFINE_uint32(put_slow_log_threshold, 50000, "config the threshold of put slow log");
 DEFINE_uint32(query_slow_log_threshold, 50000, "config the threshold of query slow log");
+DEFINE_bool(enable_procedure_trace, false,
+            "record the time of each stage and runner of procedure calls into the latency recorders of the "
+            "procedure, which are listed in the /vars page of tablet");
+DEFINE_string(procedure_result_cache_list, "",
+              "the procedures whose outputs are cached by the request row, in the format of db.sp separated by "
+              "comma, * for all procedures");
+DEFINE_uint32(procedure_result_cache_ttl_ms, 1000,
+              "the max staleness of a cached procedure output, the puts to the other tablets are not tracked");
+DEFINE_uint32(procedure_result_cache_capacity, 10000, "the max number of cached outputs of each procedure");
+DEFINE_bool(enable_request_scheduler, false,
+            "limit the concurrency of each class of tablet requests and admit the higher classes first");
+DEFINE_uint32(request_scheduler_max_concurrency, 0,
+              "the max running requests of all classes, under which the classes are prioritized. 0 is unlimited");
+DEFINE_uint32(request_scheduler_online_query_limit, 0, "the max running online queries, 0 is unlimited");
+DEFINE_uint32(request_scheduler_online_put_limit, 0, "the max running online puts, 0 is unlimited");
+DEFINE_uint32(request_scheduler_replication_limit, 0, "the max running replication requests, 0 is unlimited");
+DEFINE_uint32(request_scheduler_batch_scan_limit, 8, "the max running scans and traverses, 0 is unlimited");
+DEFINE_uint32(request_scheduler_maintenance_limit, 2,
+              "the max running snapshot, load table and data sending tasks, 0 is unlimited");
+DEFINE_uint32(request_scheduler_queue_target_ms, 50,
+              "shed the requests of a class if its queueing time stays above the target, 0 disables shedding");
+DEFINE_uint32(request_scheduler_max_wait_ms, 1000, "the max queueing time of a request, 0 is unlimited");
+DEFINE_string(jit_object_cache_dir, "",
+              "the directory to keep the compiled objects of sql across restarts, empty to disable");
+DEFINE_uint32(jit_object_cache_max_mb, 1024,
+              "remove the least recently used objects once jit_object_cache_dir exceeds the size, 0 is unlimited");
+DEFINE_bool(enable_tiered_compile, false,
+            "compile the batch queries without optimization first, and optimize them in background");
 
 // local db config
 DEFINE_string(db_root_path, "/tmp/", "the root path of db");
@@ -100,6 +154,17 @@ DEFINE_int32(retry_send_file_wait_time_ms, 3000, "conf the wait time when retry
 DEFINE_int32(stream_close_wait_time_ms, 1000, "the wait time before close stream");
 DEFINE_uint32(stream_block_size, 1 * 1204 * 1024, "config the write/read block size in streaming");
 DEFINE_int32(stream_bandwidth_limit, 10 * 1204 * 1024, "the limit bandwidth. Byte/Second");
+DEFINE_uint32(stream_scan_chunk_size, 256 * 1024, "the byte size of one chunk pushed by streaming scan/traverse");
+DEFINE_int32(stream_scan_max_buf_size, 2 * 1024 * 1024,
+             "the max bytes of a streaming scan/traverse not consumed by the client. the tablet stops reading the "
+             "table until the client catches up");
+DEFINE_int32(stream_scan_wait_timeout_ms, 60000,
+             "abort the streaming scan/traverse if the client does not consume any chunk in this time");
+DEFINE_int32(stream_scan_write_timeout_ms, 300000,
+             "abort the streaming scan/traverse if the client has not consumed all the records in this time, so that "
+             "a slow client does not hold a thread of the tablet");
+DEFINE_uint32(stream_scan_thread_num, 4, "the thread num of tablet to push the chunks of streaming scan/traverse");
+DEFINE_uint32(stream_scan_client_queue_size, 8, "the max chunks buffered by the client of streaming scan/traverse");
 
 // if set 23, the task will execute 23:00 every day
 DEFINE_int32(make_snapshot_time, 23, "config the time to make snapshot");
@@ -110,6 +175,9 @@ DEFINE_uint32(make_snapshot_offline_interval, 60 * 60 * 24,
               "config tablet self makesnapshot when how long time do not "
               "makesnapshot from ns. unit is second");
 DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib");
+DEFINE_uint32(snapshot_max_delta_num, 0,
+              "config the max delta snapshots chained to the base snapshot before merging them into a new base. "
+              "0 means making full snapshot every time");
 DEFINE_int32(snapshot_pool_size, 1, "the size of tablet thread pool for making snapshot");
 
 DEFINE_uint32(load_index_max_wait_time, 120 * 60 * 1000, "config the max wait time of load index");
@@ -123,7 +191,20 @@ DEFINE_uint32(absolute_ttl_max, 60 * 24 * 365 * 30, "the max ttl of absolute tim
 DEFINE_uint32(skiplist_max_height, 12, "the max height of skiplist");
 DEFINE_uint32(key_entry_max_height, 8, "the max height of key entry");
 DEFINE_uint32(latest_default_skiplist_height, 1, "the default height of skiplist for latest table");
+DEFINE_uint32(latest_list_max_cnt, 0,
+              "the latest index whose lat_ttl is not larger than it keeps the rows of a key in a ring buffer "
+              "which evicts the oldest row on put. 0 means disable");
+DEFINE_uint32(key_index_init_capacity, 0,
+              "look up keys of memtable segments with a hash index of this initial capacity besides the "
+              "skiplist. 0 means disable");
 DEFINE_uint32(absolute_default_skiplist_height, 4, "the default height of skiplist for absolute table");
+DEFINE_uint32(arena_slab_size, 64 * 1024, "the slab size of segment arena for the table which enables arena");
+DEFINE_bool(enable_numa, false,
+            "bind the memory of each memory table partition to a numa node, which enables arena for the table, "
+            "and run the gc of the partition on the cpus of the node");
+DEFINE_uint32(mem_table_compact_threshold, 0,
+              "compact the rows older than this minutes of absolute ttl table into compressed blocks during gc. "
+              "0 means disable");
 DEFINE_bool(enable_show_tp, false, "enable show tp");
 DEFINE_uint32(max_col_display_length, 256, "config the max length of column display");
 
@@ -141,6 +222,8 @@ DEFINE_bool(verify_compression, false, "For debug");
 DEFINE_uint32(load_table_batch, 30, "set laod table batch size");
 DEFINE_uint32(load_table_thread_num, 3, "set load tabale thread pool size");
 DEFINE_uint32(load_table_queue_size, 1000, "set load tabale queue size");
+DEFINE_uint32(load_snapshot_range_size, 64 * 1024 * 1024,
+             "the min size of the ranges an uncompressed snapshot is split into to load in parallel");
 
 // multiple data center
 DEFINE_uint32(get_replica_status_interval, 10000, "config the interval to sync replica cluster status time");
@@ -2332,6 +2332,8 @@ int NameServerImpl::CreateTableOnTablet(std::shared_ptr<::openmldb::nameserver::
     if (table_info->has_key_entry_max_height()) {
         table_meta.set_key_entry_max_height(table_info->key_entry_max_height());
     }
+    table_meta.set_enable_arena(table_info->enable_arena());
+    table_meta.set_storage_mode(table_info->storage_mode());
     for (int idx = 0; idx < table_info->column_desc_size(); idx++) {
         ::openmldb::common::ColumnDesc* column_desc = table_meta.add_column_desc();
         column_desc->CopyFrom(table_info->column_desc(idx));
@@ -30,11 +30,15 @@
 #include "base/file_util.h"
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/strings.h"
+#include "boost/bind.hpp"
 #include "log/log_format.h"
+#include "replica/replication_scheduler.h"
 #include "storage/segment.h"
 
 DECLARE_int32(binlog_single_file_max_size);
 DECLARE_int32(binlog_name_length);
+DECLARE_bool(binlog_notify_on_put);
+DECLARE_bool(binlog_group_commit);
 DECLARE_string(zk_cluster);
 
 namespace openmldb {
@@ -59,7 +63,16 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       term_(0),
       mu_(),
       cv_(),
-      wmu_() {
+      wmu_(),
+      group_commit_(FLAGS_binlog_group_commit),
+      commit_stopped_(false),
+      commit_appending_(0),
+      commit_scheduled_(false),
+      commit_head_(NULL),
+      commit_pool_(),
+      commit_mu_(),
+      commit_cv_(),
+      scheduler_() {
     binlog_index_ = 0;
     snapshot_log_part_index_.store(-1, std::memory_order_relaxed);
     snapshot_last_offset_.store(0, std::memory_order_relaxed);
@@ -67,6 +80,7 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
 }
 
 LogReplicator::~LogReplicator() {
+    StopGroupCommit();
     DelAllReplicateNode();
     if (logs_ != NULL) {
         logs_->Clear();
@@ -131,6 +145,10 @@ bool LogReplicator::StartSyncing() {
     std::vector<std::shared_ptr<ReplicateNode>>::iterator it = nodes_.begin();
     for (; it != nodes_.end(); ++it) {
         std::shared_ptr<ReplicateNode> node = *it;
+        if (scheduler_) {
+            scheduler_->AddNode(this, node);
+            continue;
+        }
         int ok = node->Start();
         if (ok != 0) {
             return false;
@@ -287,7 +305,27 @@ uint64_t LogReplicator::GetLeaderTerm() { return term_.load(std::memory_order_re
 void LogReplicator::SetLeaderTerm(uint64_t term) { term_.store(term, std::memory_order_relaxed); }
 
 bool LogReplicator::ApplyEntry(const LogEntry& entry) {
+    std::string buffer;
+    entry.SerializeToString(&buffer);
+    return ApplyRawEntry(entry.log_index(), ::openmldb::base::Slice(buffer.c_str(), buffer.size()));
+}
+
+bool LogReplicator::ApplyRawEntry(uint64_t log_index, const ::openmldb::base::Slice& record) {
     std::lock_guard<std::mutex> lock(wmu_);
+    return ApplyRawEntryLocked(log_index, record);
+}
+
+bool LogReplicator::ApplyRawEntries(const std::vector<std::pair<uint64_t, ::openmldb::base::Slice>>& records) {
+    std::lock_guard<std::mutex> lock(wmu_);
+    for (const auto& kv : records) {
+        if (!ApplyRawEntryLocked(kv.first, kv.second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LogReplicator::ApplyRawEntryLocked(uint64_t log_index, const ::openmldb::base::Slice& record) {
     uint64_t last_log_offset = GetOffset();
     if (wh_ == NULL || (wh_->GetSize() / (1024 * 1024)) > (uint32_t)FLAGS_binlog_single_file_max_size) {
         if (!RollWLogFile()) {
@@ -295,20 +333,17 @@ bool LogReplicator::ApplyEntry(const LogEntry& entry) {
             return false;
         }
     }
-    if (entry.log_index() <= last_log_offset) {
+    if (log_index <= last_log_offset) {
         PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u",
-                entry.log_index(), last_log_offset, tid_, pid_);
+                log_index, last_log_offset, tid_, pid_);
         return true;
     }
-    std::string buffer;
-    entry.SerializeToString(&buffer);
-    ::openmldb::base::Slice slice(buffer.c_str(), buffer.size());
-    ::openmldb::log::Status status = wh_->Write(slice);
+    ::openmldb::log::Status status = wh_->Write(record);
     if (!status.ok()) {
         PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
         return false;
     }
-    log_offset_.store(entry.log_index(), std::memory_order_relaxed);
+    log_offset_.store(log_index, std::memory_order_relaxed);
     DEBUGLOG("sync log entry to offset %lu for %s", GetOffset(), path_.c_str());
     return true;
 }
@@ -350,7 +385,9 @@ int LogReplicator::AddReplicateNode(const std::map<std::string, std::string>& re
             PDLOG(WARNING, "init replicate node %s error", endpoint.c_str());
             return -1;
         }
-        if (replicate_node->Start() != 0) {
+        if (scheduler_) {
+            scheduler_->AddNode(this, replicate_node);
+        } else if (replicate_node->Start() != 0) {
             PDLOG(WARNING, "fail to start sync thread for table #tid %u, #pid %u", tid_, pid_);
             return -1;
         }
@@ -390,7 +427,11 @@ int LogReplicator::DelReplicateNode(const std::string& endpoint) {
         PDLOG(INFO, "delete replica. endpoint[%s] tid[%u] pid[%u]", endpoint.c_str(), tid_, pid_);
     }
     if (node) {
-        node->Stop();
+        if (scheduler_) {
+            scheduler_->DelNode(node.get());
+        } else {
+            node->Stop();
+        }
     }
     return 0;
 }
@@ -425,13 +466,45 @@ bool LogReplicator::DelAllReplicateNode() {
     for (; it != copied_nodes.end(); ++it) {
         DEBUGLOG("stop replicator node");
         std::shared_ptr<ReplicateNode> node = *it;
-        node->Stop();
+        if (scheduler_) {
+            scheduler_->DelNode(node.get());
+        } else {
+            node->Stop();
+        }
     }
     return true;
 }
 
 bool LogReplicator::AppendEntry(LogEntry& entry) {
     std::lock_guard<std::mutex> lock(wmu_);
+    std::string buffer;
+    return AppendEntryLocked(entry, &buffer);
+}
+
+bool LogReplicator::AppendEntry(LogEntry& entry, const std::function<bool(const LogEntry&)>& apply) {
+    std::lock_guard<std::mutex> lock(wmu_);
+    entry.set_log_index(1 + log_offset_.load(std::memory_order_relaxed));
+    if (!apply(entry)) {
+        return false;
+    }
+    std::string buffer;
+    return AppendEntryLocked(entry, &buffer);
+}
+
+uint32_t LogReplicator::AppendEntries(std::vector<LogEntry>* entries) {
+    std::lock_guard<std::mutex> lock(wmu_);
+    std::string buffer;
+    uint32_t cnt = 0;
+    for (auto& entry : *entries) {
+        if (!AppendEntryLocked(entry, &buffer)) {
+            break;
+        }
+        cnt++;
+    }
+    return cnt;
+}
+
+bool LogReplicator::AppendEntryLocked(LogEntry& entry, std::string* buffer) {
     if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
         bool ok = RollWLogFile();
         if (!ok) {
@@ -440,9 +513,8 @@ bool LogReplicator::AppendEntry(LogEntry& entry) {
     }
     uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
     entry.set_log_index(1 + cur_offset);
-    std::string buffer;
-    entry.SerializeToString(&buffer);
-    ::openmldb::base::Slice slice(buffer);
+    entry.SerializeToString(buffer);
+    ::openmldb::base::Slice slice(*buffer);
     ::openmldb::log::Status status = wh_->Write(slice);
     if (!status.ok()) {
         PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
@@ -456,9 +528,127 @@ bool LogReplicator::AppendEntry(LogEntry& entry) {
     return true;
 }
 
+void LogReplicator::AppendEntryAsync(LogEntry& entry, AppendCallback callback) {
+    commit_appending_.fetch_add(1);
+    if (commit_stopped_.load()) {
+        commit_appending_.fetch_sub(1);
+        callback(false);
+        return;
+    }
+    GroupCommitTask* task = new GroupCommitTask();
+    task->entry.Swap(&entry);
+    task->callback = std::move(callback);
+    task->ok = false;
+    task->next = NULL;
+    GroupCommitTask* head = commit_head_.load(std::memory_order_relaxed);
+    do {
+        task->next = head;
+    } while (!commit_head_.compare_exchange_weak(head, task));
+    bool schedule = !commit_scheduled_.exchange(true);
+    commit_appending_.fetch_sub(1);
+    if (!schedule) {
+        // the running task commits it
+        return;
+    }
+    if (commit_pool_) {
+        commit_pool_->AddTask(boost::bind(&LogReplicator::RunGroupCommit, this));
+    } else {
+        RunGroupCommit();
+    }
+}
+
+void LogReplicator::StopGroupCommit() {
+    commit_stopped_.store(true);
+    {
+        // the appenders and the task never touch the replicator once they are done here
+        std::unique_lock<std::mutex> lock(commit_mu_);
+        while (commit_appending_.load() > 0 || commit_scheduled_.load()) {
+            commit_cv_.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+    GroupCommitTask* head = commit_head_.exchange(NULL);
+    if (head != NULL) {
+        GroupCommitTask* tasks = NULL;
+        while (head != NULL) {
+            GroupCommitTask* next = head->next;
+            head->next = tasks;
+            tasks = head;
+            head = next;
+        }
+        std::string buffer;
+        CommitBatch(tasks, &buffer);
+    }
+}
+
+void LogReplicator::RunGroupCommit() {
+    std::string buffer;
+    while (true) {
+        GroupCommitTask* head = commit_head_.exchange(NULL, std::memory_order_acquire);
+        // the queue is pushed in lifo order, reverse it to keep the arrival order
+        GroupCommitTask* tasks = NULL;
+        while (head != NULL) {
+            GroupCommitTask* next = head->next;
+            head->next = tasks;
+            tasks = head;
+            head = next;
+        }
+        if (tasks != NULL) {
+            CommitBatch(tasks, &buffer);
+        }
+        {
+            std::lock_guard<std::mutex> lock(commit_mu_);
+            commit_scheduled_.store(false);
+            // an entry queued before the flag is cleared has seen it set
+            if (commit_head_.load() == NULL || commit_scheduled_.exchange(true)) {
+                commit_cv_.notify_all();
+                return;
+            }
+        }
+        if (commit_pool_) {
+            // yield the thread to the other replicators, the queued entries form the next batch
+            commit_pool_->AddTask(boost::bind(&LogReplicator::RunGroupCommit, this));
+            return;
+        }
+    }
+}
+
+void LogReplicator::CommitBatch(GroupCommitTask* tasks, std::string* buffer) {
+    bool synced = false;
+    uint32_t cnt = 0;
+    {
+        std::lock_guard<std::mutex> lock(wmu_);
+        for (GroupCommitTask* task = tasks; task != NULL; task = task->next) {
+            task->ok = AppendEntryLocked(task->entry, buffer);
+            cnt++;
+        }
+        if (wh_ != NULL) {
+            ::openmldb::log::Status status = wh_->Sync();
+            if (status.ok()) {
+                synced = true;
+            } else {
+                PDLOG(WARNING, "fail to sync data for path %s", path_.c_str());
+            }
+        }
+    }
+    DEBUGLOG("group commit %u entries for tid %u pid %u", cnt, tid_, pid_);
+    if (FLAGS_binlog_notify_on_put) {
+        Notify();
+    }
+    while (tasks != NULL) {
+        GroupCommitTask* next = tasks->next;
+        tasks->callback(tasks->ok && synced);
+        delete tasks;
+        tasks = next;
+    }
+}
+
 bool LogReplicator::RollWLogFile() {
     if (wh_ != NULL) {
         wh_->EndLog();
+        // entries acked by group commit must stay durable after rolling
+        if (group_commit_) {
+            wh_->Sync();
+        }
         delete wh_;
         wh_ = NULL;
     }
@@ -479,7 +669,12 @@ bool LogReplicator::RollWLogFile() {
     return true;
 }
 
-void LogReplicator::Notify() { cv_.notify_all(); }
+void LogReplicator::Notify() {
+    cv_.notify_all();
+    if (scheduler_) {
+        scheduler_->Notify(this);
+    }
+}
 
 }  // namespace replica
 }  // namespace openmldb
@@ -19,10 +19,12 @@
 
 #include <atomic>
 #include <condition_variable>  // NOLINT
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/skiplist.h"
@@ -48,6 +50,19 @@ using ::openmldb::storage::Table;
 
 enum ReplicatorRole { kLeaderNode = 1, kFollowerNode };
 
+class ReplicationScheduler;
+
+// invoked with true once the entry has been written and synced to disk
+typedef std::function<void(bool)> AppendCallback;
+
+// a pending entry of group commit, linked in the lock-free commit queue
+struct GroupCommitTask {
+    ::openmldb::api::LogEntry entry;
+    AppendCallback callback;
+    bool ok;
+    GroupCommitTask* next;
+};
+
 class LogReplicator {
  public:
     LogReplicator(uint32_t tid, uint32_t pid, const std::string& path,
@@ -58,14 +73,47 @@ class LogReplicator {
 
     bool Init();
 
+    // the replicate nodes are synced by the shared scheduler instead of their own
+    // sync threads. It must be set before Init
+    inline void SetScheduler(const std::shared_ptr<ReplicationScheduler>& scheduler) { scheduler_ = scheduler; }
+
     bool StartSyncing();
 
     // the slave node receives master log entries
     bool ApplyEntry(const ::openmldb::api::LogEntry& entry);
 
+    // the slave node writes the raw record of master binlog as it is
+    bool ApplyRawEntry(uint64_t log_index, const ::openmldb::base::Slice& record);
+
+    // the slave node writes the raw records in the order of log index with one lock
+    bool ApplyRawEntries(const std::vector<std::pair<uint64_t, ::openmldb::base::Slice>>& records);
+
     // the master node append entry
     bool AppendEntry(::openmldb::api::LogEntry& entry);  // NOLINT
 
+    // the master node applies entry with its log index before appending it, in the log order of
+    // the entries. the entry is not appended if apply fails
+    bool AppendEntry(::openmldb::api::LogEntry& entry,  // NOLINT
+                     const std::function<bool(const ::openmldb::api::LogEntry&)>& apply);
+
+    // the master node appends entries with one lock and returns the count appended
+    uint32_t AppendEntries(std::vector<::openmldb::api::LogEntry>* entries);
+
+    // the master node append entry with group commit. the entry is queued
+    // and written by a task of the commit pool, which syncs once per batch and
+    // then invokes callback. callback is always invoked exactly once, with
+    // false at once if group commit is stopped
+    void AppendEntryAsync(::openmldb::api::LogEntry& entry, AppendCallback callback);  // NOLINT
+
+    // the threads shared by the group commits of all the replicators. without
+    // a pool the entries are committed by the appending threads
+    inline void SetCommitPool(const std::shared_ptr<ThreadPool>& pool) { commit_pool_ = pool; }
+
+    // wait until the queued entries are committed, and fail the later appends
+    void StopGroupCommit();
+
+    inline bool IsGroupCommitEnabled() const { return group_commit_; }
+
     //  data to slave nodes
     void Notify();
     // recover logs meta
@@ -111,6 +159,15 @@ class LogReplicator {
  private:
     bool OpenSeqFile(const std::string& path, SequentialFile** sf);
 
+    // append entry to the write handle, wmu_ must be held
+    bool AppendEntryLocked(::openmldb::api::LogEntry& entry, std::string* buffer);  // NOLINT
+
+    // wmu_ must be held
+    bool ApplyRawEntryLocked(uint64_t log_index, const ::openmldb::base::Slice& record);
+
+    void RunGroupCommit();
+    void CommitBatch(GroupCommitTask* tasks, std::string* buffer);
+
  private:
     // the replicator root data path
     uint32_t tid_;
@@ -137,6 +194,20 @@ class LogReplicator {
     std::atomic<uint64_t> snapshot_last_offset_;
 
     std::mutex wmu_;
+
+    // group commit
+    bool group_commit_;
+    std::atomic<bool> commit_stopped_;
+    // the appends which passed the stop check but are not queued yet
+    std::atomic<uint32_t> commit_appending_;
+    // a commit task is queued or running, at most one at a time
+    std::atomic<bool> commit_scheduled_;
+    std::atomic<GroupCommitTask*> commit_head_;
+    std::shared_ptr<ThreadPool> commit_pool_;
+    std::mutex commit_mu_;
+    std::condition_variable commit_cv_;
+
+    std::shared_ptr<ReplicationScheduler> scheduler_;
 };
 
 }  // namespace replica
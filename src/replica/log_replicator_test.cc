@@ -17,6 +17,7 @@
 #include "replica/log_replicator.h"
 
 #include <brpc/server.h>
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 #include <sched.h>
 #include <stdio.h>
@@ -24,7 +25,14 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <future>  // NOLINT
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "base/glog_wapper.h"
 #include "base/status.h"
@@ -32,10 +40,14 @@
 #include "common/timer.h"
 #include "proto/tablet.pb.h"
 #include "replica/replicate_node.h"
+#include "replica/replication_scheduler.h"
 #include "storage/mem_table.h"
 #include "storage/segment.h"
 #include "storage/ticket.h"
 
+DECLARE_bool(binlog_group_commit);
+DECLARE_bool(binlog_sync_raw_record);
+
 using ::baidu::common::ThreadPool;
 using ::google::protobuf::Closure;
 using ::google::protobuf::RpcController;
@@ -67,6 +79,16 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
         return replicator_.Init();
     }
 
+    // serve another partition on the same endpoint
+    bool AddPartition(std::shared_ptr<MemTable> table, const std::string& path) {
+        auto replicator = std::make_shared<LogReplicator>(table->GetId(), table->GetPid(), path, real_ep_map_, role_);
+        if (!replicator->Init()) {
+            return false;
+        }
+        partitions_[table->GetPid()] = std::make_pair(table, replicator);
+        return true;
+    }
+
     void Put(RpcController* controller, const ::openmldb::api::PutRequest* request,
              ::openmldb::api::PutResponse* response, Closure* done) {}
 
@@ -81,28 +103,85 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
 
     void AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                        ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
-        uint64_t last_log_offset = replicator_.GetOffset();
+        butil::IOBuf& attachment = static_cast<brpc::Controller*>(controller)->request_attachment();
+        AppendEntriesInternal(request, &attachment, response);
+        done->Run();
+        replicator_.Notify();
+    }
+
+    void BatchAppendEntries(RpcController* controller, const ::openmldb::api::BatchAppendEntriesRequest* request,
+                            ::openmldb::api::BatchAppendEntriesResponse* response, Closure* done) {
+        butil::IOBuf& attachment = static_cast<brpc::Controller*>(controller)->request_attachment();
+        batch_rpc_cnt_++;
+        batch_partition_cnt_ += request->requests_size();
+        for (const auto& sub_request : request->requests()) {
+            AppendEntriesInternal(&sub_request, &attachment, response->add_responses());
+        }
+        response->set_code(::openmldb::base::ReturnCode::kOk);
+        done->Run();
+        replicator_.Notify();
+        for (auto& kv : partitions_) {
+            kv.second.second->Notify();
+        }
+    }
+
+    void AppendEntriesInternal(const ::openmldb::api::AppendEntriesRequest* request, butil::IOBuf* attachment,
+                               ::openmldb::api::AppendEntriesResponse* response) {
+        Table* table = table_.get();
+        LogReplicator* replicator = &replicator_;
+        auto it = partitions_.find(request->pid());
+        if (it != partitions_.end()) {
+            table = it->second.first.get();
+            replicator = it->second.second.get();
+        }
+        uint64_t last_log_offset = replicator->GetOffset();
+        for (int32_t i = 0; i < request->raw_entry_size_size(); i++) {
+            std::string record;
+            attachment->cutn(&record, request->raw_entry_size(i));
+            uint64_t log_index = 0;
+            ::openmldb::api::LogEntry entry;
+            if (!PeekLogIndex(::openmldb::base::Slice(record), &log_index) || !entry.ParseFromString(record)) {
+                response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+                response->set_msg("bad raw record");
+                return;
+            }
+            raw_record_cnt_++;
+            if (log_index <= last_log_offset) {
+                continue;
+            }
+            if (!replicator->ApplyRawEntry(log_index, ::openmldb::base::Slice(record))) {
+                response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+                response->set_msg("fail to append entries to replicator");
+                return;
+            }
+            table->Put(entry);
+        }
         for (int32_t i = 0; i < request->entries_size(); i++) {
             if (request->entries(i).log_index() <= last_log_offset) {
                 continue;
             }
             const auto& entry = request->entries(i);
-            if (!replicator_.ApplyEntry(entry)) {
+            if (!replicator->ApplyEntry(entry)) {
                 response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
                 response->set_msg("fail to append entries to replicator");
                 return;
             }
-            table_->Put(entry);
+            table->Put(entry);
         }
-        response->set_log_offset(replicator_.GetOffset());
-        done->Run();
-        replicator_.Notify();
+        response->set_log_offset(replicator->GetOffset());
     }
 
     void SetMode(bool follower) { follower_.store(follower); }
 
     bool GetMode() { return follower_.load(std::memory_order_relaxed); }
 
+    uint64_t GetRawRecordCnt() { return raw_record_cnt_.load(std::memory_order_relaxed); }
+
+    uint64_t GetBatchRpcCnt() { return batch_rpc_cnt_.load(std::memory_order_relaxed); }
+
+    // the partitions carried by all the batch rpcs
+    uint64_t GetBatchPartitionCnt() { return batch_partition_cnt_.load(std::memory_order_relaxed); }
+
  private:
     std::shared_ptr<Table> table_;
     ReplicatorRole role_;
@@ -110,6 +189,10 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
     std::map<std::string, std::string> real_ep_map_;
     LogReplicator replicator_;
     std::atomic<bool> follower_;
+    std::atomic<uint64_t> raw_record_cnt_{0};
+    std::atomic<uint64_t> batch_rpc_cnt_{0};
+    std::atomic<uint64_t> batch_partition_cnt_{0};
+    std::map<uint32_t, std::pair<std::shared_ptr<MemTable>, std::shared_ptr<LogReplicator>>> partitions_;
 };
 
 bool ReceiveEntry(const ::openmldb::api::LogEntry& entry) { return true; }
@@ -146,6 +229,205 @@ TEST_F(LogReplicatorTest, BenchMark) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(LogReplicatorTest, PeekLogIndex) {
+    ::openmldb::api::LogEntry entry;
+    std::string buffer;
+    entry.SerializeToString(&buffer);
+    uint64_t log_index = 0;
+    ASSERT_FALSE(PeekLogIndex(::openmldb::base::Slice(buffer), &log_index));
+    entry.set_term(3);
+    entry.set_pk("test");
+    entry.set_value("value");
+    entry.set_log_index(UINT64_MAX - 1);
+    entry.SerializeToString(&buffer);
+    ASSERT_TRUE(PeekLogIndex(::openmldb::base::Slice(buffer), &log_index));
+    ASSERT_EQ(UINT64_MAX - 1, log_index);
+    // the fields in front of log index are skipped
+    ::openmldb::api::LogEntry dim_entry;
+    dim_entry.set_value("value");
+    dim_entry.add_dimensions()->set_key("card");
+    dim_entry.SerializeToString(&buffer);
+    ::openmldb::api::LogEntry log_index_entry;
+    log_index_entry.set_log_index(10);
+    std::string index_buffer;
+    log_index_entry.SerializeToString(&index_buffer);
+    buffer.append(index_buffer);
+    ASSERT_TRUE(PeekLogIndex(::openmldb::base::Slice(buffer), &log_index));
+    ASSERT_EQ(10u, log_index);
+    ASSERT_FALSE(PeekLogIndex(::openmldb::base::Slice(buffer.data(), 3), &log_index));
+}
+
+TEST_F(LogReplicatorTest, GroupCommit) {
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    FLAGS_binlog_group_commit = true;
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    FLAGS_binlog_group_commit = false;
+    ASSERT_TRUE(replicator.Init());
+    ASSERT_TRUE(replicator.IsGroupCommitEnabled());
+    replicator.SetCommitPool(std::make_shared<ThreadPool>(2));
+    uint32_t thread_num = 4;
+    uint32_t cnt = 1000;
+    std::atomic<uint32_t> succ_cnt(0);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < thread_num; i++) {
+        threads.emplace_back([&replicator, &succ_cnt, i, cnt] {
+            for (uint32_t j = 0; j < cnt; j++) {
+                ::openmldb::api::LogEntry entry;
+                entry.set_term(1);
+                entry.set_pk("key" + std::to_string(i));
+                entry.set_value("value" + std::to_string(j));
+                entry.set_ts(9527 + j);
+                std::promise<bool> synced;
+                replicator.AppendEntryAsync(entry, [&synced](bool ok) { synced.set_value(ok); });
+                if (synced.get_future().get()) {
+                    succ_cnt.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(thread_num * cnt, succ_cnt.load());
+    ASSERT_EQ(thread_num * cnt, replicator.GetOffset());
+    // log index in binlog must be continuous
+    ::openmldb::log::LogReader log_reader(replicator.GetLogPart(), folder + "/binlog/", false);
+    log_reader.SetOffset(0);
+    std::string buffer;
+    ::openmldb::base::Slice record;
+    uint64_t offset = 0;
+    while (log_reader.ReadNextRecord(&record, &buffer).ok()) {
+        ::openmldb::api::LogEntry entry;
+        ASSERT_TRUE(entry.ParseFromString(record.ToString()));
+        ASSERT_EQ(offset + 1, entry.log_index());
+        offset = entry.log_index();
+    }
+    ASSERT_EQ(thread_num * cnt, offset);
+}
+
+TEST_F(LogReplicatorTest, GroupCommitStop) {
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    FLAGS_binlog_group_commit = true;
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    FLAGS_binlog_group_commit = false;
+    ASSERT_TRUE(replicator.Init());
+    auto pool = std::make_shared<ThreadPool>(1);
+    replicator.SetCommitPool(pool);
+    // block the pool, so the entries stay in the queue until stop
+    std::promise<void> blocked;
+    std::shared_future<void> unblock = blocked.get_future().share();
+    pool->AddTask([unblock] { unblock.wait(); });
+    uint32_t cnt = 100;
+    std::atomic<uint32_t> succ_cnt(0);
+    std::atomic<uint32_t> callback_cnt(0);
+    for (uint32_t i = 0; i < cnt; i++) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_term(1);
+        entry.set_pk("key");
+        entry.set_value("value" + std::to_string(i));
+        entry.set_ts(9527 + i);
+        replicator.AppendEntryAsync(entry, [&succ_cnt, &callback_cnt](bool ok) {
+            if (ok) {
+                succ_cnt.fetch_add(1);
+            }
+            callback_cnt.fetch_add(1);
+        });
+    }
+    ASSERT_EQ(0u, callback_cnt.load());
+    std::thread stop([&replicator] { replicator.StopGroupCommit(); });
+    blocked.set_value();
+    stop.join();
+    // every queued entry is committed and answered before stop returns
+    ASSERT_EQ(cnt, callback_cnt.load());
+    ASSERT_EQ(cnt, succ_cnt.load());
+    ASSERT_EQ(cnt, replicator.GetOffset());
+    // the late append fails at once
+    ::openmldb::api::LogEntry entry;
+    entry.set_term(1);
+    entry.set_pk("key");
+    entry.set_value("late");
+    bool late_ok = true;
+    bool late_called = false;
+    replicator.AppendEntryAsync(entry, [&late_ok, &late_called](bool ok) {
+        late_ok = ok;
+        late_called = true;
+    });
+    ASSERT_TRUE(late_called);
+    ASSERT_FALSE(late_ok);
+    ASSERT_EQ(cnt, replicator.GetOffset());
+}
+
+// compare put throughput and p99 latency of the three durability modes:
+// sync per row, sync by timer and group commit
+TEST_F(LogReplicatorTest, GroupCommitBenchMark) {
+    uint32_t thread_num = 8;
+    uint32_t cnt = 500;
+    std::string value(128, 'a');
+    for (const std::string mode : {"per-row", "timer-sync", "group-commit"}) {
+        std::map<std::string, std::string> map;
+        std::string folder = "/tmp/" + GenRand() + "/";
+        FLAGS_binlog_group_commit = mode == "group-commit";
+        LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+        FLAGS_binlog_group_commit = false;
+        ASSERT_TRUE(replicator.Init());
+        replicator.SetCommitPool(std::make_shared<ThreadPool>(2));
+        std::atomic<bool> running(true);
+        std::thread sync_thread;
+        if (mode == "timer-sync") {
+            sync_thread = std::thread([&replicator, &running] {
+                while (running.load(std::memory_order_relaxed)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    replicator.SyncToDisk();
+                }
+            });
+        }
+        std::vector<std::vector<uint64_t>> latency(thread_num);
+        std::vector<std::thread> threads;
+        uint64_t start = ::baidu::common::timer::get_micros();
+        for (uint32_t i = 0; i < thread_num; i++) {
+            threads.emplace_back([&, i] {
+                for (uint32_t j = 0; j < cnt; j++) {
+                    ::openmldb::api::LogEntry entry;
+                    entry.set_term(1);
+                    entry.set_pk("key" + std::to_string(i));
+                    entry.set_value(value);
+                    entry.set_ts(9527 + j);
+                    uint64_t begin = ::baidu::common::timer::get_micros();
+                    if (mode == "group-commit") {
+                        std::promise<bool> synced;
+                        replicator.AppendEntryAsync(entry, [&synced](bool ok) { synced.set_value(ok); });
+                        ASSERT_TRUE(synced.get_future().get());
+                    } else {
+                        ASSERT_TRUE(replicator.AppendEntry(entry));
+                        if (mode == "per-row") {
+                            replicator.SyncToDisk();
+                        }
+                    }
+                    latency[i].push_back(::baidu::common::timer::get_micros() - begin);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        uint64_t consumed = ::baidu::common::timer::get_micros() - start;
+        running.store(false, std::memory_order_relaxed);
+        if (sync_thread.joinable()) {
+            sync_thread.join();
+        }
+        ASSERT_EQ(thread_num * cnt, replicator.GetOffset());
+        std::vector<uint64_t> all;
+        for (const auto& vec : latency) {
+            all.insert(all.end(), vec.begin(), vec.end());
+        }
+        std::sort(all.begin(), all.end());
+        RecordProperty(mode + "_qps", static_cast<int>(thread_num * cnt * 1000000ul / (consumed + 1)));
+        RecordProperty(mode + "_p99_us", static_cast<int>(all[all.size() * 99 / 100]));
+    }
+}
+
 TEST_F(LogReplicatorTest, LeaderAndFollowerMulti) {
     brpc::ServerOptions options;
     brpc::Server server0;
@@ -461,6 +743,175 @@ TEST_F(LogReplicatorTest, LeaderAndFollower) {
     }
 }
 
+TEST_F(LogReplicatorTest, LeaderAndFollowerRawRecord) {
+    FLAGS_binlog_sync_raw_record = true;
+    brpc::ServerOptions options;
+    brpc::Server server;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    MockTabletImpl* follower = NULL;
+    {
+        std::string follower_addr = "127.0.0.1:18537";
+        std::string folder = "/tmp/" + GenRand() + "/";
+        follower = new MockTabletImpl(kFollowerNode, folder, g_endpoints, table);
+        ASSERT_TRUE(follower->Init());
+        ASSERT_EQ(0, server.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+        ASSERT_EQ(0, server.Start(follower_addr.c_str(), &options));
+    }
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator leader(1, 1, folder, g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    const int record_num = 100;
+    for (int i = 0; i < record_num; i++) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_pk("test_pk");
+        entry.set_value("value" + std::to_string(i));
+        entry.set_ts(9527 + i);
+        ASSERT_TRUE(leader.AppendEntry(entry));
+    }
+    leader.Notify();
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair("127.0.0.1:18537", ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    for (int i = 0; i < 100 && table->GetRecordCnt() < record_num; i++) {
+        usleep(100 * 1000);
+    }
+    leader.DelAllReplicateNode();
+    FLAGS_binlog_sync_raw_record = false;
+    ASSERT_EQ(record_num, (int64_t)table->GetRecordCnt());
+    ASSERT_EQ(record_num, (int64_t)follower->GetRawRecordCnt());
+    Ticket ticket;
+    TableIterator* it = table->NewIterator("test_pk", ticket);
+    it->SeekToFirst();
+    for (int i = record_num - 1; i >= 0; i--) {
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(9527 + i, (int64_t)it->GetKey());
+        ASSERT_EQ("value" + std::to_string(i), it->GetValue().ToString());
+        it->Next();
+    }
+    ASSERT_FALSE(it->Valid());
+    delete it;
+    server.Stop(10000);
+}
+
+TEST_F(LogReplicatorTest, LeaderAndFollowerScheduler) {
+    brpc::ServerOptions options;
+    brpc::Server server;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    MockTabletImpl* follower = NULL;
+    {
+        std::string follower_addr = "127.0.0.1:18538";
+        std::string folder = "/tmp/" + GenRand() + "/";
+        follower = new MockTabletImpl(kFollowerNode, folder, g_endpoints, table);
+        ASSERT_TRUE(follower->Init());
+        ASSERT_EQ(0, server.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+        ASSERT_EQ(0, server.Start(follower_addr.c_str(), &options));
+    }
+    std::shared_ptr<ReplicationScheduler> scheduler = std::make_shared<ReplicationScheduler>(2);
+    scheduler->Start();
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator leader(1, 1, folder, g_endpoints, kLeaderNode);
+    leader.SetScheduler(scheduler);
+    ASSERT_TRUE(leader.Init());
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair("127.0.0.1:18538", ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    const int record_num = 1000;
+    for (int i = 0; i < record_num; i++) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_pk("test_pk");
+        entry.set_value("value" + std::to_string(i));
+        entry.set_ts(9527 + i);
+        ASSERT_TRUE(leader.AppendEntry(entry));
+        leader.Notify();
+    }
+    for (int i = 0; i < 100 && table->GetRecordCnt() < record_num; i++) {
+        usleep(100 * 1000);
+    }
+    ASSERT_EQ(record_num, (int64_t)table->GetRecordCnt());
+    ASSERT_GT(follower->GetBatchRpcCnt(), 0u);
+    ASSERT_GT(scheduler->GetBatchByteSize("127.0.0.1:18538"), 0u);
+    std::map<std::string, uint64_t> info_map;
+    for (int i = 0; i < 100 && info_map["127.0.0.1:18538"] < (uint64_t)record_num; i++) {
+        info_map.clear();
+        leader.GetReplicateInfo(info_map);
+        usleep(10 * 1000);
+    }
+    ASSERT_EQ((uint64_t)record_num, info_map["127.0.0.1:18538"]);
+    leader.DelAllReplicateNode();
+    ASSERT_EQ(0u, scheduler->GetBatchByteSize("127.0.0.1:18538"));
+    scheduler->Stop();
+    server.Stop(10000);
+}
+
+// the partitions bound for the same follower endpoint are synced by the same rpcs
+TEST_F(LogReplicatorTest, SchedulerMergePartitions) {
+    brpc::ServerOptions options;
+    brpc::Server server;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    const uint32_t partition_num = 8;
+    std::vector<std::shared_ptr<MemTable>> tables;
+    for (uint32_t pid = 0; pid < partition_num; pid++) {
+        tables.push_back(
+            std::make_shared<MemTable>("test", 2, pid, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime));
+        tables.back()->Init();
+    }
+    MockTabletImpl* follower = NULL;
+    {
+        std::string follower_addr = "127.0.0.1:18539";
+        follower = new MockTabletImpl(kFollowerNode, "/tmp/" + GenRand() + "/", g_endpoints, tables[0]);
+        ASSERT_TRUE(follower->Init());
+        for (uint32_t pid = 1; pid < partition_num; pid++) {
+            ASSERT_TRUE(follower->AddPartition(tables[pid], "/tmp/" + GenRand() + "/"));
+        }
+        ASSERT_EQ(0, server.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+        ASSERT_EQ(0, server.Start(follower_addr.c_str(), &options));
+    }
+    // the nodes are scheduled together by the first tick after start
+    std::shared_ptr<ReplicationScheduler> scheduler = std::make_shared<ReplicationScheduler>(2);
+    std::vector<std::shared_ptr<LogReplicator>> leaders;
+    const int record_num = 100;
+    for (uint32_t pid = 0; pid < partition_num; pid++) {
+        auto leader = std::make_shared<LogReplicator>(2, pid, "/tmp/" + GenRand() + "/", g_endpoints, kLeaderNode);
+        leader->SetScheduler(scheduler);
+        ASSERT_TRUE(leader->Init());
+        std::map<std::string, std::string> map;
+        map.insert(std::make_pair("127.0.0.1:18539", ""));
+        ASSERT_EQ(0, leader->AddReplicateNode(map));
+        for (int i = 0; i < record_num; i++) {
+            ::openmldb::api::LogEntry entry;
+            entry.set_pk("test_pk");
+            entry.set_value("value" + std::to_string(i));
+            entry.set_ts(9527 + i);
+            ASSERT_TRUE(leader->AppendEntry(entry));
+        }
+        leaders.push_back(leader);
+    }
+    scheduler->Start();
+    for (uint32_t pid = 0; pid < partition_num; pid++) {
+        for (int i = 0; i < 100 && tables[pid]->GetRecordCnt() < record_num; i++) {
+            usleep(100 * 1000);
+        }
+        ASSERT_EQ(record_num, (int64_t)tables[pid]->GetRecordCnt());
+    }
+    ASSERT_GE(follower->GetBatchPartitionCnt(), partition_num);
+    ASSERT_GT(follower->GetBatchRpcCnt(), 0u);
+    ASSERT_LT(follower->GetBatchRpcCnt(), partition_num);
+    for (auto& leader : leaders) {
+        leader->DelAllReplicateNode();
+    }
+    scheduler->Stop();
+    server.Stop(10000);
+}
+
 TEST_F(LogReplicatorTest, Leader_Remove_local_follower) {
     brpc::ServerOptions options;
     brpc::Server server0;
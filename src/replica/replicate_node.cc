@@ -18,12 +18,16 @@
 
 #include <gflags/gflags.h>
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
 #include <algorithm>
 
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/strings.h"
 
 DECLARE_int32(binlog_sync_batch_size);
+DECLARE_bool(binlog_sync_raw_record);
 DECLARE_int32(binlog_sync_wait_time);
 DECLARE_int32(binlog_coffee_time);
 DECLARE_int32(binlog_match_logoffset_interval);
@@ -35,6 +39,22 @@ DECLARE_uint32(go_back_max_try_cnt);
 namespace openmldb {
 namespace replica {
 
+bool PeekLogIndex(const ::openmldb::base::Slice& record, uint64_t* log_index) {
+    using ::google::protobuf::internal::WireFormatLite;
+    ::google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(record.data()), record.size());
+    uint32_t tag = 0;
+    while ((tag = input.ReadTag()) != 0) {
+        if (WireFormatLite::GetTagFieldNumber(tag) == ::openmldb::api::LogEntry::kLogIndexFieldNumber &&
+            WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_VARINT) {
+            return input.ReadVarint64(log_index);
+        }
+        if (!WireFormatLite::SkipField(&input, tag)) {
+            return false;
+        }
+    }
+    return false;
+}
+
 static void* RunSyncTask(void* args) {
     if (args == NULL) {
         PDLOG(WARNING, "input args is null");
@@ -52,7 +72,10 @@ ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std
                              std::atomic<uint64_t>* follower_offset, const std::string& real_point)
     : log_reader_(logs, log_path, false),
       cache_(),
+      cache_attachment_(),
+      cache_log_index_(0),
       endpoint_(point),
+      real_endpoint_(real_point.empty() ? point : real_point),
       last_sync_offset_(0),
       log_matched_(false),
       tid_(tid),
@@ -128,12 +151,7 @@ void ReplicateNode::SyncData() {
                 }
             }
         }
-        int ret;
-        if (rep_node_.load(std::memory_order_relaxed)) {
-            ret = SyncData(follower_offset_->load(std::memory_order_relaxed));
-        } else {
-            ret = SyncData(leader_log_offset_->load(std::memory_order_relaxed));
-        }
+        int ret = SyncData(GetSyncTargetOffset());
         if (ret == 1) {
             coffee_time = FLAGS_binlog_coffee_time;
         }
@@ -178,27 +196,62 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
         PDLOG(WARNING, "log offset [%lu] le last sync offset [%lu], do nothing", log_offset, last_sync_offset_);
         return 1;
     }
-    ::openmldb::api::AppendEntriesRequest request;
-    ::openmldb::api::AppendEntriesResponse response;
+    SyncBatch batch;
+    if (ReadEntries(log_offset, FLAGS_binlog_sync_batch_size, 0, &batch) < 0) {
+        return -1;
+    }
+    if (!batch.Empty()) {
+        ::openmldb::api::AppendEntriesResponse response;
+        bool ret = false;
+        if (batch.request.raw_entry_size_size() > 0) {
+            brpc::Controller cntl;
+            cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+            cntl.set_max_retry(FLAGS_request_max_retry);
+            cntl.request_attachment().append(batch.attachment);
+            ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &cntl, &batch.request,
+                                          &response);
+        } else {
+            ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &batch.request,
+                                          &response, FLAGS_request_timeout_ms, FLAGS_request_max_retry);
+        }
+        FinishEntries(&batch, ret, response);
+    }
+    if (batch.need_wait) {
+        return 1;
+    }
+    return 0;
+}
+
+int ReplicateNode::ReadEntries(uint64_t log_offset, uint32_t max_cnt, uint32_t max_bytes, SyncBatch* batch) {
+    ::openmldb::api::AppendEntriesRequest& request = batch->request;
+    butil::IOBuf& attachment = batch->attachment;
     uint64_t sync_log_offset = last_sync_offset_;
-    bool request_from_cache = false;
     bool need_wait = false;
     if (cache_.size() > 0) {
-        request_from_cache = true;
+        batch->from_cache = true;
         request = cache_[0];
-        if (request.entries_size() <= 0) {
+        uint64_t last_log_index = 0;
+        if (request.raw_entry_size_size() > 0) {
+            attachment = cache_attachment_;
+            last_log_index = cache_log_index_;
+        } else if (request.entries_size() > 0) {
+            last_log_index = request.entries(request.entries_size() - 1).log_index();
+        } else {
             cache_.clear();
+            request.Clear();
             PDLOG(WARNING, "empty append entry request from node %s cache", endpoint_.c_str());
             return -1;
         }
-        const ::openmldb::api::LogEntry& entry = request.entries(request.entries_size() - 1);
-        if (entry.log_index() <= last_sync_offset_) {
+        if (last_log_index <= last_sync_offset_) {
             DEBUGLOG("duplicate log index from node %s cache", endpoint_.c_str());
             cache_.clear();
+            cache_attachment_.clear();
+            request.Clear();
+            attachment.clear();
             return -1;
         }
-        PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", entry.log_index(), tid_, pid_);
-        sync_log_offset = entry.log_index();
+        PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", last_log_index, tid_, pid_);
+        sync_log_offset = last_log_index;
     } else {
         request.set_tid(tid_);
         request.set_pid(pid_);
@@ -206,32 +259,49 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
         if (!FLAGS_zk_cluster.empty()) {
             request.set_term(term_->load(std::memory_order_relaxed));
         }
-        uint32_t batchSize = log_offset - last_sync_offset_;
-        batchSize = std::min(batchSize, (uint32_t)FLAGS_binlog_sync_batch_size);
+        uint64_t batchSize = log_offset - last_sync_offset_;
+        batchSize = std::min(batchSize, (uint64_t)max_cnt);
+        bool raw_record = FLAGS_binlog_sync_raw_record;
+        uint64_t byte_size = 0;
         for (uint64_t i = 0; i < batchSize;) {
             std::string buffer;
             ::openmldb::base::Slice record;
             ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
             if (status.ok()) {
-                ::openmldb::api::LogEntry* entry = request.add_entries();
-                if (!entry->ParseFromString(record.ToString())) {
-                    PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
-                          ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(), tid_,
-                          pid_);
-                    request.mutable_entries()->RemoveLast();
-                    break;
+                ::openmldb::api::LogEntry* entry = NULL;
+                uint64_t log_index = 0;
+                if (raw_record) {
+                    if (!PeekLogIndex(record, &log_index)) {
+                        PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
+                              ::openmldb::base::DebugString(record.ToString()).c_str(), record.size(), tid_, pid_);
+                        break;
+                    }
+                } else {
+                    entry = request.add_entries();
+                    if (!entry->ParseFromString(record.ToString())) {
+                        PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
+                              ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(),
+                              tid_, pid_);
+                        request.mutable_entries()->RemoveLast();
+                        break;
+                    }
+                    DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
+                    log_index = entry->log_index();
                 }
-                DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
-                if (entry->log_index() <= sync_log_offset) {
-                    DEBUGLOG("skip duplicate log offset %lld", entry->log_index());
-                    request.mutable_entries()->RemoveLast();
+                if (log_index <= sync_log_offset) {
+                    DEBUGLOG("skip duplicate log offset %lld", log_index);
+                    if (entry != NULL) {
+                        request.mutable_entries()->RemoveLast();
+                    }
                     continue;
                 }
                 // the log index should incr by 1
-                if ((sync_log_offset + 1) != entry->log_index()) {
+                if ((sync_log_offset + 1) != log_index) {
                     PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", sync_log_offset + 1,
-                          entry->log_index(), tid_, pid_);
-                    request.mutable_entries()->RemoveLast();
+                          log_index, tid_, pid_);
+                    if (entry != NULL) {
+                        request.mutable_entries()->RemoveLast();
+                    }
                     if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
                         log_reader_.GoBackToStart();
                         go_back_cnt_ = 0;
@@ -243,7 +313,12 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
                     need_wait = true;
                     break;
                 }
-                sync_log_offset = entry->log_index();
+                if (raw_record) {
+                    request.add_raw_entry_size(record.size());
+                    attachment.append(record.data(), record.size());
+                }
+                sync_log_offset = log_index;
+                byte_size += record.size();
             } else if (status.IsWaitRecord()) {
                 DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
                 need_wait = true;
@@ -267,33 +342,54 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
             }
             i++;
             go_back_cnt_ = 0;
+            if (max_bytes > 0 && byte_size >= max_bytes) {
+                break;
+            }
         }
     }
-    if (request.entries_size() > 0) {
-        bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
-                                           FLAGS_request_timeout_ms, FLAGS_request_max_retry);
-        if (ret && response.code() == 0) {
-            DEBUGLOG("sync log to node[%s] to offset %lld", endpoint_.c_str(), sync_log_offset);
-            last_sync_offset_ = sync_log_offset;
-            if (!rep_node_.load(std::memory_order_relaxed) &&
-                (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
-                follower_offset_->store(last_sync_offset_, std::memory_order_relaxed);
-            }
-            if (request_from_cache) {
-                cache_.clear();
-            }
-        } else {
-            if (!request_from_cache) {
-                cache_.push_back(request);
-            }
-            need_wait = true;
-            PDLOG(WARNING, "fail to sync log to node %s. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
+    batch->sync_log_offset = sync_log_offset;
+    batch->need_wait = need_wait;
+    return 0;
+}
+
+void ReplicateNode::FinishEntries(SyncBatch* batch, bool ok, const ::openmldb::api::AppendEntriesResponse& response) {
+    if (batch->Empty()) {
+        return;
+    }
+    // the follower which does not support raw records ignores them
+    if (ok && response.code() == 0 && batch->request.raw_entry_size_size() > 0 &&
+        response.log_offset() < batch->sync_log_offset) {
+        PDLOG(WARNING, "node %s does not apply raw records. log offset %lu tid %u pid %u", endpoint_.c_str(),
+              response.log_offset(), tid_, pid_);
+        ok = false;
+    }
+    if (ok && response.code() == 0) {
+        DEBUGLOG("sync log to node[%s] to offset %lld", endpoint_.c_str(), batch->sync_log_offset);
+        last_sync_offset_ = batch->sync_log_offset;
+        if (!rep_node_.load(std::memory_order_relaxed) &&
+            (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
+            follower_offset_->store(last_sync_offset_, std::memory_order_relaxed);
         }
+        if (batch->from_cache) {
+            cache_.clear();
+            cache_attachment_.clear();
+        }
+    } else {
+        if (!batch->from_cache) {
+            cache_.push_back(batch->request);
+            cache_attachment_ = batch->attachment;
+            cache_log_index_ = batch->sync_log_offset;
+        }
+        batch->need_wait = true;
+        PDLOG(WARNING, "fail to sync log to node %s. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
     }
-    if (need_wait) {
-        return 1;
+}
+
+uint64_t ReplicateNode::GetSyncTargetOffset() {
+    if (rep_node_.load(std::memory_order_relaxed)) {
+        return follower_offset_->load(std::memory_order_relaxed);
     }
-    return 0;
+    return leader_log_offset_->load(std::memory_order_relaxed);
 }
 
 void ReplicateNode::Stop() {
@@ -24,6 +24,7 @@
 #include "base/skiplist.h"
 #include "bthread/bthread.h"
 #include "bthread/condition_variable.h"
+#include "butil/iobuf.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
@@ -36,6 +37,23 @@ namespace replica {
 using ::openmldb::log::LogReader;
 typedef ::openmldb::base::Skiplist<uint32_t, uint64_t, ::openmldb::base::DefaultComparator> LogParts;
 
+// read the log index of a serialized LogEntry without parsing the other fields
+bool PeekLogIndex(const ::openmldb::base::Slice& record, uint64_t* log_index);
+
+// the entries read from binlog for one AppendEntries request
+struct SyncBatch {
+    SyncBatch() : request(), attachment(), sync_log_offset(0), from_cache(false), need_wait(false) {}
+
+    inline bool Empty() const { return request.entries_size() == 0 && request.raw_entry_size_size() == 0; }
+
+    ::openmldb::api::AppendEntriesRequest request;
+    // the raw records are sent in the attachment
+    butil::IOBuf attachment;
+    uint64_t sync_log_offset;
+    bool from_cache;
+    bool need_wait;
+};
+
 class ReplicateNode {
  public:
     ReplicateNode(const std::string& point, LogParts* logs, const std::string& log_path, uint32_t tid, uint32_t pid,
@@ -53,6 +71,24 @@ class ReplicateNode {
 
     int SyncData(uint64_t log_offset);
 
+    // read at most max_cnt entries or max_bytes bytes not after log_offset into batch,
+    // 0 max_bytes means no limit. It returns -1 if the cached request is invalid
+    int ReadEntries(uint64_t log_offset, uint32_t max_cnt, uint32_t max_bytes, SyncBatch* batch);
+
+    // update the sync offset with the result of sending batch
+    void FinishEntries(SyncBatch* batch, bool ok, const ::openmldb::api::AppendEntriesResponse& response);
+
+    // the offset this node should be synced to
+    uint64_t GetSyncTargetOffset();
+
+    int MatchLogOffsetFromNode();
+
+    inline const std::string& GetRealEndPoint() const { return real_endpoint_; }
+
+    inline uint32_t GetTid() const { return tid_; }
+
+    inline uint32_t GetPid() const { return pid_; }
+
     void SetLastSyncOffset(uint64_t offset);
 
     bool IsLogMatched();
@@ -69,13 +105,14 @@ class ReplicateNode {
 
     ReplicateNode& operator=(const ReplicateNode&) = delete;
 
- private:
-    int MatchLogOffsetFromNode();
-
  private:
     LogReader log_reader_;
     std::vector<::openmldb::api::AppendEntriesRequest> cache_;
+    // the attachment and last log index of the cached request with raw records
+    butil::IOBuf cache_attachment_;
+    uint64_t cache_log_index_;
     std::string endpoint_;
+    std::string real_endpoint_;
     uint64_t last_sync_offset_;
     bool log_matched_;
     uint32_t tid_;
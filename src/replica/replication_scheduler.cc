@@ -0,0 +1,352 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "replica/replication_scheduler.h"
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/glog_wapper.h"
+#include "boost/bind.hpp"
+#include "common/timer.h"
+
+DECLARE_int32(binlog_coffee_time);
+DECLARE_int32(binlog_sync_wait_time);
+DECLARE_int32(request_max_retry);
+DECLARE_int32(request_timeout_ms);
+DECLARE_uint32(replication_batch_max_bytes);
+DECLARE_uint32(replication_latency_target_ms);
+
+namespace openmldb {
+namespace replica {
+
+static const uint32_t MIN_BATCH_BYTE_SIZE = 16 * 1024;
+// the max count of partitions in one rpc
+static const uint32_t MAX_BATCH_NODE_CNT = 512;
+
+ReplicationScheduler::ReplicationScheduler(uint32_t thread_num)
+    : mu_(), cv_(), nodes_(), owners_(), endpoints_(), running_(false), pool_(thread_num), tick_pool_(1) {}
+
+ReplicationScheduler::~ReplicationScheduler() { Stop(); }
+
+void ReplicationScheduler::Start() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (running_) {
+            return;
+        }
+        running_ = true;
+    }
+    tick_pool_.DelayTask(FLAGS_binlog_sync_wait_time, boost::bind(&ReplicationScheduler::Tick, this));
+}
+
+void ReplicationScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    tick_pool_.Stop(true);
+    pool_.Stop(true);
+    std::lock_guard<std::mutex> lock(mu_);
+    // the nodes left in queues are never synced
+    for (auto& kv : nodes_) {
+        kv.second.busy = false;
+    }
+    cv_.notify_all();
+}
+
+void ReplicationScheduler::AddNode(LogReplicator* owner, const std::shared_ptr<ReplicateNode>& node) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (nodes_.find(node.get()) != nodes_.end()) {
+        return;
+    }
+    NodeState& state = nodes_[node.get()];
+    state.node = node;
+    state.owner = owner;
+    state.pending = false;
+    state.busy = false;
+    owners_[owner].push_back(node.get());
+    const std::string& real_endpoint = node->GetRealEndPoint();
+    auto it = endpoints_.find(real_endpoint);
+    if (it == endpoints_.end()) {
+        EndpointState& ep = endpoints_[real_endpoint];
+        ep.client = std::make_shared<::openmldb::RpcClient<::openmldb::api::TabletServer_Stub>>(real_endpoint);
+        if (ep.client->Init() != 0) {
+            PDLOG(WARNING, "fail to init rpc client for endpoint %s", real_endpoint.c_str());
+        }
+        ep.node_cnt = 0;
+        ep.running = false;
+        ep.batch_byte_size = std::max(FLAGS_replication_batch_max_bytes / 4, MIN_BATCH_BYTE_SIZE);
+        it = endpoints_.find(real_endpoint);
+    }
+    it->second.node_cnt++;
+    PDLOG(INFO, "add node %s to replication scheduler. tid %u pid %u", node->GetEndPoint().c_str(), node->GetTid(),
+          node->GetPid());
+    // match the log offset and sync the existing log
+    ScheduleLocked(&state);
+}
+
+void ReplicationScheduler::DelNode(ReplicateNode* node) {
+    std::unique_lock<std::mutex> lock(mu_);
+    auto it = nodes_.find(node);
+    if (it == nodes_.end()) {
+        return;
+    }
+    cv_.wait(lock, [this, node] {
+        auto cur = nodes_.find(node);
+        return cur == nodes_.end() || !cur->second.busy;
+    });
+    it = nodes_.find(node);
+    if (it == nodes_.end()) {
+        return;
+    }
+    std::shared_ptr<ReplicateNode> holder = it->second.node;
+    auto owner_it = owners_.find(it->second.owner);
+    if (owner_it != owners_.end()) {
+        auto& vec = owner_it->second;
+        vec.erase(std::remove(vec.begin(), vec.end(), node), vec.end());
+        if (vec.empty()) {
+            owners_.erase(owner_it);
+        }
+    }
+    auto ep_it = endpoints_.find(node->GetRealEndPoint());
+    if (ep_it != endpoints_.end()) {
+        auto& ready = ep_it->second.ready;
+        ready.erase(std::remove(ready.begin(), ready.end(), node), ready.end());
+        // the client is kept while a thread is serving the endpoint
+        if (--ep_it->second.node_cnt == 0 && !ep_it->second.running) {
+            endpoints_.erase(ep_it);
+        }
+    }
+    nodes_.erase(it);
+    PDLOG(INFO, "delete node %s from replication scheduler. tid %u pid %u", node->GetEndPoint().c_str(),
+          node->GetTid(), node->GetPid());
+}
+
+void ReplicationScheduler::Notify(LogReplicator* owner) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = owners_.find(owner);
+    if (it == owners_.end()) {
+        return;
+    }
+    for (ReplicateNode* node : it->second) {
+        ScheduleLocked(&nodes_[node]);
+    }
+}
+
+uint32_t ReplicationScheduler::GetBatchByteSize(const std::string& real_endpoint) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = endpoints_.find(real_endpoint);
+    return it == endpoints_.end() ? 0 : it->second.batch_byte_size;
+}
+
+void ReplicationScheduler::ScheduleLocked(NodeState* state) {
+    if (state->pending || !running_) {
+        return;
+    }
+    const std::string& real_endpoint = state->node->GetRealEndPoint();
+    auto it = endpoints_.find(real_endpoint);
+    if (it == endpoints_.end()) {
+        return;
+    }
+    state->pending = true;
+    it->second.ready.push_back(state->node.get());
+    if (!it->second.running) {
+        it->second.running = true;
+        pool_.AddTask(boost::bind(&ReplicationScheduler::RunEndpoint, this, real_endpoint));
+    }
+}
+
+void ReplicationScheduler::Wakeup(ReplicateNode* node) {
+    std::lock_guard<std::mutex> lock(mu_);
+    // the node may have been deleted
+    auto it = nodes_.find(node);
+    if (it != nodes_.end()) {
+        ScheduleLocked(&it->second);
+    }
+}
+
+void ReplicationScheduler::Tick() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!running_) {
+            return;
+        }
+        for (auto& kv : nodes_) {
+            NodeState& state = kv.second;
+            if (!state.pending && !state.busy &&
+                state.node->GetSyncTargetOffset() > state.node->GetLastSyncOffset()) {
+                ScheduleLocked(&state);
+            }
+        }
+    }
+    tick_pool_.DelayTask(FLAGS_binlog_sync_wait_time, boost::bind(&ReplicationScheduler::Tick, this));
+}
+
+void ReplicationScheduler::RunEndpoint(const std::string& real_endpoint) {
+    while (true) {
+        std::vector<std::shared_ptr<ReplicateNode>> nodes;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            auto it = endpoints_.find(real_endpoint);
+            if (it == endpoints_.end()) {
+                return;
+            }
+            EndpointState& ep = it->second;
+            if (ep.ready.empty() || !running_) {
+                ep.running = false;
+                if (ep.node_cnt == 0) {
+                    endpoints_.erase(it);
+                }
+                return;
+            }
+            while (!ep.ready.empty() && nodes.size() < MAX_BATCH_NODE_CNT) {
+                NodeState& state = nodes_[ep.ready.front()];
+                ep.ready.pop_front();
+                state.pending = false;
+                state.busy = true;
+                nodes.push_back(state.node);
+            }
+        }
+        std::vector<ReplicateNode*> again;
+        std::vector<ReplicateNode*> delayed;
+        SyncNodes(real_endpoint, nodes, &again, &delayed);
+        std::lock_guard<std::mutex> lock(mu_);
+        for (const auto& node : nodes) {
+            auto it = nodes_.find(node.get());
+            if (it != nodes_.end()) {
+                it->second.busy = false;
+            }
+        }
+        for (ReplicateNode* node : again) {
+            auto it = nodes_.find(node);
+            if (it != nodes_.end()) {
+                ScheduleLocked(&it->second);
+            }
+        }
+        for (ReplicateNode* node : delayed) {
+            pool_.DelayTask(FLAGS_binlog_coffee_time, boost::bind(&ReplicationScheduler::Wakeup, this, node));
+        }
+        cv_.notify_all();
+    }
+}
+
+void ReplicationScheduler::SyncNodes(const std::string& real_endpoint,
+                                     const std::vector<std::shared_ptr<ReplicateNode>>& nodes,
+                                     std::vector<ReplicateNode*>* again, std::vector<ReplicateNode*>* delayed) {
+    std::shared_ptr<::openmldb::RpcClient<::openmldb::api::TabletServer_Stub>> client;
+    uint64_t budget = 0;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = endpoints_.find(real_endpoint);
+        if (it == endpoints_.end()) {
+            return;
+        }
+        client = it->second.client;
+        budget = it->second.batch_byte_size;
+    }
+    const uint64_t batch_byte_size = budget;
+    std::vector<SyncBatch> batches(nodes.size());
+    std::vector<uint32_t> sent;
+    ::openmldb::api::BatchAppendEntriesRequest request;
+    butil::IOBuf attachment;
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        ReplicateNode* node = nodes[i].get();
+        if (budget == 0) {
+            again->push_back(node);
+            continue;
+        }
+        if (!node->IsLogMatched() && node->MatchLogOffsetFromNode() != 0) {
+            delayed->push_back(node);
+            continue;
+        }
+        uint64_t target = node->GetSyncTargetOffset();
+        if (target <= node->GetLastSyncOffset()) {
+            continue;
+        }
+        SyncBatch& batch = batches[i];
+        if (node->ReadEntries(target, UINT32_MAX, budget, &batch) < 0) {
+            again->push_back(node);
+            continue;
+        }
+        if (batch.Empty()) {
+            if (batch.need_wait) {
+                delayed->push_back(node);
+            }
+            continue;
+        }
+        uint64_t byte_size = batch.attachment.size() + batch.request.ByteSizeLong();
+        budget = byte_size >= budget ? 0 : budget - byte_size;
+        // the requests are swapped back after the rpc
+        request.add_requests()->Swap(&batch.request);
+        attachment.append(batch.attachment);
+        sent.push_back(i);
+    }
+    if (sent.empty()) {
+        return;
+    }
+    ::openmldb::api::BatchAppendEntriesResponse response;
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+    cntl.set_max_retry(FLAGS_request_max_retry);
+    cntl.request_attachment().swap(attachment);
+    uint64_t start = ::baidu::common::timer::get_micros();
+    bool ok = client->SendRequest(&::openmldb::api::TabletServer_Stub::BatchAppendEntries, &cntl, &request,
+                                  &response);
+    uint64_t latency_ms = (::baidu::common::timer::get_micros() - start) / 1000;
+    ok = ok && response.code() == 0 && response.responses_size() == request.requests_size();
+    if (!ok) {
+        PDLOG(WARNING, "fail to sync %d partitions to endpoint %s", request.requests_size(), real_endpoint.c_str());
+    }
+    ::openmldb::api::AppendEntriesResponse failed_response;
+    for (uint32_t k = 0; k < sent.size(); k++) {
+        ReplicateNode* node = nodes[sent[k]].get();
+        SyncBatch& batch = batches[sent[k]];
+        batch.request.Swap(request.mutable_requests(k));
+        node->FinishEntries(&batch, ok, ok ? response.responses(k) : failed_response);
+        if (batch.need_wait) {
+            delayed->push_back(node);
+        } else if (node->GetSyncTargetOffset() > node->GetLastSyncOffset()) {
+            again->push_back(node);
+        }
+    }
+    if (!ok) {
+        return;
+    }
+    // halve the batch if the rpc is slower than the target and double it if the
+    // budget was used up within half of the target
+    uint64_t new_byte_size = batch_byte_size;
+    if (latency_ms > FLAGS_replication_latency_target_ms) {
+        new_byte_size = std::max(batch_byte_size / 2, (uint64_t)MIN_BATCH_BYTE_SIZE);
+    } else if (budget == 0 && latency_ms * 2 < FLAGS_replication_latency_target_ms) {
+        new_byte_size = std::min(batch_byte_size * 2, (uint64_t)FLAGS_replication_batch_max_bytes);
+    }
+    if (new_byte_size != batch_byte_size) {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = endpoints_.find(real_endpoint);
+        if (it != endpoints_.end()) {
+            it->second.batch_byte_size = new_byte_size;
+        }
+    }
+}
+
+}  // namespace replica
+}  // namespace openmldb
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_REPLICA_REPLICATION_SCHEDULER_H_
+#define SRC_REPLICA_REPLICATION_SCHEDULER_H_
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/thread_pool.h"
+#include "proto/tablet.pb.h"
+#include "replica/replicate_node.h"
+#include "rpc/rpc_client.h"
+
+namespace openmldb {
+namespace replica {
+
+using ::baidu::common::ThreadPool;
+
+class LogReplicator;
+
+// ReplicationScheduler syncs the replicate nodes of all the partitions in a tablet
+// with a few shared threads instead of one sync loop per node. The nodes bound for
+// the same endpoint are served by at most one thread at a time, which coalesces the
+// entries of many partitions into one BatchAppendEntries rpc. The nodes are scheduled
+// when the leader log is appended. A tick reschedules the nodes lagging behind in
+// case of no notification, e.g. binlog_notify_on_put is off
+class ReplicationScheduler {
+ public:
+    explicit ReplicationScheduler(uint32_t thread_num);
+    ~ReplicationScheduler();
+
+    void Start();
+    void Stop();
+
+    void AddNode(LogReplicator* owner, const std::shared_ptr<ReplicateNode>& node);
+
+    // remove the node and wait until it is not synced by any thread
+    void DelNode(ReplicateNode* node);
+
+    // the log of owner is appended
+    void Notify(LogReplicator* owner);
+
+    // the byte size budget of one rpc to endpoint which adapts to the rpc latency
+    uint32_t GetBatchByteSize(const std::string& real_endpoint);
+
+    ReplicationScheduler(const ReplicationScheduler&) = delete;
+    ReplicationScheduler& operator=(const ReplicationScheduler&) = delete;
+
+ private:
+    struct NodeState {
+        std::shared_ptr<ReplicateNode> node;
+        LogReplicator* owner;
+        // the node is in the ready queue of its endpoint
+        bool pending;
+        // the node is being synced
+        bool busy;
+    };
+
+    struct EndpointState {
+        std::shared_ptr<::openmldb::RpcClient<::openmldb::api::TabletServer_Stub>> client;
+        std::deque<ReplicateNode*> ready;
+        uint32_t node_cnt;
+        // a thread is serving the endpoint
+        bool running;
+        uint32_t batch_byte_size;
+    };
+
+    // mu_ must be held
+    void ScheduleLocked(NodeState* state);
+    void Wakeup(ReplicateNode* node);
+    void RunEndpoint(const std::string& real_endpoint);
+    // sync the nodes in one rpc and return the nodes to be scheduled again
+    void SyncNodes(const std::string& real_endpoint,
+                   const std::vector<std::shared_ptr<ReplicateNode>>& nodes,
+                   std::vector<ReplicateNode*>* again, std::vector<ReplicateNode*>* delayed);
+    void Tick();
+
+ private:
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::map<ReplicateNode*, NodeState> nodes_;
+    std::map<LogReplicator*, std::vector<ReplicateNode*>> owners_;
+    std::map<std::string, EndpointState> endpoints_;
+    bool running_;
+    ThreadPool pool_;
+    ThreadPool tick_pool_;
+};
+
+}  // namespace replica
+}  // namespace openmldb
+
+#endif  // SRC_REPLICA_REPLICATION_SCHEDULER_H_
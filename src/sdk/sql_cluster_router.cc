@@ -16,9 +16,11 @@
 
 #include "sdk/sql_cluster_router.h"
 
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "boost/none.hpp"
 #include "brpc/channel.h"
@@ -1050,6 +1052,113 @@ bool SQLClusterRouter::PutRow(uint32_t tid, const std::shared_ptr<SQLInsertRow>&
     return true;
 }
 
+bool SQLClusterRouter::PutRows(uint32_t tid, const std::shared_ptr<SQLInsertRows>& rows,
+                               const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                               ::hybridse::sdk::Status* status) {
+    typedef openmldb::RpcCallback<openmldb::api::PutBatchResponse> PutBatchCallback;
+    std::map<uint32_t, ::openmldb::api::PutBatchRequest> requests;
+    // at most one batch of a partition is in flight, so the rows of the same key are put in order.
+    // the partitions are put concurrently
+    std::map<uint32_t, PutBatchCallback*> callbacks;
+    bool ok = true;
+    auto wait = [&](uint32_t pid) {
+        auto it = callbacks.find(pid);
+        if (it == callbacks.end()) {
+            return;
+        }
+        PutBatchCallback* callback = it->second;
+        callbacks.erase(it);
+        brpc::Join(callback->GetController()->call_id());
+        const auto& response = callback->GetResponse();
+        if (callback->GetController()->Failed() || response->code() != 0) {
+            if (ok) {
+                status->msg = "fail to make a put request to table. tid " + std::to_string(tid) + " pid " +
+                              std::to_string(pid);
+                if (response->failed_idx_size() > 0) {
+                    status->msg += ", " + std::to_string(response->failed_idx_size()) + " rows of the batch failed";
+                }
+                LOG(WARNING) << status->msg << ". " << response->msg();
+            }
+            ok = false;
+        }
+        callback->UnRef();
+    };
+    auto send = [&](uint32_t pid, ::openmldb::api::PutBatchRequest* request) {
+        wait(pid);
+        if (!ok) {
+            return;
+        }
+        auto response = std::make_shared<openmldb::api::PutBatchResponse>();
+        auto cntl = std::make_shared<brpc::Controller>();
+        cntl->set_timeout_ms(options_.request_timeout);
+        PutBatchCallback* callback = new PutBatchCallback(response, cntl);
+        // the request is serialized before the call returns
+        callback->Ref();
+        if (!tablets[pid]->GetClient()->AsyncPutBatch(*request, callback)) {
+            callback->UnRef();
+            callback->UnRef();
+            ok = false;
+        } else {
+            callbacks.emplace(pid, callback);
+        }
+        request->clear_rows();
+    };
+    for (uint32_t i = 0; i < rows->GetCnt() && ok; ++i) {
+        std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
+        const auto& ts_dimensions = row->GetTs();
+        uint64_t cur_ts = 0;
+        if (ts_dimensions.empty()) {
+            cur_ts = ::baidu::common::timer::get_micros() / 1000;
+        }
+        for (const auto& kv : row->GetDimensions()) {
+            uint32_t pid = kv.first;
+            if (pid >= tablets.size() || !tablets[pid] || !tablets[pid]->GetClient()) {
+                status->msg = "fail to get tablet client. pid " + std::to_string(pid);
+                LOG(WARNING) << status->msg;
+                ok = false;
+                break;
+            }
+            ::openmldb::api::PutBatchRequest& request = requests[pid];
+            if (!request.has_tid()) {
+                request.set_tid(tid);
+                request.set_pid(pid);
+                request.set_format_version(1);
+            }
+            ::openmldb::api::PutRequest* put = request.add_rows();
+            put->set_value(row->GetRow());
+            for (const auto& dim : kv.second) {
+                ::openmldb::api::Dimension* d = put->add_dimensions();
+                d->set_key(dim.first);
+                d->set_idx(dim.second);
+            }
+            if (ts_dimensions.empty()) {
+                put->set_time(cur_ts);
+            } else {
+                for (size_t idx = 0; idx < ts_dimensions.size(); idx++) {
+                    ::openmldb::api::TSDimension* d = put->add_ts_dimensions();
+                    d->set_ts(ts_dimensions[idx]);
+                    d->set_idx(idx);
+                }
+            }
+            if ((uint32_t)request.rows_size() >= options_.put_batch_size) {
+                send(pid, &request);
+            }
+        }
+    }
+    for (auto& kv : requests) {
+        if (ok && kv.second.rows_size() > 0) {
+            send(kv.first, &kv.second);
+        }
+    }
+    while (!callbacks.empty()) {
+        wait(callbacks.begin()->first);
+    }
+    if (!ok && status->msg.empty()) {
+        status->msg = "fail to make a put request to table. tid " + std::to_string(tid);
+    }
+    return ok;
+}
+
 bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
                                      hybridse::sdk::Status* status) {
     if (!rows || !status) {
@@ -1066,6 +1175,9 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             LOG(WARNING) << status->msg;
             return false;
         }
+        if (options_.put_batch_size > 0) {
+            return PutRows(table_info->tid(), rows, tablets, status);
+        }
         for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
             std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
             if (!PutRow(table_info->tid(), row, tablets, status)) {
@@ -191,6 +191,11 @@ class SQLClusterRouter : public SQLRouter {
                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
                 ::hybridse::sdk::Status* status);
 
+    // group the rows by partition and send the batches without waiting for the previous ones
+    bool PutRows(uint32_t tid, const std::shared_ptr<SQLInsertRows>& rows,
+                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                 ::hybridse::sdk::Status* status);
+
     bool IsConstQuery(::hybridse::vm::PhysicalOpNode* node);
     std::shared_ptr<SQLCache> GetCache(const std::string& db, const std::string& sql);
 
@@ -37,6 +37,9 @@ struct SQLRouterOptions {
     uint32_t session_timeout = 2000;
     uint32_t max_sql_cache_size = 10;
     uint32_t request_timeout = 60000;
+    // insert rows with PutBatch rpcs of at most put_batch_size rows per partition.
+    // 0 means one Put rpc per row, which works with the tablets without PutBatch
+    uint32_t put_batch_size = 0;
 };
 
 class ExplainInfo {
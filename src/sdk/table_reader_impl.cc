@@ -17,10 +17,13 @@
 #include "sdk/table_reader_impl.h"
 
 #include <memory>
+#include <string>
 #include <utility>
 
 #include "base/hash.h"
 #include "brpc/channel.h"
+#include "butil/iobuf.h"
+#include "client/stream_kv_iterator.h"
 #include "client/tablet_client.h"
 #include "proto/tablet.pb.h"
 #include "sdk/result_set_sql.h"
@@ -191,14 +194,32 @@ std::shared_ptr<hybridse::sdk::ResultSet> TableReaderImpl::Scan(const std::strin
     if (so.at_least > 0) {
         request.set_atleast(so.at_least);
     }
-    auto response = std::make_shared<::openmldb::api::ScanResponse>();
+    // the tablet pushes the rows through a stream, so a large scan is neither limited by
+    // scan_max_bytes_size nor buffered in a single response by the tablet
+    std::string msg;
+    auto it = client->ScanStream(request, &msg);
+    if (!it) {
+        status->code = -1;
+        status->msg = msg;
+        return std::shared_ptr<hybridse::sdk::ResultSet>();
+    }
+    // the result set reads the rows from the attachment of the controller
     auto cntl = std::make_shared<::brpc::Controller>();
-    client->Scan(request, cntl.get(), response.get());
-    if (response->code() != 0) {
-        status->code = response->code();
-        status->msg = response->msg();
+    butil::IOBuf& buf = cntl->response_attachment();
+    for (; it->Valid(); it->Next()) {
+        ::openmldb::base::Slice value = it->GetValue();
+        buf.append(value.data(), value.size());
+    }
+    int32_t code = it->GetCode();
+    if (code != 0) {
+        status->code = code;
+        status->msg = code == -1 ? "stream is closed by the tablet" : it->GetMsg();
         return std::shared_ptr<hybridse::sdk::ResultSet>();
     }
+    auto response = std::make_shared<::openmldb::api::ScanResponse>();
+    response->set_code(code);
+    response->set_count(it->GetCount());
+    response->set_buf_size(buf.size());
     auto rs = ResultSetSQL::MakeResultSet(response, request.projection(), cntl, table_handler, status);
     return rs;
 }
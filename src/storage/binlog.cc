@@ -17,6 +17,7 @@
 #include "storage/binlog.h"
 
 #include <map>
+#include <memory>
 #include <set>
 #include <utility>
 #include <vector>
@@ -31,14 +32,17 @@
 #include "gflags/gflags.h"
 #include "log/log_writer.h"
 #include "log/status.h"
+#include "storage/sharded_replayer.h"
 
 DECLARE_uint64(gc_on_table_recover_count);
 DECLARE_int32(binlog_name_length);
+DECLARE_uint32(load_table_thread_num);
 
 namespace openmldb {
 namespace storage {
 
-Binlog::Binlog(LogParts* log_part, const std::string& binlog_path) : log_part_(log_part), log_path_(binlog_path) {}
+Binlog::Binlog(LogParts* log_part, const std::string& binlog_path)
+    : log_part_(log_part), log_path_(binlog_path), recover_record_cnt_(0), recover_byte_size_(0) {}
 
 bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, uint64_t& latest_offset) {
     uint32_t tid = table->GetId();
@@ -54,6 +58,12 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
     uint64_t consumed = ::baidu::common::timer::now_time();
     int last_log_index = log_reader.GetLogIndex();
     bool reach_end_log = true;
+    std::unique_ptr<ShardedReplayer> replayer;
+    if (FLAGS_load_table_thread_num > 1) {
+        replayer.reset(new ShardedReplayer(table, FLAGS_load_table_thread_num));
+    }
+    recover_record_cnt_ = 0;
+    recover_byte_size_ = 0;
     while (true) {
         buffer.clear();
         ::openmldb::base::Slice record;
@@ -89,7 +99,7 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             failed_cnt++;
             continue;
         }
-        bool ok = entry.ParseFromString(record.ToString());
+        bool ok = entry.ParseFromArray(record.data(), record.size());
         if (!ok) {
             PDLOG(WARNING, "fail parse record for tid %u, pid %u with value %s", tid, pid,
                   ::openmldb::base::DebugString(record.ToString()).c_str());
@@ -109,17 +119,25 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
                   cur_offset, entry.log_index(), tid, pid);
         }
 
+        cur_offset = entry.log_index();
         if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
             if (entry.dimensions_size() == 0) {
                 PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid, pid, entry.log_index());
             } else {
+                // delete may cover keys of other shards, apply the puts before it
+                if (replayer) {
+                    replayer->Flush();
+                    replayer->Wait();
+                }
                 table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
             }
+        } else if (replayer) {
+            replayer->Put(&entry);
         } else {
             table->Put(entry);
         }
-        cur_offset = entry.log_index();
         succ_cnt++;
+        recover_byte_size_ += record.size();
         if (succ_cnt % 100000 == 0) {
             PDLOG(INFO,
                   "[Recover] load data from binlog succ_cnt %lu, failed_cnt "
@@ -130,6 +148,11 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             table->SchedGc();
         }
     }
+    if (replayer) {
+        replayer->Flush();
+        replayer->Wait();
+    }
+    recover_record_cnt_ = succ_cnt;
     latest_offset = cur_offset;
     if (!reach_end_log) {
         int log_index = log_reader.GetLogIndex();
@@ -35,9 +35,15 @@ class Binlog {
     bool RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset,
                            uint64_t& latest_offset);  // NOLINT
 
+    // the records and bytes replayed by the last RecoverFromBinlog
+    uint64_t GetRecoverRecordCnt() const { return recover_record_cnt_; }
+    uint64_t GetRecoverByteSize() const { return recover_byte_size_; }
+
  private:
     LogParts* log_part_;
     std::string log_path_;
+    uint64_t recover_record_cnt_;
+    uint64_t recover_byte_size_;
 };
 
 }  // namespace storage
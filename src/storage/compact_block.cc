@@ -0,0 +1,177 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/compact_block.h"
+
+#include <snappy.h>
+
+#include "base/glog_wapper.h"
+
+namespace openmldb {
+namespace storage {
+
+static void PutVarint64(std::string* dst, uint64_t value) {
+    while (value >= 0x80) {
+        dst->push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    dst->push_back(static_cast<char>(value));
+}
+
+static bool GetVarint64(const char** cur, const char* limit, uint64_t* value) {
+    uint64_t result = 0;
+    for (uint32_t shift = 0; shift <= 63 && *cur < limit; shift += 7) {
+        uint64_t byte = static_cast<uint8_t>(**cur);
+        (*cur)++;
+        result |= (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+CompactBlock* CompactBlock::Encode(const std::vector<std::pair<uint64_t, Slice>>& rows) {
+    if (rows.empty()) {
+        return NULL;
+    }
+    CompactBlock* block = new CompactBlock();
+    block->max_ts = rows.front().first;
+    block->min_ts = rows.back().first;
+    block->cnt = rows.size();
+    std::string raw;
+    uint64_t pre_ts = block->max_ts;
+    // ts column, the first one is max_ts
+    for (const auto& row : rows) {
+        PutVarint64(&block->data, pre_ts - row.first);
+        pre_ts = row.first;
+    }
+    // size column
+    for (const auto& row : rows) {
+        PutVarint64(&block->data, row.second.size());
+        raw.append(row.second.data(), row.second.size());
+    }
+    std::string compressed;
+    ::snappy::Compress(raw.data(), raw.size(), &compressed);
+    block->data.append(compressed);
+    block->data.shrink_to_fit();
+    return block;
+}
+
+bool CompactBlockReader::Reset(const CompactBlock* block) {
+    ts_.clear();
+    offset_.clear();
+    rows_.clear();
+    if (block == NULL) {
+        return false;
+    }
+    const char* cur = block->data.data();
+    const char* limit = cur + block->data.size();
+    ts_.reserve(block->cnt);
+    offset_.reserve(block->cnt + 1);
+    uint64_t ts = block->max_ts;
+    for (uint32_t i = 0; i < block->cnt; i++) {
+        uint64_t delta = 0;
+        if (!GetVarint64(&cur, limit, &delta)) {
+            PDLOG(WARNING, "fail to decode ts column of compact block");
+            ts_.clear();
+            return false;
+        }
+        ts -= delta;
+        ts_.push_back(ts);
+    }
+    uint64_t offset = 0;
+    offset_.push_back(0);
+    for (uint32_t i = 0; i < block->cnt; i++) {
+        uint64_t size = 0;
+        if (!GetVarint64(&cur, limit, &size)) {
+            PDLOG(WARNING, "fail to decode size column of compact block");
+            ts_.clear();
+            return false;
+        }
+        offset += size;
+        offset_.push_back(offset);
+    }
+    if (!::snappy::Uncompress(cur, limit - cur, &rows_) || rows_.size() != offset) {
+        PDLOG(WARNING, "fail to uncompress rows of compact block");
+        ts_.clear();
+        return false;
+    }
+    return true;
+}
+
+void CompactBlockIterator::Load(const CompactBlock* block) {
+    cur_ = block;
+    pos_ = 0;
+    while (cur_ != NULL && (!reader_.Reset(cur_) || reader_.GetCnt() == 0)) {
+        cur_ = cur_->next;
+    }
+}
+
+void CompactBlockIterator::Next() {
+    if (cur_ == NULL) {
+        return;
+    }
+    pos_++;
+    if (pos_ >= reader_.GetCnt()) {
+        Load(cur_->next);
+    }
+}
+
+void CompactBlockIterator::Seek(uint64_t ts) {
+    const CompactBlock* block = head_;
+    while (block != NULL && block->min_ts > ts) {
+        block = block->next;
+    }
+    Load(block);
+    if (cur_ == NULL) {
+        return;
+    }
+    // the rows are in desc order, find the first one less or equal than ts
+    uint32_t low = 0;
+    uint32_t high = reader_.GetCnt();
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (reader_.GetTs(mid) > ts) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    pos_ = low;
+    if (pos_ >= reader_.GetCnt()) {
+        Load(cur_->next);
+    }
+}
+
+void CompactBlockIterator::SeekToFirst() { Load(head_); }
+
+void CompactBlockIterator::SeekToLast() {
+    const CompactBlock* last = NULL;
+    for (const CompactBlock* block = head_; block != NULL; block = block->next) {
+        if (block->cnt > 0) {
+            last = block;
+        }
+    }
+    Load(last);
+    if (cur_ != NULL) {
+        pos_ = reader_.GetCnt() - 1;
+    }
+}
+
+}  // namespace storage
+}  // namespace openmldb
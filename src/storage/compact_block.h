@@ -0,0 +1,105 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_COMPACT_BLOCK_H_
+#define SRC_STORAGE_COMPACT_BLOCK_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/slice.h"
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::base::Slice;
+
+// CompactBlock keeps the cold rows of one key entry. The data is laid out
+// column by column: the delta encoded timestamps, the row sizes and then
+// the snappy compressed row payloads. Blocks of a key entry are chained
+// from the newest to the oldest and their time ranges never overlap
+struct CompactBlock {
+    CompactBlock()
+        : max_ts(0), min_ts(0), cnt(0), raw_byte_size(0), record_cnt(0), record_byte_size(0), next(NULL) {}
+
+    // rows must be sorted by time in desc order
+    static CompactBlock* Encode(const std::vector<std::pair<uint64_t, Slice>>& rows);
+
+    // the memory hold by this block
+    inline uint64_t GetByteSize() const { return sizeof(CompactBlock) + data.size(); }
+
+    uint64_t max_ts;
+    uint64_t min_ts;
+    uint32_t cnt;
+    // the memory released by rows and index nodes when building this block
+    uint64_t raw_byte_size;
+    // the record count and byte size released by gc when this block is freed
+    uint64_t record_cnt;
+    uint64_t record_byte_size;
+    CompactBlock* next;
+    std::string data;
+};
+
+// decode all the rows of a compact block
+class CompactBlockReader {
+ public:
+    CompactBlockReader() : ts_(), offset_(), rows_() {}
+
+    bool Reset(const CompactBlock* block);
+
+    inline uint32_t GetCnt() const { return ts_.size(); }
+    inline const uint64_t& GetTs(uint32_t pos) const { return ts_[pos]; }
+    inline const char* GetData(uint32_t pos) const { return rows_.data() + offset_[pos]; }
+    inline uint32_t GetSize(uint32_t pos) const { return offset_[pos + 1] - offset_[pos]; }
+
+ private:
+    std::vector<uint64_t> ts_;
+    std::vector<uint32_t> offset_;
+    std::string rows_;
+};
+
+// iterate the rows of a compact block chain in desc time order
+class CompactBlockIterator {
+ public:
+    explicit CompactBlockIterator(const CompactBlock* head) : head_(head), cur_(NULL), pos_(0), reader_() {}
+
+    inline bool Valid() const { return cur_ != NULL; }
+    void Next();
+    // seek to the first row whose time is less or equal than ts
+    void Seek(uint64_t ts);
+    void SeekToFirst();
+    void SeekToLast();
+    inline const uint64_t& GetKey() const { return reader_.GetTs(pos_); }
+    inline const char* GetData() const { return reader_.GetData(pos_); }
+    inline uint32_t GetSize() const { return reader_.GetSize(pos_); }
+
+ private:
+    // load the first readable block from block
+    void Load(const CompactBlock* block);
+
+ private:
+    const CompactBlock* head_;
+    const CompactBlock* cur_;
+    uint32_t pos_;
+    CompactBlockReader reader_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_COMPACT_BLOCK_H_
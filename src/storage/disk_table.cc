@@ -0,0 +1,900 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/disk_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/glog_wapper.h"
+#include "common/timer.h"
+#include "gflags/gflags.h"
+#include "leveldb/cache.h"
+#include "leveldb/options.h"
+
+DECLARE_uint32(max_traverse_cnt);
+DECLARE_string(file_compression);
+DECLARE_uint32(block_cache_mb);
+DECLARE_uint32(write_buffer_mb);
+DECLARE_bool(disable_wal);
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t GC_BATCH_SIZE = 1000;
+static const uint32_t TS_SIZE = sizeof(uint64_t);
+static const uint32_t OFFSET_SIZE = sizeof(uint64_t);
+static const uint32_t ROW_SUFFIX_SIZE = TS_SIZE + OFFSET_SIZE;
+static const uint32_t PREFIX_HEAD_SIZE = 2 * sizeof(uint32_t);
+// the meta of table is out of the range of any index
+static const uint32_t META_INDEX_ID = UINT32_MAX;
+
+static void PutFixed32BE(uint32_t value, std::string* dst) {
+    for (int i = 3; i >= 0; i--) {
+        dst->push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+    }
+}
+
+static void PutFixed64BE(uint64_t value, std::string* dst) {
+    for (int i = 7; i >= 0; i--) {
+        dst->push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+    }
+}
+
+static uint64_t DecodeFixed64BE(const char* ptr) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (value << 8) | static_cast<uint8_t>(ptr[i]);
+    }
+    return value;
+}
+
+static uint32_t DecodeFixed32BE(const char* ptr) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value = (value << 8) | static_cast<uint8_t>(ptr[i]);
+    }
+    return value;
+}
+
+// the block cache is shared by all the disk tables in this process
+static ::leveldb::Cache* GetBlockCache() {
+    static ::leveldb::Cache* cache = ::leveldb::NewLRUCache(static_cast<size_t>(FLAGS_block_cache_mb) << 20);
+    return cache;
+}
+
+static DiskSnapshot MakeSnapshot(::leveldb::DB* db) {
+    return DiskSnapshot(db->GetSnapshot(),
+                        [db](const ::leveldb::Snapshot* snapshot) { db->ReleaseSnapshot(snapshot); });
+}
+
+static ::leveldb::Iterator* NewDBIterator(::leveldb::DB* db, const DiskSnapshot& snapshot) {
+    ::leveldb::ReadOptions read_options;
+    read_options.snapshot = snapshot.get();
+    return db->NewIterator(read_options);
+}
+
+// position it after the last row of the pk
+static void SeekAfterPK(::leveldb::Iterator* it, const std::string& prefix) {
+    std::string last_key = prefix;
+    DiskTableKeyCodec::AppendTsEnd(0, &last_key);
+    it->Seek(last_key);
+}
+
+// the log offset and record count saved in db, see DiskTable::SaveOffset
+static std::string EncodeOffsetKey() {
+    std::string key = DiskTableKeyCodec::EncodeIndex(META_INDEX_ID);
+    key.append("offset");
+    return key;
+}
+
+static std::string EncodeOffsetValue(uint64_t offset, uint64_t record_cnt) {
+    std::string value;
+    PutFixed64BE(offset, &value);
+    PutFixed64BE(record_cnt, &value);
+    return value;
+}
+
+std::string DiskTableKeyCodec::EncodeIndex(uint32_t index_id) {
+    std::string key;
+    PutFixed32BE(index_id, &key);
+    return key;
+}
+
+std::string DiskTableKeyCodec::EncodePrefix(uint32_t index_id, const std::string& pk) {
+    std::string key;
+    key.reserve(PREFIX_HEAD_SIZE + pk.size() + ROW_SUFFIX_SIZE);
+    PutFixed32BE(index_id, &key);
+    PutFixed32BE(pk.size(), &key);
+    key.append(pk);
+    return key;
+}
+
+std::string DiskTableKeyCodec::EncodeKey(uint32_t index_id, const std::string& pk, uint64_t ts, uint64_t offset) {
+    std::string key = EncodePrefix(index_id, pk);
+    AppendTs(ts, &key);
+    PutFixed64BE(UINT64_MAX - offset, &key);
+    return key;
+}
+
+void DiskTableKeyCodec::AppendTs(uint64_t ts, std::string* dst) { PutFixed64BE(UINT64_MAX - ts, dst); }
+
+void DiskTableKeyCodec::AppendTsEnd(uint64_t ts, std::string* dst) {
+    AppendTs(ts, dst);
+    // the offset 0 is never used by rows
+    dst->append(OFFSET_SIZE, static_cast<char>(0xff));
+}
+
+uint64_t DiskTableKeyCodec::DecodeTs(const ::leveldb::Slice& key) {
+    return UINT64_MAX - DecodeFixed64BE(key.data() + key.size() - ROW_SUFFIX_SIZE);
+}
+
+::leveldb::Slice DiskTableKeyCodec::DecodePrefix(const ::leveldb::Slice& key) {
+    return ::leveldb::Slice(key.data(), key.size() - ROW_SUFFIX_SIZE);
+}
+
+std::string DiskTableKeyCodec::DecodePK(const ::leveldb::Slice& key) {
+    uint32_t pk_size = DecodeFixed32BE(key.data() + sizeof(uint32_t));
+    return std::string(key.data() + PREFIX_HEAD_SIZE, pk_size);
+}
+
+DiskTable::DiskTable(const ::openmldb::api::TableMeta& table_meta, const std::string& db_path)
+    : Table(table_meta.name(), table_meta.tid(), table_meta.pid(), 0, true, 60 * 1000,
+            std::map<std::string, uint32_t>(), ::openmldb::type::TTLType::kAbsoluteTime,
+            ::openmldb::type::CompressType::kNoCompress),
+      db_path_(db_path),
+      db_(NULL),
+      enable_gc_(true),
+      record_cnt_(0),
+      offset_(0) {
+    diskused_ = 0;
+    table_meta_ = std::make_shared<::openmldb::api::TableMeta>(table_meta);
+}
+
+DiskTable::~DiskTable() {
+    if (db_ != NULL) {
+        delete db_;
+        db_ = NULL;
+    }
+    PDLOG(INFO, "drop disk table. tid %u pid %u", id_, pid_);
+}
+
+bool DiskTable::Init() {
+    if (!InitFromMeta()) {
+        return false;
+    }
+    ::leveldb::Options options;
+    options.create_if_missing = true;
+    options.block_cache = GetBlockCache();
+    options.write_buffer_size = static_cast<size_t>(FLAGS_write_buffer_mb) << 20;
+    // leveldb only supports snappy
+    if (FLAGS_file_compression == "off") {
+        options.compression = ::leveldb::kNoCompression;
+    } else {
+        options.compression = ::leveldb::kSnappyCompression;
+    }
+    if (!::openmldb::base::MkdirRecur(db_path_)) {
+        PDLOG(WARNING, "fail to create path %s. tid %u pid %u", db_path_.c_str(), id_, pid_);
+        return false;
+    }
+    // the rows in db are kept, only the binlog after the saved offset is replayed when the table is loaded
+    ::leveldb::Status status = ::leveldb::DB::Open(options, db_path_, &db_);
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to open %s: %s. tid %u pid %u", db_path_.c_str(), status.ToString().c_str(), id_,
+              pid_);
+        return false;
+    }
+    std::string value;
+    status = db_->Get(::leveldb::ReadOptions(), EncodeOffsetKey(), &value);
+    if (status.ok() && value.size() == 2 * sizeof(uint64_t)) {
+        offset_.store(DecodeFixed64BE(value.data()), std::memory_order_relaxed);
+        record_cnt_.store(DecodeFixed64BE(value.data() + sizeof(uint64_t)), std::memory_order_relaxed);
+    } else if (!status.ok() && !status.IsNotFound()) {
+        PDLOG(WARNING, "fail to read offset of %s: %s. tid %u pid %u", db_path_.c_str(), status.ToString().c_str(),
+              id_, pid_);
+        return false;
+    }
+    PDLOG(INFO, "init disk table name %s, id %d, pid %d, path %s, offset %lu, record cnt %lu", name_.c_str(), id_,
+          pid_, db_path_.c_str(), offset_.load(std::memory_order_relaxed),
+          record_cnt_.load(std::memory_order_relaxed));
+    return true;
+}
+
+::leveldb::WriteOptions DiskTable::GetWriteOptions() const {
+    // leveldb always writes its log, so the log is synced if wal is enabled, otherwise the rows
+    // lost by a crash are recovered from binlog after the saved offset
+    ::leveldb::WriteOptions options;
+    options.sync = !FLAGS_disable_wal;
+    return options;
+}
+
+bool DiskTable::SaveOffset(uint64_t offset) {
+    ::leveldb::Status status =
+        db_->Put(GetWriteOptions(), EncodeOffsetKey(),
+                 EncodeOffsetValue(offset, record_cnt_.load(std::memory_order_relaxed)));
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to save offset %lu: %s. tid %u pid %u", offset, status.ToString().c_str(), id_, pid_);
+        return false;
+    }
+    offset_.store(offset, std::memory_order_relaxed);
+    return true;
+}
+
+bool DiskTable::WriteRows(uint64_t offset, ::leveldb::WriteBatch* batch) {
+    uint64_t record_cnt = record_cnt_.fetch_add(1, std::memory_order_relaxed) + 1;
+    // the rows are recovered out of log order while loading, the offset is saved after it finishes
+    bool save_offset = GetTableStat() != ::openmldb::storage::kLoading;
+    if (save_offset) {
+        batch->Put(EncodeOffsetKey(), EncodeOffsetValue(offset, record_cnt));
+    }
+    ::leveldb::Status status = db_->Write(GetWriteOptions(), batch);
+    if (!status.ok()) {
+        record_cnt_.fetch_sub(1, std::memory_order_relaxed);
+        PDLOG(WARNING, "fail to put: %s. tid %u pid %u", status.ToString().c_str(), id_, pid_);
+        return false;
+    }
+    if (save_offset) {
+        offset_.store(offset, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool DiskTable::Put(const LogEntry& entry) {
+    ::leveldb::WriteBatch batch;
+    bool ok = false;
+    if (entry.dimensions_size() > 0) {
+        ok = entry.ts_dimensions_size() > 0
+                 ? AddRows(entry.dimensions(), entry.ts_dimensions(), entry.value(), entry.log_index(), &batch)
+                 : AddRows(entry.ts(), entry.value(), entry.dimensions(), entry.log_index(), &batch);
+    } else {
+        ok = AddRows(entry.pk(), entry.ts(), ::leveldb::Slice(entry.value()), entry.log_index(), &batch);
+    }
+    return ok && WriteRows(entry.log_index(), &batch);
+}
+
+bool DiskTable::Put(const std::string& pk, uint64_t time, const char* data, uint32_t size) {
+    uint64_t offset = offset_.load(std::memory_order_relaxed) + 1;
+    ::leveldb::WriteBatch batch;
+    return AddRows(pk, time, ::leveldb::Slice(data, size), offset, &batch) && WriteRows(offset, &batch);
+}
+
+bool DiskTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions) {
+    uint64_t offset = offset_.load(std::memory_order_relaxed) + 1;
+    ::leveldb::WriteBatch batch;
+    return AddRows(time, value, dimensions, offset, &batch) && WriteRows(offset, &batch);
+}
+
+bool DiskTable::Put(const Dimensions& dimensions, const TSDimensions& ts_dimensions, const std::string& value) {
+    uint64_t offset = offset_.load(std::memory_order_relaxed) + 1;
+    ::leveldb::WriteBatch batch;
+    return AddRows(dimensions, ts_dimensions, value, offset, &batch) && WriteRows(offset, &batch);
+}
+
+bool DiskTable::AddRows(const std::string& pk, uint64_t time, const ::leveldb::Slice& value, uint64_t offset,
+                        ::leveldb::WriteBatch* batch) {
+    auto inner_index = table_index_.GetInnerIndex(0);
+    if (!inner_index) {
+        return false;
+    }
+    for (const auto& index_def : inner_index->GetIndex()) {
+        if (index_def->IsReady()) {
+            batch->Put(DiskTableKeyCodec::EncodeKey(index_def->GetId(), pk, time, offset), value);
+        }
+    }
+    return true;
+}
+
+bool DiskTable::AddRows(uint64_t time, const std::string& value, const Dimensions& dimensions, uint64_t offset,
+                        ::leveldb::WriteBatch* batch) {
+    std::map<int32_t, std::string> inner_index_key_map;
+    for (auto iter = dimensions.begin(); iter != dimensions.end(); iter++) {
+        int32_t inner_pos = table_index_.GetInnerIndexPos(iter->idx());
+        if (inner_pos < 0) {
+            PDLOG(WARNING, "invalid dimesion. dimesion idx %u, tid %u pid %u", iter->idx(), id_, pid_);
+            return false;
+        }
+        inner_index_key_map.emplace(inner_pos, iter->key());
+    }
+    for (const auto& kv : inner_index_key_map) {
+        auto inner_index = table_index_.GetInnerIndex(kv.first);
+        if (!inner_index) {
+            PDLOG(WARNING, "invalid inner index pos %d. tid %u pid %u", kv.first, id_, pid_);
+            return false;
+        }
+        for (const auto& index_def : inner_index->GetIndex()) {
+            if (index_def->GetTsColumn()) {
+                PDLOG(WARNING, "has set col. tid %u pid %u", id_, pid_);
+                return false;
+            }
+            if (index_def->IsReady()) {
+                batch->Put(DiskTableKeyCodec::EncodeKey(index_def->GetId(), kv.second, time, offset), value);
+            }
+        }
+    }
+    return true;
+}
+
+bool DiskTable::AddRows(const Dimensions& dimensions, const TSDimensions& ts_dimensions, const std::string& value,
+                        uint64_t offset, ::leveldb::WriteBatch* batch) {
+    if (dimensions.empty() || ts_dimensions.empty()) {
+        PDLOG(WARNING, "empty dimension. tid %u pid %u", id_, pid_);
+        return false;
+    }
+    std::map<int32_t, std::string> inner_index_key_map;
+    for (auto iter = dimensions.begin(); iter != dimensions.end(); iter++) {
+        int32_t inner_pos = table_index_.GetInnerIndexPos(iter->idx());
+        if (inner_pos < 0) {
+            PDLOG(WARNING, "invalid dimension. dimension idx %u, tid %u pid %u", iter->idx(), id_, pid_);
+            return false;
+        }
+        inner_index_key_map.emplace(inner_pos, iter->key());
+    }
+    for (const auto& kv : inner_index_key_map) {
+        auto inner_index = table_index_.GetInnerIndex(kv.first);
+        if (!inner_index) {
+            PDLOG(WARNING, "invalid inner index pos %d. tid %u pid %u", kv.first, id_, pid_);
+            return false;
+        }
+        for (const auto& index_def : inner_index->GetIndex()) {
+            if (!index_def->IsReady()) {
+                continue;
+            }
+            auto ts_col = index_def->GetTsColumn();
+            bool has_found_ts = false;
+            uint64_t ts = 0;
+            if (ts_col) {
+                for (const auto& ts_dimension : ts_dimensions) {
+                    if (static_cast<int>(ts_dimension.idx()) == ts_col->GetTsIdx()) {
+                        has_found_ts = true;
+                        ts = ts_dimension.ts();
+                        break;
+                    }
+                }
+            } else if (ts_dimensions.size() == 1) {
+                has_found_ts = true;
+                ts = ts_dimensions.begin()->ts();
+            }
+            if (!has_found_ts) {
+                DEBUGLOG("cannot find ts of index %u. tid %u pid %u", index_def->GetId(), id_, pid_);
+                continue;
+            }
+            batch->Put(DiskTableKeyCodec::EncodeKey(index_def->GetId(), kv.second, ts, offset), value);
+        }
+    }
+    return true;
+}
+
+bool DiskTable::Delete(const std::string& pk, uint32_t idx) {
+    std::shared_ptr<IndexDef> index_def = GetIndex(idx);
+    if (!index_def || !index_def->IsReady()) {
+        return false;
+    }
+    auto inner_index = table_index_.GetInnerIndex(index_def->GetInnerPos());
+    if (!inner_index) {
+        return false;
+    }
+    ::leveldb::WriteBatch batch;
+    uint64_t delete_cnt = 0;
+    std::unique_ptr<::leveldb::Iterator> it(db_->NewIterator(::leveldb::ReadOptions()));
+    for (const auto& cur_index : inner_index->GetIndex()) {
+        std::string prefix = DiskTableKeyCodec::EncodePrefix(cur_index->GetId(), pk);
+        for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+            if (it->key().size() == prefix.size() + ROW_SUFFIX_SIZE) {
+                batch.Delete(it->key());
+                delete_cnt++;
+            }
+        }
+    }
+    if (delete_cnt == 0) {
+        return false;
+    }
+    ::leveldb::Status status = db_->Write(GetWriteOptions(), &batch);
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to delete pk %s: %s. tid %u pid %u", pk.c_str(), status.ToString().c_str(), id_, pid_);
+        return false;
+    }
+    return true;
+}
+
+DiskSnapshot DiskTable::NewSnapshot() { return MakeSnapshot(db_); }
+
+TableIterator* DiskTable::NewIterator(const std::string& pk, Ticket& ticket) { return NewIterator(0, pk, ticket); }
+
+TableIterator* DiskTable::NewIterator(uint32_t index, const std::string& pk, Ticket& ticket) {
+    std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(index);
+    if (!index_def || !index_def->IsReady()) {
+        PDLOG(WARNING, "index %d not found in table, tid %u pid %u", index, id_, pid_);
+        return NULL;
+    }
+    return new DiskTableIterator(db_, NewSnapshot(), DiskTableKeyCodec::EncodePrefix(index_def->GetId(), pk));
+}
+
+TableIterator* DiskTable::NewTraverseIterator(uint32_t index) {
+    std::shared_ptr<IndexDef> index_def = GetIndex(index);
+    if (!index_def || !index_def->IsReady()) {
+        PDLOG(WARNING, "index %u not found. tid %u pid %u", index, id_, pid_);
+        return NULL;
+    }
+    uint64_t expire_time = 0;
+    uint64_t expire_cnt = 0;
+    auto ttl = index_def->GetTTL();
+    if (enable_gc_.load(std::memory_order_relaxed)) {
+        expire_time = GetExpireTime(*ttl);
+        expire_cnt = ttl->lat_ttl;
+    }
+    return new DiskTableTraverseIterator(db_, NewSnapshot(), index_def->GetId(), ttl->ttl_type, expire_time,
+                                         expire_cnt);
+}
+
+::hybridse::vm::WindowIterator* DiskTable::NewWindowIterator(uint32_t index) {
+    std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(index);
+    if (!index_def || !index_def->IsReady()) {
+        LOG(WARNING) << "index" << index << "  not found. tid " << id_ << " pid " << pid_;
+        return NULL;
+    }
+    uint64_t expire_time = 0;
+    uint64_t expire_cnt = 0;
+    auto ttl = index_def->GetTTL();
+    if (enable_gc_.load(std::memory_order_relaxed)) {
+        expire_time = GetExpireTime(*ttl);
+        expire_cnt = ttl->lat_ttl;
+    }
+    return new DiskTableKeyIterator(db_, NewSnapshot(), index_def->GetId(), ttl->ttl_type, expire_time, expire_cnt);
+}
+
+void DiskTable::SchedGc() {
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    PDLOG(INFO, "start making gc for disk table %s, tid %u, pid %u", name_.c_str(), id_, pid_);
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_idx_cnt = 0;
+    for (const auto& index_def : table_index_.GetAllIndex()) {
+        uint64_t cur_gc_cnt = 0;
+        if (index_def->GetStatus() == IndexStatus::kWaiting) {
+            index_def->SetStatus(IndexStatus::kDeleting);
+            continue;
+        } else if (index_def->GetStatus() == IndexStatus::kDeleting) {
+            cur_gc_cnt = DeleteIndexData(index_def->GetId());
+            index_def->SetStatus(IndexStatus::kDeleted);
+        } else if (index_def->GetStatus() == IndexStatus::kDeleted) {
+            continue;
+        } else if (enable_gc_.load(std::memory_order_relaxed) && index_def->GetTTL()->NeedGc()) {
+            cur_gc_cnt = GcIndex(index_def->GetId(), *(index_def->GetTTL()));
+        }
+        gc_idx_cnt += cur_gc_cnt;
+        // every record has one row in the first index
+        if (index_def->GetId() == 0) {
+            gc_record_cnt = cur_gc_cnt;
+        }
+    }
+    uint64_t record_cnt = record_cnt_.load(std::memory_order_relaxed);
+    while (!record_cnt_.compare_exchange_weak(record_cnt, record_cnt > gc_record_cnt ? record_cnt - gc_record_cnt : 0,
+                                              std::memory_order_relaxed)) {
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    PDLOG(INFO, "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu consumed %lu ms for disk table %s tid %u pid %u",
+          gc_idx_cnt, gc_record_cnt, consumed / 1000, name_.c_str(), id_, pid_);
+    UpdateTTL();
+}
+
+uint64_t DiskTable::GcIndex(uint32_t index_id, const TTLSt& ttl_st) {
+    TTLSt expire_value(GetExpireTime(ttl_st), ttl_st.lat_ttl, ttl_st.ttl_type);
+    std::string index_prefix = DiskTableKeyCodec::EncodeIndex(index_id);
+    ::leveldb::ReadOptions read_options;
+    read_options.fill_cache = false;
+    std::unique_ptr<::leveldb::Iterator> it(db_->NewIterator(read_options));
+    ::leveldb::WriteBatch batch;
+    uint32_t batch_cnt = 0;
+    uint64_t gc_cnt = 0;
+    std::string cur_prefix;
+    uint32_t record_idx = 0;
+    for (it->Seek(index_prefix); it->Valid() && it->key().starts_with(index_prefix); it->Next()) {
+        ::leveldb::Slice prefix = DiskTableKeyCodec::DecodePrefix(it->key());
+        if (prefix != ::leveldb::Slice(cur_prefix)) {
+            cur_prefix.assign(prefix.data(), prefix.size());
+            record_idx = 0;
+        }
+        record_idx++;
+        if (!expire_value.IsExpired(DiskTableKeyCodec::DecodeTs(it->key()), record_idx)) {
+            continue;
+        }
+        batch.Delete(it->key());
+        gc_cnt++;
+        if (++batch_cnt >= GC_BATCH_SIZE) {
+            db_->Write(::leveldb::WriteOptions(), &batch);
+            batch.Clear();
+            batch_cnt = 0;
+        }
+    }
+    if (batch_cnt > 0) {
+        db_->Write(::leveldb::WriteOptions(), &batch);
+    }
+    return gc_cnt;
+}
+
+uint64_t DiskTable::DeleteIndexData(uint32_t index_id) {
+    std::string index_prefix = DiskTableKeyCodec::EncodeIndex(index_id);
+    ::leveldb::ReadOptions read_options;
+    read_options.fill_cache = false;
+    std::unique_ptr<::leveldb::Iterator> it(db_->NewIterator(read_options));
+    ::leveldb::WriteBatch batch;
+    uint32_t batch_cnt = 0;
+    uint64_t delete_cnt = 0;
+    for (it->Seek(index_prefix); it->Valid() && it->key().starts_with(index_prefix); it->Next()) {
+        batch.Delete(it->key());
+        delete_cnt++;
+        if (++batch_cnt >= GC_BATCH_SIZE) {
+            db_->Write(::leveldb::WriteOptions(), &batch);
+            batch.Clear();
+            batch_cnt = 0;
+        }
+    }
+    if (batch_cnt > 0) {
+        db_->Write(::leveldb::WriteOptions(), &batch);
+    }
+    return delete_cnt;
+}
+
+// tll as ms
+uint64_t DiskTable::GetExpireTime(const TTLSt& ttl_st) {
+    if (!enable_gc_.load(std::memory_order_relaxed) || ttl_st.abs_ttl == 0 ||
+        ttl_st.ttl_type == ::openmldb::storage::TTLType::kLatestTime) {
+        return 0;
+    }
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    return cur_time - ttl_st.abs_ttl;
+}
+
+bool DiskTable::CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts) {
+    ::openmldb::storage::Ticket ticket;
+    std::unique_ptr<TableIterator> it(NewIterator(index_id, key, ticket));
+    if (!it) {
+        return true;
+    }
+    it->SeekToLast();
+    if (it->Valid() && ts >= it->GetKey()) {
+        return false;
+    }
+    return true;
+}
+
+bool DiskTable::IsExpire(const LogEntry& entry) {
+    if (!enable_gc_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    std::map<uint32_t, uint64_t> ts_dimemsions_map;
+    for (auto iter = entry.ts_dimensions().begin(); iter != entry.ts_dimensions().end(); iter++) {
+        ts_dimemsions_map.insert(std::make_pair(iter->idx(), iter->ts()));
+    }
+    std::map<int32_t, std::string> inner_index_key_map;
+    if (entry.dimensions_size() > 0) {
+        for (auto iter = entry.dimensions().begin(); iter != entry.dimensions().end(); iter++) {
+            int32_t inner_pos = table_index_.GetInnerIndexPos(iter->idx());
+            if (inner_pos >= 0) {
+                inner_index_key_map.emplace(inner_pos, iter->key());
+            }
+        }
+    } else {
+        int32_t inner_pos = table_index_.GetInnerIndexPos(0);
+        if (inner_pos >= 0) {
+            inner_index_key_map.emplace(inner_pos, entry.pk());
+        }
+    }
+    for (const auto& kv : inner_index_key_map) {
+        auto inner_index = table_index_.GetInnerIndex(kv.first);
+        if (!inner_index) {
+            continue;
+        }
+        for (const auto& index_def : inner_index->GetIndex()) {
+            if (!index_def || !index_def->IsReady()) {
+                continue;
+            }
+            auto ttl = index_def->GetTTL();
+            if (!ttl->NeedGc()) {
+                return false;
+            }
+            uint64_t ts = entry.ts();
+            auto ts_col = index_def->GetTsColumn();
+            if (ts_col) {
+                auto iter = ts_dimemsions_map.find(ts_col->GetTsIdx());
+                if (iter == ts_dimemsions_map.end()) {
+                    continue;
+                }
+                ts = iter->second;
+            }
+            bool is_expire = false;
+            uint32_t index_id = index_def->GetId();
+            switch (index_def->GetTTLType()) {
+                case ::openmldb::storage::TTLType::kLatestTime:
+                    is_expire = CheckLatest(index_id, kv.second, ts);
+                    break;
+                case ::openmldb::storage::TTLType::kAbsoluteTime:
+                    is_expire = ts < GetExpireTime(*ttl);
+                    break;
+                case ::openmldb::storage::TTLType::kAbsOrLat:
+                    is_expire = ts < GetExpireTime(*ttl) || CheckLatest(index_id, kv.second, ts);
+                    break;
+                case ::openmldb::storage::TTLType::kAbsAndLat:
+                    is_expire = ts < GetExpireTime(*ttl) && CheckLatest(index_id, kv.second, ts);
+                    break;
+                default:
+                    return true;
+            }
+            if (!is_expire) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+DiskTableIterator::DiskTableIterator(::leveldb::DB* db, const DiskSnapshot& snapshot, const std::string& prefix)
+    : snapshot_(snapshot), it_(NewDBIterator(db, snapshot)), prefix_(prefix) {}
+
+DiskTableIterator::~DiskTableIterator() { delete it_; }
+
+bool DiskTableIterator::Valid() {
+    return it_->Valid() && it_->key().size() == prefix_.size() + ROW_SUFFIX_SIZE && it_->key().starts_with(prefix_);
+}
+
+void DiskTableIterator::Next() { it_->Next(); }
+
+openmldb::base::Slice DiskTableIterator::GetValue() const {
+    return openmldb::base::Slice(it_->value().data(), it_->value().size());
+}
+
+std::string DiskTableIterator::GetPK() const { return DiskTableKeyCodec::DecodePK(it_->key()); }
+
+uint64_t DiskTableIterator::GetKey() const { return DiskTableKeyCodec::DecodeTs(it_->key()); }
+
+void DiskTableIterator::SeekToFirst() { it_->Seek(prefix_); }
+
+void DiskTableIterator::SeekToLast() {
+    SeekAfterPK(it_, prefix_);
+    if (it_->Valid()) {
+        it_->Prev();
+    } else {
+        it_->SeekToLast();
+    }
+}
+
+void DiskTableIterator::Seek(uint64_t time) {
+    std::string key = prefix_;
+    DiskTableKeyCodec::AppendTs(time, &key);
+    it_->Seek(key);
+}
+
+DiskTableTraverseIterator::DiskTableTraverseIterator(::leveldb::DB* db, const DiskSnapshot& snapshot,
+                                                     uint32_t index_id, ::openmldb::storage::TTLType ttl_type,
+                                                     uint64_t expire_time, uint64_t expire_cnt)
+    : snapshot_(snapshot),
+      it_(NewDBIterator(db, snapshot)),
+      index_id_(index_id),
+      index_prefix_(DiskTableKeyCodec::EncodeIndex(index_id)),
+      prefix_(),
+      record_idx_(0),
+      expire_value_(expire_time, expire_cnt, ttl_type),
+      traverse_cnt_(0) {}
+
+DiskTableTraverseIterator::~DiskTableTraverseIterator() { delete it_; }
+
+bool DiskTableTraverseIterator::InIndex() const {
+    return it_->Valid() && it_->key().starts_with(index_prefix_) && it_->key().size() >= PREFIX_HEAD_SIZE + ROW_SUFFIX_SIZE;
+}
+
+bool DiskTableTraverseIterator::IsExpired() const {
+    return expire_value_.IsExpired(DiskTableKeyCodec::DecodeTs(it_->key()), record_idx_);
+}
+
+bool DiskTableTraverseIterator::Valid() { return InIndex() && !IsExpired(); }
+
+void DiskTableTraverseIterator::Next() {
+    it_->Next();
+    record_idx_++;
+    traverse_cnt_++;
+    if (!InIndex() || DiskTableKeyCodec::DecodePrefix(it_->key()) != ::leveldb::Slice(prefix_) || IsExpired()) {
+        NextPK();
+    }
+}
+
+uint64_t DiskTableTraverseIterator::GetCount() const { return traverse_cnt_; }
+
+void DiskTableTraverseIterator::NextPK() {
+    do {
+        if (!InIndex()) {
+            return;
+        }
+        if (DiskTableKeyCodec::DecodePrefix(it_->key()) == ::leveldb::Slice(prefix_)) {
+            SeekAfterPK(it_, prefix_);
+            if (!InIndex()) {
+                return;
+            }
+        }
+        ::leveldb::Slice prefix = DiskTableKeyCodec::DecodePrefix(it_->key());
+        prefix_.assign(prefix.data(), prefix.size());
+        record_idx_ = 1;
+        traverse_cnt_++;
+        if (traverse_cnt_ >= FLAGS_max_traverse_cnt) {
+            break;
+        }
+    } while (IsExpired());
+}
+
+void DiskTableTraverseIterator::Seek(const std::string& pk, uint64_t ts) {
+    prefix_ = DiskTableKeyCodec::EncodePrefix(index_id_, pk);
+    it_->Seek(prefix_);
+    if (!InIndex()) {
+        return;
+    }
+    if (DiskTableKeyCodec::DecodePrefix(it_->key()) != ::leveldb::Slice(prefix_)) {
+        // the pk does not exist, start from the next one
+        NextPK();
+        return;
+    }
+    record_idx_ = 1;
+    if (expire_value_.ttl_type == ::openmldb::storage::TTLType::kAbsoluteTime) {
+        std::string key = prefix_;
+        DiskTableKeyCodec::AppendTsEnd(ts, &key);
+        it_->Seek(key);
+        traverse_cnt_++;
+    } else {
+        // the position of row in pk is needed by latest ttl
+        while (InIndex() && DiskTableKeyCodec::DecodePrefix(it_->key()) == ::leveldb::Slice(prefix_)) {
+            traverse_cnt_++;
+            if (DiskTableKeyCodec::DecodeTs(it_->key()) < ts) {
+                break;
+            }
+            it_->Next();
+            record_idx_++;
+        }
+    }
+    if (!InIndex() || DiskTableKeyCodec::DecodePrefix(it_->key()) != ::leveldb::Slice(prefix_) || IsExpired()) {
+        NextPK();
+    }
+}
+
+openmldb::base::Slice DiskTableTraverseIterator::GetValue() const {
+    return openmldb::base::Slice(it_->value().data(), it_->value().size());
+}
+
+uint64_t DiskTableTraverseIterator::GetKey() const {
+    if (InIndex()) {
+        return DiskTableKeyCodec::DecodeTs(it_->key());
+    }
+    return UINT64_MAX;
+}
+
+std::string DiskTableTraverseIterator::GetPK() const {
+    if (!InIndex()) {
+        return std::string();
+    }
+    return DiskTableKeyCodec::DecodePK(it_->key());
+}
+
+void DiskTableTraverseIterator::SeekToFirst() {
+    prefix_.clear();
+    it_->Seek(index_prefix_);
+    NextPK();
+}
+
+DiskTableRowIterator::DiskTableRowIterator(::leveldb::DB* db, const DiskSnapshot& snapshot, const std::string& prefix,
+                                           ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+                                           uint64_t expire_cnt)
+    : snapshot_(snapshot),
+      it_(NewDBIterator(db, snapshot)),
+      prefix_(prefix),
+      valid_(false),
+      ts_(0),
+      record_idx_(0),
+      expire_value_(expire_time, expire_cnt, ttl_type),
+      row_() {}
+
+DiskTableRowIterator::~DiskTableRowIterator() { delete it_; }
+
+void DiskTableRowIterator::Load() {
+    valid_ = it_->Valid() && it_->key().size() == prefix_.size() + ROW_SUFFIX_SIZE && it_->key().starts_with(prefix_);
+    if (valid_) {
+        ts_ = DiskTableKeyCodec::DecodeTs(it_->key());
+    }
+}
+
+bool DiskTableRowIterator::Valid() const { return valid_ && !expire_value_.IsExpired(ts_, record_idx_); }
+
+void DiskTableRowIterator::Next() {
+    it_->Next();
+    record_idx_++;
+    Load();
+}
+
+const uint64_t& DiskTableRowIterator::GetKey() const { return ts_; }
+
+const ::hybridse::codec::Row& DiskTableRowIterator::GetValue() {
+    // the value of leveldb iterator is released when iterator moves
+    const ::leveldb::Slice value = it_->value();
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(value.size()));
+    memcpy(buf, value.data(), value.size());
+    row_ = ::hybridse::codec::Row(::hybridse::base::RefCountedSlice::CreateManaged(buf, value.size()));
+    return row_;
+}
+
+void DiskTableRowIterator::Seek(const uint64_t& key) {
+    std::string seek_key = prefix_;
+    DiskTableKeyCodec::AppendTs(key, &seek_key);
+    it_->Seek(seek_key);
+    Load();
+}
+
+void DiskTableRowIterator::SeekToFirst() {
+    it_->Seek(prefix_);
+    Load();
+}
+
+DiskTableKeyIterator::DiskTableKeyIterator(::leveldb::DB* db, const DiskSnapshot& snapshot, uint32_t index_id,
+                                           ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+                                           uint64_t expire_cnt)
+    : db_(db),
+      snapshot_(snapshot),
+      it_(NewDBIterator(db, snapshot)),
+      index_id_(index_id),
+      index_prefix_(DiskTableKeyCodec::EncodeIndex(index_id)),
+      ttl_type_(ttl_type),
+      expire_time_(expire_time),
+      expire_cnt_(expire_cnt) {}
+
+DiskTableKeyIterator::~DiskTableKeyIterator() { delete it_; }
+
+void DiskTableKeyIterator::SeekToFirst() { it_->Seek(index_prefix_); }
+
+void DiskTableKeyIterator::Seek(const std::string& key) {
+    it_->Seek(DiskTableKeyCodec::EncodePrefix(index_id_, key));
+}
+
+bool DiskTableKeyIterator::Valid() {
+    return it_->Valid() && it_->key().starts_with(index_prefix_) && it_->key().size() >= PREFIX_HEAD_SIZE + ROW_SUFFIX_SIZE;
+}
+
+void DiskTableKeyIterator::Next() {
+    ::leveldb::Slice prefix = DiskTableKeyCodec::DecodePrefix(it_->key());
+    SeekAfterPK(it_, std::string(prefix.data(), prefix.size()));
+}
+
+::hybridse::vm::RowIterator* DiskTableKeyIterator::GetRawValue() {
+    ::leveldb::Slice prefix = DiskTableKeyCodec::DecodePrefix(it_->key());
+    auto* it = new DiskTableRowIterator(db_, snapshot_, std::string(prefix.data(), prefix.size()), ttl_type_,
+                                        expire_time_, expire_cnt_);
+    it->SeekToFirst();
+    return it;
+}
+
+std::unique_ptr<::hybridse::vm::RowIterator> DiskTableKeyIterator::GetValue() {
+    return std::unique_ptr<::hybridse::vm::RowIterator>(GetRawValue());
+}
+
+const hybridse::codec::Row DiskTableKeyIterator::GetKey() {
+    // the key of leveldb iterator is released when iterator moves
+    std::string pk = DiskTableKeyCodec::DecodePK(it_->key());
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(pk.size()));
+    memcpy(buf, pk.data(), pk.size());
+    hybridse::codec::Row row(::hybridse::base::RefCountedSlice::CreateManaged(buf, pk.size()));
+    return row;
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_DISK_TABLE_H_
+#define SRC_STORAGE_DISK_TABLE_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "leveldb/db.h"
+#include "leveldb/write_batch.h"
+#include "proto/tablet.pb.h"
+#include "storage/iterator.h"
+#include "storage/table.h"
+#include "storage/ticket.h"
+#include "vm/catalog.h"
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::api::LogEntry;
+
+// the snapshot is released when the last iterator using it is deleted
+typedef std::shared_ptr<const ::leveldb::Snapshot> DiskSnapshot;
+
+// the key of a row in disk table is |index id(4B)|pk size(4B)|pk|ts(8B)|offset(8B)|, all
+// the integers are big endian and the ts and offset are stored as UINT64_MAX minus them so
+// the rows of one pk are in desc time order. the offset is the log index of the row, so
+// the rows with the same pk and ts are all kept and replaying a log entry overwrites its rows
+class DiskTableKeyCodec {
+ public:
+    static std::string EncodeIndex(uint32_t index_id);
+    static std::string EncodePrefix(uint32_t index_id, const std::string& pk);
+    static std::string EncodeKey(uint32_t index_id, const std::string& pk, uint64_t ts, uint64_t offset);
+    static void AppendTs(uint64_t ts, std::string* dst);
+    // the key after all the rows of ts in dst
+    static void AppendTsEnd(uint64_t ts, std::string* dst);
+    // the key must be encoded by EncodeKey
+    static uint64_t DecodeTs(const ::leveldb::Slice& key);
+    static ::leveldb::Slice DecodePrefix(const ::leveldb::Slice& key);
+    static std::string DecodePK(const ::leveldb::Slice& key);
+};
+
+// iterate the rows of one pk
+class DiskTableIterator : public TableIterator {
+ public:
+    DiskTableIterator(::leveldb::DB* db, const DiskSnapshot& snapshot, const std::string& prefix);
+    ~DiskTableIterator() override;
+    bool Valid() override;
+    void Next() override;
+    openmldb::base::Slice GetValue() const override;
+    std::string GetPK() const override;
+    uint64_t GetKey() const override;
+    void SeekToFirst() override;
+    void SeekToLast() override;
+    void Seek(uint64_t time) override;
+
+ private:
+    DiskSnapshot snapshot_;
+    ::leveldb::Iterator* it_;
+    std::string prefix_;
+};
+
+// iterate all the rows of one index and filter the expired ones
+class DiskTableTraverseIterator : public TableIterator {
+ public:
+    DiskTableTraverseIterator(::leveldb::DB* db, const DiskSnapshot& snapshot, uint32_t index_id,
+                              ::openmldb::storage::TTLType ttl_type, uint64_t expire_time, uint64_t expire_cnt);
+    ~DiskTableTraverseIterator() override;
+    bool Valid() override;
+    void Next() override;
+    void Seek(const std::string& pk, uint64_t time) override;
+    openmldb::base::Slice GetValue() const override;
+    std::string GetPK() const override;
+    uint64_t GetKey() const override;
+    void SeekToFirst() override;
+    uint64_t GetCount() const override;
+
+ private:
+    bool InIndex() const;
+    bool IsExpired() const;
+    // skip the rest rows of current pk and find the next pk which has valid rows
+    void NextPK();
+
+ private:
+    DiskSnapshot snapshot_;
+    ::leveldb::Iterator* it_;
+    uint32_t index_id_;
+    std::string index_prefix_;
+    std::string prefix_;
+    uint32_t record_idx_;
+    TTLSt expire_value_;
+    uint64_t traverse_cnt_;
+};
+
+class DiskTableRowIterator : public ::hybridse::vm::RowIterator {
+ public:
+    DiskTableRowIterator(::leveldb::DB* db, const DiskSnapshot& snapshot, const std::string& prefix,
+                         ::openmldb::storage::TTLType ttl_type, uint64_t expire_time, uint64_t expire_cnt);
+
+    ~DiskTableRowIterator() override;
+
+    bool Valid() const override;
+    void Next() override;
+    const uint64_t& GetKey() const override;
+    const ::hybridse::codec::Row& GetValue() override;
+    void Seek(const uint64_t& key) override;
+    void SeekToFirst() override;
+    bool IsSeekable() const override { return true; }
+
+ private:
+    void Load();
+
+ private:
+    DiskSnapshot snapshot_;
+    ::leveldb::Iterator* it_;
+    std::string prefix_;
+    bool valid_;
+    uint64_t ts_;
+    uint32_t record_idx_;
+    TTLSt expire_value_;
+    ::hybridse::codec::Row row_;
+};
+
+class DiskTableKeyIterator : public ::hybridse::vm::WindowIterator {
+ public:
+    DiskTableKeyIterator(::leveldb::DB* db, const DiskSnapshot& snapshot, uint32_t index_id,
+                         ::openmldb::storage::TTLType ttl_type, uint64_t expire_time, uint64_t expire_cnt);
+
+    ~DiskTableKeyIterator() override;
+
+    void Seek(const std::string& key) override;
+
+    void SeekToFirst() override;
+
+    void Next() override;
+
+    bool Valid() override;
+
+    std::unique_ptr<::hybridse::vm::RowIterator> GetValue() override;
+    ::hybridse::vm::RowIterator* GetRawValue() override;
+
+    const hybridse::codec::Row GetKey() override;
+
+ private:
+    ::leveldb::DB* db_;
+    DiskSnapshot snapshot_;
+    ::leveldb::Iterator* it_;
+    uint32_t index_id_;
+    std::string index_prefix_;
+    ::openmldb::storage::TTLType ttl_type_;
+    uint64_t expire_time_;
+    uint64_t expire_cnt_;
+};
+
+// DiskTable keeps all the indexes of a table partition in one leveldb instance,
+// the hot blocks are cached in a block cache shared by all the disk tables
+class DiskTable : public Table {
+ public:
+    DiskTable(const ::openmldb::api::TableMeta& table_meta, const std::string& db_path);
+    ~DiskTable() override;
+    DiskTable(const DiskTable&) = delete;
+    DiskTable& operator=(const DiskTable&) = delete;
+
+    bool Init() override;
+
+    bool Put(const std::string& pk, uint64_t time, const char* data, uint32_t size) override;
+
+    bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
+
+    bool Put(const Dimensions& dimensions, const TSDimensions& ts_dimensions, const std::string& value) override;
+
+    // the rows are keyed by the log index of entry, the puts without log entry take the offset after the last one
+    bool Put(const LogEntry& entry) override;
+
+    bool Delete(const std::string& pk, uint32_t idx) override;
+
+    TableIterator* NewIterator(const std::string& pk, Ticket& ticket) override;
+
+    TableIterator* NewIterator(uint32_t index, const std::string& pk, Ticket& ticket) override;
+
+    TableIterator* NewTraverseIterator(uint32_t index) override;
+
+    ::hybridse::vm::WindowIterator* NewWindowIterator(uint32_t index) override;
+
+    void SchedGc() override;
+
+    uint64_t GetRecordCnt() const override { return record_cnt_.load(std::memory_order_relaxed); }
+
+    bool IsExpire(const LogEntry& entry) override;
+
+    uint64_t GetExpireTime(const TTLSt& ttl_st) override;
+
+    inline void SetExpire(bool is_expire) { enable_gc_.store(is_expire, std::memory_order_relaxed); }
+
+    inline bool GetExpireStatus() { return enable_gc_.load(std::memory_order_relaxed); }
+
+    inline const std::string& GetDBPath() const { return db_path_; }
+
+    uint64_t GetPersistedOffset() override { return offset_.load(std::memory_order_relaxed); }
+
+    // the offset is saved with the rows put in log order, and by this after the table is
+    // loaded as the rows are recovered out of order
+    bool SaveOffset(uint64_t offset);
+
+ private:
+    bool AddRows(const std::string& pk, uint64_t time, const ::leveldb::Slice& value, uint64_t offset,
+                 ::leveldb::WriteBatch* batch);
+    bool AddRows(uint64_t time, const std::string& value, const Dimensions& dimensions, uint64_t offset,
+                 ::leveldb::WriteBatch* batch);
+    bool AddRows(const Dimensions& dimensions, const TSDimensions& ts_dimensions, const std::string& value,
+                 uint64_t offset, ::leveldb::WriteBatch* batch);
+    // write the rows of one record with the log offset of it
+    bool WriteRows(uint64_t offset, ::leveldb::WriteBatch* batch);
+    ::leveldb::WriteOptions GetWriteOptions() const;
+    DiskSnapshot NewSnapshot();
+    bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
+    // delete the expired rows of one index, return the count of deleted rows
+    uint64_t GcIndex(uint32_t index_id, const TTLSt& ttl_st);
+    // delete all the rows of one index
+    uint64_t DeleteIndexData(uint32_t index_id);
+
+ private:
+    std::string db_path_;
+    ::leveldb::DB* db_;
+    std::atomic<bool> enable_gc_;
+    std::atomic<uint64_t> record_cnt_;
+    // the log offset up to which the rows are kept in db
+    std::atomic<uint64_t> offset_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_DISK_TABLE_H_
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/disk_table.h"
+
+#include <gflags/gflags.h>
+
+#include "base/file_util.h"
+#include "base/glog_wapper.h"
+#include "codec/schema_codec.h"
+#include "common/timer.h"
+#include "gtest/gtest.h"
+#include "storage/ticket.h"
+
+DECLARE_uint32(max_traverse_cnt);
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::codec::SchemaCodec;
+
+class DiskTableTest : public ::testing::Test {
+ public:
+    DiskTableTest() {}
+    ~DiskTableTest() {}
+};
+
+static std::string GetDBPath(const std::string& name) {
+    return "/tmp/disk_table_test/" + name + std::to_string(::baidu::common::timer::get_micros());
+}
+
+static void BuildTableMeta(::openmldb::type::TTLType ttl_type, uint64_t abs_ttl, uint64_t lat_ttl,
+                           ::openmldb::api::TableMeta* table_meta) {
+    table_meta->set_name("table1");
+    table_meta->set_tid(1);
+    table_meta->set_pid(0);
+    table_meta->set_mode(::openmldb::api::TableMode::kTableLeader);
+    table_meta->set_storage_mode(::openmldb::type::StorageMode::kSSD);
+    SchemaCodec::SetColumnDesc(table_meta->add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta->add_column_desc(), "mcc", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta->add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+    SchemaCodec::SetColumnDesc(table_meta->add_column_desc(), "ts2", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta->add_column_key(), "card", "card", "ts1", ttl_type, abs_ttl, lat_ttl);
+    SchemaCodec::SetIndex(table_meta->add_column_key(), "card1", "card", "ts2", ttl_type, abs_ttl, lat_ttl);
+    SchemaCodec::SetIndex(table_meta->add_column_key(), "mcc", "mcc", "ts1", ttl_type, abs_ttl, lat_ttl);
+}
+
+static void PutRows(DiskTable* table, uint64_t base_ts, int num) {
+    for (int i = 0; i < num; i++) {
+        ::openmldb::api::PutRequest request;
+        ::openmldb::api::Dimension* dim = request.add_dimensions();
+        dim->set_idx(0);
+        dim->set_key("card" + std::to_string(i % 100));
+        dim = request.add_dimensions();
+        dim->set_idx(1);
+        dim->set_key("card" + std::to_string(i % 100));
+        dim = request.add_dimensions();
+        dim->set_idx(2);
+        dim->set_key("mcc" + std::to_string(i));
+        ::openmldb::api::TSDimension* ts = request.add_ts_dimensions();
+        ts->set_idx(0);
+        ts->set_ts(base_ts + i);
+        ts = request.add_ts_dimensions();
+        ts->set_idx(1);
+        ts->set_ts(base_ts + 10000 + i);
+        std::string value = "value" + std::to_string(i);
+        ASSERT_TRUE(table->Put(request.dimensions(), request.ts_dimensions(), value));
+    }
+}
+
+TEST_F(DiskTableTest, Put) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("t1");
+    table_meta.set_tid(1);
+    table_meta.set_pid(0);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "value", ::openmldb::type::kString);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "", ::openmldb::type::kAbsoluteTime, 0, 0);
+    std::string path = GetDBPath("put");
+    DiskTable* table = new DiskTable(table_meta, path);
+    ASSERT_TRUE(table->Init());
+    ASSERT_TRUE(table->Put("test", 9537, "test", 4));
+    ASSERT_TRUE(table->Put("test", 9538, "test1", 5));
+    ASSERT_EQ(2, (int64_t)table->GetRecordCnt());
+    Ticket ticket;
+    TableIterator* it = table->NewIterator("test", ticket);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(9538, (int64_t)it->GetKey());
+    std::string value_str(it->GetValue().data(), it->GetValue().size());
+    ASSERT_EQ("test1", value_str);
+    it->Next();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(9537, (int64_t)it->GetKey());
+    it->Next();
+    ASSERT_FALSE(it->Valid());
+    it->SeekToLast();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(9537, (int64_t)it->GetKey());
+    it->Seek(9537);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(9537, (int64_t)it->GetKey());
+    delete it;
+    it = table->NewIterator("tes", ticket);
+    it->SeekToFirst();
+    ASSERT_FALSE(it->Valid());
+    delete it;
+    ASSERT_TRUE(table->Delete("test", 0));
+    ASSERT_FALSE(table->Delete("test", 0));
+    it = table->NewIterator("test", ticket);
+    it->SeekToFirst();
+    ASSERT_FALSE(it->Valid());
+    delete it;
+    delete table;
+    ::openmldb::base::RemoveDirRecursive(path);
+}
+
+TEST_F(DiskTableTest, TableIteratorTS) {
+    ::openmldb::api::TableMeta table_meta;
+    BuildTableMeta(::openmldb::type::kAbsoluteTime, 0, 0, &table_meta);
+    std::string path = GetDBPath("iterator");
+    DiskTable table(table_meta, path);
+    ASSERT_TRUE(table.Init());
+    PutRows(&table, 1000, 1000);
+    ASSERT_EQ(1000, (int64_t)table.GetRecordCnt());
+    for (uint32_t idx = 0; idx < 2; idx++) {
+        TableIterator* it = table.NewTraverseIterator(idx);
+        it->SeekToFirst();
+        int count = 0;
+        while (it->Valid()) {
+            count++;
+            it->Next();
+        }
+        ASSERT_EQ(1000, count);
+        ASSERT_EQ(1100, (int64_t)it->GetCount());
+        delete it;
+    }
+    Ticket ticket;
+    TableIterator* iter = table.NewIterator(0, "card5", ticket);
+    iter->SeekToFirst();
+    int count = 0;
+    uint64_t last_ts = UINT64_MAX;
+    while (iter->Valid()) {
+        ASSERT_LT(iter->GetKey(), last_ts);
+        last_ts = iter->GetKey();
+        count++;
+        iter->Next();
+    }
+    ASSERT_EQ(10, count);
+    delete iter;
+    iter = table.NewIterator(1, "card5", ticket);
+    iter->SeekToFirst();
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(10000 + 1000 + 905, (int64_t)iter->GetKey());
+    delete iter;
+    iter = table.NewIterator(2, "mcc10", ticket);
+    iter->SeekToFirst();
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ("value10", iter->GetValue().ToString());
+    delete iter;
+    ASSERT_EQ(NULL, table.NewIterator(3, "mcc10", ticket));
+
+    // resume traverse from the middle of a pk
+    TableIterator* it = table.NewTraverseIterator(0);
+    it->Seek("card5", 1505);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ("card5", it->GetPK());
+    ASSERT_EQ(1405, (int64_t)it->GetKey());
+    delete it;
+    ::openmldb::base::RemoveDirRecursive(path);
+}
+
+TEST_F(DiskTableTest, WindowIterator) {
+    ::openmldb::api::TableMeta table_meta;
+    BuildTableMeta(::openmldb::type::kLatestTime, 0, 3, &table_meta);
+    std::string path = GetDBPath("window");
+    DiskTable table(table_meta, path);
+    ASSERT_TRUE(table.Init());
+    PutRows(&table, 1000, 1000);
+    std::unique_ptr<::hybridse::vm::WindowIterator> it(table.NewWindowIterator(0));
+    it->SeekToFirst();
+    int pk_cnt = 0;
+    while (it->Valid()) {
+        auto row_it = it->GetValue();
+        int row_cnt = 0;
+        while (row_it->Valid()) {
+            row_cnt++;
+            row_it->Next();
+        }
+        // the window iterator is the same as memtable which keeps lat_ttl + 1 rows before gc
+        ASSERT_EQ(4, row_cnt);
+        pk_cnt++;
+        it->Next();
+    }
+    ASSERT_EQ(100, pk_cnt);
+    it->Seek("card5");
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ("card5", std::string(reinterpret_cast<const char*>(it->GetKey().buf()), it->GetKey().size()));
+    auto row_it = it->GetValue();
+    row_it->Seek(1500);
+    ASSERT_TRUE(row_it->Valid());
+    ASSERT_EQ(1405u, row_it->GetKey());
+    const ::hybridse::codec::Row& row = row_it->GetValue();
+    ASSERT_EQ("value405", std::string(reinterpret_cast<const char*>(row.buf()), row.size()));
+    ::openmldb::base::RemoveDirRecursive(path);
+}
+
+TEST_F(DiskTableTest, SchedGc) {
+    ::openmldb::api::TableMeta table_meta;
+    BuildTableMeta(::openmldb::type::kLatestTime, 0, 3, &table_meta);
+    std::string path = GetDBPath("gc_latest");
+    DiskTable table(table_meta, path);
+    ASSERT_TRUE(table.Init());
+    PutRows(&table, 1000, 1000);
+    table.SchedGc();
+    ASSERT_EQ(300, (int64_t)table.GetRecordCnt());
+    TableIterator* it = table.NewTraverseIterator(0);
+    it->SeekToFirst();
+    int count = 0;
+    while (it->Valid()) {
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(300, count);
+    delete it;
+    ::openmldb::api::LogEntry entry;
+    entry.set_ts(1000);
+    entry.set_value("value");
+    auto dim = entry.add_dimensions();
+    dim->set_idx(0);
+    dim->set_key("card0");
+    auto ts = entry.add_ts_dimensions();
+    ts->set_idx(0);
+    ts->set_ts(1000);
+    ASSERT_TRUE(table.IsExpire(entry));
+    ts->set_ts(1999);
+    ASSERT_FALSE(table.IsExpire(entry));
+    ::openmldb::base::RemoveDirRecursive(path);
+
+    ::openmldb::api::TableMeta abs_meta;
+    BuildTableMeta(::openmldb::type::kAbsoluteTime, 1, 0, &abs_meta);
+    path = GetDBPath("gc_abs");
+    DiskTable abs_table(abs_meta, path);
+    ASSERT_TRUE(abs_table.Init());
+    uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+    PutRows(&abs_table, now - 2 * 60 * 1000, 500);
+    PutRows(&abs_table, now, 500);
+    ASSERT_EQ(1000, (int64_t)abs_table.GetRecordCnt());
+    abs_table.SchedGc();
+    ASSERT_EQ(500, (int64_t)abs_table.GetRecordCnt());
+    ::openmldb::base::RemoveDirRecursive(path);
+}
+
+static void BuildEntry(uint64_t log_index, const std::string& key, uint64_t ts, const std::string& value,
+                       ::openmldb::api::LogEntry* entry) {
+    entry->set_log_index(log_index);
+    entry->set_pk(key);
+    entry->set_ts(ts);
+    entry->set_value(value);
+}
+
+TEST_F(DiskTableTest, Recover) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("t1");
+    table_meta.set_tid(1);
+    table_meta.set_pid(0);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "value", ::openmldb::type::kString);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "", ::openmldb::type::kAbsoluteTime, 0, 0);
+    std::string path = GetDBPath("recover");
+    DiskTable* table = new DiskTable(table_meta, path);
+    ASSERT_TRUE(table->Init());
+    ASSERT_EQ(0u, table->GetPersistedOffset());
+    ::openmldb::api::LogEntry entry;
+    // the rows with the same pk and ts are all kept
+    BuildEntry(1, "card0", 100, "value1", &entry);
+    ASSERT_TRUE(table->Put(entry));
+    BuildEntry(2, "card0", 100, "value2", &entry);
+    ASSERT_TRUE(table->Put(entry));
+    BuildEntry(3, "card0", 101, "value3", &entry);
+    ASSERT_TRUE(table->Put(entry));
+    ASSERT_EQ(3u, table->GetPersistedOffset());
+    ASSERT_EQ(3, (int64_t)table->GetRecordCnt());
+    delete table;
+
+    table = new DiskTable(table_meta, path);
+    ASSERT_TRUE(table->Init());
+    ASSERT_EQ(3u, table->GetPersistedOffset());
+    ASSERT_EQ(3, (int64_t)table->GetRecordCnt());
+    // the rows put while loading save the offset once the load finishes
+    table->SetTableStat(::openmldb::storage::kLoading);
+    BuildEntry(4, "card0", 100, "value4", &entry);
+    ASSERT_TRUE(table->Put(entry));
+    ASSERT_EQ(3u, table->GetPersistedOffset());
+    ASSERT_TRUE(table->SaveOffset(4));
+    table->SetTableStat(::openmldb::storage::kNormal);
+    delete table;
+
+    table = new DiskTable(table_meta, path);
+    ASSERT_TRUE(table->Init());
+    ASSERT_EQ(4u, table->GetPersistedOffset());
+    ASSERT_EQ(4, (int64_t)table->GetRecordCnt());
+    Ticket ticket;
+    TableIterator* it = table->NewIterator("card0", ticket);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ("value3", it->GetValue().ToString());
+    it->Next();
+    // the later row of the same ts comes first
+    ASSERT_EQ("value4", it->GetValue().ToString());
+    it->Next();
+    ASSERT_EQ("value2", it->GetValue().ToString());
+    it->Next();
+    ASSERT_EQ("value1", it->GetValue().ToString());
+    it->Next();
+    ASSERT_FALSE(it->Valid());
+    it->Seek(100);
+    ASSERT_EQ("value4", it->GetValue().ToString());
+    it->SeekToLast();
+    ASSERT_EQ("value1", it->GetValue().ToString());
+    delete it;
+    // replaying an entry overwrites its rows
+    BuildEntry(2, "card0", 100, "value2", &entry);
+    ASSERT_TRUE(table->Put(entry));
+    TableIterator* traverse_it = table->NewTraverseIterator(0);
+    traverse_it->SeekToFirst();
+    int count = 0;
+    while (traverse_it->Valid()) {
+        count++;
+        traverse_it->Next();
+    }
+    ASSERT_EQ(4, count);
+    traverse_it->Seek("card0", 101);
+    ASSERT_TRUE(traverse_it->Valid());
+    ASSERT_EQ(100, (int64_t)traverse_it->GetKey());
+    delete traverse_it;
+    delete table;
+    ::openmldb::base::RemoveDirRecursive(path);
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    FLAGS_max_traverse_cnt = 200000;
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    return RUN_ALL_TESTS();
+}
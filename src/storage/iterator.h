@@ -23,6 +23,8 @@
 namespace openmldb {
 namespace storage {
 
+struct DataBlock;
+
 class TableIterator {
  public:
     TableIterator() {}
@@ -39,6 +41,8 @@ class TableIterator {
     virtual void Seek(const std::string& pk, uint64_t time) {}
     virtual void Seek(uint64_t time) {}
     virtual uint64_t GetCount() const { return 0; }
+    // the block of the current value if it can be pinned to outlive the iterator, otherwise NULL
+    virtual DataBlock* GetPinnableBlock() const { return NULL; }
 };
 
 }  // namespace storage
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/key_index.h"
+
+#include "base/hash.h"
+
+namespace openmldb {
+namespace storage {
+
+// must differ from the seed of segment selection, otherwise the keys of a
+// segment share the low bits of hash and gather in a few slots
+static const uint32_t KEY_INDEX_SEED = 0x9747b28c;
+static const uint32_t KEY_INDEX_MIN_CAPACITY = 16;
+static KeyIndex::KeyNode* const TOMBSTONE = reinterpret_cast<KeyIndex::KeyNode*>(1);
+
+KeyIndex::Table::Table(uint32_t cap) : capacity(cap), slots(new Slot[cap]) {
+    for (uint32_t i = 0; i < capacity; i++) {
+        slots[i].hash.store(0, std::memory_order_relaxed);
+        slots[i].node.store(NULL, std::memory_order_relaxed);
+    }
+}
+
+KeyIndex::Table::~Table() { delete[] slots; }
+
+KeyIndex::KeyIndex(uint32_t capacity) : table_(NULL), size_(0), tombstone_cnt_(0) {
+    uint32_t cap = KEY_INDEX_MIN_CAPACITY;
+    while (cap < capacity && cap < (1u << 31)) {
+        cap <<= 1;
+    }
+    table_.store(new Table(cap), std::memory_order_relaxed);
+}
+
+KeyIndex::~KeyIndex() { delete table_.load(std::memory_order_relaxed); }
+
+uint32_t KeyIndex::Hash(const Slice& key) { return ::openmldb::base::hash(key.data(), key.size(), KEY_INDEX_SEED); }
+
+int64_t KeyIndex::Find(const Table* table, const Slice& key, uint32_t hash) const {
+    uint32_t mask = table->capacity - 1;
+    uint32_t pos = hash & mask;
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        const Slot& slot = table->slots[pos];
+        KeyNode* node = slot.node.load(std::memory_order_acquire);
+        if (node == NULL) {
+            return -1;
+        }
+        // the hash only filters, the key of the loaded node decides
+        if (node != TOMBSTONE && slot.hash.load(std::memory_order_relaxed) == hash && node->GetKey().compare(key) == 0) {
+            return pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return -1;
+}
+
+KeyIndex::KeyNode* KeyIndex::Get(const Slice& key) const {
+    const Table* table = table_.load(std::memory_order_acquire);
+    int64_t pos = Find(table, key, Hash(key));
+    if (pos < 0) {
+        return NULL;
+    }
+    KeyNode* node = table->slots[pos].node.load(std::memory_order_acquire);
+    // the key may be removed after it was found
+    if (node == NULL || node == TOMBSTONE || node->GetKey().compare(key) != 0) {
+        return NULL;
+    }
+    return node;
+}
+
+void KeyIndex::InsertSlot(Table* table, KeyNode* node, uint32_t hash) {
+    uint32_t mask = table->capacity - 1;
+    uint32_t pos = hash & mask;
+    while (true) {
+        Slot& slot = table->slots[pos];
+        KeyNode* cur = slot.node.load(std::memory_order_relaxed);
+        if (cur == NULL || cur == TOMBSTONE) {
+            if (cur == TOMBSTONE) {
+                tombstone_cnt_--;
+            }
+            slot.hash.store(hash, std::memory_order_relaxed);
+            slot.node.store(node, std::memory_order_release);
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+KeyIndex::Table* KeyIndex::Insert(KeyNode* node) {
+    Table* table = table_.load(std::memory_order_relaxed);
+    Table* old_table = NULL;
+    if ((uint64_t)(size_ + tombstone_cnt_ + 1) * 4 > (uint64_t)table->capacity * 3) {
+        // grow if more than half slots are used without tombstones, otherwise rehash
+        // to the same capacity to clear tombstones
+        uint32_t cap = table->capacity;
+        if ((uint64_t)(size_ + 1) * 2 > cap && cap < (1u << 31)) {
+            cap <<= 1;
+        }
+        Table* new_table = new Table(cap);
+        for (uint32_t i = 0; i < table->capacity; i++) {
+            KeyNode* cur = table->slots[i].node.load(std::memory_order_relaxed);
+            if (cur != NULL && cur != TOMBSTONE) {
+                InsertSlot(new_table, cur, table->slots[i].hash.load(std::memory_order_relaxed));
+            }
+        }
+        tombstone_cnt_ = 0;
+        table_.store(new_table, std::memory_order_release);
+        old_table = table;
+        table = new_table;
+    }
+    InsertSlot(table, node, Hash(node->GetKey()));
+    size_++;
+    return old_table;
+}
+
+bool KeyIndex::Remove(const Slice& key) {
+    Table* table = table_.load(std::memory_order_relaxed);
+    int64_t pos = Find(table, key, Hash(key));
+    if (pos < 0) {
+        return false;
+    }
+    table->slots[pos].node.store(TOMBSTONE, std::memory_order_release);
+    size_--;
+    tombstone_cnt_++;
+    return true;
+}
+
+void KeyIndex::Clear() {
+    Table* table = table_.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        table->slots[i].hash.store(0, std::memory_order_relaxed);
+        table->slots[i].node.store(NULL, std::memory_order_relaxed);
+    }
+    size_ = 0;
+    tombstone_cnt_ = 0;
+}
+
+}  // namespace storage
+}  // namespace openmldb
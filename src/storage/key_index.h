@@ -0,0 +1,88 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_KEY_INDEX_H_
+#define SRC_STORAGE_KEY_INDEX_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "base/skiplist.h"
+#include "base/slice.h"
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::base::Slice;
+
+// KeyIndex maps a key to its node in the key entries skiplist of a segment with
+// open addressing and linear probing, so a point lookup does not descend the
+// skiplist. Get is lock free. Insert, Remove and Clear must be externally
+// synchronized. The nodes are not owned by the index
+class KeyIndex {
+ public:
+    typedef ::openmldb::base::Node<Slice, void*> KeyNode;
+
+    struct Slot {
+        std::atomic<uint32_t> hash;
+        std::atomic<KeyNode*> node;
+    };
+
+    struct Table {
+        explicit Table(uint32_t cap);
+        ~Table();
+        uint32_t capacity;
+        Slot* slots;
+    };
+
+    // capacity is rounded up to a power of two
+    explicit KeyIndex(uint32_t capacity);
+    ~KeyIndex();
+
+    KeyNode* Get(const Slice& key) const;
+
+    // The node must not be in the index. It returns the table replaced by rehash or NULL.
+    // The replaced table may still be read by Get and must be freed by the caller later
+    Table* Insert(KeyNode* node);
+
+    // return false if the key is not found
+    bool Remove(const Slice& key);
+
+    // remove all keys. The caller must make sure there is no reader
+    void Clear();
+
+    inline uint32_t GetSize() const { return size_; }
+
+    inline uint32_t GetCapacity() const { return table_.load(std::memory_order_relaxed)->capacity; }
+
+    static uint32_t Hash(const Slice& key);
+
+ private:
+    // the slot of key in table or -1 if not found
+    int64_t Find(const Table* table, const Slice& key, uint32_t hash) const;
+    void InsertSlot(Table* table, KeyNode* node, uint32_t hash);
+
+ private:
+    std::atomic<Table*> table_;
+    uint32_t size_;
+    uint32_t tombstone_cnt_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+
+#endif  // SRC_STORAGE_KEY_INDEX_H_
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/key_index.h"
+
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/glog_wapper.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace storage {
+
+class KeyIndexTest : public ::testing::Test {
+ public:
+    KeyIndexTest() {}
+    ~KeyIndexTest() {}
+};
+
+static std::vector<KeyIndex::KeyNode*> NewNodes(const std::vector<std::string>& keys) {
+    std::vector<KeyIndex::KeyNode*> nodes;
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        void* value = reinterpret_cast<void*>((uint64_t)i + 1);
+        nodes.push_back(new KeyIndex::KeyNode(Slice(keys[i]), value, 1));
+    }
+    return nodes;
+}
+
+static void DeleteNodes(std::vector<KeyIndex::KeyNode*>* nodes) {
+    for (auto node : *nodes) {
+        delete node;
+    }
+    nodes->clear();
+}
+
+TEST_F(KeyIndexTest, InsertGetRemove) {
+    std::vector<std::string> keys;
+    for (int i = 0; i < 100; i++) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    std::vector<KeyIndex::KeyNode*> nodes = NewNodes(keys);
+    KeyIndex index(16);
+    std::vector<KeyIndex::Table*> tables;
+    for (auto node : nodes) {
+        KeyIndex::Table* table = index.Insert(node);
+        if (table != NULL) {
+            tables.push_back(table);
+        }
+    }
+    ASSERT_EQ(100u, index.GetSize());
+    ASSERT_FALSE(tables.empty());
+    ASSERT_GE(index.GetCapacity() * 3, index.GetSize() * 4);
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        KeyIndex::KeyNode* node = index.Get(Slice(keys[i]));
+        ASSERT_TRUE(node == nodes[i]);
+        ASSERT_EQ((uint64_t)i + 1, reinterpret_cast<uint64_t>(node->GetValue()));
+    }
+    ASSERT_TRUE(index.Get(Slice("key100")) == NULL);
+    ASSERT_TRUE(index.Get(Slice("")) == NULL);
+    for (uint32_t i = 0; i < keys.size(); i += 2) {
+        ASSERT_TRUE(index.Remove(Slice(keys[i])));
+    }
+    ASSERT_FALSE(index.Remove(Slice(keys[0])));
+    ASSERT_EQ(50u, index.GetSize());
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        KeyIndex::KeyNode* node = index.Get(Slice(keys[i]));
+        if (i % 2 == 0) {
+            ASSERT_TRUE(node == NULL);
+        } else {
+            ASSERT_TRUE(node == nodes[i]);
+        }
+    }
+    index.Clear();
+    ASSERT_EQ(0u, index.GetSize());
+    ASSERT_TRUE(index.Get(Slice(keys[1])) == NULL);
+    for (auto table : tables) {
+        delete table;
+    }
+    DeleteNodes(&nodes);
+}
+
+TEST_F(KeyIndexTest, RehashTombstone) {
+    std::vector<std::string> keys;
+    for (int i = 0; i < 1000; i++) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    std::vector<KeyIndex::KeyNode*> nodes = NewNodes(keys);
+    KeyIndex index(64);
+    // insert and remove keys repeatedly, tombstones are cleared without growing
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        delete index.Insert(nodes[i]);
+        if (i >= 10) {
+            ASSERT_TRUE(index.Remove(Slice(keys[i - 10])));
+        }
+    }
+    ASSERT_EQ(10u, index.GetSize());
+    ASSERT_EQ(64u, index.GetCapacity());
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        ASSERT_EQ(i + 10 >= keys.size(), index.Get(Slice(keys[i])) == nodes[i]);
+    }
+    DeleteNodes(&nodes);
+}
+
+TEST_F(KeyIndexTest, ConcurrentGet) {
+    const int key_num = 100000;
+    std::vector<std::string> keys;
+    for (int i = 0; i < key_num; i++) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    std::vector<KeyIndex::KeyNode*> nodes = NewNodes(keys);
+    KeyIndex index(16);
+    std::atomic<int> inserted(0);
+    std::vector<KeyIndex::Table*> tables;
+    // the writer inserts new keys and rehashes while the readers look up the inserted keys
+    std::thread writer([&]() {
+        for (int i = 0; i < key_num; i++) {
+            KeyIndex::Table* table = index.Insert(nodes[i]);
+            if (table != NULL) {
+                tables.push_back(table);
+            }
+            inserted.store(i + 1, std::memory_order_release);
+        }
+    });
+    std::vector<std::thread> readers;
+    std::atomic<int> failed(0);
+    for (int t = 0; t < 2; t++) {
+        readers.emplace_back([&, t]() {
+            uint32_t seed = t;
+            while (inserted.load(std::memory_order_acquire) < key_num) {
+                int cnt = inserted.load(std::memory_order_acquire);
+                if (cnt == 0) {
+                    continue;
+                }
+                int pos = rand_r(&seed) % cnt;
+                if (index.Get(Slice(keys[pos])) != nodes[pos]) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    writer.join();
+    for (auto& t : readers) {
+        t.join();
+    }
+    ASSERT_EQ(0, failed.load());
+    ASSERT_EQ((uint32_t)key_num, index.GetSize());
+    for (auto table : tables) {
+        delete table;
+    }
+    DeleteNodes(&nodes);
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::openmldb::base::SetLogLevel(INFO);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -33,6 +33,10 @@ DECLARE_uint32(key_entry_max_height);
 DECLARE_uint32(absolute_default_skiplist_height);
 DECLARE_uint32(latest_default_skiplist_height);
 DECLARE_uint32(max_traverse_cnt);
+DECLARE_uint32(arena_slab_size);
+DECLARE_uint32(mem_table_compact_threshold);
+DECLARE_uint32(latest_list_max_cnt);
+DECLARE_uint32(key_index_init_capacity);
 
 namespace openmldb {
 namespace storage {
@@ -48,13 +52,25 @@ MemTable::MemTable(const std::string& name, uint32_t id, uint32_t pid, uint32_t
       enable_gc_(true),
       record_cnt_(0),
       segment_released_(false),
-      record_byte_size_(0) {}
+      record_byte_size_(0),
+      gc_index_pos_(0),
+      gc_seg_pos_(0),
+      gc_index_prepared_(false),
+      gc_index_need_(false),
+      gc_round_start_time_(0),
+      last_gc_time_(::baidu::common::timer::get_micros() / 1000) {}
 
 MemTable::MemTable(const ::openmldb::api::TableMeta& table_meta)
     : Table(table_meta.name(), table_meta.tid(), table_meta.pid(), 0, true, 60 * 1000,
             std::map<std::string, uint32_t>(), ::openmldb::type::TTLType::kAbsoluteTime,
             ::openmldb::type::CompressType::kNoCompress),
-      segments_(MAX_INDEX_NUM, NULL) {
+      segments_(MAX_INDEX_NUM, NULL),
+      gc_index_pos_(0),
+      gc_seg_pos_(0),
+      gc_index_prepared_(false),
+      gc_index_need_(false),
+      gc_round_start_time_(0),
+      last_gc_time_(::baidu::common::timer::get_micros() / 1000) {
     seg_cnt_ = 8;
     enable_gc_ = true;
     record_cnt_ = 0;
@@ -117,10 +133,29 @@ bool MemTable::Init() {
                 PDLOG(INFO, "init %u, %u segment. height %u tid %u pid %u", i, j, cur_key_entry_max_height, id_, pid_);
             }
         }
+        // only the memory of arena can be bound to a numa node
+        if (table_meta_->enable_arena() || numa_node_ >= 0) {
+            for (uint32_t j = 0; j < seg_cnt_; j++) {
+                seg_arr[j]->EnableArena(FLAGS_arena_slab_size, numa_node_);
+            }
+        }
+        if (FLAGS_key_index_init_capacity > 0) {
+            for (uint32_t j = 0; j < seg_cnt_; j++) {
+                seg_arr[j]->EnableKeyIndex(FLAGS_key_index_init_capacity);
+            }
+        }
         segments_[i] = seg_arr;
         key_entry_max_height_ = cur_key_entry_max_height;
+        uint32_t latest_cnt = GetLatestCnt(i);
+        if (latest_cnt > 0) {
+            for (uint32_t j = 0; j < seg_cnt_; j++) {
+                seg_arr[j]->EnableLatest(latest_cnt);
+            }
+            PDLOG(INFO, "inner index %u keeps latest %u rows in latest list. tid %u pid %u", i, latest_cnt, id_, pid_);
+        }
     }
-    PDLOG(INFO, "init table name %s, id %d, pid %d, seg_cnt %d", name_.c_str(), id_, pid_, seg_cnt_);
+    PDLOG(INFO, "init table name %s, id %d, pid %d, seg_cnt %d, enable_arena %d, numa_node %d", name_.c_str(), id_,
+          pid_, seg_cnt_, table_meta_->enable_arena(), numa_node_);
     return true;
 }
 
@@ -171,7 +206,7 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
             }
         }
     }
-    DataBlock* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    DataBlock* block = NewDataBlock(inner_index_key_map, real_ref_cnt, value);
     for (const auto& kv : inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         bool need_put = false;
@@ -236,7 +271,7 @@ bool MemTable::Put(const Dimensions& dimensions, const TSDimensions& ts_dimensio
             }
         }
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    auto* block = NewDataBlock(inner_index_key_map, real_ref_cnt, value);
     for (const auto& kv : inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         bool need_put = false;
@@ -261,6 +296,23 @@ bool MemTable::Put(const Dimensions& dimensions, const TSDimensions& ts_dimensio
     return true;
 }
 
+DataBlock* MemTable::NewDataBlock(const std::map<int32_t, Slice>& inner_index_key_map, uint32_t dim_cnt,
+                                  const std::string& value) {
+    // the block is shared by all dimensions, so allocate it from the segment of the first one
+    if (!inner_index_key_map.empty()) {
+        const auto& kv = *inner_index_key_map.begin();
+        Segment** seg_arr = segments_[kv.first];
+        if (seg_arr != NULL) {
+            uint32_t seg_idx = 0;
+            if (seg_cnt_ > 1) {
+                seg_idx = ::openmldb::base::hash(kv.second.data(), kv.second.size(), SEED) % seg_cnt_;
+            }
+            return seg_arr[seg_idx]->NewDataBlock(dim_cnt, value.c_str(), value.length());
+        }
+    }
+    return DataBlock::New(NULL, dim_cnt, value.c_str(), value.length());
+}
+
 bool MemTable::Put(const Slice& pk, uint64_t time, DataBlock* row, uint32_t idx) {
     std::shared_ptr<IndexDef> index_def = GetIndex(idx);
     if (!index_def || !index_def->IsReady()) {
@@ -311,49 +363,122 @@ uint64_t MemTable::Release() {
     return total_cnt;
 }
 
-void MemTable::SchedGc() {
-    uint64_t consumed = ::baidu::common::timer::get_micros();
-    PDLOG(INFO, "start making gc for table %s, tid %u, pid %u", name_.c_str(), id_, pid_);
-    uint64_t gc_idx_cnt = 0;
-    uint64_t gc_record_cnt = 0;
-    uint64_t gc_record_byte_size = 0;
+bool MemTable::PrepareIndexGc(uint32_t inner_pos, std::map<uint32_t, TTLSt>* ttl_st_map, uint64_t& gc_idx_cnt,
+                              uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
     auto inner_indexs = table_index_.GetAllInnerIndex();
-    for (uint32_t i = 0; i < inner_indexs->size(); i++) {
-        const std::vector<std::shared_ptr<IndexDef>>& real_index = inner_indexs->at(i)->GetIndex();
-        std::map<uint32_t, TTLSt> ttl_st_map;
-        bool need_gc = true;
-        size_t deleted_num = 0;
-        for (size_t pos = 0; pos < real_index.size(); pos++) {
-            auto cur_index = real_index[pos];
-            auto ts_col = cur_index->GetTsColumn();
-            if (ts_col) {
-                ttl_st_map.emplace(ts_col->GetTsIdx(), *(cur_index->GetTTL()));
-            } else {
-                ttl_st_map.emplace(0, *(cur_index->GetTTL()));
-            }
-            if (cur_index->GetStatus() == IndexStatus::kWaiting) {
-                cur_index->SetStatus(IndexStatus::kDeleting);
-                need_gc = false;
-            } else if (cur_index->GetStatus() == IndexStatus::kDeleting) {
-                if (real_index.size() == 1) {
-                    if (segments_[i] != NULL) {
-                        for (uint32_t k = 0; k < seg_cnt_; k++) {
-                            if (segments_[i][k] != NULL) {
-                                segments_[i][k]->ReleaseAndCount(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-                            }
+    if (inner_pos >= inner_indexs->size()) {
+        return false;
+    }
+    const std::vector<std::shared_ptr<IndexDef>>& real_index = inner_indexs->at(inner_pos)->GetIndex();
+    bool need_gc = true;
+    size_t deleted_num = 0;
+    for (size_t pos = 0; pos < real_index.size(); pos++) {
+        auto cur_index = real_index[pos];
+        auto ts_col = cur_index->GetTsColumn();
+        if (ts_col) {
+            ttl_st_map->emplace(ts_col->GetTsIdx(), *(cur_index->GetTTL()));
+        } else {
+            ttl_st_map->emplace(0, *(cur_index->GetTTL()));
+        }
+        if (cur_index->GetStatus() == IndexStatus::kWaiting) {
+            cur_index->SetStatus(IndexStatus::kDeleting);
+            need_gc = false;
+        } else if (cur_index->GetStatus() == IndexStatus::kDeleting) {
+            if (real_index.size() == 1) {
+                if (segments_[inner_pos] != NULL) {
+                    for (uint32_t k = 0; k < seg_cnt_; k++) {
+                        if (segments_[inner_pos][k] != NULL) {
+                            segments_[inner_pos][k]->ReleaseAndCount(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
                         }
                     }
-                    deleted_num++;
                 }
-                cur_index->SetStatus(IndexStatus::kDeleted);
-            } else if (cur_index->GetStatus() == IndexStatus::kDeleted) {
                 deleted_num++;
             }
+            cur_index->SetStatus(IndexStatus::kDeleted);
+        } else if (cur_index->GetStatus() == IndexStatus::kDeleted) {
+            deleted_num++;
         }
-        if (!enable_gc_.load(std::memory_order_relaxed) || !need_gc) {
+    }
+    if (!enable_gc_.load(std::memory_order_relaxed) || !need_gc) {
+        return false;
+    }
+    if (deleted_num == real_index.size() || ttl_st_map->empty()) {
+        return false;
+    }
+    return true;
+}
+
+uint32_t MemTable::GetLatestCnt(uint32_t inner_pos) {
+    if (FLAGS_latest_list_max_cnt == 0) {
+        return 0;
+    }
+    auto inner_index = table_index_.GetInnerIndex(inner_pos);
+    if (!inner_index || inner_index->GetIndex().size() != 1) {
+        return 0;
+    }
+    auto ttl = inner_index->GetIndex().front()->GetTTL();
+    if (ttl->ttl_type != ::openmldb::storage::TTLType::kLatestTime || ttl->lat_ttl == 0 ||
+        ttl->lat_ttl > FLAGS_latest_list_max_cnt) {
+        return 0;
+    }
+    return ttl->lat_ttl;
+}
+
+void MemTable::UpdateLatestCnt() {
+    for (uint32_t i = 0; i < segments_.size(); i++) {
+        if (segments_[i] == NULL || !segments_[i][0]->IsLatestEnabled()) {
+            continue;
+        }
+        uint32_t latest_cnt = GetLatestCnt(i);
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            segments_[i][j]->SetLatestCnt(latest_cnt);
+        }
+    }
+}
+
+void MemTable::TakeEvictedRecord(uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    for (uint32_t i = 0; i < segments_.size(); i++) {
+        if (segments_[i] == NULL || !segments_[i][0]->IsLatestEnabled()) {
             continue;
         }
-        if (deleted_num == real_index.size() || ttl_st_map.empty()) {
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            segments_[i][j]->TakeEvictedRecord(gc_record_cnt, gc_record_byte_size);
+        }
+    }
+}
+
+void MemTable::SetExpire(bool is_expire) {
+    enable_gc_.store(is_expire, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < segments_.size(); i++) {
+        if (segments_[i] == NULL) {
+            continue;
+        }
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            segments_[i][j]->SetLatestEvict(is_expire);
+        }
+    }
+}
+
+uint64_t MemTable::GetCompactTime() {
+    if (FLAGS_mem_table_compact_threshold == 0) {
+        return 0;
+    }
+    return ::baidu::common::timer::get_micros() / 1000 - FLAGS_mem_table_compact_threshold * 60 * 1000;
+}
+
+void MemTable::SchedGc() {
+    std::lock_guard<std::mutex> lock(gc_mu_);
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    PDLOG(INFO, "start making gc for table %s, tid %u, pid %u", name_.c_str(), id_, pid_);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    uint64_t compact_cnt = 0;
+    uint64_t compact_time = GetCompactTime();
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    for (uint32_t i = 0; i < inner_indexs->size(); i++) {
+        std::map<uint32_t, TTLSt> ttl_st_map;
+        if (!PrepareIndexGc(i, &ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size)) {
             continue;
         }
         for (uint32_t j = 0; j < seg_cnt_; j++) {
@@ -366,19 +491,95 @@ void MemTable::SchedGc() {
             } else {
                 segment->ExecuteGc(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
+            if (compact_time > 0 && ttl_st_map.size() == 1 &&
+                ttl_st_map.begin()->second.ttl_type == ::openmldb::storage::TTLType::kAbsoluteTime) {
+                segment->Compact(compact_time, compact_cnt);
+            }
             seg_gc_time = ::baidu::common::timer::get_micros() / 1000 - seg_gc_time;
             PDLOG(INFO, "gc segment[%u][%u] done consumed %lu for table %s tid %u pid %u", i, j, seg_gc_time,
                   name_.c_str(), id_, pid_);
         }
     }
+    TakeEvictedRecord(gc_record_cnt, gc_record_byte_size);
+    last_gc_time_.store(consumed / 1000, std::memory_order_relaxed);
     consumed = ::baidu::common::timer::get_micros() - consumed;
     record_cnt_.fetch_sub(gc_record_cnt, std::memory_order_relaxed);
     record_byte_size_.fetch_sub(gc_record_byte_size, std::memory_order_relaxed);
     PDLOG(INFO,
-          "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu consumed %lu ms for "
+          "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu compact_cnt %lu consumed %lu ms for "
           "table %s tid %u pid %u",
-          gc_idx_cnt, gc_record_cnt, consumed / 1000, name_.c_str(), id_, pid_);
+          gc_idx_cnt, gc_record_cnt, compact_cnt, consumed / 1000, name_.c_str(), id_, pid_);
     UpdateTTL();
+    UpdateLatestCnt();
+}
+
+bool MemTable::SchedGcSlice(uint32_t max_key_num, uint32_t max_free_num, uint64_t max_time_us) {
+    std::lock_guard<std::mutex> lock(gc_mu_);
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint64_t deadline = start_time + max_time_us;
+    if (gc_round_start_time_ == 0) {
+        gc_round_start_time_ = start_time / 1000;
+        PDLOG(INFO, "start incremental gc for table %s, tid %u, pid %u", name_.c_str(), id_, pid_);
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    uint64_t compact_cnt = 0;
+    uint64_t compact_time = GetCompactTime();
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    bool finished = false;
+    while (true) {
+        if (gc_index_pos_ >= inner_indexs->size()) {
+            finished = true;
+            break;
+        }
+        if (!gc_index_prepared_) {
+            gc_ttl_st_map_.clear();
+            gc_index_need_ =
+                PrepareIndexGc(gc_index_pos_, &gc_ttl_st_map_, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            gc_index_prepared_ = true;
+            gc_seg_pos_ = 0;
+        }
+        if (!gc_index_need_ || gc_seg_pos_ >= seg_cnt_) {
+            gc_index_pos_++;
+            gc_index_prepared_ = false;
+            continue;
+        }
+        Segment* segment = segments_[gc_index_pos_][gc_seg_pos_];
+        if (segment->ExecuteGcSlice(gc_ttl_st_map_, max_key_num, max_free_num, deadline, gc_idx_cnt, gc_record_cnt,
+                                    gc_record_byte_size)) {
+            if (compact_time > 0 && gc_ttl_st_map_.size() == 1 &&
+                gc_ttl_st_map_.begin()->second.ttl_type == ::openmldb::storage::TTLType::kAbsoluteTime) {
+                segment->Compact(compact_time, compact_cnt);
+            }
+            gc_seg_pos_++;
+        }
+        if (::baidu::common::timer::get_micros() >= deadline) {
+            break;
+        }
+    }
+    TakeEvictedRecord(gc_record_cnt, gc_record_byte_size);
+    record_cnt_.fetch_sub(gc_record_cnt, std::memory_order_relaxed);
+    record_byte_size_.fetch_sub(gc_record_byte_size, std::memory_order_relaxed);
+    DEBUGLOG("gc slice done, gc_idx_cnt %lu, gc_record_cnt %lu consumed %lu us for table %s tid %u pid %u", gc_idx_cnt,
+             gc_record_cnt, ::baidu::common::timer::get_micros() - start_time, name_.c_str(), id_, pid_);
+    if (finished) {
+        PDLOG(INFO, "incremental gc finished, consumed %lu ms for table %s tid %u pid %u",
+              start_time / 1000 - gc_round_start_time_, name_.c_str(), id_, pid_);
+        last_gc_time_.store(gc_round_start_time_, std::memory_order_relaxed);
+        gc_round_start_time_ = 0;
+        gc_index_pos_ = 0;
+        gc_index_prepared_ = false;
+        UpdateTTL();
+        UpdateLatestCnt();
+    }
+    return finished;
+}
+
+uint64_t MemTable::GetGcLag() const {
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    uint64_t last_gc_time = last_gc_time_.load(std::memory_order_relaxed);
+    return cur_time > last_gc_time ? cur_time - last_gc_time : 0;
 }
 
 // tll as ms
@@ -562,6 +763,30 @@ uint64_t MemTable::GetRecordIdxCnt() {
     return record_idx_cnt;
 }
 
+uint64_t MemTable::GetArenaByteSize() {
+    uint64_t arena_byte_size = 0;
+    for (uint32_t i = 0; i < segments_.size(); i++) {
+        if (segments_[i] != NULL) {
+            for (uint32_t j = 0; j < seg_cnt_; j++) {
+                arena_byte_size += segments_[i][j]->GetArenaByteSize();
+            }
+        }
+    }
+    return arena_byte_size;
+}
+
+uint64_t MemTable::GetCompactSavedByteSize() {
+    uint64_t saved_byte_size = 0;
+    for (uint32_t i = 0; i < segments_.size(); i++) {
+        if (segments_[i] != NULL) {
+            for (uint32_t j = 0; j < seg_cnt_; j++) {
+                saved_byte_size += segments_[i][j]->GetCompactSavedByteSize();
+            }
+        }
+    }
+    return saved_byte_size;
+}
+
 uint64_t MemTable::GetRecordPkCnt() {
     uint64_t record_pk_cnt = 0;
     auto inner_indexs = table_index_.GetAllInnerIndex();
@@ -640,6 +865,11 @@ bool MemTable::AddIndex(const ::openmldb::common::ColumnKey& column_key) {
                       FLAGS_absolute_default_skiplist_height, id_, pid_);
             }
         }
+        if (table_meta_->enable_arena() || numa_node_ >= 0) {
+            for (uint32_t j = 0; j < seg_cnt_; j++) {
+                seg_arr[j]->EnableArena(FLAGS_arena_slab_size, numa_node_);
+            }
+        }
         index_def = std::make_shared<IndexDef>(column_key.index_name(), table_index_.GetMaxIndexId() + 1);
         if (table_index_.AddIndex(index_def) < 0) {
             PDLOG(WARNING, "add index failed. tid %u pid %u", id_, pid_);
@@ -881,30 +1111,30 @@ bool MemTableKeyIterator::Valid() {
 void MemTableKeyIterator::Next() { NextPK(); }
 
 ::hybridse::vm::RowIterator* MemTableKeyIterator::GetRawValue() {
-    TimeEntries::Iterator* it = NULL;
+    KeyEntryIterator* it = NULL;
     if (segments_[seg_idx_]->GetTsCnt() > 1) {
         KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-        it = entry->entries.NewIterator();
         ticket_.Push(entry);
+        it = entry->NewIterator();
     } else {
-        it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                 ->entries.NewIterator();
         ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
+        it = ((KeyEntry*)pk_it_->GetValue())          // NOLINT
+                 ->NewIterator();
     }
     it->SeekToFirst();
     return new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_);
 }
 
 std::unique_ptr<::hybridse::vm::RowIterator> MemTableKeyIterator::GetValue() {
-    TimeEntries::Iterator* it = NULL;
+    KeyEntryIterator* it = NULL;
     if (segments_[seg_idx_]->GetTsCnt() > 1) {
         KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-        it = entry->entries.NewIterator();
         ticket_.Push(entry);
+        it = entry->NewIterator();
     } else {
-        it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                 ->entries.NewIterator();
         ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
+        it = ((KeyEntry*)pk_it_->GetValue())          // NOLINT
+                 ->NewIterator();
     }
     it->SeekToFirst();
     std::unique_ptr<MemTableWindowIterator> wit(new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_));
@@ -1007,12 +1237,12 @@ void MemTableTraverseIterator::NextPK() {
         }
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[0];  // NOLINT
-            it_ = entry->entries.NewIterator();
             ticket_.Push(entry);
+            it_ = entry->NewIterator();
         } else {
-            it_ = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                      ->entries.NewIterator();
             ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
+            it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
+                      ->NewIterator();
         }
         it_->SeekToFirst();
         record_idx_ = 1;
@@ -1043,11 +1273,11 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
             ticket_.Push(entry);
-            it_ = entry->entries.NewIterator();
+            it_ = entry->NewIterator();
         } else {
             ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
             it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                      ->entries.NewIterator();
+                      ->NewIterator();
         }
         if (spk.compare(pk_it_->GetKey()) != 0) {
             it_->SeekToFirst();
@@ -1089,6 +1319,11 @@ openmldb::base::Slice MemTableTraverseIterator::GetValue() const {
     return openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
 }
 
+DataBlock* MemTableTraverseIterator::GetPinnableBlock() const {
+    DataBlock* block = it_->GetValue();
+    return block->IsPinnable() ? block : NULL;
+}
+
 uint64_t MemTableTraverseIterator::GetKey() const {
     if (it_ != NULL && it_->Valid()) {
         return it_->GetKey();
@@ -1120,11 +1355,11 @@ void MemTableTraverseIterator::SeekToFirst() {
             if (segments_[seg_idx_]->GetTsCnt() > 1) {
                 KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
                 ticket_.Push(entry);
-                it_ = entry->entries.NewIterator();
+                it_ = entry->NewIterator();
             } else {
                 ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
                 it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                          ->entries.NewIterator();
+                          ->NewIterator();
             }
             it_->SeekToFirst();
             traverse_cnt_++;
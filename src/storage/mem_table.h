@@ -20,6 +20,7 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 
@@ -40,7 +41,7 @@ typedef google::protobuf::RepeatedPtrField<::openmldb::api::Dimension> Dimension
 
 class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
  public:
-    MemTableWindowIterator(TimeEntries::Iterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+    MemTableWindowIterator(KeyEntryIterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
                            uint64_t expire_cnt)
         : it_(it), record_idx_(0), expire_value_(expire_time, expire_cnt, ttl_type), row_() {}
 
@@ -62,7 +63,15 @@ class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
 
     // TODO(wangtaize) unify the row object
     inline const ::hybridse::codec::Row& GetValue() {
-        row_.Reset(reinterpret_cast<const int8_t*>(it_->GetValue()->data), it_->GetValue()->size);
+        DataBlock* block = it_->GetValue();
+        if (it_->IsCompact()) {
+            // the row of compact block is released when iterator moves
+            int8_t* buf = reinterpret_cast<int8_t*>(malloc(block->size));
+            memcpy(buf, block->data, block->size);
+            row_ = ::hybridse::codec::Row(::hybridse::base::RefCountedSlice::CreateManaged(buf, block->size));
+        } else {
+            row_.Reset(reinterpret_cast<const int8_t*>(block->data), block->size);
+        }
         return row_;
     }
     inline void Seek(const uint64_t& key) { it_->Seek(key); }
@@ -70,7 +79,7 @@ class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
     inline bool IsSeekable() const { return true; }
 
  private:
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
     uint32_t record_idx_;
     TTLSt expire_value_;
     ::hybridse::codec::Row row_;
@@ -104,7 +113,7 @@ class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
     uint32_t const seg_cnt_;
     uint32_t seg_idx_;
     KeyEntries::Iterator* pk_it_;
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
     ::openmldb::storage::TTLType ttl_type_;
     uint64_t expire_time_;
     uint64_t expire_cnt_;
@@ -122,6 +131,7 @@ class MemTableTraverseIterator : public TableIterator {
     void Next() override;
     void Seek(const std::string& key, uint64_t time) override;
     openmldb::base::Slice GetValue() const override;
+    DataBlock* GetPinnableBlock() const override;
     std::string GetPK() const override;
     uint64_t GetKey() const override;
     void SeekToFirst() override;
@@ -135,7 +145,7 @@ class MemTableTraverseIterator : public TableIterator {
     uint32_t const seg_cnt_;
     uint32_t seg_idx_;
     KeyEntries::Iterator* pk_it_;
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
     uint32_t record_idx_;
     uint32_t ts_idx_;
     // uint64_t expire_value_;
@@ -188,6 +198,14 @@ class MemTable : public Table {
 
     void SchedGc() override;
 
+    // Gc the table incrementally from the position left by last call until the deadline.
+    // Every segment scans at most max_key_num keys and frees at most max_free_num records
+    // in one call. It returns true when a whole round of gc is finished
+    bool SchedGcSlice(uint32_t max_key_num, uint32_t max_free_num, uint64_t max_time_us);
+
+    // the time in ms since the start of last finished gc round
+    uint64_t GetGcLag() const;
+
     int GetCount(uint32_t index, const std::string& pk,
                  uint64_t& count);  // NOLINT
 
@@ -195,6 +213,10 @@ class MemTable : public Table {
     bool GetRecordIdxCnt(uint32_t idx, uint64_t** stat, uint32_t* size);
     uint64_t GetRecordIdxByteSize();
     uint64_t GetRecordPkCnt();
+    // the byte size of slabs hold by segment arenas
+    uint64_t GetArenaByteSize();
+    // the byte size released by compacting cold rows
+    uint64_t GetCompactSavedByteSize();
 
     void SetCompressType(::openmldb::type::CompressType compress_type);
     ::openmldb::type::CompressType GetCompressType();
@@ -205,7 +227,8 @@ class MemTable : public Table {
 
     inline uint32_t GetSegCnt() const { return seg_cnt_; }
 
-    inline void SetExpire(bool is_expire) { enable_gc_.store(is_expire, std::memory_order_relaxed); }
+    // the rows of latest lists are not evicted either if expiration is disabled
+    void SetExpire(bool is_expire);
 
     uint64_t GetExpireTime(const TTLSt& ttl_st) override;
 
@@ -219,6 +242,12 @@ class MemTable : public Table {
 
     inline uint32_t GetKeyEntryHeight() const { return key_entry_max_height_; }
 
+    // bind the memory of segments to the numa node, which enables arena. It must be called before Init
+    inline void SetNumaNode(int numa_node) { numa_node_ = numa_node; }
+
+    // -1 if the table is not bound to any node
+    inline int GetNumaNode() const { return numa_node_; }
+
     bool DeleteIndex(const std::string& idx_name);
 
     bool AddIndex(const ::openmldb::common::ColumnKey& column_key);
@@ -228,6 +257,26 @@ class MemTable : public Table {
 
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
 
+    DataBlock* NewDataBlock(const std::map<int32_t, Slice>& inner_index_key_map, uint32_t dim_cnt,
+                            const std::string& value);
+
+    // update the status of deleting indexes and get the ttl of the inner index.
+    // return false if the inner index need not gc
+    bool PrepareIndexGc(uint32_t inner_pos, std::map<uint32_t, TTLSt>* ttl_st_map,
+                        uint64_t& gc_idx_cnt,            // NOLINT
+                        uint64_t& gc_record_cnt,         // NOLINT
+                        uint64_t& gc_record_byte_size);  // NOLINT
+
+    uint64_t GetCompactTime();
+
+    // the count of rows kept by latest lists of the inner index, 0 means the
+    // inner index keeps rows in time lists
+    uint32_t GetLatestCnt(uint32_t inner_pos);
+    void UpdateLatestCnt();
+    // the records released by put of latest lists are counted by gc
+    void TakeEvictedRecord(uint64_t& gc_record_cnt,          // NOLINT
+                           uint64_t& gc_record_byte_size);   // NOLINT
+
  private:
     uint32_t seg_cnt_;
     std::vector<Segment**> segments_;
@@ -237,6 +286,17 @@ class MemTable : public Table {
     bool segment_released_;
     std::atomic<uint64_t> record_byte_size_;
     uint32_t key_entry_max_height_;
+    int numa_node_ = -1;
+    // only one gc runs on the table at a time
+    std::mutex gc_mu_;
+    // the position of incremental gc
+    uint32_t gc_index_pos_;
+    uint32_t gc_seg_pos_;
+    bool gc_index_prepared_;
+    bool gc_index_need_;
+    std::map<uint32_t, TTLSt> gc_ttl_st_map_;
+    uint64_t gc_round_start_time_;
+    std::atomic<uint64_t> last_gc_time_;
 };
 
 }  // namespace storage
@@ -14,10 +14,14 @@
  * limitations under the License.
  */
 
+#include <gflags/gflags.h>
+
 #include "common/timer.h"
 #include "gtest/gtest.h"
 #include "storage/mem_table.h"
 
+DECLARE_uint32(mem_table_compact_threshold);
+
 namespace openmldb {
 namespace storage {
 
@@ -48,6 +52,55 @@ TEST_F(MemTableIteratorTest, smoketest) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(MemTableIteratorTest, compact) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    MemTable* table = new MemTable("tx_log", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    std::string key = "test";
+    uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+    // 5 hot rows and 20 rows older than two hours
+    std::vector<uint64_t> ts_vec;
+    for (uint64_t i = 0; i < 5; i++) {
+        ts_vec.push_back(now - i);
+    }
+    for (uint64_t i = 0; i < 20; i++) {
+        ts_vec.push_back(now - 2 * 60 * 60 * 1000 - i);
+    }
+    for (auto ts : ts_vec) {
+        std::string value = "value" + std::to_string(ts);
+        table->Put(key, ts, value.c_str(), value.size());
+    }
+    FLAGS_mem_table_compact_threshold = 60;
+    table->SchedGc();
+    FLAGS_mem_table_compact_threshold = 0;
+    ASSERT_GT(table->GetCompactSavedByteSize(), 0u);
+    ASSERT_EQ(25u, table->GetRecordCnt());
+    ::hybridse::vm::WindowIterator* it = table->NewWindowIterator(0);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    std::unique_ptr<::hybridse::vm::RowIterator> wit = it->GetValue();
+    wit->SeekToFirst();
+    std::vector<::hybridse::codec::Row> rows;
+    for (auto ts : ts_vec) {
+        ASSERT_TRUE(wit->Valid());
+        ASSERT_EQ(ts, wit->GetKey());
+        rows.push_back(wit->GetValue());
+        wit->Next();
+    }
+    ASSERT_FALSE(wit->Valid());
+    // rows of compact blocks are still valid after the iterator moves
+    for (size_t i = 0; i < ts_vec.size(); i++) {
+        ASSERT_EQ("value" + std::to_string(ts_vec[i]), rows[i].ToString());
+    }
+    wit->Seek(now - 2 * 60 * 60 * 1000 - 10);
+    ASSERT_TRUE(wit->Valid());
+    ASSERT_EQ(now - 2 * 60 * 60 * 1000 - 10, wit->GetKey());
+    wit.reset();
+    delete it;
+    delete table;
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -23,6 +23,8 @@
 #include <snappy.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <memory>
 #include <set>
 #include <utility>
 
@@ -40,6 +42,7 @@
 #include "common/thread_pool.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
+#include "log/log_format.h"
 #include "log/log_reader.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
@@ -53,7 +56,9 @@ DECLARE_uint32(make_snapshot_max_deleted_keys);
 DECLARE_uint32(load_table_batch);
 DECLARE_uint32(load_table_thread_num);
 DECLARE_uint32(load_table_queue_size);
+DECLARE_uint32(load_snapshot_range_size);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(snapshot_max_delta_num);
 
 namespace openmldb {
 namespace storage {
@@ -61,6 +66,7 @@ namespace storage {
 const std::string SNAPSHOT_SUBFIX = ".sdb";  // NOLINT
 const uint32_t KEY_NUM_DISPLAY = 1000000;    // NOLINT
 const std::string MANIFEST = "MANIFEST";     // NOLINT
+const uint32_t SNAPSHOT_READ_BUFFER_SIZE = 4 * 1024 * 1024;
 
 MemTableSnapshot::MemTableSnapshot(uint32_t tid, uint32_t pid, LogParts* log_part, const std::string& db_root_path)
     : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path) {}
@@ -82,12 +88,23 @@ bool MemTableSnapshot::Init() {
 bool MemTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_offset) {
     ::openmldb::api::Manifest manifest;
     manifest.set_offset(0);
+    recover_record_cnt_ = 0;
+    recover_byte_size_ = 0;
     int ret = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
     if (ret == -1) {
         return false;
     }
     if (ret == 0) {
-        RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+        if (manifest.offset() <= table->GetPersistedOffset()) {
+            PDLOG(INFO, "table keeps the rows of snapshot offset %lu. tid %u pid %u", manifest.offset(), tid_, pid_);
+        } else {
+            RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+            for (const auto& delta : manifest.delta()) {
+                if (!RecoverFromDelta(delta, table)) {
+                    return false;
+                }
+            }
+        }
         latest_offset = manifest.offset();
         offset_ = latest_offset;
     }
@@ -99,7 +116,28 @@ void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uin
     std::string full_path = snapshot_path_ + "/" + snapshot_name;
     std::atomic<uint64_t> g_succ_cnt(0);
     std::atomic<uint64_t> g_failed_cnt(0);
-    RecoverSingleSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    uint64_t file_size = 0;
+    ::openmldb::base::GetFileSize(full_path, file_size);
+    // the records of an uncompressed snapshot can be located from any block, so the file is
+    // split into block aligned ranges which are read and put to table in parallel
+    uint64_t range_size = std::max(FLAGS_load_snapshot_range_size, ::openmldb::log::kBlockSize);
+    uint64_t range_num = std::min((file_size + range_size - 1) / range_size, (uint64_t)FLAGS_load_table_thread_num);
+    if (table && !IsCompressed(full_path) && range_num > 1) {
+        uint64_t block_num = (file_size + ::openmldb::log::kBlockSize - 1) / ::openmldb::log::kBlockSize;
+        ::openmldb::base::TaskPool range_pool(range_num, range_num);
+        for (uint64_t i = 0; i < range_num; i++) {
+            uint64_t start = block_num * i / range_num * ::openmldb::log::kBlockSize;
+            uint64_t end = block_num * (i + 1) / range_num * ::openmldb::log::kBlockSize;
+            range_pool.AddTask(boost::bind(&MemTableSnapshot::RecoverSnapshotRange, this, full_path, start, end, table,
+                                           &g_succ_cnt, &g_failed_cnt));
+        }
+        range_pool.Stop();
+        PDLOG(INFO, "load snapshot %s with %lu ranges. tid %u pid %u", full_path.c_str(), range_num, tid_, pid_);
+    } else {
+        RecoverSingleSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    }
+    recover_record_cnt_ += g_succ_cnt.load(std::memory_order_relaxed);
+    recover_byte_size_ += file_size;
     PDLOG(INFO, "[Recover] progress done stat: success count %lu, failed count %lu",
           g_succ_cnt.load(std::memory_order_relaxed), g_failed_cnt.load(std::memory_order_relaxed));
     if (g_succ_cnt.load(std::memory_order_relaxed) != expect_cnt) {
@@ -108,6 +146,113 @@ void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uin
     }
 }
 
+bool MemTableSnapshot::RecoverFromDelta(const ::openmldb::api::SnapshotDelta& delta, std::shared_ptr<Table> table) {
+    std::string full_path = snapshot_path_ + delta.name();
+    FILE* fd = fopen(full_path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+        return false;
+    }
+    uint64_t file_size = 0;
+    ::openmldb::base::GetFileSize(full_path, file_size);
+    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(full_path, fd);
+    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, IsCompressed(full_path));
+    std::string buffer;
+    ::openmldb::api::LogEntry entry;
+    uint64_t put_cnt = 0;
+    uint64_t delete_cnt = 0;
+    uint64_t failed_cnt = 0;
+    // the records are applied in order so that a delete only removes the records before it.
+    // the expired records are removed by gc after loading
+    while (true) {
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
+            break;
+        }
+        if (!status.ok() || !entry.ParseFromArray(record.data(), record.size())) {
+            failed_cnt++;
+            continue;
+        }
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            if (entry.dimensions_size() > 0) {
+                table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
+            }
+            delete_cnt++;
+        } else {
+            table->Put(entry);
+            put_cnt++;
+        }
+    }
+    delete seq_file;
+    recover_record_cnt_ += put_cnt;
+    recover_byte_size_ += file_size;
+    PDLOG(INFO, "load delta snapshot %s. put count %lu, delete count %lu, failed count %lu. tid %u pid %u",
+          delta.name().c_str(), put_cnt, delete_cnt, failed_cnt, tid_, pid_);
+    if (put_cnt + delete_cnt != delta.count()) {
+        PDLOG(WARNING, "delta snapshot %s, expect cnt %lu but load cnt %lu", delta.name().c_str(), delta.count(),
+              put_cnt + delete_cnt);
+    }
+    return true;
+}
+
+void MemTableSnapshot::RecoverSnapshotRange(const std::string& path, uint64_t start, uint64_t end,
+                                            std::shared_ptr<Table> table, std::atomic<uint64_t>* succ_cnt,
+                                            std::atomic<uint64_t>* failed_cnt) {
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return;
+    }
+    // read ahead in large chunks, the buffer must outlive the file
+    std::unique_ptr<char[]> io_buf(new char[SNAPSHOT_READ_BUFFER_SIZE]);
+    setvbuf(fd, io_buf.get(), _IOFBF, SNAPSHOT_READ_BUFFER_SIZE);
+    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
+    // the reader skips the tail of the record starting in previous range
+    ::openmldb::log::Reader reader(seq_file, NULL, false, start, false);
+    std::string buffer;
+    ::openmldb::api::LogEntry entry;
+    uint64_t cnt = 0;
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    while (true) {
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
+            break;
+        }
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                  status.ToString().c_str());
+            failed_cnt->fetch_add(1, std::memory_order_relaxed);
+            if (cnt == 0) {
+                // reader would skip to the start block again
+                break;
+            }
+            continue;
+        }
+        if (reader.LastRecordOffset() >= end) {
+            break;
+        }
+        // parse from the read buffer directly
+        if (!entry.ParseFromArray(record.data(), record.size())) {
+            failed_cnt->fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        auto scount = succ_cnt->fetch_add(1, std::memory_order_relaxed);
+        if (scount % 100000 == 0) {
+            PDLOG(INFO, "load snapshot %s with succ_cnt %lu, failed_cnt %lu", path.c_str(), scount,
+                  failed_cnt->load(std::memory_order_relaxed));
+        }
+        table->Put(entry);
+        cnt++;
+    }
+    // will close the fd
+    delete seq_file;
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    PDLOG(INFO, "read range [%lu, %lu) of path %s completed, count %lu, consumed %lu ms. tid %u pid %u", start, end,
+          path.c_str(), cnt, consumed / 1000, tid_, pid_);
+}
+
 void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table,
                                              std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
     ::openmldb::base::TaskPool load_pool_(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
@@ -167,6 +312,8 @@ void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::share
         }
         // will close the fd atomic
         delete seq_file;
+        // wait the pending batches before collecting the count
+        load_pool_.Stop();
         if (g_succ_cnt) {
             g_succ_cnt->fetch_add(succ_cnt, std::memory_order_relaxed);
         }
@@ -238,6 +385,11 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
             has_error = true;
             break;
         }
+        // the tombstone in delta snapshot
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            deleted_key_num++;
+            continue;
+        }
         int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
         if (ret == 1) {
             deleted_key_num++;
@@ -353,6 +505,90 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         return -1;
     }
     making_snapshot_.store(true, std::memory_order_release);
+    ::openmldb::api::Manifest manifest;
+    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
+    int ret = 0;
+    if (result == 0 && FLAGS_snapshot_max_delta_num > 0 &&
+        static_cast<uint32_t>(manifest.delta_size()) < FLAGS_snapshot_max_delta_num) {
+        ret = MakeDeltaSnapshot(table, manifest, out_offset, end_offset);
+    } else {
+        // merge the delta snapshots into a new base snapshot when the chain is full
+        ret = MakeFullSnapshot(table, result, manifest, out_offset, end_offset);
+    }
+    deleted_keys_.clear();
+    making_snapshot_.store(false, std::memory_order_release);
+    return ret;
+}
+
+int MemTableSnapshot::MakeDeltaSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
+                                        uint64_t& out_offset, uint64_t end_offset) {
+    std::string now_time = ::openmldb::base::GetNowTime();
+    std::string snapshot_name =
+        now_time.substr(0, now_time.length() - 2) + "_" + std::to_string(offset_) + ".delta" + SNAPSHOT_SUBFIX;
+    if (FLAGS_snapshot_compression != "off") {
+        snapshot_name.append(".");
+        snapshot_name.append(FLAGS_snapshot_compression);
+    }
+    std::string snapshot_name_tmp = snapshot_name + ".tmp";
+    std::string full_path = snapshot_path_ + snapshot_name;
+    std::string tmp_file_path = snapshot_path_ + snapshot_name_tmp;
+    FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+        return -1;
+    }
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
+    uint64_t cur_offset = offset_;
+    uint64_t last_term = manifest.term();
+    uint64_t write_count = 0;
+    uint64_t expired_key_num = 0;
+    uint64_t deleted_key_num = 0;
+    int ret = DumpBinlog(table, end_offset > 0 ? end_offset : UINT64_MAX, true, wh, &cur_offset, &last_term,
+                         &write_count, &expired_key_num, &deleted_key_num);
+    wh->EndLog();
+    delete wh;
+    if (ret < 0) {
+        unlink(tmp_file_path.c_str());
+        return -1;
+    }
+    if (cur_offset == offset_) {
+        PDLOG(INFO, "no new binlog after offset %lu. tid %u pid %u", offset_, tid_, pid_);
+        unlink(tmp_file_path.c_str());
+        out_offset = offset_;
+        return 0;
+    }
+    if (rename(tmp_file_path.c_str(), full_path.c_str()) != 0) {
+        PDLOG(WARNING, "rename[%s] failed", snapshot_name.c_str());
+        unlink(tmp_file_path.c_str());
+        return -1;
+    }
+    ::openmldb::api::Manifest new_manifest(manifest);
+    ::openmldb::api::SnapshotDelta* delta = new_manifest.add_delta();
+    delta->set_name(snapshot_name);
+    delta->set_count(write_count);
+    delta->set_offset(cur_offset);
+    new_manifest.set_offset(cur_offset);
+    new_manifest.set_term(last_term);
+    if (GenManifest(new_manifest) != 0) {
+        PDLOG(WARNING, "GenManifest failed. delete delta snapshot file[%s]", full_path.c_str());
+        unlink(full_path.c_str());
+        return -1;
+    }
+    uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
+    PDLOG(INFO,
+          "make delta snapshot[%s] success. update offset from %lu to %lu. use %lu second. write key %lu deleted key "
+          "%lu. delta num %d tid %u pid %u",
+          snapshot_name.c_str(), offset_, cur_offset, consumed, write_count, deleted_key_num,
+          new_manifest.delta_size(), tid_, pid_);
+    offset_ = cur_offset;
+    out_offset = cur_offset;
+    return 0;
+}
+
+int MemTableSnapshot::MakeFullSnapshot(std::shared_ptr<Table> table, int manifest_result,
+                                       const ::openmldb::api::Manifest& manifest, uint64_t& out_offset,
+                                       uint64_t end_offset) {
     std::string now_time = ::openmldb::base::GetNowTime();
     std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
     if (FLAGS_snapshot_compression != "off") {
@@ -365,31 +601,97 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
     FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
     if (fd == NULL) {
         PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
-        making_snapshot_.store(false, std::memory_order_release);
         return -1;
     }
     uint64_t collected_offset = CollectDeletedKey(end_offset);
     uint64_t start_time = ::baidu::common::timer::now_time();
     WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
-    ::openmldb::api::Manifest manifest;
     bool has_error = false;
     uint64_t write_count = 0;
     uint64_t expired_key_num = 0;
     uint64_t deleted_key_num = 0;
     uint64_t last_term = 0;
-    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
-    if (result == 0) {
+    if (manifest_result == 0) {
+        if (CollectDeletedKeyFromDelta(manifest) < 0) {
+            has_error = true;
+        }
         // filter old snapshot
-        if (TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num) < 0) {
+        if (!has_error && TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num) < 0) {
             has_error = true;
         }
+        for (int i = 0; !has_error && i < manifest.delta_size(); i++) {
+            ::openmldb::api::Manifest delta_manifest;
+            delta_manifest.set_name(manifest.delta(i).name());
+            delta_manifest.set_count(manifest.delta(i).count());
+            // the count is checked for each file
+            uint64_t delta_write_count = 0;
+            uint64_t delta_expired_key_num = 0;
+            uint64_t delta_deleted_key_num = 0;
+            if (TTLSnapshot(table, delta_manifest, wh, delta_write_count, delta_expired_key_num,
+                            delta_deleted_key_num) < 0) {
+                has_error = true;
+            }
+            write_count += delta_write_count;
+            expired_key_num += delta_expired_key_num;
+            deleted_key_num += delta_deleted_key_num;
+        }
         last_term = manifest.term();
         DEBUGLOG("old manifest term is %lu", last_term);
-    } else if (result < 0) {
+    } else if (manifest_result < 0) {
         // parse manifest error
         has_error = true;
     }
+    uint64_t cur_offset = offset_;
+    if (!has_error && DumpBinlog(table, collected_offset, false, wh, &cur_offset, &last_term, &write_count,
+                                 &expired_key_num, &deleted_key_num) < 0) {
+        has_error = true;
+    }
+    if (wh != NULL) {
+        wh->EndLog();
+        delete wh;
+        wh = NULL;
+    }
+    int ret = 0;
+    if (has_error) {
+        unlink(tmp_file_path.c_str());
+        ret = -1;
+    } else {
+        if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
+            if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
+                // delete old snapshot
+                if (manifest.has_name() && manifest.name() != snapshot_name) {
+                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
+                    unlink((snapshot_path_ + manifest.name()).c_str());
+                }
+                for (const auto& delta : manifest.delta()) {
+                    unlink((snapshot_path_ + delta.name()).c_str());
+                }
+                uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
+                PDLOG(INFO,
+                      "make snapshot[%s] success. update offset from %lu to %lu."
+                      "use %lu second. write key %lu expired key %lu deleted key "
+                      "%lu merged delta num %d",
+                      snapshot_name.c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
+                      deleted_key_num, manifest.delta_size());
+                offset_ = cur_offset;
+                out_offset = cur_offset;
+            } else {
+                PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
+                unlink(full_path.c_str());
+                ret = -1;
+            }
+        } else {
+            PDLOG(WARNING, "rename[%s] failed", snapshot_name.c_str());
+            unlink(tmp_file_path.c_str());
+            ret = -1;
+        }
+    }
+    return ret;
+}
 
+int MemTableSnapshot::DumpBinlog(std::shared_ptr<Table> table, uint64_t end_offset, bool is_delta, WriteHandle* wh,
+                                 uint64_t* cur_offset, uint64_t* last_term, uint64_t* write_count,
+                                 uint64_t* expired_key_num, uint64_t* deleted_key_num) {
     // get deleted index
     std::set<uint32_t> deleted_index;
     for (const auto& it : table->GetAllIndex()) {
@@ -398,11 +700,10 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         }
     }
     ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
-    log_reader.SetOffset(offset_);
-    uint64_t cur_offset = offset_;
+    log_reader.SetOffset(*cur_offset);
     std::string buffer;
     std::string tmp_buf;
-    while (!has_error && cur_offset < collected_offset) {
+    while (*cur_offset < end_offset) {
         buffer.clear();
         ::openmldb::base::Slice record;
         ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
@@ -411,44 +712,46 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
             if (!entry.ParseFromString(record.ToString())) {
                 PDLOG(WARNING, "fail to parse LogEntry. record[%s] size[%ld]",
                       ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size());
-                has_error = true;
-                break;
+                return -1;
             }
-            if (entry.log_index() <= cur_offset) {
+            if (entry.log_index() <= *cur_offset) {
                 continue;
             }
-            if (cur_offset + 1 != entry.log_index()) {
-                PDLOG(WARNING, "log missing expect offset %lu but %ld", cur_offset + 1, entry.log_index());
+            if (*cur_offset + 1 != entry.log_index()) {
+                PDLOG(WARNING, "log missing expect offset %lu but %ld", *cur_offset + 1, entry.log_index());
                 continue;
             }
-            cur_offset = entry.log_index();
+            *cur_offset = entry.log_index();
             if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
-                continue;
-            }
-            if (entry.has_term()) {
-                last_term = entry.term();
-            }
-            int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
-            if (ret == 1) {
-                deleted_key_num++;
-                continue;
-            } else if (ret == 2) {
-                record.reset(tmp_buf.data(), tmp_buf.size());
-            }
-            if (table->IsExpire(entry)) {
-                expired_key_num++;
-                continue;
+                if (!is_delta) {
+                    continue;
+                }
+                // keep the delete record as a tombstone
+            } else {
+                if (entry.has_term()) {
+                    *last_term = entry.term();
+                }
+                int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
+                if (ret == 1) {
+                    (*deleted_key_num)++;
+                    continue;
+                } else if (ret == 2) {
+                    record.reset(tmp_buf.data(), tmp_buf.size());
+                }
+                if (!is_delta && table->IsExpire(entry)) {
+                    (*expired_key_num)++;
+                    continue;
+                }
             }
             ::openmldb::log::Status status = wh->Write(record);
             if (!status.ok()) {
-                PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
-                      status.ToString().c_str());
-                has_error = true;
-                break;
+                PDLOG(WARNING, "fail to write snapshot. status[%s] tid[%u] pid[%u]", status.ToString().c_str(), tid_,
+                      pid_);
+                return -1;
             }
-            write_count++;
-            if ((write_count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
-                PDLOG(INFO, "has write key num[%lu] expired key num[%lu]", write_count, expired_key_num);
+            (*write_count)++;
+            if ((*write_count + *expired_key_num + *deleted_key_num) % KEY_NUM_DISPLAY == 0) {
+                PDLOG(INFO, "has write key num[%lu] expired key num[%lu]", *write_count, *expired_key_num);
             }
         } else if (status.IsEof()) {
             continue;
@@ -461,57 +764,57 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
                 PDLOG(WARNING,
                       "read new binlog file. tid[%u] pid[%u] cur_log_index[%d] "
                       "end_log_index[%d] cur_offset[%lu]",
-                      tid_, pid_, cur_log_index, end_log_index, cur_offset);
+                      tid_, pid_, cur_log_index, end_log_index, *cur_offset);
                 continue;
             }
             DEBUGLOG("has read all record!");
             break;
         } else {
             PDLOG(WARNING, "fail to get record. status is %s", status.ToString().c_str());
-            has_error = true;
-            break;
+            return -1;
         }
     }
-    if (wh != NULL) {
-        wh->EndLog();
-        delete wh;
-        wh = NULL;
-    }
-    int ret = 0;
-    if (has_error) {
-        unlink(tmp_file_path.c_str());
-        ret = -1;
-    } else {
-        if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
-            if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
-                // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
-                }
-                uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
-                PDLOG(INFO,
-                      "make snapshot[%s] success. update offset from %lu to %lu."
-                      "use %lu second. write key %lu expired key %lu deleted key "
-                      "%lu",
-                      snapshot_name.c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
-                      deleted_key_num);
-                offset_ = cur_offset;
-                out_offset = cur_offset;
-            } else {
-                PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
-                unlink(full_path.c_str());
-                ret = -1;
+    return 0;
+}
+
+int MemTableSnapshot::CollectDeletedKeyFromDelta(const ::openmldb::api::Manifest& manifest) {
+    for (const auto& delta : manifest.delta()) {
+        std::string full_path = snapshot_path_ + delta.name();
+        FILE* fd = fopen(full_path.c_str(), "rb");
+        if (fd == NULL) {
+            PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+            return -1;
+        }
+        ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(full_path, fd);
+        ::openmldb::log::Reader reader(seq_file, NULL, false, 0, IsCompressed(full_path));
+        std::string buffer;
+        ::openmldb::api::LogEntry entry;
+        bool has_error = false;
+        while (true) {
+            ::openmldb::base::Slice record;
+            ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+            if (status.IsEof()) {
+                break;
             }
-        } else {
-            PDLOG(WARNING, "rename[%s] failed", snapshot_name.c_str());
-            unlink(tmp_file_path.c_str());
-            ret = -1;
+            if (!status.ok() || !entry.ParseFromArray(record.data(), record.size())) {
+                PDLOG(WARNING, "fail to read delta snapshot %s. tid %u pid %u", full_path.c_str(), tid_, pid_);
+                has_error = true;
+                break;
+            }
+            if (!entry.has_method_type() || entry.method_type() != ::openmldb::api::MethodType::kDelete ||
+                entry.dimensions_size() == 0) {
+                continue;
+            }
+            std::string combined_key = entry.dimensions(0).key() + "|" + std::to_string(entry.dimensions(0).idx());
+            uint64_t& offset = deleted_keys_[combined_key];
+            offset = std::max(offset, entry.log_index());
+        }
+        delete seq_file;
+        if (has_error) {
+            return -1;
         }
     }
-    deleted_keys_.clear();
-    making_snapshot_.store(false, std::memory_order_release);
-    return ret;
+    return 0;
 }
 
 int MemTableSnapshot::RemoveDeletedKey(const ::openmldb::api::LogEntry& entry, const std::set<uint32_t>& deleted_index,
@@ -596,11 +899,18 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
             has_error = true;
             break;
         }
+        // the tombstone in delta snapshot
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            deleted_key_num++;
+            continue;
+        }
         // deleted key
         std::string tmp_buf;
+        uint64_t cur_offset = entry.log_index();
         if (entry.dimensions_size() == 0) {
             std::string combined_key = entry.pk() + "|0";
-            if (deleted_keys_.find(combined_key) != deleted_keys_.end()) {
+            auto iter = deleted_keys_.find(combined_key);
+            if (iter != deleted_keys_.end() && cur_offset <= iter->second) {
                 deleted_key_num++;
                 continue;
             }
@@ -609,7 +919,8 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
             for (int pos = 0; pos < entry.dimensions_size(); pos++) {
                 std::string combined_key =
                     entry.dimensions(pos).key() + "|" + std::to_string(entry.dimensions(pos).idx());
-                if (deleted_keys_.find(combined_key) != deleted_keys_.end() ||
+                auto iter = deleted_keys_.find(combined_key);
+                if ((iter != deleted_keys_.end() && cur_offset <= iter->second) ||
                     !table->GetIndex(entry.dimensions(pos).idx())->IsReady()) {
                     deleted_pos_set.insert(pos);
                 }
@@ -780,10 +1091,27 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
     int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
     if (result == 0) {
         DLOG(INFO) << "begin extract index data from snapshot";
-        if (ExtractIndexFromSnapshot(table, manifest, wh, column_key, idx, partition_num, max_idx, index_cols,
+        if (CollectDeletedKeyFromDelta(manifest) < 0 ||
+            ExtractIndexFromSnapshot(table, manifest, wh, column_key, idx, partition_num, max_idx, index_cols,
                                      write_count, expired_key_num, deleted_key_num) < 0) {
             has_error = true;
         }
+        for (int i = 0; !has_error && i < manifest.delta_size(); i++) {
+            ::openmldb::api::Manifest delta_manifest;
+            delta_manifest.set_name(manifest.delta(i).name());
+            delta_manifest.set_count(manifest.delta(i).count());
+            uint64_t delta_write_count = 0;
+            uint64_t delta_expired_key_num = 0;
+            uint64_t delta_deleted_key_num = 0;
+            if (ExtractIndexFromSnapshot(table, delta_manifest, wh, column_key, idx, partition_num, max_idx,
+                                         index_cols, delta_write_count, delta_expired_key_num,
+                                         delta_deleted_key_num) < 0) {
+                has_error = true;
+            }
+            write_count += delta_write_count;
+            expired_key_num += delta_expired_key_num;
+            deleted_key_num += delta_deleted_key_num;
+        }
         last_term = manifest.term();
         DEBUGLOG("old manifest term is %lu", last_term);
     } else if (result < 0) {
@@ -960,6 +1288,9 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
                     DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
                     unlink((snapshot_path_ + manifest.name()).c_str());
                 }
+                for (const auto& delta : manifest.delta()) {
+                    unlink((snapshot_path_ + delta.name()).c_str());
+                }
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
                       "make snapshot[%s] success. update offset from %lu to %lu."
@@ -1074,64 +1405,74 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         return false;
     }
     *snapshot_offset = manifest.offset();
-    std::string path = snapshot_path_ + "/" + manifest.name();
-    uint64_t succ_cnt = 0;
-    uint64_t failed_cnt = 0;
-    FILE* fd = fopen(path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
-        return false;
+    std::vector<std::string> snapshot_names = {manifest.name()};
+    for (const auto& delta : manifest.delta()) {
+        snapshot_names.push_back(delta.name());
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
-    bool compressed = IsCompressed(path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
-    ::openmldb::api::LogEntry entry;
-    std::string buffer;
-    std::string entry_buff;
-    DLOG(INFO) << "begin dump snapshot index data";
-    while (true) {
-        buffer.clear();
-        ::openmldb::base::Slice record;
-        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
-        if (status.IsWaitRecord() || status.IsEof()) {
-            PDLOG(INFO,
-                  "read path %s for table tid %u pid %u completed, succ_cnt "
-                  "%lu, failed_cnt %lu",
-                  path.c_str(), tid_, pid_, succ_cnt, failed_cnt);
-            break;
-        }
-        if (!status.ok()) {
-            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
-                  status.ToString().c_str());
-            failed_cnt++;
-            continue;
-        }
-        entry_buff.assign(record.data(), record.size());
-        if (!entry.ParseFromString(entry_buff)) {
-            PDLOG(WARNING, "fail to parse record for tid %u, pid %u", tid_, pid_);
-            failed_cnt++;
-            continue;
-        }
-        uint32_t index_pid = 0;
-        if (!PackNewIndexEntry(table, index_cols, max_idx, idx, partition_num, &entry, &index_pid)) {
-            DLOG(INFO) << "pack new entry fail in snapshot";
-            continue;
-        }
-        std::string entry_str;
-        entry.SerializeToString(&entry_str);
-        ::openmldb::base::Slice new_record(entry_str);
-        status = whs[index_pid]->Write(new_record);
-        if (!status.ok()) {
-            delete seq_file;
-            PDLOG(WARNING,
-                  "fail to dump index entrylog in snapshot to pid[%u]. tid "
-                  "%u pid %u",
-                  index_pid, tid_, pid_);
+    for (const auto& name : snapshot_names) {
+        std::string path = snapshot_path_ + "/" + name;
+        uint64_t succ_cnt = 0;
+        uint64_t failed_cnt = 0;
+        FILE* fd = fopen(path.c_str(), "rb");
+        if (fd == NULL) {
+            PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
             return false;
         }
-        succ_cnt++;
+        ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
+        bool compressed = IsCompressed(path);
+        ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+        ::openmldb::api::LogEntry entry;
+        std::string buffer;
+        std::string entry_buff;
+        DLOG(INFO) << "begin dump snapshot index data";
+        while (true) {
+            buffer.clear();
+            ::openmldb::base::Slice record;
+            ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+            if (status.IsWaitRecord() || status.IsEof()) {
+                PDLOG(INFO,
+                      "read path %s for table tid %u pid %u completed, succ_cnt "
+                      "%lu, failed_cnt %lu",
+                      path.c_str(), tid_, pid_, succ_cnt, failed_cnt);
+                break;
+            }
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                      status.ToString().c_str());
+                failed_cnt++;
+                continue;
+            }
+            entry_buff.assign(record.data(), record.size());
+            if (!entry.ParseFromString(entry_buff)) {
+                PDLOG(WARNING, "fail to parse record for tid %u, pid %u", tid_, pid_);
+                failed_cnt++;
+                continue;
+            }
+            // skip the tombstone in delta snapshot
+            if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+                continue;
+            }
+            uint32_t index_pid = 0;
+            if (!PackNewIndexEntry(table, index_cols, max_idx, idx, partition_num, &entry, &index_pid)) {
+                DLOG(INFO) << "pack new entry fail in snapshot";
+                continue;
+            }
+            std::string entry_str;
+            entry.SerializeToString(&entry_str);
+            ::openmldb::base::Slice new_record(entry_str);
+            status = whs[index_pid]->Write(new_record);
+            if (!status.ok()) {
+                delete seq_file;
+                PDLOG(WARNING,
+                      "fail to dump index entrylog in snapshot to pid[%u]. tid "
+                      "%u pid %u",
+                      index_pid, tid_, pid_);
+                return false;
+            }
+            succ_cnt++;
+        }
+        delete seq_file;
     }
-    delete seq_file;
     return true;
 }
 
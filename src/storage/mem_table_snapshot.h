@@ -54,6 +54,9 @@ class MemTableSnapshot : public Snapshot {
 
     void RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table);
 
+    // replay the puts and deletes of a delta snapshot in order
+    bool RecoverFromDelta(const ::openmldb::api::SnapshotDelta& delta, std::shared_ptr<Table> table);
+
     int MakeSnapshot(std::shared_ptr<Table> table,
                      uint64_t& out_offset,  // NOLINT
                      uint64_t end_offset) override;
@@ -100,8 +103,29 @@ class MemTableSnapshot : public Snapshot {
     void RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table, std::atomic<uint64_t>* g_succ_cnt,
                                std::atomic<uint64_t>* g_failed_cnt);
 
+    // load the records start in [start, end) of an uncompressed snapshot. start must be block aligned
+    void RecoverSnapshotRange(const std::string& path, uint64_t start, uint64_t end, std::shared_ptr<Table> table,
+                              std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
+
     uint64_t CollectDeletedKey(uint64_t end_offset);
 
+    // add the delete records kept in the delta snapshots to deleted_keys_
+    int CollectDeletedKeyFromDelta(const ::openmldb::api::Manifest& manifest);
+
+    // write the binlog records after offset_ to the snapshot. the delete records are kept
+    // in delta snapshot and the expired records are left to be removed by gc after loading
+    int DumpBinlog(std::shared_ptr<Table> table, uint64_t end_offset, bool is_delta, WriteHandle* wh,
+                   uint64_t* cur_offset, uint64_t* last_term, uint64_t* write_count, uint64_t* expired_key_num,
+                   uint64_t* deleted_key_num);
+
+    // rewrite the base snapshot, the delta snapshots and the binlog to a new base snapshot
+    int MakeFullSnapshot(std::shared_ptr<Table> table, int manifest_result, const ::openmldb::api::Manifest& manifest,
+                         uint64_t& out_offset, uint64_t end_offset);  // NOLINT
+
+    // append the binlog after the last snapshot in the chain to a new delta snapshot
+    int MakeDeltaSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
+                          uint64_t& out_offset, uint64_t end_offset);  // NOLINT
+
     int DecodeData(std::shared_ptr<Table> table, const openmldb::api::LogEntry& entry, uint32_t maxIdx,
                    std::vector<std::string>& row);  // NOLINT
 
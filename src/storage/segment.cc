@@ -18,6 +18,10 @@
 
 #include <gflags/gflags.h>
 
+#include <algorithm>
+#include <shared_mutex>  // NOLINT
+#include <utility>
+
 #include "base/glog_wapper.h"
 #include "base/strings.h"
 #include "common/timer.h"
@@ -30,16 +34,37 @@ DECLARE_uint32(gc_deleted_pk_version_delta);
 namespace openmldb {
 namespace storage {
 
+// the tail with less rows is left in time list
+static const uint32_t COMPACT_MIN_ROW_CNT = 8;
+
 static const SliceComparator scmp;
 Segment::Segment()
     : entries_(NULL),
+      key_index_(NULL),
       mu_(),
       idx_cnt_(0),
       idx_byte_size_(0),
       pk_cnt_(0),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      arena_(NULL),
+      compact_byte_size_(0),
+      compact_raw_byte_size_(0),
+      latest_enabled_(false),
+      latest_cnt_(0),
+      latest_evict_(true),
+      latest_overflow_(false),
+      latest_mixed_(false),
+      evicted_record_cnt_(0),
+      evicted_record_byte_size_(0),
+      gc_cursor_(),
+      gc_slice_started_(false),
+      gc_slice_key_num_(0),
+      gc_slice_free_num_(0),
+      gc_slice_deadline_(0),
+      gc_slice_scanned_(0),
+      gc_slice_idx_cnt_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     key_entry_max_height_ = (uint8_t)FLAGS_skiplist_max_height;
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
@@ -47,6 +72,7 @@ Segment::Segment()
 
 Segment::Segment(uint8_t height)
     : entries_(NULL),
+      key_index_(NULL),
       mu_(),
       idx_cnt_(0),
       idx_byte_size_(0),
@@ -54,13 +80,31 @@ Segment::Segment(uint8_t height)
       key_entry_max_height_(height),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      arena_(NULL),
+      compact_byte_size_(0),
+      compact_raw_byte_size_(0),
+      latest_enabled_(false),
+      latest_cnt_(0),
+      latest_evict_(true),
+      latest_overflow_(false),
+      latest_mixed_(false),
+      evicted_record_cnt_(0),
+      evicted_record_byte_size_(0),
+      gc_cursor_(),
+      gc_slice_started_(false),
+      gc_slice_key_num_(0),
+      gc_slice_free_num_(0),
+      gc_slice_deadline_(0),
+      gc_slice_scanned_(0),
+      gc_slice_idx_cnt_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
 }
 
 Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
     : entries_(NULL),
+      key_index_(NULL),
       mu_(),
       idx_cnt_(0),
       idx_byte_size_(0),
@@ -68,7 +112,24 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
       key_entry_max_height_(height),
       ts_cnt_(ts_idx_vec.size()),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      arena_(NULL),
+      compact_byte_size_(0),
+      compact_raw_byte_size_(0),
+      latest_enabled_(false),
+      latest_cnt_(0),
+      latest_evict_(true),
+      latest_overflow_(false),
+      latest_mixed_(false),
+      evicted_record_cnt_(0),
+      evicted_record_byte_size_(0),
+      gc_cursor_(),
+      gc_slice_started_(false),
+      gc_slice_key_num_(0),
+      gc_slice_free_num_(0),
+      gc_slice_deadline_(0),
+      gc_slice_scanned_(0),
+      gc_slice_idx_cnt_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
     for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
@@ -79,7 +140,96 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
 
 Segment::~Segment() {
     delete entries_;
+    delete key_index_;
+    for (const auto& kv : key_index_free_list_) {
+        delete kv.second;
+    }
     delete entry_free_list_;
+    // slabs still referenced by living blocks are freed with the last block
+    delete arena_;
+}
+
+void Segment::EnableArena(uint32_t slab_size, int numa_node) {
+    if (arena_ == NULL) {
+        arena_ = new ::openmldb::base::SlabArena(slab_size, numa_node);
+    }
+}
+
+void Segment::EnableKeyIndex(uint32_t capacity) {
+    if (key_index_ == NULL) {
+        key_index_ = new KeyIndex(capacity);
+    }
+}
+
+bool Segment::FindKeyEntry(const Slice& key, void*& entry) {
+    if (key_index_ != NULL) {
+        KeyIndex::KeyNode* node = key_index_->Get(key);
+        entry = node == NULL ? NULL : node->GetValue();
+    } else if (entries_->Get(key, entry) < 0) {
+        entry = NULL;
+    }
+    return entry != NULL;
+}
+
+uint8_t Segment::InsertKeyEntry(const Slice& key, void* entry) {
+    if (key_index_ == NULL) {
+        return entries_->Insert(key, entry, arena_);
+    }
+    KeyIndex::KeyNode* node = NULL;
+    uint8_t height = entries_->Insert(key, entry, arena_, &node);
+    KeyIndex::Table* table = key_index_->Insert(node);
+    if (table != NULL) {
+        // the readers may still probe the old table
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        key_index_free_list_.emplace_back(gc_version_.load(std::memory_order_relaxed), table);
+    }
+    return height;
+}
+
+::openmldb::base::Node<Slice, void*>* Segment::RemoveKeyEntry(const Slice& key) {
+    ::openmldb::base::Node<Slice, void*>* node = entries_->Remove(key);
+    if (node != NULL && key_index_ != NULL) {
+        key_index_->Remove(node->GetKey());
+    }
+    return node;
+}
+
+void Segment::FreeKeyIndexTable(uint64_t version) {
+    std::lock_guard<std::mutex> lock(gc_mu_);
+    auto it = key_index_free_list_.begin();
+    while (it != key_index_free_list_.end() && it->first < version) {
+        delete it->second;
+        it++;
+    }
+    key_index_free_list_.erase(key_index_free_list_.begin(), it);
+}
+
+void Segment::EnableLatest(uint32_t cnt) {
+    if (ts_cnt_ > 1 || cnt == 0) {
+        return;
+    }
+    latest_enabled_ = true;
+    latest_cnt_.store(cnt, std::memory_order_relaxed);
+}
+
+void Segment::SetLatestCnt(uint32_t cnt) {
+    if (!latest_enabled_) {
+        return;
+    }
+    uint32_t old_cnt = latest_cnt_.exchange(cnt, std::memory_order_relaxed);
+    if (old_cnt == cnt) {
+        return;
+    }
+    if (cnt == 0) {
+        latest_mixed_.store(true, std::memory_order_relaxed);
+    } else if (cnt < old_cnt) {
+        latest_overflow_.store(true, std::memory_order_relaxed);
+    }
+}
+
+void Segment::TakeEvictedRecord(uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    gc_record_cnt += evicted_record_cnt_.exchange(0, std::memory_order_relaxed);
+    gc_record_byte_size += evicted_record_byte_size_.exchange(0, std::memory_order_relaxed);
 }
 
 uint64_t Segment::Release() {
@@ -105,6 +255,10 @@ uint64_t Segment::Release() {
         it->Next();
     }
     entries_->Clear();
+    if (key_index_ != NULL) {
+        key_index_->Clear();
+    }
+    FreeKeyIndexTable(UINT64_MAX);
     delete it;
 
     KeyEntryNodeList::Iterator* f_it = entry_free_list_->NewIterator();
@@ -124,7 +278,7 @@ uint64_t Segment::Release() {
             entry->Release();
             delete entry;
         }
-        delete node;
+        ::openmldb::base::Node<Slice, void*>::Delete(node);
         f_it->Next();
     }
     delete f_it;
@@ -140,8 +294,8 @@ void Segment::ReleaseAndCount(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uin
         Slice key = it->GetKey();
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
-            entry_node = entries_->Remove(key);
+            std::lock_guard<std::shared_mutex> lock(mu_);
+            entry_node = RemoveKeyEntry(key);
         }
         if (entry_node != NULL) {
             FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
@@ -159,7 +313,7 @@ void Segment::Put(const Slice& key, uint64_t time, const char* data, uint32_t si
     if (ts_cnt_ > 1) {
         return;
     }
-    auto* db = new DataBlock(1, data, size);
+    auto* db = DataBlock::New(arena_, 1, data, size);
     Put(key, time, db);
 }
 
@@ -167,41 +321,180 @@ void Segment::Put(const Slice& key, uint64_t time, DataBlock* row) {
     if (ts_cnt_ > 1) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mu_);
+    {
+        std::shared_lock<std::shared_mutex> lock(mu_);
+        void* entry = NULL;
+        if (FindKeyEntry(key, entry)) {
+            idx_cnt_.fetch_add(1, std::memory_order_relaxed);
+            idx_byte_size_.fetch_add(PutEntry(reinterpret_cast<KeyEntry*>(entry), time, row),
+                                     std::memory_order_relaxed);
+            return;
+        }
+    }
+    std::lock_guard<std::shared_mutex> lock(mu_);
     PutUnlock(key, time, row);
 }
 
 void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
     void* entry = nullptr;
     uint32_t byte_size = 0;
-    int ret = entries_->Get(key, entry);
-    if (ret < 0 || entry == NULL) {
+    if (!FindKeyEntry(key, entry)) {
         char* pk = new char[key.size()];
         memcpy(pk, key.data(), key.size());
         // need to delete memory when free node
         Slice skey(pk, key.size());
-        entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
-        uint8_t height = entries_->Insert(skey, entry);
+        uint32_t latest_cnt = latest_cnt_.load(std::memory_order_relaxed);
+        if (latest_cnt > 0) {
+            KeyEntry* key_entry = new KeyEntry(1);
+            key_entry->latest_.store(LatestList::New(latest_cnt), std::memory_order_relaxed);
+            byte_size += LatestList::ByteSize(latest_cnt);
+            entry = (void*)key_entry;  // NOLINT
+        } else {
+            entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
+        }
+        uint8_t height = InsertKeyEntry(skey, entry);
         byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
         pk_cnt_.fetch_add(1, std::memory_order_relaxed);
     }
     idx_cnt_.fetch_add(1, std::memory_order_relaxed);
-    uint8_t height = ((KeyEntry*)entry)->entries.Insert(time, row);  // NOLINT
-    ((KeyEntry*)entry)                                               // NOLINT
-        ->count_.fetch_add(1, std::memory_order_relaxed);
-    byte_size += GetRecordTsIdxSize(height);
+    byte_size += PutEntry(reinterpret_cast<KeyEntry*>(entry), time, row);
     idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
 }
 
+uint32_t Segment::PutEntry(KeyEntry* entry, uint64_t time, DataBlock* row) {
+    uint8_t height = 0;
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+        if (entry->latest_.load(std::memory_order_relaxed) != NULL) {
+            uint32_t cnt = latest_cnt_.load(std::memory_order_relaxed);
+            if (cnt > 0) {
+                PutLatest(entry, cnt, time, row);
+                return 0;
+            }
+            MoveLatestToList(entry);
+        }
+        height = entry->entries.Insert(time, row, arena_);
+    }
+    entry->count_.fetch_add(1, std::memory_order_relaxed);
+    return GetRecordTsIdxSize(height);
+}
+
+void Segment::PutLatest(KeyEntry* entry, uint32_t cnt, uint64_t time, DataBlock* row) {
+    entry->count_.fetch_add(1, std::memory_order_relaxed);
+    LatestList* list = entry->latest_.load(std::memory_order_relaxed);
+    // the rows copied by readers must not be released
+    bool evict = latest_evict_.load(std::memory_order_relaxed) && entry->refs_.load(std::memory_order_acquire) <= 0;
+    uint32_t pos = list->FindPos(time);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    if (evict && pos >= cnt) {
+        // the row is older than all the rows kept
+        gc_idx_cnt++;
+        if (row->Unref()) {
+            gc_record_byte_size += GetRecordSize(row->size);
+            DataBlock::Delete(row);
+            gc_record_cnt++;
+        }
+    } else {
+        if (evict) {
+            TrimLatest(entry, cnt - 1, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            if (list->Capacity() != cnt) {
+                ResizeLatest(entry, cnt);
+            }
+        } else if (list->IsFull()) {
+            ResizeLatest(entry, std::max(list->Capacity() * 2, cnt));
+        }
+        list = GetMutableLatest(entry);
+        list->Insert(std::min(pos, list->Size()), time, row);
+        if (list->Size() > cnt) {
+            latest_overflow_.store(true, std::memory_order_relaxed);
+        }
+    }
+    if (gc_idx_cnt > 0) {
+        entry->count_.fetch_sub(gc_idx_cnt, std::memory_order_relaxed);
+        idx_cnt_.fetch_sub(gc_idx_cnt, std::memory_order_relaxed);
+        evicted_record_cnt_.fetch_add(gc_record_cnt, std::memory_order_relaxed);
+        evicted_record_byte_size_.fetch_add(gc_record_byte_size, std::memory_order_relaxed);
+    }
+}
+
+void Segment::TrimLatest(KeyEntry* entry, uint32_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                         uint64_t& gc_record_byte_size) {
+    LatestList* list = entry->latest_.load(std::memory_order_relaxed);
+    if (list->Size() <= keep_cnt) {
+        return;
+    }
+    list = GetMutableLatest(entry);
+    while (list->Size() > keep_cnt) {
+        DataBlock* block = list->PopBack().block;
+        gc_idx_cnt++;
+        if (block->Unref()) {
+            gc_record_byte_size += GetRecordSize(block->size);
+            DataBlock::Delete(block);
+            gc_record_cnt++;
+        }
+    }
+}
+
+void Segment::ResizeLatest(KeyEntry* entry, uint32_t capacity) {
+    LatestList* list = entry->latest_.load(std::memory_order_relaxed);
+    LatestList* new_list = list->Resize(capacity);
+    entry->latest_.store(new_list, std::memory_order_release);
+    idx_byte_size_.fetch_add(LatestList::ByteSize(new_list->Capacity()), std::memory_order_relaxed);
+    idx_byte_size_.fetch_sub(LatestList::ByteSize(list->Capacity()), std::memory_order_relaxed);
+    LatestList::UnRef(list);
+}
+
+LatestList* Segment::GetMutableLatest(KeyEntry* entry) {
+    LatestList* list = entry->latest_.load(std::memory_order_relaxed);
+    if (!list->IsShared()) {
+        return list;
+    }
+    // the iterators keep reading the old list until they are deleted
+    LatestList* new_list = list->Resize(list->Capacity());
+    entry->latest_.store(new_list, std::memory_order_release);
+    LatestList::UnRef(list);
+    return new_list;
+}
+
+void Segment::MoveLatestToList(KeyEntry* entry) {
+    LatestList* list = entry->latest_.load(std::memory_order_relaxed);
+    uint64_t byte_size = 0;
+    // insert from the oldest row, so the rows with the same ts keep their order
+    for (uint32_t i = list->Size(); i > 0; i--) {
+        LatestRow row = list->Get(i - 1);
+        byte_size += GetRecordTsIdxSize(entry->entries.Insert(row.ts, row.block, arena_));
+    }
+    entry->latest_.store(NULL, std::memory_order_release);
+    idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+    idx_byte_size_.fetch_sub(LatestList::ByteSize(list->Capacity()), std::memory_order_relaxed);
+    LatestList::UnRef(list);
+}
+
+bool Segment::PrepareGcEntry(KeyEntry* entry) {
+    if (entry->latest_.load(std::memory_order_acquire) == NULL) {
+        return true;
+    }
+    if (latest_cnt_.load(std::memory_order_relaxed) > 0) {
+        return false;
+    }
+    std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+    if (entry->latest_.load(std::memory_order_relaxed) != NULL) {
+        MoveLatestToList(entry);
+    }
+    return true;
+}
+
 void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row) {
     void* key_entry_or_list = nullptr;
     uint32_t byte_size = 0;
-    std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
-    int ret = entries_->Get(key, key_entry_or_list);
+    std::lock_guard<std::shared_mutex> lock(mu_);  // TODO(hw): need lock?
+    bool found = FindKeyEntry(key, key_entry_or_list);
     if (ts_cnt_ == 1) {
         PutUnlock(key, time, row);
     } else {
-        if (ret < 0 || key_entry_or_list == nullptr) {
+        if (!found) {
             char* pk = new char[key.size()];
             memcpy(pk, key.data(), key.size());
             Slice skey(pk, key.size());
@@ -210,12 +503,12 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
                 entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
             }
             auto entry_arr = (void*)entry_arr_tmp;  // NOLINT
-            uint8_t height = entries_->Insert(skey, entry_arr);
+            uint8_t height = InsertKeyEntry(skey, entry_arr);
             byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
             pk_cnt_.fetch_add(1, std::memory_order_relaxed);
         }
         uint8_t height = ((KeyEntry**)key_entry_or_list)[key_entry_id]->entries.Insert(  // NOLINT
-            time, row);
+            time, row, arena_);
         ((KeyEntry**)key_entry_or_list)[key_entry_id]->count_.fetch_add(  // NOLINT
             1, std::memory_order_relaxed);
         byte_size += GetRecordTsIdxSize(height);
@@ -244,7 +537,23 @@ void Segment::Put(const Slice& key, const TSDimensions& ts_dimension, DataBlock*
         return;
     }
     void* entry_arr = NULL;
-    std::lock_guard<std::mutex> lock(mu_);
+    {
+        std::shared_lock<std::shared_mutex> lock(mu_);
+        if (FindKeyEntry(key, entry_arr)) {
+            for (const auto& cur_ts : ts_dimension) {
+                auto pos = ts_idx_map_.find(cur_ts.idx());
+                if (pos == ts_idx_map_.end()) {
+                    continue;
+                }
+                KeyEntry* entry = reinterpret_cast<KeyEntry**>(entry_arr)[pos->second];
+                idx_byte_size_.fetch_add(PutEntry(entry, cur_ts.ts(), row), std::memory_order_relaxed);
+                idx_cnt_vec_[pos->second]->fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+    }
+    entry_arr = NULL;
+    std::lock_guard<std::shared_mutex> lock(mu_);
     for (const auto& cur_ts : ts_dimension) {
         uint32_t byte_size = 0;
         auto pos = ts_idx_map_.find(cur_ts.idx());
@@ -252,8 +561,7 @@ void Segment::Put(const Slice& key, const TSDimensions& ts_dimension, DataBlock*
             continue;
         }
         if (entry_arr == NULL) {
-            int ret = entries_->Get(key, entry_arr);
-            if (ret < 0 || entry_arr == NULL) {
+            if (!FindKeyEntry(key, entry_arr)) {
                 char* pk = new char[key.size()];
                 memcpy(pk, key.data(), key.size());
                 Slice skey(pk, key.size());
@@ -262,16 +570,12 @@ void Segment::Put(const Slice& key, const TSDimensions& ts_dimension, DataBlock*
                     entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
                 }
                 entry_arr = (void*)entry_arr_tmp;  // NOLINT
-                uint8_t height = entries_->Insert(skey, entry_arr);
+                uint8_t height = InsertKeyEntry(skey, entry_arr);
                 byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
                 pk_cnt_.fetch_add(1, std::memory_order_relaxed);
             }
         }
-        uint8_t height = ((KeyEntry**)entry_arr)[pos->second]->entries.Insert(  // NOLINT
-            cur_ts.ts(), row);
-        ((KeyEntry**)entry_arr)[pos->second]->count_.fetch_add(  // NOLINT
-            1, std::memory_order_relaxed);
-        byte_size += GetRecordTsIdxSize(height);
+        byte_size += PutEntry(reinterpret_cast<KeyEntry**>(entry_arr)[pos->second], cur_ts.ts(), row);
         idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
         idx_cnt_vec_[pos->second]->fetch_add(1, std::memory_order_relaxed);
     }
@@ -282,10 +586,20 @@ bool Segment::Get(const Slice& key, const uint64_t time, DataBlock** block) {
         return false;
     }
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!FindKeyEntry(key, entry)) {
         return false;
     }
-    *block = ((KeyEntry*)entry)->entries.Get(time);  // NOLINT
+    KeyEntry* key_entry = reinterpret_cast<KeyEntry*>(entry);
+    if (key_entry->latest_.load(std::memory_order_acquire) != NULL) {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(key_entry->mu_);
+        LatestList* list = key_entry->latest_.load(std::memory_order_relaxed);
+        if (list != NULL) {
+            uint32_t pos = list->FindPos(time);
+            *block = pos < list->Size() && list->Get(pos).ts == time ? list->Get(pos).block : NULL;
+            return true;
+        }
+    }
+    *block = key_entry->entries.Get(time);
     return true;
 }
 
@@ -301,7 +615,7 @@ bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock
         return Get(key, time, block);
     }
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!FindKeyEntry(key, entry)) {
         return false;
     }
     *block = ((KeyEntry**)entry)[pos->second]->entries.Get(time);  // NOLINT
@@ -311,8 +625,8 @@ bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock
 bool Segment::Delete(const Slice& key) {
     ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
     {
-        std::lock_guard<std::mutex> lock(mu_);
-        entry_node = entries_->Remove(key);
+        std::lock_guard<std::shared_mutex> lock(mu_);
+        entry_node = RemoveKeyEntry(key);
         if (entry_node == NULL) {
             return false;
         }
@@ -327,19 +641,31 @@ bool Segment::Delete(const Slice& key) {
 void Segment::FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,
                        uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
     while (node != NULL) {
-        gc_idx_cnt++;
         ::openmldb::base::Node<uint64_t, DataBlock*>* tmp = node;
         idx_byte_size_.fetch_sub(GetRecordTsIdxSize(tmp->Height()));
         node = node->GetNextNoBarrier(0);
+        gc_idx_cnt++;
         DEBUGLOG("delete key %lu with height %u", tmp->GetKey(), tmp->Height());
-        if (tmp->GetValue()->dim_cnt_down > 1) {
-            tmp->GetValue()->dim_cnt_down--;
-        } else {
+        if (tmp->GetValue()->Unref()) {
             DEBUGLOG("delele data block for key %lu", tmp->GetKey());
             gc_record_byte_size += GetRecordSize(tmp->GetValue()->size);
-            delete tmp->GetValue();
+            DataBlock::Delete(tmp->GetValue());
             gc_record_cnt++;
         }
+        ::openmldb::base::Node<uint64_t, DataBlock*>::Delete(tmp);
+    }
+}
+
+void Segment::FreeCompactList(CompactBlock* block, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                              uint64_t& gc_record_byte_size) {
+    while (block != NULL) {
+        gc_idx_cnt += block->cnt;
+        gc_record_cnt += block->record_cnt;
+        gc_record_byte_size += block->record_byte_size;
+        compact_byte_size_.fetch_sub(block->GetByteSize(), std::memory_order_relaxed);
+        compact_raw_byte_size_.fetch_sub(block->raw_byte_size, std::memory_order_relaxed);
+        CompactBlock* tmp = block;
+        block = block->next;
         delete tmp;
     }
 }
@@ -374,6 +700,14 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
     } else {
         uint64_t old = gc_idx_cnt;
         KeyEntry* entry = (KeyEntry*)entry_node->GetValue();  // NOLINT
+        LatestList* list = entry->latest_.load(std::memory_order_acquire);
+        if (list != NULL) {
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+            TrimLatest(entry, 0, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            list = entry->latest_.exchange(NULL, std::memory_order_relaxed);
+            idx_byte_size_.fetch_sub(LatestList::ByteSize(list->Capacity()), std::memory_order_relaxed);
+            LatestList::UnRef(list);
+        }
         TimeEntries::Iterator* it = entry->entries.NewIterator();
         it->SeekToFirst();
         if (it->Valid()) {
@@ -382,6 +716,8 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
             FreeList(data_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         }
         delete it;
+        FreeCompactList(entry->compact_.exchange(NULL, std::memory_order_relaxed), gc_idx_cnt, gc_record_cnt,
+                        gc_record_byte_size);
         delete entry;
         uint64_t byte_size =
             GetRecordPkIdxSize(entry_node->Height(), entry_node->GetKey().size(), key_entry_max_height_);
@@ -397,10 +733,11 @@ void Segment::GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t&
         std::lock_guard<std::mutex> lock(gc_mu_);
         node = entry_free_list_->Split(version);
     }
+    FreeKeyIndexTable(version);
     while (node != NULL) {
         ::openmldb::base::Node<Slice, void*>* entry_node = node->GetValue();
         FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-        delete entry_node;
+        ::openmldb::base::Node<Slice, void*>::Delete(entry_node);
         ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<Slice, void*>*>* tmp = node;
         node = node->GetNextNoBarrier(0);
         delete tmp;
@@ -417,6 +754,68 @@ void Segment::GcFreeList(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t
     GcEntryFreeList(free_list_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
 }
 
+bool Segment::ExecuteGcSlice(const std::map<uint32_t, TTLSt>& ttl_st_map, uint32_t max_key_num,
+                             uint32_t max_free_num, uint64_t deadline, uint64_t& gc_idx_cnt,
+                             uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    if (gc_cursor_.empty()) {
+        // a new round of gc on this segment
+        IncrGcVersion();
+        GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    }
+    gc_slice_started_ = false;
+    gc_slice_key_num_ = std::max(max_key_num, 1u);
+    gc_slice_free_num_ = max_free_num;
+    gc_slice_deadline_ = deadline;
+    gc_slice_scanned_ = 0;
+    gc_slice_idx_cnt_ = gc_idx_cnt;
+    ExecuteGc(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    if (!gc_slice_started_) {
+        // no key need gc with current ttl
+        gc_cursor_.clear();
+    }
+    gc_slice_key_num_ = 0;
+    return gc_cursor_.empty();
+}
+
+KeyEntries::Iterator* Segment::NewGcIterator() {
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    gc_slice_started_ = true;
+    if (gc_slice_key_num_ > 0 && !gc_cursor_.empty()) {
+        it->Seek(Slice(gc_cursor_));
+    } else {
+        it->SeekToFirst();
+    }
+    return it;
+}
+
+bool Segment::NextGcKey(uint64_t gc_idx_cnt) {
+    if (gc_slice_key_num_ == 0) {
+        return true;
+    }
+    if (gc_slice_scanned_ >= gc_slice_key_num_ ||
+        (gc_slice_free_num_ > 0 && gc_idx_cnt - gc_slice_idx_cnt_ >= gc_slice_free_num_)) {
+        return false;
+    }
+    // checking time of every key is too expensive
+    if (gc_slice_deadline_ > 0 && gc_slice_scanned_ % 64 == 63 &&
+        ::baidu::common::timer::get_micros() >= gc_slice_deadline_) {
+        return false;
+    }
+    gc_slice_scanned_++;
+    return true;
+}
+
+void Segment::UpdateGcCursor(KeyEntries::Iterator* it) {
+    if (gc_slice_key_num_ == 0) {
+        return;
+    }
+    if (it->Valid()) {
+        gc_cursor_.assign(it->GetKey().data(), it->GetKey().size());
+    } else {
+        gc_cursor_.clear();
+    }
+}
+
 void Segment::ExecuteGc(const TTLSt& ttl_st, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                         uint64_t& gc_record_byte_size) {
     uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
@@ -433,6 +832,12 @@ void Segment::ExecuteGc(const TTLSt& ttl_st, uint64_t& gc_idx_cnt, uint64_t& gc_
             if (ttl_st.lat_ttl == 0) {
                 return;
             }
+            // the rows of latest lists are evicted by put, so only scan the keys at the start of
+            // a round if some lists are not trimmed or some keys are in time lists
+            if (latest_cnt_.load(std::memory_order_relaxed) > 0 && !latest_mixed_.load(std::memory_order_relaxed) &&
+                gc_cursor_.empty() && !latest_overflow_.exchange(false, std::memory_order_relaxed)) {
+                return;
+            }
             Gc4Head(ttl_st.lat_ttl, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             break;
         }
@@ -488,13 +893,26 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
     }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
-    KeyEntries::Iterator* it = entries_->NewIterator();
-    it->SeekToFirst();
-    while (it->Valid()) {
+    KeyEntries::Iterator* it = NewGcIterator();
+    while (it->Valid() && NextGcKey(gc_idx_cnt)) {
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
+        if (!PrepareGcEntry(entry)) {
+            uint64_t entry_gc_idx_cnt = 0;
+            {
+                std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+                if (entry->latest_.load(std::memory_order_relaxed) != NULL &&
+                    entry->refs_.load(std::memory_order_acquire) <= 0) {
+                    TrimLatest(entry, keep_cnt, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+                }
+            }
+            entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
+            gc_idx_cnt += entry_gc_idx_cnt;
+            it->Next();
+            continue;
+        }
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<std::shared_mutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByPos(keep_cnt);
             }
@@ -508,6 +926,7 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
     DEBUGLOG("[Gc4Head] segment gc keep cnt %lu consumed %lu, count %lu", keep_cnt,
              (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
     idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+    UpdateGcCursor(it);
     delete it;
 }
 
@@ -515,9 +934,8 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         uint64_t& gc_record_byte_size) {
     uint64_t old = gc_idx_cnt;
     uint64_t consumed = ::baidu::common::timer::get_micros();
-    KeyEntries::Iterator* it = entries_->NewIterator();
-    it->SeekToFirst();
-    while (it->Valid()) {
+    KeyEntries::Iterator* it = NewGcIterator();
+    while (it->Valid() && NextGcKey(gc_idx_cnt)) {
         KeyEntry** entry_arr = (KeyEntry**)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
@@ -532,6 +950,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             }
             KeyEntry* entry = entry_arr[pos->second];
             ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+            CompactBlock* expired = NULL;
             bool continue_flag = false;
             switch (kv.second.ttl_type) {
                 case ::openmldb::storage::TTLType::kAbsoluteTime: {
@@ -540,8 +959,8 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
-                        SplitList(entry, kv.second.abs_ttl, &node);
+                        std::lock_guard<std::shared_mutex> lock(mu_);
+                        SplitList(entry, kv.second.abs_ttl, &node, &expired);
                         if (entry->entries.IsEmpty()) {
                             empty_cnt++;
                         }
@@ -549,7 +968,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     break;
                 }
                 case ::openmldb::storage::TTLType::kLatestTime: {
-                    std::lock_guard<std::mutex> lock(mu_);
+                    std::lock_guard<std::shared_mutex> lock(mu_);
                     if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                         node = entry->entries.SplitByPos(kv.second.lat_ttl);
                     }
@@ -561,7 +980,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<std::shared_mutex> lock(mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             node = entry->entries.SplitByKeyAndPos(kv.second.abs_ttl, kv.second.lat_ttl);
                         }
@@ -574,7 +993,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<std::shared_mutex> lock(mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             if (kv.second.abs_ttl == 0) {
                                 node = entry->entries.SplitByPos(kv.second.lat_ttl);
@@ -598,6 +1017,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             }
             uint64_t entry_gc_idx_cnt = 0;
             FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            FreeCompactList(expired, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
             idx_cnt_vec_[pos->second]->fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
             gc_idx_cnt += entry_gc_idx_cnt;
@@ -606,7 +1026,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             bool is_empty = true;
             ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
             {
-                std::lock_guard<std::mutex> lock(mu_);
+                std::lock_guard<std::shared_mutex> lock(mu_);
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
                     if (!entry_arr[i]->entries.IsEmpty()) {
                         is_empty = false;
@@ -614,7 +1034,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     }
                 }
                 if (is_empty) {
-                    entry_node = entries_->Remove(key);
+                    entry_node = RemoveKeyEntry(key);
                 }
             }
             if (entry_node != NULL) {
@@ -625,29 +1045,198 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
     }
     DEBUGLOG("[GcAll] segment gc consumed %lu, count %lu", (::baidu::common::timer::get_micros() - consumed) / 1000,
              gc_idx_cnt - old);
+    UpdateGcCursor(it);
     delete it;
 }
 
-void Segment::SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node) {
+void Segment::SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node,
+                        CompactBlock** expired) {
     // skip entry that ocupied by reader
     if (entry->refs_.load(std::memory_order_acquire) <= 0) {
         *node = entry->entries.Split(ts);
+        // keep the blocks which still have unexpired rows
+        CompactBlock* head = entry->compact_.load(std::memory_order_relaxed);
+        CompactBlock* pre = NULL;
+        CompactBlock* cur = head;
+        while (cur != NULL && cur->max_ts > ts) {
+            pre = cur;
+            cur = cur->next;
+        }
+        if (pre != NULL) {
+            pre->next = NULL;
+        } else {
+            entry->compact_.store(NULL, std::memory_order_release);
+        }
+        *expired = cur;
     }
 }
 
+bool Segment::IsCompactEntryExpired(KeyEntry* entry, uint64_t time) {
+    const CompactBlock* block = entry->GetCompactBlock();
+    if (block == NULL) {
+        return true;
+    }
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
+    if (node != NULL && node->GetKey() <= time) {
+        return true;
+    }
+    while (block->next != NULL) {
+        block = block->next;
+    }
+    return block->max_ts <= time;
+}
+
+// merge the hot rows with the compact blocks overlapped with them into one block.
+// rest is set to the first block which is not merged
+static CompactBlock* MergeCompactBlock(const std::vector<std::pair<uint64_t, DataBlock*>>& hot_rows,
+                                       CompactBlock* head, CompactBlock** rest) {
+    std::vector<std::pair<uint64_t, Slice>> rows;
+    rows.reserve(hot_rows.size());
+    for (const auto& kv : hot_rows) {
+        rows.emplace_back(kv.first, Slice(kv.second->data, kv.second->size));
+    }
+    uint64_t min_ts = hot_rows.back().first;
+    std::vector<std::unique_ptr<CompactBlockReader>> readers;
+    CompactBlock* cur = head;
+    uint64_t raw_byte_size = 0;
+    uint64_t record_cnt = 0;
+    uint64_t record_byte_size = 0;
+    while (cur != NULL && cur->max_ts >= min_ts) {
+        std::unique_ptr<CompactBlockReader> reader(new CompactBlockReader());
+        if (reader->Reset(cur)) {
+            for (uint32_t i = 0; i < reader->GetCnt(); i++) {
+                rows.emplace_back(reader->GetTs(i), Slice(reader->GetData(i), reader->GetSize(i)));
+            }
+        }
+        raw_byte_size += cur->raw_byte_size;
+        record_cnt += cur->record_cnt;
+        record_byte_size += cur->record_byte_size;
+        readers.push_back(std::move(reader));
+        cur = cur->next;
+    }
+    if (!readers.empty()) {
+        std::stable_sort(rows.begin(), rows.end(),
+                         [](const std::pair<uint64_t, Slice>& a, const std::pair<uint64_t, Slice>& b) {
+                             return a.first > b.first;
+                         });
+    }
+    CompactBlock* block = CompactBlock::Encode(rows);
+    block->raw_byte_size = raw_byte_size;
+    block->record_cnt = record_cnt;
+    block->record_byte_size = record_byte_size;
+    block->next = cur;
+    *rest = cur;
+    return block;
+}
+
+void Segment::Compact(uint64_t time, uint64_t& compact_cnt) {
+    if (ts_cnt_ > 1 || time == 0) {
+        return;
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t old = compact_cnt;
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
+        it->Next();
+        CompactEntry(entry, time, compact_cnt);
+    }
+    delete it;
+    DEBUGLOG("[Compact] segment compact with key %lu, consumed %lu, count %lu", time,
+             (::baidu::common::timer::get_micros() - consumed) / 1000, compact_cnt - old);
+}
+
+void Segment::CompactEntry(KeyEntry* entry, uint64_t time, uint64_t& compact_cnt) {
+    // collect and encode the rows without lock, only the gc thread removes nodes
+    std::vector<std::pair<uint64_t, DataBlock*>> hot_rows;
+    TimeEntries::Iterator* it = entry->entries.NewIterator();
+    it->Seek(time);
+    while (it->Valid()) {
+        hot_rows.emplace_back(it->GetKey(), it->GetValue());
+        it->Next();
+    }
+    delete it;
+    if (hot_rows.size() < COMPACT_MIN_ROW_CNT) {
+        return;
+    }
+    CompactBlock* head = entry->GetCompactBlock();
+    CompactBlock* rest = NULL;
+    CompactBlock* block = MergeCompactBlock(hot_rows, head, &rest);
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+    {
+        std::lock_guard<std::shared_mutex> lock(mu_);
+        if (entry->refs_.load(std::memory_order_acquire) > 0) {
+            delete block;
+            return;
+        }
+        node = entry->entries.Split(time);
+        // rows may be put into the compacted range after they are collected
+        uint32_t pos = 0;
+        bool changed = false;
+        for (auto* cur = node; cur != NULL; cur = cur->GetNextNoBarrier(0), pos++) {
+            if (pos >= hot_rows.size() || hot_rows[pos].second != cur->GetValue()) {
+                changed = true;
+                break;
+            }
+        }
+        if (changed || pos != hot_rows.size()) {
+            hot_rows.clear();
+            for (auto* cur = node; cur != NULL; cur = cur->GetNextNoBarrier(0)) {
+                hot_rows.emplace_back(cur->GetKey(), cur->GetValue());
+            }
+            delete block;
+            block = MergeCompactBlock(hot_rows, head, &rest);
+        }
+        entry->compact_.store(block, std::memory_order_release);
+    }
+    while (head != rest) {
+        compact_byte_size_.fetch_sub(head->GetByteSize(), std::memory_order_relaxed);
+        compact_raw_byte_size_.fetch_sub(head->raw_byte_size, std::memory_order_relaxed);
+        CompactBlock* tmp = head;
+        head = head->next;
+        delete tmp;
+    }
+    while (node != NULL) {
+        ::openmldb::base::Node<uint64_t, DataBlock*>* tmp = node;
+        node = node->GetNextNoBarrier(0);
+        uint32_t idx_byte_size = GetRecordTsIdxSize(tmp->Height());
+        idx_byte_size_.fetch_sub(idx_byte_size, std::memory_order_relaxed);
+        block->raw_byte_size += idx_byte_size;
+        DataBlock* value = tmp->GetValue();
+        if (value->Unref()) {
+            uint32_t record_byte_size = GetRecordSize(value->size);
+            block->raw_byte_size += record_byte_size;
+            block->record_cnt++;
+            block->record_byte_size += record_byte_size;
+            DataBlock::Delete(value);
+        }
+        ::openmldb::base::Node<uint64_t, DataBlock*>::Delete(tmp);
+        compact_cnt++;
+    }
+    compact_byte_size_.fetch_add(block->GetByteSize(), std::memory_order_relaxed);
+    compact_raw_byte_size_.fetch_add(block->raw_byte_size, std::memory_order_relaxed);
+}
+
 // fast gc with no global pause
 void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                      uint64_t& gc_record_byte_size) {
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
-    KeyEntries::Iterator* it = entries_->NewIterator();
-    it->SeekToFirst();
-    while (it->Valid()) {
+    KeyEntries::Iterator* it = NewGcIterator();
+    while (it->Valid() && NextGcKey(gc_idx_cnt)) {
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
+        if (!PrepareGcEntry(entry)) {
+            continue;
+        }
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
-        if (node == NULL) {
+        if (entry->GetCompactBlock() != NULL) {
+            if (!IsCompactEntryExpired(entry, time)) {
+                continue;
+            }
+        } else if (node == NULL) {
             continue;
         } else if (node->GetKey() > time) {
             DEBUGLOG(
@@ -657,12 +1246,13 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
             continue;
         }
         node = NULL;
+        CompactBlock* expired = NULL;
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
-            SplitList(entry, time, &node);
-            if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+            std::lock_guard<std::shared_mutex> lock(mu_);
+            SplitList(entry, time, &node, &expired);
+            if (entry->entries.IsEmpty() && entry->GetCompactBlock() == NULL) {
+                entry_node = RemoveKeyEntry(key);
             }
         }
         if (entry_node != NULL) {
@@ -671,12 +1261,14 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
         }
         uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        FreeCompactList(expired, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
     }
     DEBUGLOG("[Gc4TTL] segment gc with key %lu ,consumed %lu, count %lu", time,
              (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
     idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+    UpdateGcCursor(it);
     delete it;
 }
 
@@ -688,12 +1280,14 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
     }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
-    KeyEntries::Iterator* it = entries_->NewIterator();
-    it->SeekToFirst();
-    while (it->Valid()) {
+    KeyEntries::Iterator* it = NewGcIterator();
+    while (it->Valid() && NextGcKey(gc_idx_cnt)) {
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
-        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
         it->Next();
+        if (!PrepareGcEntry(entry)) {
+            continue;
+        }
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
         if (node == NULL) {
             continue;
         } else if (node->GetKey() > time) {
@@ -705,7 +1299,7 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
         }
         node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<std::shared_mutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyAndPos(time, keep_cnt);
             }
@@ -720,6 +1314,7 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
         "count %lu",
         time, keep_cnt, (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
     idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+    UpdateGcCursor(it);
     delete it;
 }
 
@@ -737,12 +1332,14 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
     }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
-    KeyEntries::Iterator* it = entries_->NewIterator();
-    it->SeekToFirst();
-    while (it->Valid()) {
+    KeyEntries::Iterator* it = NewGcIterator();
+    while (it->Valid() && NextGcKey(gc_idx_cnt)) {
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
+        if (!PrepareGcEntry(entry)) {
+            continue;
+        }
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
         if (node == NULL) {
             continue;
@@ -750,12 +1347,12 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
         node = NULL;
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<std::shared_mutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyOrPos(time, keep_cnt);
             }
             if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+                entry_node = RemoveKeyEntry(key);
             }
         }
         if (entry_node != NULL) {
@@ -772,6 +1369,7 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
         "count %lu",
         time, keep_cnt, (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
     idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+    UpdateGcCursor(it);
     delete it;
 }
 
@@ -780,7 +1378,7 @@ int Segment::GetCount(const Slice& key, uint64_t& count) {
         return -1;
     }
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!FindKeyEntry(key, entry)) {
         return -1;
     }
     count = ((KeyEntry*)entry)->count_.load(std::memory_order_relaxed);  // NOLINT
@@ -796,7 +1394,7 @@ int Segment::GetCount(const Slice& key, uint32_t idx, uint64_t& count) {
         return GetCount(key, count);
     }
     void* entry_arr = NULL;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == NULL) {
+    if (!FindKeyEntry(key, entry_arr)) {
         return -1;
     }
     count = ((KeyEntry**)entry_arr)[pos->second]->count_.load(  // NOLINT
@@ -810,11 +1408,11 @@ MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket) {
         return new MemTableIterator(NULL);
     }
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!FindKeyEntry(key, entry)) {
         return new MemTableIterator(NULL);
     }
-    ticket.Push((KeyEntry*)entry);                                           // NOLINT
-    return new MemTableIterator(((KeyEntry*)entry)->entries.NewIterator());  // NOLINT
+    ticket.Push((KeyEntry*)entry);                               // NOLINT
+    return new MemTableIterator(((KeyEntry*)entry)->NewIterator());  // NOLINT
 }
 
 MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& ticket) {
@@ -826,14 +1424,14 @@ MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& t
         return NewIterator(key, ticket);
     }
     void* entry_arr = NULL;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == NULL) {
+    if (!FindKeyEntry(key, entry_arr)) {
         return new MemTableIterator(NULL);
     }
-    ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                                         // NOLINT
-    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->entries.NewIterator());  // NOLINT
+    ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                             // NOLINT
+    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->NewIterator());  // NOLINT
 }
 
-MemTableIterator::MemTableIterator(TimeEntries::Iterator* it) : it_(it) {}
+MemTableIterator::MemTableIterator(KeyEntryIterator* it) : it_(it) {}
 
 MemTableIterator::~MemTableIterator() {
     if (it_ != NULL) {
@@ -866,6 +1464,11 @@ void MemTableIterator::Next() {
     return ::openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
 }
 
+DataBlock* MemTableIterator::GetPinnableBlock() const {
+    DataBlock* block = it_->GetValue();
+    return block->IsPinnable() ? block : NULL;
+}
+
 uint64_t MemTableIterator::GetKey() const { return it_->GetKey(); }
 
 void MemTableIterator::SeekToFirst() {
@@ -21,12 +21,19 @@
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <shared_mutex>  // NOLINT
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "base/skiplist.h"
+#include "base/slab.h"
 #include "base/slice.h"
+#include "base/spinlock.h"
 #include "proto/tablet.pb.h"
+#include "storage/compact_block.h"
 #include "storage/iterator.h"
+#include "storage/key_index.h"
 #include "storage/schema.h"
 #include "storage/ticket.h"
 
@@ -43,16 +50,27 @@ class Ticket;
 struct DataBlock {
     // dimension count down
     uint8_t dim_cnt_down;
+    // header and data are in one arena allocation
+    bool in_arena : 1;
+    // header and data are in one heap allocation
+    bool inlined : 1;
+    // the count of readers which keep the data after leaving the segment, see Pin
+    uint8_t pin_cnt;
     uint32_t size;
     char* data;
 
-    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len) : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+    // the pin count is marked if the block is deleted while pinned, then the last unpin frees it
+    static constexpr uint8_t PIN_RELEASED = 0x80;
+    static constexpr uint8_t MAX_PIN_CNT = PIN_RELEASED - 1;
+
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len)
+        : dim_cnt_down(dim_cnt), in_arena(false), inlined(false), pin_cnt(0), size(len), data(NULL) {
         data = new char[len];
         memcpy(data, input, len);
     }
 
     DataBlock(uint8_t dim_cnt, char* input, uint32_t len, bool skip_copy)
-        : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+        : dim_cnt_down(dim_cnt), in_arena(false), inlined(false), pin_cnt(0), size(len), data(NULL) {
         if (skip_copy) {
             data = input;
         } else {
@@ -62,9 +80,103 @@ struct DataBlock {
     }
 
     ~DataBlock() {
-        delete[] data;
+        if (!in_arena && !inlined) {
+            delete[] data;
+        }
         data = NULL;
     }
+
+    // Create a data block from arena if arena is not NULL, otherwise from heap.
+    // Either way the data follows the header, see FromData
+    static DataBlock* New(::openmldb::base::SlabArena* arena, uint8_t dim_cnt, const char* input, uint32_t len) {
+        if (arena != NULL) {
+            char* mem = reinterpret_cast<char*>(arena->Allocate(sizeof(DataBlock) + len));
+            if (mem != NULL) {
+                char* buf = mem + sizeof(DataBlock);
+                memcpy(buf, input, len);
+                DataBlock* block = new (mem) DataBlock(dim_cnt, buf, len, true);
+                block->in_arena = true;
+                return block;
+            }
+        }
+        char* mem = reinterpret_cast<char*>(malloc(sizeof(DataBlock) + len));
+        if (mem == NULL) {
+            return new DataBlock(dim_cnt, input, len);
+        }
+        char* buf = mem + sizeof(DataBlock);
+        memcpy(buf, input, len);
+        DataBlock* block = new (mem) DataBlock(dim_cnt, buf, len, true);
+        block->inlined = true;
+        return block;
+    }
+
+    // whether the block can be pinned by readers which only keep the data, such as rpc responses
+    inline bool IsPinnable() const { return in_arena || inlined; }
+
+    // the block of the data of a pinnable block
+    static DataBlock* FromData(const char* data) {
+        return reinterpret_cast<DataBlock*>(const_cast<char*>(data) - sizeof(DataBlock));
+    }
+
+    // Keep the block alive until Unpin even if gc deletes it. The caller must hold a
+    // ticket of the key entry. Return false if the pin count is saturated
+    inline bool Pin() {
+        uint8_t cnt = __atomic_load_n(&pin_cnt, __ATOMIC_ACQUIRE);
+        while (cnt < MAX_PIN_CNT) {
+            if (__atomic_compare_exchange_n(&pin_cnt, &cnt, cnt + 1, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Drop a pin and free the block if it has been deleted
+    static void Unpin(DataBlock* block) {
+        if (__atomic_sub_fetch(&block->pin_cnt, 1, __ATOMIC_ACQ_REL) == PIN_RELEASED) {
+            Free(block);
+        }
+    }
+
+    // Decrease the dimension count and return true if it's the last dimension
+    // referring to the block. The block may be released by puts of other dimensions
+    inline bool Unref() {
+        uint8_t cnt = __atomic_load_n(&dim_cnt_down, __ATOMIC_ACQUIRE);
+        while (cnt > 1) {
+            if (__atomic_compare_exchange_n(&dim_cnt_down, &cnt, cnt - 1, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Free the data block which is created by new or DataBlock::New. A pinned block
+    // is freed by the last Unpin instead
+    static void Delete(DataBlock* block) {
+        if (block == NULL) {
+            return;
+        }
+        uint8_t cnt = __atomic_load_n(&block->pin_cnt, __ATOMIC_ACQUIRE);
+        while (cnt > 0) {
+            if (__atomic_compare_exchange_n(&block->pin_cnt, &cnt, cnt | PIN_RELEASED, true, __ATOMIC_ACQ_REL,
+                                            __ATOMIC_ACQUIRE)) {
+                return;
+            }
+        }
+        Free(block);
+    }
+
+ private:
+    static void Free(DataBlock* block) {
+        if (block->in_arena) {
+            block->~DataBlock();
+            ::openmldb::base::SlabArena::Free(block);
+        } else if (block->inlined) {
+            block->~DataBlock();
+            free(block);
+        } else {
+            delete block;
+        }
+    }
 };
 
 // the desc time comparator
@@ -82,41 +194,288 @@ struct TimeComparator {
 static const TimeComparator tcmp;
 typedef ::openmldb::base::Skiplist<uint64_t, DataBlock*, TimeComparator> TimeEntries;
 
+struct LatestRow {
+    uint64_t ts;
+    DataBlock* block;
+};
+
+// LatestList keeps the newest rows of a key in a latest index in desc time
+// order. The rows are in a ring buffer allocated with the header, so the put
+// of a new row and the eviction of the oldest row take constant time.
+// It must be accessed with the key entry locked. The iterators refer to the
+// list and read it without the lock, so a shared list is not changed any more
+// and the put copies it before the change
+class alignas(8) LatestList {
+ public:
+    static LatestList* New(uint32_t capacity) {
+        void* mem = malloc(ByteSize(capacity));
+        return new (mem) LatestList(capacity);
+    }
+
+    static void Delete(LatestList* list) {
+        if (list != NULL) {
+            list->~LatestList();
+            free(list);
+        }
+    }
+
+    inline void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+    // drop a reference and delete the list if it's the last one
+    static void UnRef(LatestList* list) {
+        if (list != NULL && list->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Delete(list);
+        }
+    }
+
+    // whether an iterator refers to the list besides the key entry
+    inline bool IsShared() const { return refs_.load(std::memory_order_acquire) > 1; }
+
+    static inline uint32_t ByteSize(uint32_t capacity) { return sizeof(LatestList) + capacity * sizeof(LatestRow); }
+
+    inline uint32_t Size() const { return size_; }
+
+    inline uint32_t Capacity() const { return capacity_; }
+
+    inline bool IsFull() const { return size_ >= capacity_; }
+
+    // pos 0 is the newest row
+    inline const LatestRow& Get(uint32_t pos) const { return Rows()[Index(pos)]; }
+
+    // the pos of first row whose ts is not larger than time, a new row is
+    // inserted before the rows with the same ts like time list
+    uint32_t FindPos(uint64_t time) const {
+        uint32_t low = 0;
+        uint32_t high = size_;
+        while (low < high) {
+            uint32_t mid = (low + high) / 2;
+            if (Get(mid).ts > time) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // the list must not be full and pos must not be larger than size
+    void Insert(uint32_t pos, uint64_t time, DataBlock* block) {
+        if (pos == 0) {
+            head_ = head_ == 0 ? capacity_ - 1 : head_ - 1;
+        } else {
+            for (uint32_t i = size_; i > pos; i--) {
+                Rows()[Index(i)] = Rows()[Index(i - 1)];
+            }
+        }
+        Rows()[Index(pos)] = LatestRow{time, block};
+        size_++;
+    }
+
+    // remove the oldest row
+    inline LatestRow PopBack() {
+        size_--;
+        return Rows()[Index(size_)];
+    }
+
+    // copy the rows to a new list, capacity must not be less than size
+    LatestList* Resize(uint32_t capacity) const {
+        LatestList* list = New(capacity);
+        for (uint32_t i = 0; i < size_; i++) {
+            list->Rows()[i] = Get(i);
+        }
+        list->size_ = size_;
+        return list;
+    }
+
+ private:
+    explicit LatestList(uint32_t capacity) : capacity_(capacity), head_(0), size_(0), refs_(1) {}
+    ~LatestList() {}
+
+    // the rows follow the header
+    inline LatestRow* Rows() const {
+        return reinterpret_cast<LatestRow*>(const_cast<LatestList*>(this) + 1);
+    }
+
+    inline uint32_t Index(uint32_t pos) const {
+        uint32_t idx = head_ + pos;
+        return idx >= capacity_ ? idx - capacity_ : idx;
+    }
+
+ private:
+    uint32_t capacity_;
+    uint32_t head_;
+    uint32_t size_;
+    std::atomic<uint32_t> refs_;
+};
+
+// KeyEntryIterator merges the rows in time list with the rows in compact
+// blocks of a key entry, so readers need not care about compaction
+class KeyEntryIterator {
+ public:
+    KeyEntryIterator(TimeEntries::Iterator* it, const CompactBlock* block)
+        : it_(it),
+          cold_(block == NULL ? NULL : new CompactBlockIterator(block)),
+          view_(1, NULL, 0, true),
+          list_(NULL),
+          pos_(0) {}
+
+    // iterate a latest list in place, the list must be referred by the caller
+    explicit KeyEntryIterator(const LatestList* list)
+        : it_(NULL), cold_(NULL), view_(1, NULL, 0, true), list_(list), pos_(0) {}
+
+    ~KeyEntryIterator() {
+        delete it_;
+        delete cold_;
+        LatestList::UnRef(const_cast<LatestList*>(list_));
+        view_.data = NULL;
+    }
+
+    inline bool Valid() const {
+        if (it_ == NULL) {
+            return pos_ < list_->Size();
+        }
+        return it_->Valid() || (cold_ != NULL && cold_->Valid());
+    }
+
+    // whether the current row comes from a compact block
+    inline bool IsCompact() const {
+        return cold_ != NULL && cold_->Valid() && (!it_->Valid() || cold_->GetKey() > it_->GetKey());
+    }
+
+    inline void Next() {
+        if (it_ == NULL) {
+            pos_++;
+        } else if (IsCompact()) {
+            cold_->Next();
+        } else {
+            it_->Next();
+        }
+    }
+
+    inline const uint64_t& GetKey() const {
+        if (it_ == NULL) {
+            return list_->Get(pos_).ts;
+        }
+        return IsCompact() ? cold_->GetKey() : it_->GetKey();
+    }
+
+    // the block returned for compact row is valid until the next move
+    inline DataBlock* GetValue() {
+        if (it_ == NULL) {
+            return list_->Get(pos_).block;
+        }
+        if (IsCompact()) {
+            view_.data = const_cast<char*>(cold_->GetData());
+            view_.size = cold_->GetSize();
+            return &view_;
+        }
+        return it_->GetValue();
+    }
+
+    inline void Seek(const uint64_t& key) {
+        if (it_ == NULL) {
+            pos_ = list_->FindPos(key);
+            return;
+        }
+        it_->Seek(key);
+        if (cold_ != NULL) {
+            cold_->Seek(key);
+        }
+    }
+
+    inline void SeekToFirst() {
+        if (it_ == NULL) {
+            pos_ = 0;
+            return;
+        }
+        it_->SeekToFirst();
+        if (cold_ != NULL) {
+            cold_->SeekToFirst();
+        }
+    }
+
+    // late rows may be put into the compacted time range, so the oldest row
+    // is either the last row of time list or of compact blocks
+    inline void SeekToLast() {
+        if (it_ == NULL) {
+            pos_ = list_->Size() == 0 ? 0 : list_->Size() - 1;
+            return;
+        }
+        it_->SeekToLast();
+        if (cold_ == NULL) {
+            return;
+        }
+        cold_->SeekToLast();
+        // keep only the oldest one valid, like Next reaches the end after it
+        if (it_->Valid() && cold_->Valid()) {
+            if (cold_->GetKey() <= it_->GetKey()) {
+                it_->Next();
+            } else {
+                cold_->Next();
+            }
+        }
+    }
+
+ private:
+    TimeEntries::Iterator* it_;
+    CompactBlockIterator* cold_;
+    DataBlock view_;
+    const LatestList* list_;
+    uint32_t pos_;
+};
+
 class MemTableIterator : public TableIterator {
  public:
-    explicit MemTableIterator(TimeEntries::Iterator* it);
+    explicit MemTableIterator(KeyEntryIterator* it);
     virtual ~MemTableIterator();
     void Seek(const uint64_t time) override;
     bool Valid() override;
     void Next() override;
     openmldb::base::Slice GetValue() const override;
+    DataBlock* GetPinnableBlock() const override;
     uint64_t GetKey() const override;
     void SeekToFirst() override;
     void SeekToLast() override;
 
  private:
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
 };
 
 class KeyEntry {
  public:
-    KeyEntry() : entries(12, 4, tcmp), refs_(0), count_(0) {}
-    explicit KeyEntry(uint8_t height) : entries(height, 4, tcmp), refs_(0), count_(0) {}
-    ~KeyEntry() {}
+    KeyEntry() : entries(12, 4, tcmp), refs_(0), mu_(), count_(0), latest_(NULL), compact_(NULL) {}
+    explicit KeyEntry(uint8_t height)
+        : entries(height, 4, tcmp), refs_(0), mu_(), count_(0), latest_(NULL), compact_(NULL) {}
+    ~KeyEntry() { LatestList::UnRef(latest_.load(std::memory_order_relaxed)); }
 
     // just return the count of datablock
     uint64_t Release() {
         uint64_t cnt = 0;
+        LatestList* list = latest_.load(std::memory_order_relaxed);
+        if (list != NULL) {
+            while (list->Size() > 0) {
+                DataBlock* block = list->PopBack().block;
+                if (block->Unref()) {
+                    DataBlock::Delete(block);
+                }
+                cnt++;
+            }
+        }
+        CompactBlock* compact_block = compact_.exchange(NULL, std::memory_order_relaxed);
+        while (compact_block != NULL) {
+            cnt += compact_block->cnt;
+            CompactBlock* tmp = compact_block;
+            compact_block = compact_block->next;
+            delete tmp;
+        }
         TimeEntries::Iterator* it = entries.NewIterator();
         it->SeekToFirst();
         while (it->Valid()) {
             cnt += 1;
             DataBlock* block = it->GetValue();
             // Avoid double free
-            if (block->dim_cnt_down > 1) {
-                block->dim_cnt_down--;
-            } else {
-                delete block;
+            if (block->Unref()) {
+                DataBlock::Delete(block);
             }
             it->Next();
         }
@@ -125,16 +484,41 @@ class KeyEntry {
         return cnt;
     }
 
+    // the compact blocks of rows moved out of time list, newest first
+    CompactBlock* GetCompactBlock() const { return compact_.load(std::memory_order_acquire); }
+
+    // delete the iterator after it's used. the entry must be referred by a
+    // ticket before, so the rows are not released by put or gc
+    KeyEntryIterator* NewIterator() {
+        if (latest_.load(std::memory_order_acquire) != NULL) {
+            std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+            LatestList* list = latest_.load(std::memory_order_relaxed);
+            if (list != NULL) {
+                list->Ref();
+                return new KeyEntryIterator(list);
+            }
+        }
+        return new KeyEntryIterator(entries.NewIterator(), GetCompactBlock());
+    }
+
     void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
 
-    void UnRef() { refs_.fetch_sub(1, std::memory_order_relaxed); }
+    // release the reads of rows before put or gc sees the entry is not referred
+    void UnRef() { refs_.fetch_sub(1, std::memory_order_release); }
 
     uint64_t GetCount() { return count_.load(std::memory_order_relaxed); }
 
  public:
     TimeEntries entries;
-    std::atomic<uint64_t> refs_;
+    // the count of readers is small, so it shares the word with mu_ to keep the entry size
+    std::atomic<uint32_t> refs_;
+    // serialize the puts to time list of this key
+    ::openmldb::base::SpinMutex mu_;
     std::atomic<uint64_t> count_;
+    // the rows are kept in latest list instead of time list if it's not NULL
+    std::atomic<LatestList*> latest_;
+    // set by compaction and gc under the segment lock while the entry is not referred
+    std::atomic<CompactBlock*> compact_;
     friend Segment;
 };
 
@@ -152,6 +536,43 @@ class Segment {
     Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec);
     ~Segment();
 
+    // Allocate data blocks and skiplist nodes from a per segment slab arena.
+    // It must be called before any put. The slabs prefer the numa node if it is not negative
+    void EnableArena(uint32_t slab_size, int numa_node = -1);
+
+    inline bool IsArenaEnabled() const { return arena_ != NULL; }
+
+    // Create a data block from the arena of this segment if it is enabled
+    inline DataBlock* NewDataBlock(uint8_t dim_cnt, const char* data, uint32_t size) {
+        return DataBlock::New(arena_, dim_cnt, data, size);
+    }
+
+    inline uint64_t GetArenaByteSize() { return arena_ == NULL ? 0 : arena_->GetSlabByteSize(); }
+
+    // Look up keys with a hash index besides the skiplist which is only used for
+    // ordered traverse. It must be called before any put
+    void EnableKeyIndex(uint32_t capacity);
+
+    inline bool IsKeyIndexEnabled() const { return key_index_ != NULL; }
+
+    // Keep the newest cnt rows of each key in a latest list and evict the older
+    // rows on put, so the segment needs no gc. It must be called before any put
+    // and only supports the segment with one ts index
+    void EnableLatest(uint32_t cnt);
+
+    inline bool IsLatestEnabled() const { return latest_enabled_; }
+
+    // Update the count of rows kept by latest lists. 0 disables latest lists
+    // and the rows are moved to time lists by the next put or gc
+    void SetLatestCnt(uint32_t cnt);
+
+    // The evicted rows are kept until the eviction is enabled again
+    void SetLatestEvict(bool evict) { latest_evict_.store(evict, std::memory_order_relaxed); }
+
+    // Take the count and byte size of records released by put since last call
+    void TakeEvictedRecord(uint64_t& gc_record_cnt,          // NOLINT
+                           uint64_t& gc_record_byte_size);   // NOLINT
+
     // Put time data
     void Put(const Slice& key, uint64_t time, const char* data, uint32_t size);
 
@@ -177,6 +598,13 @@ class Segment {
     void ExecuteGc(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& gc_idx_cnt,  // NOLINT
                    uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size);            // NOLINT
 
+    // Gc at most max_key_num keys or max_free_num records from the key left by last call
+    // until the deadline in micros. It returns true when the end of segment is reached
+    bool ExecuteGcSlice(const std::map<uint32_t, TTLSt>& ttl_st_map, uint32_t max_key_num, uint32_t max_free_num,
+                        uint64_t deadline, uint64_t& gc_idx_cnt,  // NOLINT
+                        uint64_t& gc_record_cnt,                  // NOLINT
+                        uint64_t& gc_record_byte_size);           // NOLINT
+
     void Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt,  // NOLINT
                 uint64_t& gc_record_cnt,                    // NOLINT
                 uint64_t& gc_record_byte_size);             // NOLINT
@@ -245,11 +673,60 @@ class Segment {
                          uint64_t& gc_record_cnt,         // NOLINT
                          uint64_t& gc_record_byte_size);  // NOLINT
 
+    // Move the rows not newer than time into compact blocks. It must run in
+    // the gc thread and only supports the segment with one ts index
+    void Compact(uint64_t time, uint64_t& compact_cnt);  // NOLINT
+
+    inline uint64_t GetCompactByteSize() { return compact_byte_size_.load(std::memory_order_relaxed); }
+
+    // the memory released by compaction
+    inline uint64_t GetCompactSavedByteSize() {
+        uint64_t raw = compact_raw_byte_size_.load(std::memory_order_relaxed);
+        uint64_t used = compact_byte_size_.load(std::memory_order_relaxed);
+        return raw > used ? raw - used : 0;
+    }
+
  private:
+    void CompactEntry(KeyEntry* entry, uint64_t time, uint64_t& compact_cnt);  // NOLINT
+    bool IsCompactEntryExpired(KeyEntry* entry, uint64_t time);
+    void FreeCompactList(CompactBlock* block, uint64_t& gc_idx_cnt,          // NOLINT
+                         uint64_t& gc_record_cnt,                            // NOLINT
+                         uint64_t& gc_record_byte_size);                     // NOLINT
+
+    // find the key entry or the key entry array of multi ts index
+    bool FindKeyEntry(const Slice& key, void*& entry);  // NOLINT
+    // insert and remove the key must hold mu_ exclusively
+    uint8_t InsertKeyEntry(const Slice& key, void* entry);
+    ::openmldb::base::Node<Slice, void*>* RemoveKeyEntry(const Slice& key);
+    void FreeKeyIndexTable(uint64_t version);
+
+    // the iterator starts from the gc cursor in a gc slice
+    KeyEntries::Iterator* NewGcIterator();
+    // return false if the budget of current gc slice is used up
+    bool NextGcKey(uint64_t gc_idx_cnt);
+    void UpdateGcCursor(KeyEntries::Iterator* it);
+
+    // insert the row into time list of entry and return the index byte size
+    uint32_t PutEntry(KeyEntry* entry, uint64_t time, DataBlock* row);
+
+    // the functions of latest list must be called with the key entry locked
+    void PutLatest(KeyEntry* entry, uint32_t cnt, uint64_t time, DataBlock* row);
+    void TrimLatest(KeyEntry* entry, uint32_t keep_cnt, uint64_t& gc_idx_cnt,  // NOLINT
+                    uint64_t& gc_record_cnt,                                   // NOLINT
+                    uint64_t& gc_record_byte_size);                            // NOLINT
+    void ResizeLatest(KeyEntry* entry, uint32_t capacity);
+    // the latest list of entry which is not referred by iterators
+    LatestList* GetMutableLatest(KeyEntry* entry);
+    void MoveLatestToList(KeyEntry* entry);
+    // return false if the rows of entry are in a latest list which is not gc
+    bool PrepareGcEntry(KeyEntry* entry);
+
     void FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,  // NOLINT
                   uint64_t& gc_record_cnt,         // NOLINT
                   uint64_t& gc_record_byte_size);  // NOLINT
-    void SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node);
+    // split the rows not newer than ts into node, and the compact blocks of them into expired
+    void SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node,
+                   CompactBlock** expired);
 
     void GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt,  // NOLINT
                          uint64_t& gc_record_cnt,                 // NOLINT
@@ -260,8 +737,12 @@ class Segment {
 
  private:
     KeyEntries* entries_;
-    // only Put need mutex
-    std::mutex mu_;
+    KeyIndex* key_index_;
+    // the tables replaced by rehash of key index and the gc version, guarded by gc_mu_
+    std::vector<std::pair<uint64_t, KeyIndex::Table*>> key_index_free_list_;
+    // the put to an existing key holds it shared and locks the key entry only, so puts to
+    // different keys do not block each other. creating or removing a key and gc hold it exclusively
+    std::shared_mutex mu_;
     std::mutex gc_mu_;
     std::atomic<uint64_t> idx_cnt_;
     std::atomic<uint64_t> idx_byte_size_;
@@ -273,6 +754,26 @@ class Segment {
     std::map<uint32_t, uint32_t> ts_idx_map_;
     std::vector<std::shared_ptr<std::atomic<uint64_t>>> idx_cnt_vec_;
     uint64_t ttl_offset_;
+    ::openmldb::base::SlabArena* arena_;
+    std::atomic<uint64_t> compact_byte_size_;
+    std::atomic<uint64_t> compact_raw_byte_size_;
+    bool latest_enabled_;
+    std::atomic<uint32_t> latest_cnt_;
+    std::atomic<bool> latest_evict_;
+    // some lists are longer than latest_cnt_ as the rows can not be evicted
+    std::atomic<bool> latest_overflow_;
+    // some keys are in time lists after latest lists are disabled
+    std::atomic<bool> latest_mixed_;
+    std::atomic<uint64_t> evicted_record_cnt_;
+    std::atomic<uint64_t> evicted_record_byte_size_;
+    // the key to start next gc slice, empty means from the first key. only used in gc thread
+    std::string gc_cursor_;
+    bool gc_slice_started_;
+    uint32_t gc_slice_key_num_;
+    uint32_t gc_slice_free_num_;
+    uint64_t gc_slice_deadline_;
+    uint32_t gc_slice_scanned_;
+    uint64_t gc_slice_idx_cnt_;
 };
 
 }  // namespace storage
@@ -16,11 +16,15 @@
 
 #include "storage/segment.h"
 
+#include <atomic>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/slice.h"
+#include "common/timer.h"
 #include "gtest/gtest.h"
 #include "storage/record.h"
 
@@ -37,7 +41,8 @@ class SegmentTest : public ::testing::Test {
 
 TEST_F(SegmentTest, Size) {
     ASSERT_EQ(16, (int64_t)sizeof(DataBlock));
-    ASSERT_EQ(40, (int64_t)sizeof(KeyEntry));
+    ASSERT_EQ(56, (int64_t)sizeof(KeyEntry));
+    ASSERT_EQ(16, (int64_t)sizeof(LatestList));
 }
 
 TEST_F(SegmentTest, DataBlock) {
@@ -413,6 +418,622 @@ TEST_F(SegmentTest, PutAndGetTS) {
     ASSERT_EQ(e, t);
 }
 
+TEST_F(SegmentTest, PutAndGcWithArena) {
+    Segment segment(8);
+    segment.EnableArena(4096);
+    ASSERT_TRUE(segment.IsArenaEnabled());
+    for (int i = 0; i < 100; i++) {
+        std::string pk = "pk" + std::to_string(i % 10);
+        std::string value = "value" + std::to_string(i);
+        segment.Put(Slice(pk), 9000 + i, value.c_str(), value.size());
+    }
+    ASSERT_EQ(100, (int64_t)segment.GetIdxCnt());
+    ASSERT_GT(segment.GetArenaByteSize(), 0u);
+    DataBlock* db = NULL;
+    ASSERT_TRUE(segment.Get(Slice("pk1"), 9011, &db));
+    ASSERT_TRUE(db != NULL);
+    ASSERT_TRUE(db->in_arena);
+    ASSERT_EQ("value11", std::string(db->data, db->size));
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4Head(1, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(90, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(90, (int64_t)gc_record_cnt);
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(Slice("pk9"), ticket);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(9099, (int64_t)it->GetKey());
+    ASSERT_EQ("value99", it->GetValue().ToString());
+    it->Next();
+    ASSERT_FALSE(it->Valid());
+    delete it;
+}
+
+TEST_F(SegmentTest, PinDataBlock) {
+    std::string value(100, 'a');
+    DataBlock* heap_block = DataBlock::New(NULL, 1, value.c_str(), value.size());
+    ASSERT_TRUE(heap_block->inlined);
+    ASSERT_TRUE(heap_block->IsPinnable());
+    ASSERT_EQ(heap_block, DataBlock::FromData(heap_block->data));
+    ASSERT_EQ(value, std::string(heap_block->data, heap_block->size));
+    // unpinned before deleted
+    ASSERT_TRUE(heap_block->Pin());
+    DataBlock::Unpin(heap_block);
+    DataBlock::Delete(heap_block);
+    DataBlock view(1, NULL, 0, true);
+    ASSERT_FALSE(view.IsPinnable());
+
+    Segment segment(8);
+    segment.EnableArena(4096);
+    segment.Put(Slice("pk1"), 9000, value.c_str(), value.size());
+    segment.Put(Slice("pk1"), 9002, value.c_str(), value.size());
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(Slice("pk1"), ticket);
+    it->Seek(9000);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(9000, (int64_t)it->GetKey());
+    DataBlock* block = it->GetPinnableBlock();
+    ASSERT_TRUE(block != NULL);
+    ASSERT_EQ(block, DataBlock::FromData(it->GetValue().data()));
+    ASSERT_TRUE(block->Pin());
+    ASSERT_TRUE(block->Pin());
+    delete it;
+    ticket.Pop();
+    // the pinned block is counted by gc but outlives it
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(9001, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(1, (int64_t)gc_record_cnt);
+    ASSERT_EQ(value, std::string(block->data, block->size));
+    DataBlock::Unpin(block);
+    ASSERT_EQ(value, std::string(block->data, block->size));
+    DataBlock::Unpin(block);
+
+    // the pin count saturates
+    DataBlock* full_block = DataBlock::New(NULL, 1, value.c_str(), value.size());
+    for (int i = 0; i < DataBlock::MAX_PIN_CNT; i++) {
+        ASSERT_TRUE(full_block->Pin());
+    }
+    ASSERT_FALSE(full_block->Pin());
+    DataBlock::Delete(full_block);
+    for (int i = 0; i < DataBlock::MAX_PIN_CNT; i++) {
+        DataBlock::Unpin(full_block);
+    }
+}
+
+TEST_F(SegmentTest, CompactAndGc) {
+    Segment segment(8);
+    Slice pk("pk");
+    for (uint64_t ts = 2; ts <= 200; ts += 2) {
+        std::string value = "value" + std::to_string(ts);
+        segment.Put(pk, ts, value.c_str(), value.size());
+    }
+    uint64_t compact_cnt = 0;
+    segment.Compact(100, compact_cnt);
+    ASSERT_EQ(50, (int64_t)compact_cnt);
+    ASSERT_EQ(100, (int64_t)segment.GetIdxCnt());
+    ASSERT_GT(segment.GetCompactSavedByteSize(), 0u);
+    // late row written into the compacted range
+    segment.Put(pk, 51, "late", 4);
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->Seek(52);
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(52, (int64_t)it->GetKey());
+        ASSERT_EQ("value52", it->GetValue().ToString());
+        it->Next();
+        ASSERT_EQ(51, (int64_t)it->GetKey());
+        ASSERT_EQ("late", it->GetValue().ToString());
+        it->Next();
+        ASSERT_EQ(50, (int64_t)it->GetKey());
+        ASSERT_EQ("value50", it->GetValue().ToString());
+        delete it;
+        // the key entry referenced by reader is skipped
+        compact_cnt = 0;
+        segment.Compact(120, compact_cnt);
+        ASSERT_EQ(0, (int64_t)compact_cnt);
+    }
+    compact_cnt = 0;
+    segment.Compact(120, compact_cnt);
+    ASSERT_EQ(11, (int64_t)compact_cnt);
+    compact_cnt = 0;
+    segment.Compact(140, compact_cnt);
+    ASSERT_EQ(10, (int64_t)compact_cnt);
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToFirst();
+        uint64_t cnt = 0;
+        uint64_t last_ts = UINT64_MAX;
+        while (it->Valid()) {
+            ASSERT_LE(it->GetKey(), last_ts);
+            last_ts = it->GetKey();
+            if (last_ts != 51) {
+                ASSERT_EQ("value" + std::to_string(last_ts), it->GetValue().ToString());
+            }
+            cnt++;
+            it->Next();
+        }
+        ASSERT_EQ(101, (int64_t)cnt);
+        it->Seek(121);
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(120, (int64_t)it->GetKey());
+        it->Seek(51);
+        ASSERT_EQ("late", it->GetValue().ToString());
+        delete it;
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the block with rows from 2 to 120 is expired
+    segment.Gc4TTL(130, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(61, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(61, (int64_t)gc_record_cnt);
+    ASSERT_EQ(40, (int64_t)segment.GetIdxCnt());
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->Seek(130);
+        ASSERT_EQ(130, (int64_t)it->GetKey());
+        it->SeekToLast();
+        ASSERT_EQ(122, (int64_t)it->GetKey());
+        delete it;
+    }
+    gc_idx_cnt = 0;
+    gc_record_cnt = 0;
+    segment.Gc4TTL(300, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(40, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(40, (int64_t)gc_record_cnt);
+    ASSERT_EQ(0, (int64_t)segment.GetIdxCnt());
+    ASSERT_EQ(0, (int64_t)segment.GetCompactByteSize());
+    ASSERT_EQ(0, (int64_t)segment.GetCompactSavedByteSize());
+}
+
+TEST_F(SegmentTest, CompactLateRowToLast) {
+    Segment segment(8);
+    Slice pk("pk");
+    for (uint64_t ts = 10; ts <= 200; ts += 2) {
+        std::string value = "value" + std::to_string(ts);
+        segment.Put(pk, ts, value.c_str(), value.size());
+    }
+    uint64_t compact_cnt = 0;
+    segment.Compact(100, compact_cnt);
+    ASSERT_EQ(46, (int64_t)compact_cnt);
+    // late rows older than all the compacted rows, including the ts 0
+    segment.Put(pk, 5, "late", 4);
+    segment.Put(pk, 0, "zero", 4);
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToLast();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(0, (int64_t)it->GetKey());
+        ASSERT_EQ("zero", it->GetValue().ToString());
+        it->Next();
+        ASSERT_FALSE(it->Valid());
+        it->SeekToFirst();
+        uint64_t cnt = 0;
+        while (it->Valid()) {
+            cnt++;
+            it->Next();
+        }
+        ASSERT_EQ(98, (int64_t)cnt);
+        delete it;
+    }
+    for (uint64_t ts = 1; ts <= 7; ts++) {
+        segment.Put(pk, ts, "late", 4);
+    }
+    compact_cnt = 0;
+    segment.Compact(100, compact_cnt);
+    ASSERT_EQ(9, (int64_t)compact_cnt);
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToLast();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(0, (int64_t)it->GetKey());
+        ASSERT_EQ("zero", it->GetValue().ToString());
+        it->Seek(10);
+        ASSERT_EQ("value10", it->GetValue().ToString());
+        it->Next();
+        ASSERT_EQ(7, (int64_t)it->GetKey());
+        delete it;
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(300, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(105, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(0, (int64_t)segment.GetIdxCnt());
+    ASSERT_EQ(0, (int64_t)segment.GetCompactByteSize());
+}
+
+TEST_F(SegmentTest, LatestList) {
+    LatestList* list = LatestList::New(4);
+    DataBlock db(1, "test", 4);
+    ASSERT_EQ(0u, list->FindPos(100));
+    list->Insert(0, 100, &db);
+    list->Insert(list->FindPos(200), 200, &db);
+    list->Insert(list->FindPos(50), 50, &db);
+    list->Insert(list->FindPos(150), 150, &db);
+    ASSERT_TRUE(list->IsFull());
+    uint64_t expect[] = {200, 150, 100, 50};
+    for (uint32_t i = 0; i < list->Size(); i++) {
+        ASSERT_EQ(expect[i], list->Get(i).ts);
+    }
+    ASSERT_EQ(50u, list->PopBack().ts);
+    list->Insert(list->FindPos(300), 300, &db);
+    ASSERT_EQ(300u, list->Get(0).ts);
+    ASSERT_EQ(100u, list->Get(3).ts);
+    ASSERT_EQ(4u, list->FindPos(99));
+    LatestList* new_list = list->Resize(8);
+    LatestList::Delete(list);
+    ASSERT_EQ(8u, new_list->Capacity());
+    ASSERT_EQ(4u, new_list->Size());
+    ASSERT_EQ(300u, new_list->Get(0).ts);
+    ASSERT_EQ(100u, new_list->Get(3).ts);
+    LatestList::Delete(new_list);
+}
+
+TEST_F(SegmentTest, PutLatest) {
+    Segment segment(8);
+    segment.EnableLatest(3);
+    ASSERT_TRUE(segment.IsLatestEnabled());
+    Slice pk("pk");
+    for (uint64_t ts = 1; ts <= 10; ts++) {
+        std::string value = "value" + std::to_string(ts);
+        segment.Put(pk, ts, value.c_str(), value.size());
+    }
+    // the out of order row older than the kept rows is evicted at once
+    segment.Put(pk, 5, "value5", 6);
+    // the out of order row is inserted in the middle
+    segment.Put(pk, 9, "value9_1", 8);
+    ASSERT_EQ(3, (int64_t)segment.GetIdxCnt());
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount(pk, count));
+    ASSERT_EQ(3, (int64_t)count);
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.TakeEvictedRecord(gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(9, (int64_t)gc_record_cnt);
+    DataBlock* db = NULL;
+    ASSERT_TRUE(segment.Get(pk, 9, &db));
+    ASSERT_EQ("value9_1", std::string(db->data, db->size));
+    ASSERT_TRUE(segment.Get(pk, 8, &db));
+    ASSERT_TRUE(db == NULL);
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(10, (int64_t)it->GetKey());
+        it->Next();
+        ASSERT_EQ("value9_1", it->GetValue().ToString());
+        it->Next();
+        ASSERT_EQ("value9", it->GetValue().ToString());
+        it->Next();
+        ASSERT_FALSE(it->Valid());
+        it->Seek(9);
+        ASSERT_EQ("value9_1", it->GetValue().ToString());
+        it->SeekToLast();
+        ASSERT_EQ("value9", it->GetValue().ToString());
+        // the rows are not released while the reader holds the key
+        segment.Put(pk, 11, "value11", 7);
+        segment.Put(pk, 12, "value12", 7);
+        it->SeekToFirst();
+        ASSERT_EQ("value10", it->GetValue().ToString());
+        it->SeekToLast();
+        ASSERT_EQ("value9", it->GetValue().ToString());
+        // the new reader sees the puts while the old one keeps its list
+        MemTableIterator* new_it = segment.NewIterator(pk, ticket);
+        new_it->SeekToFirst();
+        ASSERT_EQ("value12", new_it->GetValue().ToString());
+        segment.Put(pk, 10, "value10_1", 9);
+        it->Seek(10);
+        ASSERT_EQ("value10", it->GetValue().ToString());
+        new_it->Seek(10);
+        ASSERT_EQ("value10", new_it->GetValue().ToString());
+        delete new_it;
+        delete it;
+    }
+    ASSERT_EQ(6, (int64_t)segment.GetIdxCnt());
+    // the list grown by the reader is trimmed by gc
+    uint64_t gc_idx_cnt = 0;
+    segment.ExecuteGc(TTLSt(0, 3, ::openmldb::storage::kLatestTime), gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(3, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(3, (int64_t)segment.GetIdxCnt());
+    // gc need not scan the keys without overflow
+    gc_idx_cnt = 0;
+    segment.Put(pk, 13, "value13", 7);
+    segment.ExecuteGc(TTLSt(0, 3, ::openmldb::storage::kLatestTime), gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(3, (int64_t)segment.GetIdxCnt());
+
+    // the rows are moved to time list after latest list is disabled
+    segment.SetLatestCnt(0);
+    segment.Put(pk, 14, "value14", 7);
+    segment.Put(Slice("pk1"), 14, "value14", 7);
+    ASSERT_EQ(5, (int64_t)segment.GetIdxCnt());
+    gc_idx_cnt = 0;
+    segment.ExecuteGc(TTLSt(0, 2, ::openmldb::storage::kLatestTime), gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(2, (int64_t)gc_idx_cnt);
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(pk, ticket);
+    it->SeekToFirst();
+    ASSERT_EQ(14, (int64_t)it->GetKey());
+    it->Next();
+    ASSERT_EQ(13, (int64_t)it->GetKey());
+    it->Next();
+    ASSERT_FALSE(it->Valid());
+    delete it;
+}
+
+TEST_F(SegmentTest, ReleaseLatest) {
+    Segment segment(8);
+    segment.EnableLatest(2);
+    for (int i = 0; i < 10; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        segment.Put(Slice(pk), 100, "value", 5);
+        segment.Put(Slice(pk), 101, "value", 5);
+    }
+    uint64_t byte_size = segment.GetIdxByteSize();
+    ASSERT_TRUE(segment.Delete(Slice("pk0")));
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    for (int i = 0; i < 3; i++) {
+        segment.IncrGcVersion();
+        segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    }
+    ASSERT_EQ(2, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(2, (int64_t)gc_record_cnt);
+    ASSERT_EQ(18, (int64_t)segment.GetIdxCnt());
+    ASSERT_LT(segment.GetIdxByteSize(), byte_size);
+    ASSERT_EQ(18, (int64_t)segment.Release());
+}
+
+TEST_F(SegmentTest, ConcurrentPutLatest) {
+    Segment segment;
+    segment.EnableLatest(10);
+    const int thread_num = 4;
+    const int put_num = 10000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&segment, i]() {
+            for (int j = 0; j < put_num; j++) {
+                std::string key = "key" + std::to_string(j % 10);
+                segment.Put(Slice(key), (uint64_t)i * put_num + j, "test", 4);
+            }
+        });
+    }
+    // read the keys while putting
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "key" + std::to_string(i % 10);
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(Slice(key), ticket);
+        it->SeekToFirst();
+        uint64_t last_ts = UINT64_MAX;
+        while (it->Valid()) {
+            ASSERT_LT(it->GetKey(), last_ts);
+            ASSERT_EQ("test", it->GetValue().ToString());
+            last_ts = it->GetKey();
+            it->Next();
+        }
+        delete it;
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.ExecuteGc(TTLSt(0, 10, ::openmldb::storage::kLatestTime), gc_idx_cnt, gc_record_cnt,
+                      gc_record_byte_size);
+    ASSERT_EQ(100, (int64_t)segment.GetIdxCnt());
+    segment.TakeEvictedRecord(gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(thread_num * put_num - 100, (int64_t)gc_record_cnt);
+}
+
+TEST_F(SegmentTest, ConcurrentPut) {
+    Segment segment;
+    const int thread_num = 8;
+    const int key_num = 10;
+    const int put_num = 10000;
+    // all the threads put to the same keys
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&segment, i]() {
+            for (int j = 0; j < put_num; j++) {
+                std::string key = "key" + std::to_string(j % key_num);
+                segment.Put(Slice(key), (uint64_t)i * put_num + j, "test", 4);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(thread_num * put_num, (int64_t)segment.GetIdxCnt());
+    ASSERT_EQ(key_num, (int64_t)segment.GetPkCnt());
+    for (int i = 0; i < key_num; i++) {
+        std::string key = "key" + std::to_string(i);
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+        ASSERT_EQ(thread_num * put_num / key_num, (int64_t)count);
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(Slice(key), ticket);
+        it->SeekToFirst();
+        uint64_t last_ts = UINT64_MAX;
+        int cnt = 0;
+        while (it->Valid()) {
+            ASSERT_LT(it->GetKey(), last_ts);
+            last_ts = it->GetKey();
+            cnt++;
+            it->Next();
+        }
+        ASSERT_EQ(thread_num * put_num / key_num, cnt);
+        delete it;
+    }
+}
+
+TEST_F(SegmentTest, KeyIndex) {
+    Segment segment;
+    segment.EnableKeyIndex(4);
+    ASSERT_TRUE(segment.IsKeyIndexEnabled());
+    const int key_num = 1000;
+    for (int i = 0; i < key_num; i++) {
+        std::string key = "key" + std::to_string(i);
+        segment.Put(Slice(key), 100, "test1", 5);
+        segment.Put(Slice(key), 200 + i, "test2", 5);
+    }
+    ASSERT_EQ(key_num, (int64_t)segment.GetPkCnt());
+    for (int i = 0; i < key_num; i++) {
+        std::string key = "key" + std::to_string(i);
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+        ASSERT_EQ(2, (int64_t)count);
+        DataBlock* block = NULL;
+        ASSERT_TRUE(segment.Get(Slice(key), 200 + i, &block));
+        ASSERT_EQ("test2", std::string(block->data, block->size));
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(Slice(key), ticket);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(200 + i, (int64_t)it->GetKey());
+        delete it;
+    }
+    uint64_t count = 0;
+    ASSERT_EQ(-1, segment.GetCount(Slice("key1000"), count));
+    ASSERT_TRUE(segment.Delete(Slice("key0")));
+    ASSERT_FALSE(segment.Delete(Slice("key0")));
+    ASSERT_EQ(-1, segment.GetCount(Slice("key0"), count));
+    // the keys whose rows are all expired are removed from the index
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(200 + key_num / 2, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    for (int i = 0; i < 3; i++) {
+        segment.IncrGcVersion();
+        segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    }
+    ASSERT_EQ(key_num / 2 - 1, (int64_t)segment.GetPkCnt());
+    for (int i = 1; i < key_num; i++) {
+        std::string key = "key" + std::to_string(i);
+        ASSERT_EQ(i > key_num / 2 ? 0 : -1, segment.GetCount(Slice(key), count));
+    }
+    // traverse still goes through the skiplist in key order
+    KeyEntries::Iterator* pk_it = segment.GetKeyEntries()->NewIterator();
+    pk_it->SeekToFirst();
+    int pk_cnt = 0;
+    std::string last_key;
+    while (pk_it->Valid()) {
+        std::string key = pk_it->GetKey().ToString();
+        ASSERT_LT(last_key, key);
+        last_key = key;
+        pk_cnt++;
+        pk_it->Next();
+    }
+    delete pk_it;
+    ASSERT_EQ(key_num / 2 - 1, pk_cnt);
+    segment.Put(Slice("key0"), 100, "test1", 5);
+    ASSERT_EQ(0, segment.GetCount(Slice("key0"), count));
+    ASSERT_EQ(1, (int64_t)count);
+}
+
+TEST_F(SegmentTest, ConcurrentPutKeyIndex) {
+    Segment segment;
+    segment.EnableKeyIndex(4);
+    const int thread_num = 4;
+    const int put_num = 20000;
+    std::atomic<int> finished(0);
+    // the writers create new keys and rehash the index while the readers look up the keys
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&segment, &finished, i]() {
+            for (int j = 0; j < put_num; j++) {
+                std::string key = "key" + std::to_string(i) + "_" + std::to_string(j);
+                segment.Put(Slice(key), j, "test", 4);
+            }
+            finished.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    segment.Put(Slice("pk"), 1, "test", 4);
+    while (finished.load(std::memory_order_relaxed) < thread_num) {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(Slice("pk"), ticket);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(1, (int64_t)it->GetKey());
+        delete it;
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(thread_num * put_num + 1, (int64_t)segment.GetPkCnt());
+    for (int i = 0; i < thread_num; i++) {
+        for (int j = 0; j < put_num; j += 100) {
+            std::string key = "key" + std::to_string(i) + "_" + std::to_string(j);
+            uint64_t count = 0;
+            ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+            ASSERT_EQ(1, (int64_t)count);
+        }
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(put_num, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    for (int i = 0; i < 3; i++) {
+        segment.IncrGcVersion();
+        segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    }
+    ASSERT_EQ(thread_num * put_num + 1, (int64_t)gc_record_cnt);
+    ASSERT_EQ(0, (int64_t)segment.GetPkCnt());
+}
+
+// the threads put to their own keys without waiting for the others, and all
+// the rows and keys are kept
+TEST_F(SegmentTest, ConcurrentPutOwnKeys) {
+    const int put_num = 200000;
+    const int key_num = 1000;
+    for (int thread_num = 1; thread_num <= 64; thread_num *= 2) {
+        Segment segment;
+        std::vector<std::thread> threads;
+        uint64_t start = ::baidu::common::timer::get_micros();
+        for (int i = 0; i < thread_num; i++) {
+            threads.emplace_back([&segment, i, thread_num, put_num, key_num]() {
+                int num = put_num / thread_num;
+                for (int j = 0; j < num; j++) {
+                    std::string key = "key" + std::to_string(i) + "_" + std::to_string(j % key_num);
+                    segment.Put(Slice(key), j, "test", 4);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        uint64_t consumed = ::baidu::common::timer::get_micros() - start;
+        ASSERT_EQ(put_num / thread_num * thread_num, (int64_t)segment.GetIdxCnt());
+        ASSERT_EQ(thread_num * key_num, (int64_t)segment.GetPkCnt());
+        for (int i = 0; i < thread_num; i++) {
+            std::string key = "key" + std::to_string(i) + "_0";
+            Ticket ticket;
+            std::unique_ptr<MemTableIterator> it(segment.NewIterator(Slice(key), ticket));
+            it->SeekToFirst();
+            int cnt = 0;
+            while (it->Valid()) {
+                cnt++;
+                it->Next();
+            }
+            ASSERT_EQ((put_num / thread_num + key_num - 1) / key_num, cnt);
+        }
+        RecordProperty("put_qps_" + std::to_string(thread_num),
+                       std::to_string((uint64_t)put_num * 1000000 / (consumed + 1)));
+    }
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/sharded_replayer.h"
+
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "base/hash.h"
+#include "boost/bind.hpp"
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t SEED = 0xe17a1465;
+static const uint32_t REPLAY_BATCH_SIZE = 8192;
+
+ShardedReplayer::ShardedReplayer(std::shared_ptr<Table> table, uint32_t shard_num)
+    : ShardedReplayer(table, shard_num, NULL) {
+    own_pool_.reset(new ::openmldb::base::TaskPool(shard_num, shard_num));
+    pool_ = own_pool_.get();
+}
+
+ShardedReplayer::ShardedReplayer(std::shared_ptr<Table> table, uint32_t shard_num, ::openmldb::base::TaskPool* pool)
+    : table_(table),
+      shard_num_(shard_num),
+      pending_(0),
+      batch_(shard_num),
+      applying_(shard_num),
+      owned_(),
+      applying_owned_(),
+      running_(0),
+      mu_(),
+      cv_(),
+      own_pool_(),
+      pool_(pool),
+      failed_cnt_(0) {}
+
+ShardedReplayer::~ShardedReplayer() { Wait(); }
+
+void ShardedReplayer::Put(::openmldb::api::LogEntry* entry) {
+    owned_.emplace_back();
+    owned_.back().Swap(entry);
+    Add(&owned_.back());
+}
+
+void ShardedReplayer::Put(const ::openmldb::api::LogEntry& entry) { Add(&entry); }
+
+void ShardedReplayer::Add(const ::openmldb::api::LogEntry* entry) {
+    const std::string& key = entry->dimensions_size() > 0 ? entry->dimensions(0).key() : entry->pk();
+    uint32_t idx = ::openmldb::base::hash(key.data(), key.size(), SEED) % shard_num_;
+    batch_[idx].push_back(entry);
+    if (++pending_ >= REPLAY_BATCH_SIZE) {
+        Flush();
+    }
+}
+
+void ShardedReplayer::Flush() {
+    Wait();
+    if (pending_ == 0) {
+        return;
+    }
+    batch_.swap(applying_);
+    owned_.swap(applying_owned_);
+    pending_ = 0;
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        for (uint32_t idx = 0; idx < shard_num_; idx++) {
+            if (!applying_[idx].empty()) {
+                running_++;
+            }
+        }
+    }
+    for (uint32_t idx = 0; idx < shard_num_; idx++) {
+        if (!applying_[idx].empty()) {
+            pool_->AddTask(boost::bind(&ShardedReplayer::Apply, this, idx));
+        }
+    }
+}
+
+void ShardedReplayer::Wait() {
+    {
+        std::unique_lock<bthread::Mutex> lock(mu_);
+        while (running_ > 0) {
+            cv_.wait(lock);
+        }
+    }
+    applying_owned_.clear();
+}
+
+void ShardedReplayer::Apply(uint32_t idx) {
+    for (const auto* entry : applying_[idx]) {
+        if (!table_->Put(*entry)) {
+            failed_cnt_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    applying_[idx].clear();
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    if (--running_ == 0) {
+        cv_.notify_all();
+    }
+}
+
+}  // namespace storage
+}  // namespace openmldb
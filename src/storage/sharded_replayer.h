@@ -0,0 +1,92 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_SHARDED_REPLAYER_H_
+#define SRC_STORAGE_SHARDED_REPLAYER_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "base/taskpool.hpp"
+#include "bthread/condition_variable.h"
+#include "bthread/mutex.h"
+#include "proto/tablet.pb.h"
+#include "storage/table.h"
+
+namespace openmldb {
+namespace storage {
+
+// ShardedReplayer puts log entries to table in parallel. entries are sharded
+// by the first dimension key, so puts on the same key keep the log order.
+// a batch is applied by the pool while the next one is being read.
+// deletes are not sharded, the caller must Flush and Wait before a delete.
+// Wait blocks on bthread primitives, so it may be called in rpc handlers
+class ShardedReplayer {
+ public:
+    // the replayer owns a pool of shard_num threads
+    ShardedReplayer(std::shared_ptr<Table> table, uint32_t shard_num);
+
+    // the batches are applied by pool which may be shared by many replayers
+    ShardedReplayer(std::shared_ptr<Table> table, uint32_t shard_num, ::openmldb::base::TaskPool* pool);
+
+    ~ShardedReplayer();
+
+    // take the content of entry
+    void Put(::openmldb::api::LogEntry* entry);
+
+    // refer to the entry, it must be alive until Wait returns
+    void Put(const ::openmldb::api::LogEntry& entry);
+
+    // dispatch the pending entries after the previous batch is applied
+    void Flush();
+
+    // wait the dispatched batch applied
+    void Wait();
+
+    // the entries failed to put to table
+    inline uint64_t GetFailedCnt() const { return failed_cnt_.load(std::memory_order_relaxed); }
+
+    ShardedReplayer(const ShardedReplayer&) = delete;
+    ShardedReplayer& operator=(const ShardedReplayer&) = delete;
+
+ private:
+    void Add(const ::openmldb::api::LogEntry* entry);
+    void Apply(uint32_t idx);
+
+ private:
+    std::shared_ptr<Table> table_;
+    uint32_t shard_num_;
+    uint32_t pending_;
+    std::vector<std::vector<const ::openmldb::api::LogEntry*>> batch_;
+    std::vector<std::vector<const ::openmldb::api::LogEntry*>> applying_;
+    // the entries taken by Put, deque keeps their addresses
+    std::deque<::openmldb::api::LogEntry> owned_;
+    std::deque<::openmldb::api::LogEntry> applying_owned_;
+    // the count of shards being applied
+    uint32_t running_;
+    bthread::Mutex mu_;
+    bthread::ConditionVariable cv_;
+    std::unique_ptr<::openmldb::base::TaskPool> own_pool_;
+    ::openmldb::base::TaskPool* pool_;
+    std::atomic<uint64_t> failed_cnt_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+
+#endif  // SRC_STORAGE_SHARDED_REPLAYER_H_
@@ -28,7 +28,8 @@ namespace storage {
 
 class Snapshot {
  public:
-    Snapshot(uint32_t tid, uint32_t pid) : tid_(tid), pid_(pid), offset_(0), making_snapshot_(false) {}
+    Snapshot(uint32_t tid, uint32_t pid)
+        : tid_(tid), pid_(pid), offset_(0), making_snapshot_(false), recover_record_cnt_(0), recover_byte_size_(0) {}
     virtual ~Snapshot() = default;
     virtual bool Init() = 0;
     virtual int MakeSnapshot(std::shared_ptr<Table> table,
@@ -37,7 +38,11 @@ class Snapshot {
     virtual bool Recover(std::shared_ptr<Table> table,
                          uint64_t& latest_offset) = 0;  // NOLINT
     uint64_t GetOffset() { return offset_; }
+    // the records and bytes loaded by the last Recover
+    uint64_t GetRecoverRecordCnt() { return recover_record_cnt_; }
+    uint64_t GetRecoverByteSize() { return recover_byte_size_; }
     int GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term);
+    int GenManifest(const ::openmldb::api::Manifest& manifest);
     static int GetLocalManifest(const std::string& full_path,
                                 ::openmldb::api::Manifest& manifest);  // NOLINT
 
@@ -47,6 +52,8 @@ class Snapshot {
     uint64_t offset_;
     std::atomic<bool> making_snapshot_;
     std::string snapshot_path_;
+    uint64_t recover_record_cnt_;
+    uint64_t recover_byte_size_;
 };
 
 }  // namespace storage
@@ -41,6 +41,9 @@
 
 DECLARE_string(db_root_path);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(load_table_thread_num);
+DECLARE_uint32(load_snapshot_range_size);
+DECLARE_uint32(snapshot_max_delta_num);
 
 using ::openmldb::api::LogEntry;
 namespace openmldb {
@@ -715,6 +718,110 @@ TEST_F(SnapshotTest, Recover_only_snapshot) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SnapshotTest, Recover_snapshot_in_ranges) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/2_5/snapshot";
+    std::string binlog_dir = FLAGS_db_root_path + "/2_5/binlog/";
+    ::openmldb::base::MkdirRecur(snapshot_dir);
+    std::string snapshot1 = "20170609.sdb";
+    if (FLAGS_snapshot_compression != "off") {
+        snapshot1.append(".");
+        snapshot1.append(FLAGS_snapshot_compression);
+    }
+    uint32_t key_num = 50;
+    uint32_t cnt = 5000;
+    {
+        std::string full_path = snapshot_dir + "/" + snapshot1;
+        FILE* fd_w = fopen(full_path.c_str(), "ab+");
+        ASSERT_TRUE(fd_w != NULL);
+        ::openmldb::log::WritableFile* wf = ::openmldb::log::NewWritableFile(snapshot1, fd_w);
+        ::openmldb::log::Writer writer(FLAGS_snapshot_compression, wf);
+        for (uint32_t i = 0; i < cnt; i++) {
+            ::openmldb::api::LogEntry entry;
+            entry.set_pk("key" + std::to_string(i % key_num));
+            entry.set_ts(i + 1);
+            // some records span several blocks
+            entry.set_value(std::string(i % 100 == 0 ? 10000 : 50, 'a' + i % 26));
+            entry.set_log_index(i + 1);
+            std::string val;
+            ASSERT_TRUE(entry.SerializeToString(&val));
+            ASSERT_TRUE(writer.AddRecord(Slice(val)).ok());
+        }
+        writer.EndLog();
+        delete wf;
+    }
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = cnt;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    // puts on key0 before the delete must not be replayed after it
+    for (uint32_t i = 0; i < 300; i++) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(++offset);
+        if (i == 200) {
+            entry.set_method_type(::openmldb::api::MethodType::kDelete);
+            ::openmldb::api::Dimension* dimension = entry.add_dimensions();
+            dimension->set_key("key0");
+            dimension->set_idx(0);
+        } else {
+            entry.set_pk("key" + std::to_string(i % key_num));
+            entry.set_ts(cnt + i + 1);
+            entry.set_value("value");
+        }
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(Slice(buffer)).ok());
+    }
+    wh->EndLog();
+    delete wh;
+
+    uint32_t old_thread_num = FLAGS_load_table_thread_num;
+    uint32_t old_range_size = FLAGS_load_snapshot_range_size;
+    FLAGS_load_table_thread_num = 4;
+    FLAGS_load_snapshot_range_size = 4096;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 2, 5, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    MemTableSnapshot snapshot(2, 5, log_part, FLAGS_db_root_path);
+    ASSERT_TRUE(snapshot.Init());
+    ASSERT_EQ(0, snapshot.GenManifest(snapshot1, cnt, cnt, 5));
+    uint64_t snapshot_offset = 0;
+    ASSERT_TRUE(snapshot.Recover(table, snapshot_offset));
+    ASSERT_EQ(cnt, snapshot_offset);
+    ASSERT_EQ(cnt, snapshot.GetRecoverRecordCnt());
+    ASSERT_EQ(cnt, table->GetRecordCnt());
+    Binlog binlog(log_part, binlog_dir);
+    uint64_t latest_offset = 0;
+    ASSERT_TRUE(binlog.RecoverFromBinlog(table, snapshot_offset, latest_offset));
+    FLAGS_load_table_thread_num = old_thread_num;
+    FLAGS_load_snapshot_range_size = old_range_size;
+    ASSERT_EQ(cnt + 300, latest_offset);
+    ASSERT_EQ(300u, binlog.GetRecoverRecordCnt());
+    Ticket ticket;
+    for (uint32_t k = 0; k < key_num; k++) {
+        std::string key = "key" + std::to_string(k);
+        TableIterator* it = table->NewIterator(key, ticket);
+        it->SeekToFirst();
+        uint32_t num = 0;
+        uint64_t last_ts = UINT64_MAX;
+        while (it->Valid()) {
+            ASSERT_LT(it->GetKey(), last_ts);
+            last_ts = it->GetKey();
+            num++;
+            it->Next();
+        }
+        delete it;
+        if (k == 0) {
+            // only the puts after the delete in binlog are left
+            ASSERT_EQ(1u, num);
+        } else {
+            ASSERT_EQ(cnt / key_num + 6, num);
+        }
+    }
+}
+
 TEST_F(SnapshotTest, MakeSnapshot) {
     LogParts* log_part = new LogParts(12, 4, scmp);
     MemTableSnapshot snapshot(1, 2, log_part, FLAGS_db_root_path);
@@ -861,6 +968,120 @@ TEST_F(SnapshotTest, MakeSnapshot) {
     ASSERT_EQ(7, (int64_t)manifest.term());
 }
 
+TEST_F(SnapshotTest, MakeDeltaSnapshot) {
+    uint32_t max_delta_num = FLAGS_snapshot_max_delta_num;
+    FLAGS_snapshot_max_delta_num = 2;
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    MemTableSnapshot snapshot(11, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("tx_log", 11, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    std::string log_path = FLAGS_db_root_path + "/11_0/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/11_0/snapshot/";
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, log_path, binlog_index, offset++);
+    auto put = [&](const std::string& key) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(offset++);
+        entry.set_pk(key);
+        entry.set_ts(::baidu::common::timer::get_micros() / 1000);
+        entry.set_value("value");
+        entry.set_term(5);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    };
+    auto del = [&](const std::string& key) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(offset++);
+        entry.set_method_type(::openmldb::api::MethodType::kDelete);
+        ::openmldb::api::Dimension* dimension = entry.add_dimensions();
+        dimension->set_key(key);
+        dimension->set_idx(0);
+        entry.set_term(5);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    };
+    for (int i = 0; i < 10; i++) {
+        put("key" + std::to_string(i));
+    }
+    // the first snapshot is a base snapshot
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(10u, offset_value);
+    ::openmldb::api::Manifest manifest;
+    GetManifest(snapshot_path + "MANIFEST", &manifest);
+    ASSERT_EQ(10u, manifest.count());
+    ASSERT_EQ(0, manifest.delta_size());
+
+    for (int i = 10; i < 15; i++) {
+        put("key" + std::to_string(i));
+    }
+    del("key0");
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(16u, offset_value);
+    put("key0");
+    del("key1");
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(18u, offset_value);
+    manifest.Clear();
+    GetManifest(snapshot_path + "MANIFEST", &manifest);
+    ASSERT_EQ(18u, manifest.offset());
+    ASSERT_EQ(10u, manifest.count());
+    ASSERT_EQ(2, manifest.delta_size());
+    ASSERT_EQ(6u, manifest.delta(0).count());
+    ASSERT_EQ(16u, manifest.delta(0).offset());
+    ASSERT_EQ(2u, manifest.delta(1).count());
+    ASSERT_EQ(18u, manifest.delta(1).offset());
+    std::vector<std::string> vec;
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_path, vec));
+    ASSERT_EQ(4, (int32_t)vec.size());
+
+    // the deltas are applied in order on the base snapshot
+    std::shared_ptr<MemTable> recover_table =
+        std::make_shared<MemTable>("tx_log", 11, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    recover_table->Init();
+    uint64_t latest_offset = 0;
+    ASSERT_TRUE(snapshot.Recover(recover_table, latest_offset));
+    ASSERT_EQ(18u, latest_offset);
+    Ticket ticket;
+    auto key_cnt = [&](const std::string& key) {
+        TableIterator* it = recover_table->NewIterator(key, ticket);
+        it->SeekToFirst();
+        int cnt = 0;
+        while (it->Valid()) {
+            cnt++;
+            it->Next();
+        }
+        delete it;
+        return cnt;
+    };
+    ASSERT_EQ(1, key_cnt("key0"));
+    ASSERT_EQ(0, key_cnt("key1"));
+    ASSERT_EQ(1, key_cnt("key2"));
+    ASSERT_EQ(1, key_cnt("key14"));
+
+    // the deltas are merged into a new base snapshot when the chain is full
+    put("key20");
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(19u, offset_value);
+    manifest.Clear();
+    GetManifest(snapshot_path + "MANIFEST", &manifest);
+    ASSERT_EQ(19u, manifest.offset());
+    ASSERT_EQ(15u, manifest.count());
+    ASSERT_EQ(0, manifest.delta_size());
+    vec.clear();
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_path, vec));
+    ASSERT_EQ(2, (int32_t)vec.size());
+    FLAGS_snapshot_max_delta_num = max_delta_num;
+}
+
 TEST_F(SnapshotTest, MakeSnapshot_with_delete_index) {
     LogParts* log_part = new LogParts(12, 4, scmp);
     MemTableSnapshot snapshot(1, 3, log_part, FLAGS_db_root_path);
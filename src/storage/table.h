@@ -54,7 +54,7 @@ class Table {
 
     virtual bool Put(const Dimensions& dimensions, const TSDimensions& ts_dimemsions, const std::string& value) = 0;
 
-    bool Put(const ::openmldb::api::LogEntry& entry) {
+    virtual bool Put(const ::openmldb::api::LogEntry& entry) {
         if (entry.dimensions_size() > 0) {
             return entry.ts_dimensions_size() > 0 ? Put(entry.dimensions(), entry.ts_dimensions(), entry.value())
                                                   : Put(entry.ts(), entry.value(), entry.dimensions());
@@ -83,6 +83,10 @@ class Table {
 
     virtual uint64_t GetExpireTime(const TTLSt& ttl_st) = 0;
 
+    // the log offset up to which the rows survive restarts, the snapshot and binlog
+    // before it are not replayed on load. 0 if the table is rebuilt on load
+    virtual uint64_t GetPersistedOffset() { return 0; }
+
     inline std::string GetName() const { return name_; }
     inline std::string GetDB() {
         auto table_meta = GetTableMeta();
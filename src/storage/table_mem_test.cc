@@ -14,13 +14,22 @@
  * limitations under the License.
  */
 
+#include <gflags/gflags.h>
+
+#include <string>
+
+#include "codec/schema_codec.h"
 #include "common/timer.h"
+#include "gperftools/malloc_extension.h"
 #include "gtest/gtest.h"
+#include "storage/mem_table.h"
 #include "storage/table.h"
 #ifdef TCMALLOC_ENABLE
 #include "gperftools/heap-checker.h"
 #endif
 
+DECLARE_uint32(arena_slab_size);
+
 namespace openmldb {
 namespace storage {
 
@@ -53,6 +62,82 @@ TEST_F(TableMemTest, Memory) {
 #endif
 }
 
+static uint64_t GetAllocatedBytes() {
+    size_t allocated = 0;
+    MallocExtension::instance()->GetNumericProperty("generic.current_allocated_bytes", &allocated);
+    return allocated;
+}
+
+static MemTable* CreateMemTable(bool enable_arena) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("t1");
+    table_meta.set_tid(1);
+    table_meta.set_pid(0);
+    table_meta.set_seg_cnt(8);
+    table_meta.set_enable_arena(enable_arena);
+    ::openmldb::codec::SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    ::openmldb::codec::SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "mcc", ::openmldb::type::kString);
+    ::openmldb::codec::SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts", ::openmldb::type::kBigInt);
+    ::openmldb::codec::SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts",
+                                             ::openmldb::type::kAbsoluteTime, 0, 0);
+    ::openmldb::codec::SchemaCodec::SetIndex(table_meta.add_column_key(), "mcc", "mcc", "ts",
+                                             ::openmldb::type::kAbsoluteTime, 0, 0);
+    MemTable* table = new MemTable(table_meta);
+    table->Init();
+    return table;
+}
+
+// put the same rows with and without arena, and compare the heap usage
+// with the record byte size which is counted by table
+TEST_F(TableMemTest, ArenaMemory) {
+    uint32_t key_num = 10000;
+    uint32_t row_num = 500000;
+    std::string value(64, 'a');
+    uint64_t base_time = ::baidu::common::timer::get_micros() / 1000;
+    uint64_t used_bytes[2] = {0, 0};
+    uint64_t record_bytes[2] = {0, 0};
+    for (int mode = 0; mode < 2; mode++) {
+        uint64_t before = GetAllocatedBytes();
+        MemTable* table = CreateMemTable(mode == 1);
+        for (uint32_t i = 0; i < row_num; i++) {
+            ::openmldb::api::PutRequest request;
+            ::openmldb::api::Dimension* dim = request.add_dimensions();
+            dim->set_idx(0);
+            dim->set_key("card" + std::to_string(i % key_num));
+            dim = request.add_dimensions();
+            dim->set_idx(1);
+            dim->set_key("mcc" + std::to_string(i % (key_num / 10)));
+            ::openmldb::api::TSDimension* ts = request.add_ts_dimensions();
+            ts->set_idx(0);
+            ts->set_ts(base_time + i);
+            ASSERT_TRUE(table->Put(request.dimensions(), request.ts_dimensions(), value));
+        }
+        used_bytes[mode] = GetAllocatedBytes() - before;
+        record_bytes[mode] = table->GetRecordByteSize() + table->GetRecordIdxByteSize();
+        ASSERT_EQ(row_num, table->GetRecordCnt());
+        Ticket ticket;
+        TableIterator* it = table->NewIterator(0, "card1", ticket);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(value, it->GetValue().ToString());
+        delete it;
+        if (mode == 1) {
+            // the slabs are mostly filled by the rows and the skiplist nodes
+            ASSERT_GT(table->GetArenaByteSize(), 0u);
+            ASSERT_LT(table->GetArenaByteSize(), record_bytes[mode] * 5 / 4);
+        } else {
+            ASSERT_EQ(0u, table->GetArenaByteSize());
+        }
+        delete table;
+    }
+    ASSERT_EQ(record_bytes[0], record_bytes[1]);
+    // the heap stays within a quarter above the record byte size with arena
+    if (used_bytes[0] > 0 && used_bytes[1] > 0) {
+        ASSERT_LT(used_bytes[1], used_bytes[0]);
+        ASSERT_LT(used_bytes[1], record_bytes[1] * 5 / 4);
+    }
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
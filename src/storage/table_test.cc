@@ -25,6 +25,7 @@
 
 DECLARE_uint32(max_traverse_cnt);
 DECLARE_int32(gc_safe_offset);
+DECLARE_uint32(latest_list_max_cnt);
 
 namespace openmldb {
 namespace storage {
@@ -57,6 +58,27 @@ TEST_F(TableTest, Put) {
     delete table;
 }
 
+TEST_F(TableTest, NumaNode) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    MemTable* table = new MemTable("tx_log", 1, 1, 8, mapping, 10, ::openmldb::type::kAbsoluteTime);
+    ASSERT_EQ(-1, table->GetNumaNode());
+    table->SetNumaNode(0);
+    table->Init();
+    // the memory of the bound table is allocated from arena
+    ASSERT_EQ(0u, table->GetArenaByteSize());
+    table->Put("test", 9537, "test", 4);
+    ASSERT_EQ(0, table->GetNumaNode());
+    ASSERT_GT(table->GetArenaByteSize(), 0u);
+    Ticket ticket;
+    TableIterator* it = table->NewIterator("test", ticket);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ("test", it->GetValue().ToString());
+    delete it;
+    delete table;
+}
+
 TEST_F(TableTest, MultiDimissionDelete) {
     ::openmldb::api::TableMeta* table_meta = new ::openmldb::api::TableMeta();
     table_meta->set_name("t0");
@@ -317,6 +339,111 @@ TEST_F(TableTest, SchedGcHead1) {
     table->SchedGc();
 }
 
+TEST_F(TableTest, LatestList) {
+    FLAGS_latest_list_max_cnt = 10;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    MemTable* table = new MemTable("tx_log", 1, 1, 8, mapping, 3, ::openmldb::type::kLatestTime);
+    table->Init();
+    for (int i = 0; i < 10; i++) {
+        std::string key = "test" + std::to_string(i);
+        for (int j = 0; j < 10; j++) {
+            table->Put(key, 1000 + j, "test1", 5);
+        }
+    }
+    // the old rows are evicted by put
+    ASSERT_EQ(30, (int64_t)table->GetRecordIdxCnt());
+    ASSERT_EQ(100, (int64_t)table->GetRecordCnt());
+    table->SchedGc();
+    ASSERT_EQ(30, (int64_t)table->GetRecordCnt());
+    ASSERT_EQ(30, (int64_t)table->GetRecordIdxCnt());
+    Ticket ticket;
+    TableIterator* it = table->NewIterator("test5", ticket);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(1009, (int64_t)it->GetKey());
+    it->Seek(1008);
+    ASSERT_EQ(1008, (int64_t)it->GetKey());
+    delete it;
+    it = table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    int count = 0;
+    while (it->Valid()) {
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(30, count);
+    delete it;
+    std::unique_ptr<::hybridse::vm::WindowIterator> window_it(table->NewWindowIterator(0));
+    window_it->Seek("test5");
+    ASSERT_TRUE(window_it->Valid());
+    auto row_it = window_it->GetValue();
+    row_it->SeekToFirst();
+    count = 0;
+    while (row_it->Valid()) {
+        count++;
+        row_it->Next();
+    }
+    ASSERT_EQ(3, count);
+
+    // the rows are kept in time list after the ttl type is changed
+    table->SetTTL(::openmldb::storage::UpdateTTLMeta(
+        ::openmldb::storage::TTLSt(0, 0, ::openmldb::storage::kAbsoluteTime)));
+    table->SchedGc();
+    for (int j = 0; j < 10; j++) {
+        table->Put("test0", 2000 + j, "test1", 5);
+    }
+    ASSERT_EQ(40, (int64_t)table->GetRecordIdxCnt());
+    delete table;
+    FLAGS_latest_list_max_cnt = 0;
+}
+
+TEST_F(TableTest, SchedGcSlice) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    MemTable* table = new MemTable("tx_log", 1, 1, 8, mapping, 3, ::openmldb::type::kLatestTime);
+    table->Init();
+    MemTable* full_table = new MemTable("tx_log", 1, 1, 8, mapping, 3, ::openmldb::type::kLatestTime);
+    full_table->Init();
+    for (int i = 0; i < 100; i++) {
+        std::string key = "test" + std::to_string(i);
+        for (int j = 0; j < 10; j++) {
+            table->Put(key, 1000 + j, "test1", 5);
+            full_table->Put(key, 1000 + j, "test1", 5);
+        }
+    }
+    ASSERT_EQ(1000, (int64_t)table->GetRecordCnt());
+    full_table->SchedGc();
+    // no time budget, so every slice gcs at most 5 keys of one segment
+    int slice_cnt = 0;
+    while (!table->SchedGcSlice(5, 100000, 0)) {
+        slice_cnt++;
+        ASSERT_LT(slice_cnt, 10000);
+    }
+    ASSERT_GT(slice_cnt, 0);
+    ASSERT_EQ(full_table->GetRecordCnt(), table->GetRecordCnt());
+    ASSERT_EQ(full_table->GetRecordIdxCnt(), table->GetRecordIdxCnt());
+    ASSERT_EQ(300, (int64_t)table->GetRecordIdxCnt());
+    ASSERT_LT(table->GetGcLag(), 60 * 1000u);
+    Ticket ticket;
+    TableIterator* it = table->NewIterator("test5", ticket);
+    it->SeekToFirst();
+    int count = 0;
+    while (it->Valid()) {
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(3, count);
+    delete it;
+    // the next round starts from the first segment again
+    table->Put("test0", 2000, "test1", 5);
+    while (!table->SchedGcSlice(5, 100000, 0)) {
+    }
+    ASSERT_EQ(300, (int64_t)table->GetRecordIdxCnt());
+    delete table;
+    delete full_table;
+}
+
 TEST_F(TableTest, SchedGc) {
     std::map<std::string, uint32_t> mapping;
     mapping.insert(std::make_pair("idx0", 0));
@@ -122,6 +122,7 @@ class CombineIterator {
     bool Valid();
     uint64_t GetTs();
     openmldb::base::Slice GetValue();
+    inline ::openmldb::storage::DataBlock* GetPinnableBlock() const { return cur_qit_->it->GetPinnableBlock(); }
     inline uint64_t GetExpireTime() const { return expire_time_; }
     inline ::openmldb::storage::TTLType GetTTLType() const { return ttl_type_; }
 
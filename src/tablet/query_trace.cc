@@ -0,0 +1,120 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/query_trace.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "boost/algorithm/string.hpp"
+#include "common/timer.h"
+
+namespace openmldb {
+namespace tablet {
+
+QueryTrace::QueryTrace() : last_us_(::baidu::common::timer::get_micros()), stage_us_(), runner_trace_() {}
+
+void QueryTrace::EndStage(Stage stage) {
+    uint64_t now = ::baidu::common::timer::get_micros();
+    stage_us_[stage] += now - last_us_;
+    last_us_ = now;
+}
+
+uint64_t QueryTrace::GetTotalTime() const {
+    uint64_t total = 0;
+    for (int i = 0; i < kStageCnt; i++) {
+        total += stage_us_[i];
+    }
+    return total;
+}
+
+const char* QueryTrace::StageName(Stage stage) {
+    switch (stage) {
+        case kCompile:
+            return "compile";
+        case kDecode:
+            return "decode";
+        case kRun:
+            return "run";
+        case kEncode:
+            return "encode";
+        default:
+            return "unknown";
+    }
+}
+
+std::string QueryTrace::ToString() const {
+    std::ostringstream oss;
+    oss << "total " << GetTotalTime() << "us";
+    for (int i = 0; i < kStageCnt; i++) {
+        oss << ", " << StageName(static_cast<Stage>(i)) << " " << stage_us_[i] << "us";
+    }
+    std::vector<const ::hybridse::vm::RunnerTrace::Node*> nodes;
+    for (const auto& node : runner_trace_.nodes) {
+        nodes.push_back(&node);
+    }
+    std::stable_sort(nodes.begin(), nodes.end(),
+                     [](const auto* l, const auto* r) { return l->time_us > r->time_us; });
+    oss << "; runners:";
+    for (const auto* node : nodes) {
+        oss << " [" << node->id << "]" << node->name << " " << node->time_us << "us";
+        if (node->run_cnt > 1) {
+            oss << "/" << node->run_cnt;
+        }
+    }
+    return oss.str();
+}
+
+void ProcedureTraceStat::Add(const std::string& db, const std::string& sp_name, const std::string& mode,
+                             const QueryTrace& trace) {
+    std::shared_ptr<Recorders> recorders;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto& ptr = stats_[db][sp_name][mode];
+        if (!ptr) {
+            ptr = std::make_shared<Recorders>();
+            ptr->prefix = "procedure_" + db + "_" + sp_name + "_" + mode;
+            for (int i = 0; i < QueryTrace::kStageCnt; i++) {
+                ptr->stages.emplace_back(new bvar::LatencyRecorder(
+                    ptr->prefix + "_" + QueryTrace::StageName(static_cast<QueryTrace::Stage>(i))));
+            }
+        }
+        recorders = ptr;
+    }
+    for (int i = 0; i < QueryTrace::kStageCnt; i++) {
+        *recorders->stages[i] << trace.GetStageTime(static_cast<QueryTrace::Stage>(i));
+    }
+    std::lock_guard<std::mutex> lock(recorders->mu);
+    for (const auto& node : trace.GetRunnerTrace().nodes) {
+        auto& recorder = recorders->runners[node.id];
+        if (!recorder) {
+            recorder.reset(new bvar::LatencyRecorder(recorders->prefix + "_runner_" + std::to_string(node.id) + "_" +
+                                                     boost::to_lower_copy(node.name)));
+        }
+        *recorder << node.time_us;
+    }
+}
+
+void ProcedureTraceStat::Remove(const std::string& db, const std::string& sp_name) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto iter = stats_.find(db);
+    if (iter != stats_.end()) {
+        iter->second.erase(sp_name);
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_QUERY_TRACE_H_
+#define SRC_TABLET_QUERY_TRACE_H_
+
+#include <bvar/latency_recorder.h>
+
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "vm/engine.h"
+
+namespace openmldb {
+namespace tablet {
+
+// the time of each stage of one query in request or batch request mode
+class QueryTrace {
+ public:
+    enum Stage {
+        kCompile = 0,
+        kDecode,
+        kRun,
+        kEncode,
+        kStageCnt,
+    };
+
+    QueryTrace();
+
+    // add the time since the former call or the construction to the stage
+    void EndStage(Stage stage);
+
+    uint64_t GetStageTime(Stage stage) const { return stage_us_[stage]; }
+
+    uint64_t GetTotalTime() const;
+
+    // the time of each runner is collected by the run session
+    ::hybridse::vm::RunnerTrace* GetRunnerTrace() { return &runner_trace_; }
+
+    const ::hybridse::vm::RunnerTrace& GetRunnerTrace() const { return runner_trace_; }
+
+    // the stages followed by the runners in the descending order of time
+    std::string ToString() const;
+
+    static const char* StageName(Stage stage);
+
+ private:
+    uint64_t last_us_;
+    uint64_t stage_us_[kStageCnt];
+    ::hybridse::vm::RunnerTrace runner_trace_;
+};
+
+// aggregate the traces of procedures into latency recorders exposed by the builtin /vars service, named
+// procedure_<db>_<sp>_<mode>_<stage> and procedure_<db>_<sp>_<mode>_runner_<id>_<runner type>
+class ProcedureTraceStat {
+ public:
+    ProcedureTraceStat() : mu_(), stats_() {}
+
+    // mode is request or batch_request, whose plans have different runners
+    void Add(const std::string& db, const std::string& sp_name, const std::string& mode, const QueryTrace& trace);
+
+    void Remove(const std::string& db, const std::string& sp_name);
+
+ private:
+    struct Recorders {
+        std::string prefix;
+        std::vector<std::unique_ptr<bvar::LatencyRecorder>> stages;
+        std::mutex mu;
+        std::map<int32_t, std::unique_ptr<bvar::LatencyRecorder>> runners;
+    };
+
+    std::mutex mu_;
+    // key is db, sp name and mode
+    std::map<std::string, std::map<std::string, std::map<std::string, std::shared_ptr<Recorders>>>> stats_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+#endif  // SRC_TABLET_QUERY_TRACE_H_
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/query_trace.h"
+
+#include <unistd.h>
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace tablet {
+
+class QueryTraceTest : public ::testing::Test {
+ public:
+    QueryTraceTest() {}
+    ~QueryTraceTest() {}
+};
+
+TEST_F(QueryTraceTest, Stage) {
+    QueryTrace trace;
+    usleep(2000);
+    trace.EndStage(QueryTrace::kCompile);
+    trace.EndStage(QueryTrace::kDecode);
+    usleep(2000);
+    trace.EndStage(QueryTrace::kRun);
+    ASSERT_GE(trace.GetStageTime(QueryTrace::kCompile), 2000u);
+    ASSERT_LT(trace.GetStageTime(QueryTrace::kDecode), 2000u);
+    ASSERT_GE(trace.GetStageTime(QueryTrace::kRun), 2000u);
+    ASSERT_EQ(0u, trace.GetStageTime(QueryTrace::kEncode));
+    ASSERT_EQ(trace.GetStageTime(QueryTrace::kCompile) + trace.GetStageTime(QueryTrace::kDecode) +
+                  trace.GetStageTime(QueryTrace::kRun),
+              trace.GetTotalTime());
+
+    auto* runner_trace = trace.GetRunnerTrace();
+    runner_trace->Add(3, "WINDOW_AGG", 10);
+    runner_trace->Add(5, "REQUEST_UNION", 30);
+    runner_trace->Add(3, "WINDOW_AGG", 40);
+    ASSERT_EQ(2u, runner_trace->nodes.size());
+    ASSERT_EQ(80u, runner_trace->total_us);
+    ASSERT_EQ(50u, runner_trace->nodes[0].time_us);
+    ASSERT_EQ(2u, runner_trace->nodes[0].run_cnt);
+    // the slowest runner comes first
+    std::string str = trace.ToString();
+    ASSERT_NE(std::string::npos, str.find("runners: [3]WINDOW_AGG 50us/2 [5]REQUEST_UNION 30us"));
+}
+
+TEST_F(QueryTraceTest, ProcedureStat) {
+    ProcedureTraceStat stat;
+    QueryTrace trace;
+    trace.EndStage(QueryTrace::kRun);
+    trace.GetRunnerTrace()->Add(7, "WINDOW_AGG", 10);
+    stat.Add("db1", "sp1", "request", trace);
+    stat.Add("db1", "sp1", "request", trace);
+    std::ostringstream oss;
+    ASSERT_EQ(0, bvar::Variable::describe_exposed("procedure_db1_sp1_request_run_count", oss));
+    ASSERT_EQ("2", oss.str());
+    oss.str("");
+    ASSERT_EQ(0, bvar::Variable::describe_exposed("procedure_db1_sp1_request_runner_7_window_agg_count", oss));
+    ASSERT_EQ("2", oss.str());
+    stat.Remove("db1", "sp1");
+    ASSERT_NE(0, bvar::Variable::describe_exposed("procedure_db1_sp1_request_run_count", oss));
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
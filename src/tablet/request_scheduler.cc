@@ -0,0 +1,182 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/request_scheduler.h"
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+
+#include "common/timer.h"
+
+namespace openmldb {
+namespace tablet {
+
+// the queueing time is checked against the target once an interval
+constexpr uint64_t SHED_INTERVAL_US = 100 * 1000;
+// the waiting requests check the max wait at least once a slice
+constexpr uint64_t WAIT_SLICE_US = 10 * 1000;
+
+static uint32_t GetQueueDepth(void* arg) {
+    return static_cast<std::atomic<uint32_t>*>(arg)->load(std::memory_order_relaxed);
+}
+
+RequestScheduler::RequestScheduler()
+    : enable_(false), mu_(), max_concurrency_(0), running_(0), queue_target_us_(0), max_wait_us_(0), states_() {
+    for (int i = 0; i < kRequestClassCnt; i++) {
+        auto& state = states_[i];
+        std::string prefix = std::string("request_scheduler_") + ClassName(static_cast<RequestClass>(i));
+        state.queue_depth.reset(new bvar::PassiveStatus<uint32_t>(prefix + "_queue_depth", GetQueueDepth,
+                                                                   &state.waiting));
+        state.wait_time.reset(new bvar::LatencyRecorder(prefix + "_wait"));
+        state.shed_cnt.reset(new bvar::Adder<uint64_t>(prefix + "_shed"));
+    }
+}
+
+const char* RequestScheduler::ClassName(RequestClass cls) {
+    switch (cls) {
+        case kOnlineQuery:
+            return "online_query";
+        case kOnlinePut:
+            return "online_put";
+        case kReplication:
+            return "replication";
+        case kBatchScan:
+            return "batch_scan";
+        case kMaintenance:
+            return "maintenance";
+        default:
+            return "unknown";
+    }
+}
+
+void RequestScheduler::SetMaxConcurrency(uint32_t max_concurrency) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    max_concurrency_ = max_concurrency;
+    for (auto& state : states_) {
+        state.cv.notify_all();
+    }
+}
+
+void RequestScheduler::SetLimit(RequestClass cls, uint32_t limit) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    states_[cls].limit = limit;
+    for (auto& state : states_) {
+        state.cv.notify_all();
+    }
+}
+
+void RequestScheduler::SetQueueTarget(uint32_t target_ms) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    queue_target_us_ = target_ms * 1000ul;
+    for (auto& state : states_) {
+        state.overloaded = false;
+    }
+}
+
+void RequestScheduler::SetMaxWait(uint32_t max_wait_ms) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    max_wait_us_ = max_wait_ms * 1000ul;
+}
+
+bool RequestScheduler::CanRun(RequestClass cls) {
+    const auto& state = states_[cls];
+    if (state.limit > 0 && state.running >= state.limit) {
+        return false;
+    }
+    if (max_concurrency_ == 0) {
+        return true;
+    }
+    if (running_ >= max_concurrency_) {
+        return false;
+    }
+    // leave the free slots to the waiting requests of the higher classes
+    for (int i = 0; i < cls; i++) {
+        const auto& higher = states_[i];
+        bool higher_can_run = higher.limit == 0 || higher.running < higher.limit;
+        if (higher_can_run && higher.waiting.load(std::memory_order_relaxed) > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RequestScheduler::RecordWait(RequestClass cls, uint64_t wait_us, uint64_t cur_us) {
+    auto& state = states_[cls];
+    *state.wait_time << wait_us;
+    if (cur_us >= state.interval_end) {
+        // shed if even the fastest request of the last interval queued longer than the target
+        state.overloaded = queue_target_us_ > 0 && state.interval_min_wait != UINT64_MAX &&
+                           state.interval_min_wait > queue_target_us_;
+        state.interval_min_wait = wait_us;
+        state.interval_end = cur_us + SHED_INTERVAL_US;
+    } else {
+        state.interval_min_wait = std::min(state.interval_min_wait, wait_us);
+    }
+}
+
+bool RequestScheduler::Acquire(RequestClass cls, bool sheddable) {
+    uint64_t start_us = ::baidu::common::timer::get_micros();
+    std::unique_lock<bthread::Mutex> lock(mu_);
+    auto& state = states_[cls];
+    if (state.waiting.load(std::memory_order_relaxed) > 0 || !CanRun(cls)) {
+        if (sheddable && state.overloaded) {
+            *state.shed_cnt << 1;
+            return false;
+        }
+        state.waiting.fetch_add(1, std::memory_order_relaxed);
+        while (IsEnable() && !CanRun(cls)) {
+            uint64_t wait_us = ::baidu::common::timer::get_micros() - start_us;
+            if (sheddable && max_wait_us_ > 0 && wait_us >= max_wait_us_) {
+                state.waiting.fetch_sub(1, std::memory_order_relaxed);
+                *state.shed_cnt << 1;
+                RecordWait(cls, wait_us, start_us + wait_us);
+                // the lower classes may be blocked by this request
+                for (auto& other : states_) {
+                    other.cv.notify_all();
+                }
+                return false;
+            }
+            state.cv.wait_for(lock, WAIT_SLICE_US);
+        }
+        state.waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+    uint64_t cur_us = ::baidu::common::timer::get_micros();
+    RecordWait(cls, cur_us - start_us, cur_us);
+    state.running++;
+    running_++;
+    return true;
+}
+
+void RequestScheduler::Release(RequestClass cls) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    states_[cls].running--;
+    running_--;
+    for (auto& state : states_) {
+        if (state.waiting.load(std::memory_order_relaxed) > 0) {
+            state.cv.notify_all();
+        }
+    }
+}
+
+uint32_t RequestScheduler::GetRunning(RequestClass cls) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    return states_[cls].running;
+}
+
+uint32_t RequestScheduler::GetWaiting(RequestClass cls) { return states_[cls].waiting.load(std::memory_order_relaxed); }
+
+}  // namespace tablet
+}  // namespace openmldb
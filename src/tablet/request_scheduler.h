@@ -0,0 +1,153 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_REQUEST_SCHEDULER_H_
+#define SRC_TABLET_REQUEST_SCHEDULER_H_
+
+#include <bthread/condition_variable.h>
+#include <bthread/mutex.h>
+#include <bvar/bvar.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace openmldb {
+namespace tablet {
+
+// in the descending order of priority
+enum RequestClass {
+    kOnlineQuery = 0,
+    kOnlinePut,
+    kReplication,
+    kBatchScan,
+    kMaintenance,
+    kRequestClassCnt,
+};
+
+// admission control of the requests of tablet. each class has its own concurrency limit, and the classes share
+// the max concurrency, under which the waiting requests of a higher class are admitted first. if the queueing
+// time of a class stays above the target during an interval, the requests of the class that have to wait are
+// shed until the queueing time falls back
+class RequestScheduler {
+ public:
+    RequestScheduler();
+
+    void SetEnable(bool enable) { enable_.store(enable, std::memory_order_relaxed); }
+
+    bool IsEnable() const { return enable_.load(std::memory_order_relaxed); }
+
+    // 0 means unlimited
+    void SetMaxConcurrency(uint32_t max_concurrency);
+
+    // 0 means unlimited
+    void SetLimit(RequestClass cls, uint32_t limit);
+
+    // 0 disables shedding
+    void SetQueueTarget(uint32_t target_ms);
+
+    // the waiting requests give up after the time, 0 means waiting forever
+    void SetMaxWait(uint32_t max_wait_ms);
+
+    // return false if the request is shed. the requests of background tasks, which can not be retried by the
+    // client, are not sheddable and only wait
+    bool Acquire(RequestClass cls, bool sheddable = true);
+
+    void Release(RequestClass cls);
+
+    uint32_t GetRunning(RequestClass cls);
+
+    uint32_t GetWaiting(RequestClass cls);
+
+    static const char* ClassName(RequestClass cls);
+
+ private:
+    struct ClassState {
+        uint32_t limit = 0;
+        uint32_t running = 0;
+        // read by the queue depth without lock
+        std::atomic<uint32_t> waiting{0};
+        // the min queueing time of the current interval
+        uint64_t interval_min_wait = UINT64_MAX;
+        uint64_t interval_end = 0;
+        bool overloaded = false;
+        bthread::ConditionVariable cv;
+        std::unique_ptr<bvar::PassiveStatus<uint32_t>> queue_depth;
+        std::unique_ptr<bvar::LatencyRecorder> wait_time;
+        std::unique_ptr<bvar::Adder<uint64_t>> shed_cnt;
+    };
+
+    // the request of the class can run now
+    bool CanRun(RequestClass cls);
+
+    void RecordWait(RequestClass cls, uint64_t wait_us, uint64_t cur_us);
+
+    std::atomic<bool> enable_;
+    bthread::Mutex mu_;
+    uint32_t max_concurrency_;
+    uint32_t running_;
+    uint64_t queue_target_us_;
+    uint64_t max_wait_us_;
+    ClassState states_[kRequestClassCnt];
+};
+
+// acquire the scheduler on construction and release it on destruction
+class ScheduleGuard {
+ public:
+    // scheduler can be null
+    ScheduleGuard(RequestScheduler* scheduler, RequestClass cls, bool sheddable = true)
+        : scheduler_(scheduler), cls_(cls), acquired_(false) {
+        if (scheduler_ != nullptr && scheduler_->IsEnable()) {
+            acquired_ = scheduler_->Acquire(cls_, sheddable);
+            admitted_ = acquired_;
+        } else {
+            admitted_ = true;
+        }
+    }
+
+    ~ScheduleGuard() {
+        if (acquired_) {
+            scheduler_->Release(cls_);
+        }
+    }
+
+    bool Admitted() const { return admitted_; }
+
+    // give the slot to the other requests while waiting for something else than the table, e.g. a slow client
+    void Suspend() {
+        if (acquired_) {
+            scheduler_->Release(cls_);
+            acquired_ = false;
+        }
+    }
+
+    // take the slot again after Suspend. the request has run already, so it waits instead of being shed
+    void Resume() {
+        if (!acquired_ && admitted_ && scheduler_ != nullptr && scheduler_->IsEnable()) {
+            acquired_ = scheduler_->Acquire(cls_, false);
+        }
+    }
+
+ private:
+    RequestScheduler* scheduler_;
+    RequestClass cls_;
+    bool acquired_;
+    bool admitted_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+#endif  // SRC_TABLET_REQUEST_SCHEDULER_H_
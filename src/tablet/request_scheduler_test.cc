@@ -0,0 +1,177 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/request_scheduler.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace tablet {
+
+class RequestSchedulerTest : public ::testing::Test {
+ public:
+    RequestSchedulerTest() {}
+    ~RequestSchedulerTest() {}
+};
+
+static void WaitFor(RequestScheduler* scheduler, RequestClass cls, uint32_t waiting) {
+    while (scheduler->GetWaiting(cls) != waiting) {
+        usleep(1000);
+    }
+}
+
+TEST_F(RequestSchedulerTest, Disabled) {
+    RequestScheduler scheduler;
+    scheduler.SetLimit(kBatchScan, 1);
+    ScheduleGuard guard1(&scheduler, kBatchScan);
+    ScheduleGuard guard2(&scheduler, kBatchScan);
+    ASSERT_TRUE(guard1.Admitted());
+    ASSERT_TRUE(guard2.Admitted());
+    ASSERT_EQ(0u, scheduler.GetRunning(kBatchScan));
+    ScheduleGuard guard3(nullptr, kBatchScan);
+    ASSERT_TRUE(guard3.Admitted());
+}
+
+TEST_F(RequestSchedulerTest, ClassLimit) {
+    RequestScheduler scheduler;
+    scheduler.SetEnable(true);
+    scheduler.SetLimit(kBatchScan, 1);
+    ASSERT_TRUE(scheduler.Acquire(kBatchScan));
+    // the other classes are not limited
+    ASSERT_TRUE(scheduler.Acquire(kOnlineQuery));
+    ASSERT_TRUE(scheduler.Acquire(kOnlineQuery));
+    std::atomic<bool> admitted(false);
+    std::thread t([&] {
+        admitted = scheduler.Acquire(kBatchScan);
+        scheduler.Release(kBatchScan);
+    });
+    WaitFor(&scheduler, kBatchScan, 1);
+    ASSERT_FALSE(admitted);
+    scheduler.Release(kBatchScan);
+    t.join();
+    ASSERT_TRUE(admitted);
+    ASSERT_EQ(0u, scheduler.GetRunning(kBatchScan));
+    ASSERT_EQ(2u, scheduler.GetRunning(kOnlineQuery));
+}
+
+TEST_F(RequestSchedulerTest, SuspendGuard) {
+    RequestScheduler scheduler;
+    scheduler.SetEnable(true);
+    scheduler.SetLimit(kBatchScan, 1);
+    ScheduleGuard guard(&scheduler, kBatchScan, false);
+    ASSERT_TRUE(guard.Admitted());
+    ASSERT_EQ(1u, scheduler.GetRunning(kBatchScan));
+    // the other scan runs while the guard is suspended
+    guard.Suspend();
+    ASSERT_EQ(0u, scheduler.GetRunning(kBatchScan));
+    ASSERT_TRUE(scheduler.Acquire(kBatchScan));
+    std::atomic<bool> resumed(false);
+    std::thread t([&] {
+        guard.Resume();
+        resumed = true;
+    });
+    WaitFor(&scheduler, kBatchScan, 1);
+    ASSERT_FALSE(resumed);
+    scheduler.Release(kBatchScan);
+    t.join();
+    ASSERT_TRUE(resumed);
+    ASSERT_EQ(1u, scheduler.GetRunning(kBatchScan));
+}
+
+TEST_F(RequestSchedulerTest, Priority) {
+    RequestScheduler scheduler;
+    scheduler.SetEnable(true);
+    scheduler.SetMaxConcurrency(1);
+    ASSERT_TRUE(scheduler.Acquire(kMaintenance, false));
+    std::vector<RequestClass> order;
+    std::mutex mu;
+    auto run = [&](RequestClass cls) {
+        ASSERT_TRUE(scheduler.Acquire(cls));
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            order.push_back(cls);
+        }
+        scheduler.Release(cls);
+    };
+    std::thread t1(run, kBatchScan);
+    WaitFor(&scheduler, kBatchScan, 1);
+    std::thread t2(run, kOnlineQuery);
+    WaitFor(&scheduler, kOnlineQuery, 1);
+    scheduler.Release(kMaintenance);
+    t1.join();
+    t2.join();
+    // the online query comes later but runs first
+    ASSERT_EQ(2u, order.size());
+    ASSERT_EQ(kOnlineQuery, order[0]);
+    ASSERT_EQ(kBatchScan, order[1]);
+}
+
+TEST_F(RequestSchedulerTest, MaxWait) {
+    RequestScheduler scheduler;
+    scheduler.SetEnable(true);
+    scheduler.SetLimit(kOnlinePut, 1);
+    scheduler.SetMaxWait(20);
+    ASSERT_TRUE(scheduler.Acquire(kOnlinePut));
+    ASSERT_FALSE(scheduler.Acquire(kOnlinePut));
+    ASSERT_EQ(0u, scheduler.GetWaiting(kOnlinePut));
+    scheduler.Release(kOnlinePut);
+    ASSERT_TRUE(scheduler.Acquire(kOnlinePut));
+    scheduler.Release(kOnlinePut);
+}
+
+TEST_F(RequestSchedulerTest, Shed) {
+    RequestScheduler scheduler;
+    scheduler.SetEnable(true);
+    scheduler.SetLimit(kBatchScan, 1);
+    scheduler.SetQueueTarget(5);
+    ASSERT_TRUE(scheduler.Acquire(kBatchScan));
+    // each request queues far longer than the target for more than one interval
+    for (int i = 0; i < 2; i++) {
+        std::thread t([&] { ASSERT_TRUE(scheduler.Acquire(kBatchScan)); });
+        WaitFor(&scheduler, kBatchScan, 1);
+        usleep(150 * 1000);
+        scheduler.Release(kBatchScan);
+        t.join();
+    }
+    // shed at once instead of queueing
+    ASSERT_FALSE(scheduler.Acquire(kBatchScan));
+    // the requests which need not wait are still admitted
+    scheduler.Release(kBatchScan);
+    ASSERT_TRUE(scheduler.Acquire(kBatchScan));
+    scheduler.Release(kBatchScan);
+    // non sheddable requests only wait
+    ASSERT_TRUE(scheduler.Acquire(kBatchScan));
+    std::thread t([&] { ASSERT_TRUE(scheduler.Acquire(kBatchScan, false)); });
+    WaitFor(&scheduler, kBatchScan, 1);
+    scheduler.Release(kBatchScan);
+    t.join();
+    scheduler.Release(kBatchScan);
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -17,10 +17,20 @@
 #ifndef SRC_TABLET_SP_CACHE_H_
 #define SRC_TABLET_SP_CACHE_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <utility>
+#include <vector>
+
+#include "base/hash.h"
+#include "base/lru_cache.h"
+#include "base/spinlock.h"
+#include "butil/iobuf.h"
+#include "bvar/reducer.h"
+#include "common/timer.h"
 #include "vm/engine.h"
 
 namespace openmldb {
@@ -28,16 +38,132 @@ namespace tablet {
 
 using ::openmldb::base::SpinMutex;
 
+constexpr uint32_t KEY_VERSION_BUCKET_CNT = 1 << 16;
+
+// the version of a key is the sequence of the last put or delete to it. keys are hashed into a fixed number of
+// buckets, so a change of one key may invalidate the results which read another key of the same bucket
+class KeyVersionTable {
+ public:
+    explicit KeyVersionTable(uint32_t bucket_cnt = KEY_VERSION_BUCKET_CNT)
+        : seq_(0), versions_(bucket_cnt == 0 ? 1 : bucket_cnt) {}
+
+    uint64_t GetSeq() const { return seq_.load(std::memory_order_acquire); }
+
+    // call it after the key is changed
+    void Update(uint64_t key_hash) {
+        uint64_t seq = seq_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        auto& version = versions_[key_hash % versions_.size()];
+        uint64_t cur = version.load(std::memory_order_acquire);
+        while (cur < seq && !version.compare_exchange_weak(cur, seq, std::memory_order_acq_rel)) {
+        }
+    }
+
+    // whether none of the keys is changed after the sequence
+    bool Unchanged(const std::vector<uint64_t>& key_hashes, uint64_t seq) const {
+        for (uint64_t key_hash : key_hashes) {
+            if (versions_[key_hash % versions_.size()].load(std::memory_order_acquire) > seq) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+ private:
+    std::atomic<uint64_t> seq_;
+    std::vector<std::atomic<uint64_t>> versions_;
+};
+
+// the output rows of a procedure in request mode keyed by the encoded request row. a result is dropped once it is
+// older than the ttl or one of the keys read by its run is changed
+class ProcedureResultCache {
+ public:
+    ProcedureResultCache(const std::string& db, const std::string& sp_name, uint32_t capacity, uint64_t ttl_ms,
+                         std::shared_ptr<KeyVersionTable> key_versions)
+        : ttl_ms_(ttl_ms),
+          key_versions_(key_versions),
+          mu_(),
+          results_(capacity == 0 ? 1 : capacity),
+          hit_cnt_("procedure_" + db + "_" + sp_name + "_result_cache_hit"),
+          miss_cnt_("procedure_" + db + "_" + sp_name + "_result_cache_miss") {}
+
+    // append the cached output row to buf and return true if there is a valid one
+    bool Get(const std::string& request_row, butil::IOBuf* buf, uint32_t* byte_size) {
+        uint64_t hash = ::openmldb::base::MurmurHash64A(request_row.c_str(), request_row.size(), 0xe17a1465);
+        std::shared_ptr<Result> result;
+        {
+            std::lock_guard<SpinMutex> spin_lock(mu_);
+            auto cached = results_.get(hash);
+            if (cached) {
+                result = *cached;
+            }
+        }
+        uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+        if (result && result->request_row == request_row && result->expire_time > cur_time &&
+            key_versions_->Unchanged(result->key_hashes, result->seq)) {
+            buf->append(result->output);
+            *byte_size = result->byte_size;
+            hit_cnt_ << 1;
+            return true;
+        }
+        miss_cnt_ << 1;
+        return false;
+    }
+
+    // seq is the sequence of key versions before the run which reads the keys
+    void Put(const std::string& request_row, const butil::IOBuf& output, uint32_t byte_size,
+             const std::vector<uint64_t>& key_hashes, uint64_t seq) {
+        if (!key_versions_->Unchanged(key_hashes, seq)) {
+            // the output may be stale already
+            return;
+        }
+        uint64_t hash = ::openmldb::base::MurmurHash64A(request_row.c_str(), request_row.size(), 0xe17a1465);
+        auto result = std::make_shared<Result>();
+        result->request_row = request_row;
+        result->output = output;
+        result->byte_size = byte_size;
+        result->key_hashes = key_hashes;
+        result->seq = seq;
+        result->expire_time = static_cast<uint64_t>(::baidu::common::timer::get_micros() / 1000) + ttl_ms_;
+        std::lock_guard<SpinMutex> spin_lock(mu_);
+        // a result is immutable once cached, since Get reads it out of the lock. insert does not overwrite the key
+        results_.erase(hash);
+        results_.insert(hash, result);
+    }
+
+    uint64_t GetHitCnt() const { return hit_cnt_.get_value(); }
+    uint64_t GetMissCnt() const { return miss_cnt_.get_value(); }
+
+ private:
+    struct Result {
+        std::string request_row;
+        butil::IOBuf output;
+        uint32_t byte_size;
+        std::vector<uint64_t> key_hashes;
+        uint64_t seq;
+        uint64_t expire_time;
+    };
+
+    uint64_t ttl_ms_;
+    std::shared_ptr<KeyVersionTable> key_versions_;
+    SpinMutex mu_;
+    ::hybridse::base::LruCache<uint64_t, std::shared_ptr<Result>> results_;
+    bvar::Adder<uint64_t> hit_cnt_;
+    bvar::Adder<uint64_t> miss_cnt_;
+};
+
 // tablet cache entry for sql procedure
 struct SQLProcedureCacheEntry {
     std::shared_ptr<hybridse::sdk::ProcedureInfo> procedure_info;
     std::shared_ptr<hybridse::vm::CompileInfo> request_info;
     std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info;
+    // null if the result cache is not enabled for the procedure
+    std::shared_ptr<ProcedureResultCache> result_cache;
 
     SQLProcedureCacheEntry(const std::shared_ptr<hybridse::sdk::ProcedureInfo> pinfo,
                            std::shared_ptr<hybridse::vm::CompileInfo> rinfo,
-                           std::shared_ptr<hybridse::vm::CompileInfo> brinfo)
-        : procedure_info(pinfo), request_info(rinfo), batch_request_info(brinfo) {}
+                           std::shared_ptr<hybridse::vm::CompileInfo> brinfo,
+                           std::shared_ptr<ProcedureResultCache> result_cache)
+        : procedure_info(pinfo), request_info(rinfo), batch_request_info(brinfo), result_cache(result_cache) {}
 };
 
 class SpCache : public hybridse::vm::CompileInfoCache {
@@ -47,11 +173,12 @@ class SpCache : public hybridse::vm::CompileInfoCache {
     void InsertSQLProcedureCacheEntry(const std::string& db, const std::string& sp_name,
                                       std::shared_ptr<hybridse::sdk::ProcedureInfo> procedure_info,
                                       std::shared_ptr<hybridse::vm::CompileInfo> request_info,
-                                      std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info) {
+                                      std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info,
+                                      std::shared_ptr<ProcedureResultCache> result_cache = nullptr) {
         std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
         auto& sp_map_of_db = db_sp_map_[db];
-        sp_map_of_db.insert(
-            std::make_pair(sp_name, SQLProcedureCacheEntry(procedure_info, request_info, batch_request_info)));
+        sp_map_of_db.insert(std::make_pair(
+            sp_name, SQLProcedureCacheEntry(procedure_info, request_info, batch_request_info, result_cache)));
     }
 
     void DropSQLProcedureCacheEntry(const std::string& db, const std::string& sp_name) {
@@ -110,6 +237,18 @@ class SpCache : public hybridse::vm::CompileInfoCache {
         }
         return sp_it->second.batch_request_info;
     }
+    std::shared_ptr<ProcedureResultCache> GetResultCache(const std::string& db, const std::string& sp_name) {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        auto db_it = db_sp_map_.find(db);
+        if (db_it == db_sp_map_.end()) {
+            return std::shared_ptr<ProcedureResultCache>();
+        }
+        auto sp_it = db_it->second.find(sp_name);
+        if (sp_it == db_it->second.end()) {
+            return std::shared_ptr<ProcedureResultCache>();
+        }
+        return sp_it->second.result_cache;
+    }
 
  private:
     std::map<std::string, std::map<std::string, SQLProcedureCacheEntry>> db_sp_map_;
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/sp_cache.h"
+
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace tablet {
+
+class SpCacheTest : public ::testing::Test {
+ public:
+    SpCacheTest() {}
+    ~SpCacheTest() {}
+};
+
+TEST_F(SpCacheTest, KeyVersion) {
+    KeyVersionTable versions(16);
+    uint64_t seq = versions.GetSeq();
+    ASSERT_TRUE(versions.Unchanged({1, 2, 3}, seq));
+    versions.Update(2);
+    ASSERT_FALSE(versions.Unchanged({1, 2, 3}, seq));
+    ASSERT_TRUE(versions.Unchanged({1, 3}, seq));
+    // the keys of the same bucket share one version
+    ASSERT_FALSE(versions.Unchanged({18}, seq));
+    ASSERT_TRUE(versions.Unchanged({1, 2, 3}, versions.GetSeq()));
+}
+
+TEST_F(SpCacheTest, ResultCache) {
+    auto versions = std::make_shared<KeyVersionTable>(1024);
+    ProcedureResultCache cache("db1", "sp1", 2, 100, versions);
+    butil::IOBuf buf;
+    uint32_t byte_size = 0;
+    ASSERT_FALSE(cache.Get("row1", &buf, &byte_size));
+
+    butil::IOBuf output;
+    output.append("output1");
+    cache.Put("row1", output, 7, {1, 2}, versions->GetSeq());
+    ASSERT_TRUE(cache.Get("row1", &buf, &byte_size));
+    ASSERT_EQ("output1", buf.to_string());
+    ASSERT_EQ(7u, byte_size);
+    ASSERT_FALSE(cache.Get("row2", &buf, &byte_size));
+    ASSERT_EQ(1u, cache.GetHitCnt());
+    ASSERT_EQ(2u, cache.GetMissCnt());
+
+    // a put to the read keys invalidates the result
+    versions->Update(2);
+    ASSERT_FALSE(cache.Get("row1", &buf, &byte_size));
+    // the key is changed during the run, the output may be stale
+    uint64_t seq = versions->GetSeq();
+    versions->Update(1);
+    cache.Put("row1", output, 7, {1, 2}, seq);
+    ASSERT_FALSE(cache.Get("row1", &buf, &byte_size));
+    cache.Put("row1", output, 7, {1, 2}, versions->GetSeq());
+    ASSERT_TRUE(cache.Get("row1", &buf, &byte_size));
+
+    // a new result of the same row replaces the cached one
+    butil::IOBuf output2;
+    output2.append("output2");
+    cache.Put("row1", output2, 7, {1, 2}, versions->GetSeq());
+    butil::IOBuf buf2;
+    ASSERT_TRUE(cache.Get("row1", &buf2, &byte_size));
+    ASSERT_EQ("output2", buf2.to_string());
+
+    // the least recently used result is evicted
+    cache.Put("row2", output, 7, {}, versions->GetSeq());
+    cache.Put("row3", output, 7, {}, versions->GetSeq());
+    ASSERT_FALSE(cache.Get("row1", &buf, &byte_size));
+    ASSERT_TRUE(cache.Get("row3", &buf, &byte_size));
+
+    // expired by ttl
+    usleep(150 * 1000);
+    ASSERT_FALSE(cache.Get("row3", &buf, &byte_size));
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -37,14 +37,18 @@
 #ifdef TCMALLOC_ENABLE
 #include "gperftools/malloc_extension.h"
 #endif
+#include "base/endianconv.h"
 #include "base/file_util.h"
 #include "base/glog_wapper.h"
 #include "base/hash.h"
+#include "base/numa.h"
 #include "base/status.h"
 #include "base/strings.h"
 #include "brpc/controller.h"
 #include "butil/iobuf.h"
+#include "butil/time.h"
 #include "catalog/schema_adapter.h"
+#include "client/stream_kv_iterator.h"
 #include "codec/codec.h"
 #include "codec/row_codec.h"
 #include "codec/sql_rpc_row_codec.h"
@@ -52,6 +56,7 @@
 #include "glog/logging.h"
 #include "storage/binlog.h"
 #include "storage/segment.h"
+#include "storage/sharded_replayer.h"
 #include "tablet/file_sender.h"
 
 using google::protobuf::RepeatedPtrField;
@@ -62,8 +67,14 @@ using ::openmldb::storage::Table;
 
 DECLARE_int32(gc_interval);
 DECLARE_int32(gc_pool_size);
+DECLARE_uint32(gc_slice_key_num);
+DECLARE_uint32(gc_slice_free_num);
+DECLARE_uint32(gc_slice_time_us);
+DECLARE_uint32(gc_cpu_budget);
 DECLARE_int32(statdb_ttl);
 DECLARE_uint32(scan_max_bytes_size);
+DECLARE_uint32(scan_zero_copy_min_row_size);
+DECLARE_bool(enable_numa);
 DECLARE_uint32(scan_reserve_size);
 DECLARE_double(mem_release_rate);
 DECLARE_string(db_root_path);
@@ -94,6 +105,8 @@ DECLARE_int32(zk_keep_alive_check_interval);
 
 DECLARE_int32(binlog_sync_to_disk_interval);
 DECLARE_int32(binlog_delete_interval);
+DECLARE_bool(binlog_group_commit);
+DECLARE_uint32(binlog_group_commit_thread_num);
 DECLARE_uint32(absolute_ttl_max);
 DECLARE_uint32(latest_ttl_max);
 DECLARE_uint32(max_traverse_cnt);
@@ -101,7 +114,30 @@ DECLARE_uint32(snapshot_ttl_time);
 DECLARE_uint32(snapshot_ttl_check_interval);
 DECLARE_uint32(put_slow_log_threshold);
 DECLARE_uint32(query_slow_log_threshold);
+DECLARE_bool(enable_procedure_trace);
+DECLARE_string(procedure_result_cache_list);
+DECLARE_uint32(procedure_result_cache_ttl_ms);
+DECLARE_uint32(procedure_result_cache_capacity);
+DECLARE_bool(enable_request_scheduler);
+DECLARE_uint32(request_scheduler_max_concurrency);
+DECLARE_uint32(request_scheduler_online_query_limit);
+DECLARE_uint32(request_scheduler_online_put_limit);
+DECLARE_uint32(request_scheduler_replication_limit);
+DECLARE_uint32(request_scheduler_batch_scan_limit);
+DECLARE_uint32(request_scheduler_maintenance_limit);
+DECLARE_uint32(request_scheduler_queue_target_ms);
+DECLARE_uint32(request_scheduler_max_wait_ms);
 DECLARE_int32(snapshot_pool_size);
+DECLARE_uint32(replication_scheduler_thread_num);
+DECLARE_uint32(follower_apply_thread_num);
+DECLARE_uint32(stream_scan_chunk_size);
+DECLARE_int32(stream_scan_max_buf_size);
+DECLARE_int32(stream_scan_wait_timeout_ms);
+DECLARE_int32(stream_scan_write_timeout_ms);
+DECLARE_uint32(stream_scan_thread_num);
+DECLARE_string(jit_object_cache_dir);
+DECLARE_uint32(jit_object_cache_max_mb);
+DECLARE_bool(enable_tiered_compile);
 
 namespace openmldb {
 namespace tablet {
@@ -109,6 +145,100 @@ namespace tablet {
 static const std::string SERVER_CONCURRENCY_KEY = "server";  // NOLINT
 static const uint32_t SEED = 0xe17a1465;
 
+// the time before which all the records of a streaming scan/traverse started now must be consumed
+static int64_t StreamDeadline() { return butil::gettimeofday_us() + FLAGS_stream_scan_write_timeout_ms * 1000L; }
+
+// write one message to the stream and wait if the client has not consumed the former ones.
+// the slot of guard is released while waiting, so a slow client does not hold back the other scans,
+// and the wait gives up at deadline_us, so it does not hold the thread of stream_scan_pool_ either
+static bool WriteStream(brpc::StreamId stream, butil::IOBuf* msg, int64_t deadline_us, ScheduleGuard* guard = NULL) {
+    while (true) {
+        int ret = brpc::StreamWrite(stream, *msg);
+        if (ret == 0) {
+            msg->clear();
+            return true;
+        }
+        if (ret != EAGAIN) {
+            PDLOG(WARNING, "fail to write stream %lu. error %d", stream, ret);
+            return false;
+        }
+        int64_t now_us = butil::gettimeofday_us();
+        if (now_us >= deadline_us) {
+            PDLOG(WARNING, "fail to write stream %lu. the client is too slow", stream);
+            return false;
+        }
+        timespec due_time = butil::microseconds_to_timespec(
+            std::min(now_us + FLAGS_stream_scan_wait_timeout_ms * 1000L, deadline_us));
+        if (guard != NULL) {
+            guard->Suspend();
+        }
+        ret = brpc::StreamWait(stream, &due_time);
+        if (guard != NULL) {
+            guard->Resume();
+        }
+        if (ret != 0) {
+            PDLOG(WARNING, "fail to wait stream %lu. error %d", stream, ret);
+            return false;
+        }
+    }
+}
+
+// send the end message with the return code and close the stream
+static void CloseStream(brpc::StreamId stream, int32_t code, const std::string& msg, int64_t deadline_us) {
+    butil::IOBuf buf;
+    buf.push_back(::openmldb::client::kStreamEnd);
+    int32_t value = code;
+    memrev32ifbe(&value);
+    buf.append(&value, sizeof(value));
+    buf.append(msg);
+    WriteStream(stream, &buf, deadline_us);
+    brpc::StreamClose(stream);
+}
+
+// drop the pin of the block of the data referenced by a response
+static void UnpinDataBlock(void* data) {
+    ::openmldb::storage::DataBlock::Unpin(::openmldb::storage::DataBlock::FromData(static_cast<const char*>(data)));
+}
+
+// append the row data of the block. the buf references a large row instead of copying it if the block can be
+// pinned until the buf is released. block is null if it can not be pinned
+static void AppendRowData(::openmldb::storage::DataBlock* block, const char* data, uint32_t size,
+                          butil::IOBuf* buf) {
+    if (block != NULL && FLAGS_scan_zero_copy_min_row_size > 0 && size >= FLAGS_scan_zero_copy_min_row_size &&
+        block->Pin()) {
+        if (buf->append_user_data(block->data, block->size, UnpinDataBlock) == 0) {
+            return;
+        }
+        UnpinDataBlock(block->data);
+    }
+    buf->append(data, size);
+}
+
+// append a record encoded as the pairs of TraverseResponse, or ScanResponse if pk is null
+static void AppendStreamRecord(const std::string* pk, uint64_t ts, const char* data, uint32_t size,
+                               butil::IOBuf* buf, ::openmldb::storage::DataBlock* block = NULL) {
+    char header[16];
+    char* ptr = header;
+    uint32_t pk_size = pk == NULL ? 0 : pk->size();
+    uint32_t total_size = 8 + pk_size + size;
+    memcpy(ptr, static_cast<const void*>(&total_size), 4);
+    memrev32ifbe(ptr);
+    ptr += 4;
+    if (pk != NULL) {
+        memcpy(ptr, static_cast<const void*>(&pk_size), 4);
+        memrev32ifbe(ptr);
+        ptr += 4;
+    }
+    memcpy(ptr, static_cast<const void*>(&ts), 8);
+    memrev64ifbe(ptr);
+    ptr += 8;
+    buf->append(header, ptr - header);
+    if (pk != NULL) {
+        buf->append(*pk);
+    }
+    AppendRowData(block, data, size, buf);
+}
+
 TabletImpl::TabletImpl()
     : tables_(),
       mu_(),
@@ -120,6 +250,7 @@ TabletImpl::TabletImpl()
       task_pool_(FLAGS_task_pool_size),
       io_pool_(FLAGS_io_pool_size),
       snapshot_pool_(FLAGS_snapshot_pool_size),
+      stream_scan_pool_(FLAGS_stream_scan_thread_num),
       server_(NULL),
       mode_root_paths_(),
       mode_recycle_root_paths_(),
@@ -130,6 +261,15 @@ TabletImpl::TabletImpl()
       zk_path_(),
       endpoint_(),
       sp_cache_(std::shared_ptr<SpCache>(new SpCache())),
+      procedure_trace_stat_(),
+      key_versions_(),
+      result_cache_procedures_(),
+      request_scheduler_(),
+      numa_local_access_("tablet_numa_local_access"),
+      numa_remote_access_("tablet_numa_remote_access"),
+      rep_scheduler_(),
+      commit_pool_(),
+      apply_pool_(),
       notify_path_(),
       startup_mode_(::openmldb::type::StartupMode::kStandalone) {}
 
@@ -139,6 +279,10 @@ TabletImpl::~TabletImpl() {
     gc_pool_.Stop(true);
     io_pool_.Stop(true);
     snapshot_pool_.Stop(true);
+    stream_scan_pool_.Stop(true);
+    if (rep_scheduler_) {
+        rep_scheduler_->Stop();
+    }
     delete zk_client_;
 }
 
@@ -150,6 +294,9 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
                       const std::string& real_endpoint) {
     ::hybridse::vm::EngineOptions options;
     options.set_cluster_optimized(FLAGS_enable_distsql);
+    options.jit_options().set_object_cache_dir(FLAGS_jit_object_cache_dir);
+    options.jit_options().set_object_cache_max_size(static_cast<uint64_t>(FLAGS_jit_object_cache_max_mb) << 20);
+    options.set_enable_tiered_compile(FLAGS_enable_tiered_compile);
     engine_ = std::unique_ptr<::hybridse::vm::Engine>(new ::hybridse::vm::Engine(catalog_, options));
     catalog_->SetLocalTablet(
         std::shared_ptr<::hybridse::vm::Tablet>(new ::hybridse::vm::LocalTablet(engine_.get(), sp_cache_)));
@@ -168,6 +315,21 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     endpoint_ = endpoint;
     notify_path_ = zk_path + "/table/notify";
     sp_root_path_ = zk_path + "/store_procedure/db_sp_data";
+    if (!FLAGS_procedure_result_cache_list.empty()) {
+        std::vector<std::string> procedures;
+        ::openmldb::base::SplitString(FLAGS_procedure_result_cache_list, ",", procedures);
+        result_cache_procedures_.insert(procedures.begin(), procedures.end());
+        key_versions_ = std::make_shared<KeyVersionTable>();
+    }
+    request_scheduler_.SetMaxConcurrency(FLAGS_request_scheduler_max_concurrency);
+    request_scheduler_.SetLimit(kOnlineQuery, FLAGS_request_scheduler_online_query_limit);
+    request_scheduler_.SetLimit(kOnlinePut, FLAGS_request_scheduler_online_put_limit);
+    request_scheduler_.SetLimit(kReplication, FLAGS_request_scheduler_replication_limit);
+    request_scheduler_.SetLimit(kBatchScan, FLAGS_request_scheduler_batch_scan_limit);
+    request_scheduler_.SetLimit(kMaintenance, FLAGS_request_scheduler_maintenance_limit);
+    request_scheduler_.SetQueueTarget(FLAGS_request_scheduler_queue_target_ms);
+    request_scheduler_.SetMaxWait(FLAGS_request_scheduler_max_wait_ms);
+    request_scheduler_.SetEnable(FLAGS_enable_request_scheduler);
     ::openmldb::base::SplitString(FLAGS_db_root_path, ",", mode_root_paths_);
 
     ::openmldb::base::SplitString(FLAGS_recycle_bin_root_path, ",", mode_recycle_root_paths_);
@@ -194,6 +356,19 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
         return false;
     }
 
+    if (FLAGS_replication_scheduler_thread_num > 0) {
+        rep_scheduler_ =
+            std::make_shared<::openmldb::replica::ReplicationScheduler>(FLAGS_replication_scheduler_thread_num);
+        rep_scheduler_->Start();
+        PDLOG(INFO, "start replication scheduler with %u threads", FLAGS_replication_scheduler_thread_num);
+    }
+    if (FLAGS_binlog_group_commit) {
+        commit_pool_ = std::make_shared<ThreadPool>(FLAGS_binlog_group_commit_thread_num);
+    }
+    if (FLAGS_follower_apply_thread_num > 1) {
+        apply_pool_.reset(new ::openmldb::base::TaskPool(FLAGS_follower_apply_thread_num, 1024));
+    }
+
     if (!CreateMultiDir(mode_recycle_root_paths_)) {
         PDLOG(WARNING, "fail to create recycle bin root path %s", FLAGS_recycle_bin_root_path.c_str());
         return false;
@@ -487,6 +662,7 @@ void TabletImpl::Get(RpcController* controller, const ::openmldb::api::GetReques
             response->set_msg("table is loading");
             return;
         }
+        RecordNumaAccess(table);
         std::string index_name;
         if (request->has_idx_name() && request->idx_name().size() > 0) {
             index_name = request->idx_name();
@@ -560,6 +736,13 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         done->Run();
         return;
     }
+    ScheduleGuard schedule_guard(&request_scheduler_, kOnlinePut);
+    if (!schedule_guard.Admitted()) {
+        response->set_code(::openmldb::base::ReturnCode::kServerIsBusy);
+        response->set_msg("server is busy");
+        done->Run();
+        return;
+    }
     uint64_t start_time = ::baidu::common::timer::get_micros();
     std::shared_ptr<Table> table = GetTable(request->tid(), request->pid());
     if (!table) {
@@ -571,6 +754,7 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     }
     DLOG(INFO) << " request format_version " << request->format_version() << " request dimension size "
                << request->dimensions_size() << " request time " << request->time();
+    RecordNumaAccess(table);
     if ((!request->has_format_version() && table->GetTableMeta()->format_version() == 1) ||
         (request->has_format_version() && request->format_version() != table->GetTableMeta()->format_version())) {
         response->set_code(::openmldb::base::ReturnCode::kPutBadFormat);
@@ -597,27 +781,21 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         done->Run();
         return;
     }
+    if (request->dimensions_size() > 0 && CheckDimessionPut(request, table->GetIdxCnt()) != 0) {
+        response->set_code(::openmldb::base::ReturnCode::kInvalidDimensionParameter);
+        response->set_msg("invalid dimension parameter");
+        done->Run();
+        return;
+    }
+    std::shared_ptr<LogReplicator> replicator;
+    ::openmldb::api::LogEntry entry;
+    bool appended = IsDiskTable(table);
     bool ok = false;
-    if (request->dimensions_size() > 0) {
-        int32_t ret_code = CheckDimessionPut(request, table->GetIdxCnt());
-        if (ret_code != 0) {
-            response->set_code(::openmldb::base::ReturnCode::kInvalidDimensionParameter);
-            response->set_msg("invalid dimension parameter");
-            done->Run();
-            return;
-        }
-        if (request->ts_dimensions_size() > 0) {
-            DLOG(INFO) << "put data to tid " << request->tid() << " pid " << request->pid() << " with key "
-                       << request->dimensions(0).key() << " ts " << request->ts_dimensions(0).ts();
-            ok = table->Put(request->dimensions(), request->ts_dimensions(), request->value());
-        } else {
-            DLOG(INFO) << "put data to tid " << request->tid() << " pid " << request->pid() << " with key "
-                       << request->dimensions(0).key() << " ts " << request->time();
-
-            ok = table->Put(request->time(), request->value(), request->dimensions());
-        }
+    if (appended) {
+        replicator = GetReplicator(request->tid(), request->pid());
+        ok = PutToDiskTable(table, replicator, *request, &entry);
     } else {
-        ok = table->Put(request->pk(), request->time(), request->value().c_str(), request->value().size());
+        ok = PutToTable(table, *request);
     }
     if (!ok) {
         response->set_code(::openmldb::base::ReturnCode::kPutFailed);
@@ -627,25 +805,27 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     }
 
     response->set_code(::openmldb::base::ReturnCode::kOk);
-    std::shared_ptr<LogReplicator> replicator;
+    bool group_commit = false;
     do {
+        if (appended) {
+            break;
+        }
         replicator = GetReplicator(request->tid(), request->pid());
         if (!replicator) {
             PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", request->tid(), request->pid());
             break;
         }
-        ::openmldb::api::LogEntry entry;
-        entry.set_pk(request->pk());
-        entry.set_ts(request->time());
-        entry.set_value(request->value());
-        entry.set_term(replicator->GetLeaderTerm());
-        if (request->dimensions_size() > 0) {
-            entry.mutable_dimensions()->CopyFrom(request->dimensions());
+        BuildLogEntry(*request, replicator->GetLeaderTerm(), &entry);
+        if (replicator->IsGroupCommitEnabled()) {
+            // append after the slow log as request is released once done runs
+            group_commit = true;
+            break;
         }
-        if (request->ts_dimensions_size() > 0) {
-            entry.mutable_ts_dimensions()->CopyFrom(request->ts_dimensions());
+        if (!replicator->AppendEntry(entry)) {
+            PDLOG(WARNING, "fail to write binlog. tid %u, pid %u", request->tid(), request->pid());
+            response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+            response->set_msg("fail to write binlog");
         }
-        replicator->AppendEntry(entry);
     } while (false);
 
     uint64_t end_time = ::baidu::common::timer::get_micros();
@@ -666,6 +846,17 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         PDLOG(INFO, "slow log[put]. key %s time %lu. tid %u, pid %u", key.c_str(), end_time - start_time,
               request->tid(), request->pid());
     }
+    if (group_commit) {
+        // respond after the binlog is synced to disk, the commit task notifies replicate nodes
+        replicator->AppendEntryAsync(entry, [response, done](bool ok) {
+            if (!ok) {
+                response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+                response->set_msg("fail to sync binlog");
+            }
+            done->Run();
+        });
+        return;
+    }
     done->Run();
 
     if (replicator) {
@@ -675,6 +866,248 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     }
 }
 
+bool TabletImpl::PutToTable(const std::shared_ptr<Table>& table, const ::openmldb::api::PutRequest& row) {
+    bool ok = false;
+    if (row.dimensions_size() > 0) {
+        if (row.ts_dimensions_size() > 0) {
+            DLOG(INFO) << "put data to tid " << table->GetId() << " pid " << table->GetPid() << " with key "
+                       << row.dimensions(0).key() << " ts " << row.ts_dimensions(0).ts();
+            ok = table->Put(row.dimensions(), row.ts_dimensions(), row.value());
+        } else {
+            DLOG(INFO) << "put data to tid " << table->GetId() << " pid " << table->GetPid() << " with key "
+                       << row.dimensions(0).key() << " ts " << row.time();
+            ok = table->Put(row.time(), row.value(), row.dimensions());
+        }
+    } else {
+        ok = table->Put(row.pk(), row.time(), row.value().c_str(), row.value().size());
+    }
+    if (ok && key_versions_) {
+        UpdateKeyVersions(table, row.pk(), row.dimensions());
+    }
+    return ok;
+}
+
+bool TabletImpl::IsDiskTable(const std::shared_ptr<Table>& table) {
+    return table->GetTableMeta()->storage_mode() != ::openmldb::type::StorageMode::kMemory;
+}
+
+bool TabletImpl::PutToDiskTable(const std::shared_ptr<Table>& table, const std::shared_ptr<LogReplicator>& replicator,
+                                const ::openmldb::api::PutRequest& row, ::openmldb::api::LogEntry* entry) {
+    if (!replicator) {
+        PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", table->GetId(), table->GetPid());
+        return false;
+    }
+    BuildLogEntry(row, replicator->GetLeaderTerm(), entry);
+    // the rows of disk table are keyed by log index, so they are put when the index is assigned. the row
+    // is kept if the binlog fails to write after it, the same as the put of memory table
+    bool applied = false;
+    replicator->AppendEntry(*entry, [&table, &applied](const ::openmldb::api::LogEntry& cur) {
+        applied = table->Put(cur);
+        return applied;
+    });
+    if (applied && key_versions_) {
+        UpdateKeyVersions(table, row.pk(), row.dimensions());
+    }
+    return applied;
+}
+
+void TabletImpl::UpdateKeyVersions(
+    const std::shared_ptr<Table>& table, const std::string& pk,
+    const ::google::protobuf::RepeatedPtrField<::openmldb::api::Dimension>& dimensions) {
+    const std::string db = table->GetDB();
+    const std::string name = table->GetName();
+    // the reads of the whole table are invalidated by any put
+    key_versions_->Update(::openmldb::catalog::SeekKeyRecorder::Hash(db, name, ""));
+    if (dimensions.size() == 0) {
+        key_versions_->Update(::openmldb::catalog::SeekKeyRecorder::Hash(db, name, pk));
+        return;
+    }
+    for (const auto& dimension : dimensions) {
+        key_versions_->Update(::openmldb::catalog::SeekKeyRecorder::Hash(db, name, dimension.key()));
+    }
+}
+
+void TabletImpl::BuildLogEntry(const ::openmldb::api::PutRequest& row, uint64_t term,
+                               ::openmldb::api::LogEntry* entry) {
+    entry->set_pk(row.pk());
+    entry->set_ts(row.time());
+    entry->set_value(row.value());
+    entry->set_term(term);
+    if (row.dimensions_size() > 0) {
+        entry->mutable_dimensions()->CopyFrom(row.dimensions());
+    }
+    if (row.ts_dimensions_size() > 0) {
+        entry->mutable_ts_dimensions()->CopyFrom(row.ts_dimensions());
+    }
+}
+
+void TabletImpl::PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                          ::openmldb::api::PutBatchResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    response->set_put_cnt(0);
+    if (follower_.load(std::memory_order_relaxed)) {
+        response->set_code(::openmldb::base::ReturnCode::kIsFollowerCluster);
+        response->set_msg("is follower cluster");
+        return;
+    }
+    ScheduleGuard schedule_guard(&request_scheduler_, kOnlinePut);
+    if (!schedule_guard.Admitted()) {
+        response->set_code(::openmldb::base::ReturnCode::kServerIsBusy);
+        response->set_msg("server is busy");
+        return;
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint32_t tid = request->tid();
+    uint32_t pid = request->pid();
+    std::shared_ptr<Table> table = GetTable(tid, pid);
+    if (!table) {
+        PDLOG(WARNING, "table is not exist. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table is not exist");
+        return;
+    }
+    RecordNumaAccess(table);
+    if ((!request->has_format_version() && table->GetTableMeta()->format_version() == 1) ||
+        (request->has_format_version() && request->format_version() != table->GetTableMeta()->format_version())) {
+        response->set_code(::openmldb::base::ReturnCode::kPutBadFormat);
+        response->set_msg("put bad format");
+        return;
+    }
+    if (!table->IsLeader()) {
+        response->set_code(::openmldb::base::ReturnCode::kTableIsFollower);
+        response->set_msg("table is follower");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    // the whole batch is rejected if any row is invalid
+    for (const auto& row : request->rows()) {
+        if (row.time() == 0 && row.ts_dimensions_size() == 0) {
+            response->set_code(::openmldb::base::ReturnCode::kTsMustBeGreaterThanZero);
+            response->set_msg("ts must be greater than zero");
+            return;
+        }
+        if (row.dimensions_size() > 0 && CheckDimessionPut(&row, table->GetIdxCnt()) != 0) {
+            response->set_code(::openmldb::base::ReturnCode::kInvalidDimensionParameter);
+            response->set_msg("invalid dimension parameter");
+            return;
+        }
+    }
+    // put the rows of the same segment together. the sort is stable so the rows
+    // of the same key keep the request order
+    std::vector<uint32_t> order(request->rows_size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::shared_ptr<MemTable> mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    if (mem_table && mem_table->GetSegCnt() > 1) {
+        uint32_t seg_cnt = mem_table->GetSegCnt();
+        std::vector<uint32_t> seg_idx(order.size());
+        for (uint32_t i = 0; i < order.size(); i++) {
+            const auto& row = request->rows(i);
+            const std::string& key = row.dimensions_size() > 0 ? row.dimensions(0).key() : row.pk();
+            seg_idx[i] = ::openmldb::base::hash(key.c_str(), key.length(), SEED) % seg_cnt;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&seg_idx](uint32_t l, uint32_t r) { return seg_idx[l] < seg_idx[r]; });
+    }
+    std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
+    if (!replicator) {
+        PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", tid, pid);
+    }
+    uint64_t term = replicator ? replicator->GetLeaderTerm() : 0;
+    std::vector<::openmldb::api::LogEntry> entries;
+    entries.reserve(order.size());
+    // the request index of each entry
+    std::vector<uint32_t> entry_idx;
+    // the rows are not rolled back, so the client retries only the failed rows
+    std::vector<uint32_t> failed_idx;
+    bool is_disk = IsDiskTable(table);
+    for (uint32_t i : order) {
+        const auto& row = request->rows(i);
+        if (is_disk) {
+            ::openmldb::api::LogEntry entry;
+            if (!PutToDiskTable(table, replicator, row, &entry)) {
+                failed_idx.push_back(i);
+            }
+            continue;
+        }
+        if (!PutToTable(table, row)) {
+            failed_idx.push_back(i);
+            continue;
+        }
+        if (replicator) {
+            entries.emplace_back();
+            BuildLogEntry(row, term, &entries.back());
+            entry_idx.push_back(i);
+        }
+    }
+    bool group_commit = replicator && replicator->IsGroupCommitEnabled();
+    if (replicator && !entries.empty() && !group_commit) {
+        // the rows after the first entry failing to write binlog are failed
+        uint32_t appended = replicator->AppendEntries(&entries);
+        if (appended < entries.size()) {
+            PDLOG(WARNING, "fail to write binlog of %lu rows. tid %u, pid %u", entries.size() - appended, tid, pid);
+            failed_idx.insert(failed_idx.end(), entry_idx.begin() + appended, entry_idx.end());
+        }
+    }
+    uint32_t put_cnt = request->rows_size() - failed_idx.size();
+    response->set_put_cnt(put_cnt);
+    if (!failed_idx.empty()) {
+        std::sort(failed_idx.begin(), failed_idx.end());
+        for (uint32_t i : failed_idx) {
+            response->add_failed_idx(i);
+        }
+        PDLOG(WARNING, "fail to put %lu rows of %d. tid %u, pid %u", failed_idx.size(), request->rows_size(), tid,
+              pid);
+        response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+        response->set_msg("put failed");
+    } else {
+        response->set_code(::openmldb::base::ReturnCode::kOk);
+    }
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    if (start_time + FLAGS_put_slow_log_threshold < end_time) {
+        PDLOG(INFO, "slow log[put batch]. rows %d time %lu. tid %u, pid %u", request->rows_size(),
+              end_time - start_time, tid, pid);
+    }
+    if (is_disk && replicator && put_cnt > 0 && FLAGS_binlog_notify_on_put) {
+        done_guard.reset(NULL);
+        replicator->Notify();
+    }
+    if (!replicator || entries.empty()) {
+        return;
+    }
+    if (group_commit) {
+        // respond after all the entries are synced to disk
+        done_guard.release();
+        auto pending = std::make_shared<std::atomic<uint32_t>>(entries.size());
+        auto failed = std::make_shared<std::atomic<bool>>(false);
+        for (auto& entry : entries) {
+            replicator->AppendEntryAsync(entry, [response, done, pending, failed](bool ok) {
+                if (!ok) {
+                    failed->store(true, std::memory_order_relaxed);
+                }
+                if (pending->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    if (failed->load(std::memory_order_relaxed)) {
+                        response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+                        response->set_msg("fail to sync binlog");
+                    }
+                    done->Run();
+                }
+            });
+        }
+        return;
+    }
+    done_guard.reset(NULL);
+    if (FLAGS_binlog_notify_on_put) {
+        replicator->Notify();
+    }
+}
+
 int TabletImpl::CheckTableMeta(const openmldb::api::TableMeta* table_meta, std::string& msg) {
     msg.clear();
     if (table_meta->name().size() <= 0) {
@@ -844,7 +1277,7 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
             total_block_size += size;
         } else {
             openmldb::base::Slice data = combine_it->GetValue();
-            io_buf->append(reinterpret_cast<const void*>(data.data()), data.size());
+            AppendRowData(combine_it->GetPinnableBlock(), data.data(), data.size(), io_buf);
             total_block_size += data.size();
         }
         record_count++;
@@ -970,6 +1403,121 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
     return 0;
 }
 
+int32_t TabletImpl::StreamScanIndex(const ::openmldb::api::ScanRequest* request,
+                                    const ::openmldb::api::TableMeta& meta,
+                                    const std::map<int32_t, std::shared_ptr<Schema>>& vers_schema,
+                                    CombineIterator* combine_it, brpc::StreamId stream, int64_t deadline_us,
+                                    ScheduleGuard* guard, uint32_t* count) {
+    uint32_t limit = request->limit();
+    uint32_t atleast = request->atleast();
+    if (combine_it == NULL || count == NULL || (atleast > limit && limit != 0)) {
+        PDLOG(WARNING, "invalid args");
+        return -1;
+    }
+    uint64_t st = request->st();
+    uint64_t et = request->et();
+    openmldb::api::GetType et_type = request->et_type();
+    openmldb::api::GetType real_et_type = et_type;
+    uint64_t expire_time = combine_it->GetExpireTime();
+    if (et < expire_time && et_type == ::openmldb::api::GetType::kSubKeyGt) {
+        real_et_type = ::openmldb::api::GetType::kSubKeyGe;
+    }
+    ::openmldb::storage::TTLType ttl_type = combine_it->GetTTLType();
+    if (ttl_type == ::openmldb::storage::TTLType::kAbsoluteTime ||
+        ttl_type == ::openmldb::storage::TTLType::kAbsOrLat) {
+        et = std::max(et, expire_time);
+    }
+    if (st > 0 && st < et) {
+        PDLOG(WARNING, "invalid args for st %lu less than et %lu or expire time %lu", st, et, expire_time);
+        return -1;
+    }
+
+    bool enable_project = false;
+    ::openmldb::codec::RowProject row_project(vers_schema, request->projection());
+    if (!request->projection().empty() && meta.format_version() == 1) {
+        if (meta.compress_type() == ::openmldb::type::kSnappy) {
+            LOG(WARNING) << "project on compress row data, not supported";
+            return -1;
+        }
+        bool ok = row_project.Init();
+        if (!ok) {
+            PDLOG(WARNING, "invalid project list");
+            return -1;
+        }
+        enable_project = true;
+    }
+    bool remove_duplicated_record =
+        request->has_enable_remove_duplicated_record() && request->enable_remove_duplicated_record();
+    uint64_t last_time = 0;
+    uint32_t record_count = 0;
+    butil::IOBuf chunk;
+    chunk.push_back(::openmldb::client::kStreamData);
+    combine_it->SeekToFirst();
+    while (combine_it->Valid()) {
+        if (limit > 0 && record_count >= limit) {
+            break;
+        }
+        if (remove_duplicated_record && record_count > 0 && last_time == combine_it->GetTs()) {
+            combine_it->Next();
+            continue;
+        }
+        uint64_t ts = combine_it->GetTs();
+        if (atleast <= 0 || record_count >= atleast) {
+            bool jump_out = false;
+            switch (real_et_type) {
+                case ::openmldb::api::GetType::kSubKeyEq:
+                    if (ts != et) {
+                        jump_out = true;
+                    }
+                    break;
+                case ::openmldb::api::GetType::kSubKeyGt:
+                    if (ts <= et) {
+                        jump_out = true;
+                    }
+                    break;
+                case ::openmldb::api::GetType::kSubKeyGe:
+                    if (ts < et) {
+                        jump_out = true;
+                    }
+                    break;
+                default:
+                    PDLOG(WARNING, "invalid et type %s", ::openmldb::api::GetType_Name(et_type).c_str());
+                    return -2;
+            }
+            if (jump_out) break;
+        }
+        last_time = ts;
+        openmldb::base::Slice data = combine_it->GetValue();
+        if (enable_project) {
+            int8_t* ptr = nullptr;
+            uint32_t size = 0;
+            const auto* row_ptr = reinterpret_cast<const int8_t*>(data.data());
+            bool ok = row_project.Project(row_ptr, data.size(), &ptr, &size);
+            if (!ok) {
+                PDLOG(WARNING, "fail to make a projection");
+                return -4;
+            }
+            AppendStreamRecord(NULL, ts, reinterpret_cast<char*>(ptr), size, &chunk);
+            delete[] reinterpret_cast<char*>(ptr);
+        } else {
+            AppendStreamRecord(NULL, ts, data.data(), data.size(), &chunk, combine_it->GetPinnableBlock());
+        }
+        record_count++;
+        if (chunk.size() >= FLAGS_stream_scan_chunk_size) {
+            if (!WriteStream(stream, &chunk, deadline_us, guard)) {
+                return -5;
+            }
+            chunk.push_back(::openmldb::client::kStreamData);
+        }
+        combine_it->Next();
+    }
+    if (chunk.size() > 1 && !WriteStream(stream, &chunk, deadline_us, guard)) {
+        return -5;
+    }
+    *count = record_count;
+    return 0;
+}
+
 int32_t TabletImpl::CountIndex(uint64_t expire_time, uint64_t expire_cnt, ::openmldb::storage::TTLType ttl_type,
                                ::openmldb::storage::TableIterator* it, const ::openmldb::api::CountRequest* request,
                                uint32_t* count) {
@@ -1084,23 +1632,16 @@ int32_t TabletImpl::CountIndex(uint64_t expire_time, uint64_t expire_cnt, ::open
     return 0;
 }
 
-void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequest* request,
-                      ::openmldb::api::ScanResponse* response, Closure* done) {
-    brpc::ClosureGuard done_guard(done);
-    uint64_t start_time = ::baidu::common::timer::get_micros();
-    if (request->st() < request->et()) {
-        response->set_code(::openmldb::base::ReturnCode::kStLessThanEt);
-        response->set_msg("starttime less than endtime");
-        return;
-    }
+bool TabletImpl::GetScanIterators(const ::openmldb::api::ScanRequest* request,
+                                  ::openmldb::api::ScanResponse* response, std::vector<QueryIt>* query_its,
+                                  ::openmldb::storage::TTLSt* expired_value) {
     uint32_t tid = request->tid();
     uint32_t pid_num = 1;
     if (request->pid_group_size() > 0) {
         pid_num = request->pid_group_size();
     }
-    std::vector<QueryIt> query_its(pid_num);
+    query_its->resize(pid_num);
     std::shared_ptr<::openmldb::storage::TTLSt> ttl;
-    ::openmldb::storage::TTLSt expired_value;
     for (uint32_t idx = 0; idx < pid_num; idx++) {
         uint32_t pid = 0;
         if (request->pid_group_size() > 0) {
@@ -1113,13 +1654,13 @@ void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequ
             PDLOG(WARNING, "table is not exist. tid %u, pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
             response->set_msg("table is not exist");
-            return;
+            return false;
         }
         if (table->GetTableStat() == ::openmldb::storage::kLoading) {
             PDLOG(WARNING, "table is loading. tid %u, pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
             response->set_msg("table is loading");
-            return;
+            return false;
         }
         uint32_t index = 0;
         std::string index_name;
@@ -1134,24 +1675,48 @@ void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequ
             PDLOG(WARNING, "idx name %s not found in table tid %u, pid %u", index_name.c_str(), tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kIdxNameNotFound);
             response->set_msg("idx name not found");
-            return;
+            return false;
         }
         index = index_def->GetId();
         if (!ttl) {
             ttl = index_def->GetTTL();
-            expired_value = *ttl;
-            expired_value.abs_ttl = table->GetExpireTime(expired_value);
+            *expired_value = *ttl;
+            expired_value->abs_ttl = table->GetExpireTime(*expired_value);
         }
-        GetIterator(table, request->pk(), index, &query_its[idx].it, &query_its[idx].ticket);
-        if (!query_its[idx].it) {
+        GetIterator(table, request->pk(), index, &(*query_its)[idx].it, &(*query_its)[idx].ticket);
+        if (!(*query_its)[idx].it) {
             response->set_code(::openmldb::base::ReturnCode::kTsNameNotFound);
             response->set_msg("ts name not found");
-            return;
+            return false;
         }
-        query_its[idx].table = table;
+        (*query_its)[idx].table = table;
+    }
+    return true;
+}
+
+void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequest* request,
+                      ::openmldb::api::ScanResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    ScheduleGuard schedule_guard(&request_scheduler_, kBatchScan);
+    if (!schedule_guard.Admitted()) {
+        response->set_code(::openmldb::base::ReturnCode::kServerIsBusy);
+        response->set_msg("server is busy");
+        return;
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    if (request->st() < request->et()) {
+        response->set_code(::openmldb::base::ReturnCode::kStLessThanEt);
+        response->set_msg("starttime less than endtime");
+        return;
+    }
+    std::vector<QueryIt> query_its;
+    ::openmldb::storage::TTLSt expired_value;
+    if (!GetScanIterators(request, response, &query_its, &expired_value)) {
+        return;
     }
     auto table_meta = query_its.begin()->table->GetTableMeta();
     const std::map<int32_t, std::shared_ptr<Schema>> vers_schema = query_its.begin()->table->GetAllVersionSchema();
+    RecordNumaAccess(query_its.begin()->table);
     CombineIterator combine_it(std::move(query_its), request->st(), request->st_type(), expired_value);
     uint32_t count = 0;
     int32_t code = 0;
@@ -1205,6 +1770,12 @@ void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequ
 void TabletImpl::Count(RpcController* controller, const ::openmldb::api::CountRequest* request,
                        ::openmldb::api::CountResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
+    ScheduleGuard schedule_guard(&request_scheduler_, kBatchScan);
+    if (!schedule_guard.Admitted()) {
+        response->set_code(::openmldb::base::ReturnCode::kServerIsBusy);
+        response->set_msg("server is busy");
+        return;
+    }
     std::shared_ptr<Table> table = GetTable(request->tid(), request->pid());
     if (!table) {
         PDLOG(WARNING, "table is not exist. tid %u, pid %u", request->tid(), request->pid());
@@ -1267,28 +1838,226 @@ void TabletImpl::Count(RpcController* controller, const ::openmldb::api::CountRe
         case 0:
             return;
         case -1:
-            response->set_msg("invalid args");
-            response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+            response->set_msg("invalid args");
+            response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+            return;
+        case -2:
+            response->set_msg("st/et sub key type is invalid");
+            response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+            return;
+        case -3:
+            response->set_code(::openmldb::base::ReturnCode::kReacheTheScanMaxBytesSize);
+            response->set_msg("reach the max scan byte size");
+            return;
+        case -4:
+            response->set_msg("fail to encode data rows");
+            response->set_code(::openmldb::base::ReturnCode::kFailToUpdateTtlFromTablet);
+            return;
+        default:
+            return;
+    }
+}
+
+void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::TraverseRequest* request,
+                          ::openmldb::api::TraverseResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    ScheduleGuard schedule_guard(&request_scheduler_, kBatchScan);
+    if (!schedule_guard.Admitted()) {
+        response->set_code(::openmldb::base::ReturnCode::kServerIsBusy);
+        response->set_msg("server is busy");
+        return;
+    }
+    std::shared_ptr<Table> table = GetTable(request->tid(), request->pid());
+    if (!table) {
+        PDLOG(WARNING, "table is not exist. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table is not exist");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    uint32_t index = 0;
+    std::string index_name;
+    if (request->has_idx_name() && !request->idx_name().empty()) {
+        index_name = request->idx_name();
+    } else {
+        index_name = table->GetPkIndex()->GetName();
+    }
+    std::shared_ptr<IndexDef> index_def;
+    index_def = table->GetIndex(index_name);
+    if (!index_def || !index_def->IsReady()) {
+        PDLOG(WARNING, "idx name %s not found in table. tid %u, pid %u", index_name.c_str(), request->tid(),
+              request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kIdxNameNotFound);
+        response->set_msg("idx name not found");
+        return;
+    }
+    index = index_def->GetId();
+    ::openmldb::storage::TableIterator* it = NULL;
+    it = table->NewTraverseIterator(index);
+    if (it == NULL) {
+        response->set_code(::openmldb::base::ReturnCode::kTsNameNotFound);
+        response->set_msg("ts name not found, when create iterator");
+        return;
+    }
+
+    uint64_t last_time = 0;
+    std::string last_pk;
+    if (request->has_pk() && request->pk().size() > 0) {
+        DEBUGLOG("tid %u, pid %u seek pk %s ts %lu", request->tid(), request->pid(), request->pk().c_str(),
+                 request->ts());
+        it->Seek(request->pk(), request->ts());
+        last_pk = request->pk();
+        last_time = request->ts();
+    } else {
+        DEBUGLOG("tid %u, pid %u seek to first", request->tid(), request->pid());
+        it->SeekToFirst();
+    }
+    std::map<std::string, std::vector<std::pair<uint64_t, openmldb::base::Slice>>> value_map;
+    uint32_t total_block_size = 0;
+    bool remove_duplicated_record = false;
+    if (request->has_enable_remove_duplicated_record()) {
+        remove_duplicated_record = request->enable_remove_duplicated_record();
+    }
+    uint32_t scount = 0;
+    for (; it->Valid(); it->Next()) {
+        if (request->limit() > 0 && scount > request->limit() - 1) {
+            DEBUGLOG("reache the limit %u ", request->limit());
+            break;
+        }
+        DEBUGLOG("traverse pk %s ts %lu", it->GetPK().c_str(), it->GetKey());
+        // skip duplicate record
+        if (remove_duplicated_record && last_time == it->GetKey() && last_pk == it->GetPK()) {
+            DEBUGLOG("filter duplicate record for key %s with ts %lu", last_pk.c_str(), last_time);
+            continue;
+        }
+        last_pk = it->GetPK();
+        last_time = it->GetKey();
+        if (value_map.find(last_pk) == value_map.end()) {
+            value_map.insert(std::make_pair(last_pk, std::vector<std::pair<uint64_t, openmldb::base::Slice>>()));
+            value_map[last_pk].reserve(request->limit());
+        }
+        openmldb::base::Slice value = it->GetValue();
+        value_map[last_pk].push_back(std::make_pair(it->GetKey(), value));
+        total_block_size += last_pk.length() + value.size();
+        scount++;
+        if (it->GetCount() >= FLAGS_max_traverse_cnt) {
+            DEBUGLOG("traverse cnt %lu max %lu, key %s ts %lu", it->GetCount(), FLAGS_max_traverse_cnt, last_pk.c_str(),
+                     last_time);
+            break;
+        }
+    }
+    bool is_finish = false;
+    if (it->GetCount() >= FLAGS_max_traverse_cnt) {
+        DEBUGLOG("traverse cnt %lu is great than max %lu, key %s ts %lu", it->GetCount(), FLAGS_max_traverse_cnt,
+                 last_pk.c_str(), last_time);
+        last_pk = it->GetPK();
+        last_time = it->GetKey();
+        if (last_pk.empty()) {
+            is_finish = true;
+        }
+    } else if (scount < request->limit()) {
+        is_finish = true;
+    }
+    uint32_t total_size = scount * (8 + 4 + 4) + total_block_size;
+    std::string* pairs = response->mutable_pairs();
+    if (scount <= 0) {
+        pairs->resize(0);
+    } else {
+        pairs->resize(total_size);
+    }
+    char* rbuffer = reinterpret_cast<char*>(&((*pairs)[0]));
+    uint32_t offset = 0;
+    for (const auto& kv : value_map) {
+        for (const auto& pair : kv.second) {
+            DEBUGLOG("encode pk %s ts %lu size %u", kv.first.c_str(), pair.first, pair.second.size());
+            ::openmldb::codec::EncodeFull(kv.first, pair.first, pair.second.data(), pair.second.size(), rbuffer,
+                                          offset);
+            offset += (4 + 4 + 8 + kv.first.length() + pair.second.size());
+        }
+    }
+    delete it;
+    DEBUGLOG("traverse count %d. last_pk %s last_time %lu", scount, last_pk.c_str(), last_time);
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    response->set_count(scount);
+    response->set_pk(last_pk);
+    response->set_ts(last_time);
+    response->set_is_finish(is_finish);
+}
+
+void TabletImpl::ScanStream(RpcController* controller, const ::openmldb::api::ScanRequest* request,
+                            ::openmldb::api::ScanResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    if (request->st() < request->et()) {
+        response->set_code(::openmldb::base::ReturnCode::kStLessThanEt);
+        response->set_msg("starttime less than endtime");
+        return;
+    }
+    std::vector<QueryIt> query_its;
+    ::openmldb::storage::TTLSt expired_value;
+    if (!GetScanIterators(request, response, &query_its, &expired_value)) {
+        return;
+    }
+    auto* cntl = dynamic_cast<brpc::Controller*>(controller);
+    brpc::StreamOptions options;
+    options.max_buf_size = FLAGS_stream_scan_max_buf_size;
+    brpc::StreamId stream;
+    if (cntl == NULL || brpc::StreamAccept(&stream, *cntl, &options) != 0) {
+        PDLOG(WARNING, "fail to accept stream. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+        response->set_msg("fail to accept stream");
+        return;
+    }
+    std::shared_ptr<Table> table = query_its.begin()->table;
+    auto combine_it = std::make_shared<CombineIterator>(std::move(query_its), request->st(), request->st_type(),
+                                                        expired_value);
+    auto scan_request = std::make_shared<::openmldb::api::ScanRequest>(*request);
+    stream_scan_pool_.AddTask(
+        boost::bind(&TabletImpl::ScanStreamInternal, this, stream, scan_request, table, combine_it));
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    response->set_msg("ok");
+}
+
+void TabletImpl::ScanStreamInternal(brpc::StreamId stream, std::shared_ptr<::openmldb::api::ScanRequest> request,
+                                    std::shared_ptr<Table> table, std::shared_ptr<CombineIterator> combine_it) {
+    // the stream is open already, wait for the turn instead of shedding
+    ScheduleGuard schedule_guard(&request_scheduler_, kBatchScan, false);
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    int64_t deadline_us = StreamDeadline();
+    auto table_meta = table->GetTableMeta();
+    const std::map<int32_t, std::shared_ptr<Schema>> vers_schema = table->GetAllVersionSchema();
+    uint32_t count = 0;
+    int32_t code = StreamScanIndex(request.get(), *table_meta, vers_schema, combine_it.get(), stream,
+                                   deadline_us, &schedule_guard, &count);
+    PDLOG(INFO, "stream scan finished. tid %u, pid %u, count %u, code %d, time %lu", request->tid(), request->pid(),
+          count, code, ::baidu::common::timer::get_micros() - start_time);
+    switch (code) {
+        case 0:
+            CloseStream(stream, ::openmldb::base::ReturnCode::kOk, "ok", deadline_us);
+            return;
+        case -1:
+            CloseStream(stream, ::openmldb::base::ReturnCode::kInvalidParameter, "invalid args", deadline_us);
             return;
         case -2:
-            response->set_msg("st/et sub key type is invalid");
-            response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
-            return;
-        case -3:
-            response->set_code(::openmldb::base::ReturnCode::kReacheTheScanMaxBytesSize);
-            response->set_msg("reach the max scan byte size");
+            CloseStream(stream, ::openmldb::base::ReturnCode::kInvalidParameter, "st/et sub key type is invalid",
+                        deadline_us);
             return;
         case -4:
-            response->set_msg("fail to encode data rows");
-            response->set_code(::openmldb::base::ReturnCode::kFailToUpdateTtlFromTablet);
+            CloseStream(stream, ::openmldb::base::ReturnCode::kEncodeError, "fail to encode data rows", deadline_us);
             return;
         default:
+            // the client is gone or too slow
+            brpc::StreamClose(stream);
             return;
     }
 }
 
-void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::TraverseRequest* request,
-                          ::openmldb::api::TraverseResponse* response, Closure* done) {
+void TabletImpl::TraverseStream(RpcController* controller, const ::openmldb::api::TraverseRequest* request,
+                                ::openmldb::api::TraverseResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
     std::shared_ptr<Table> table = GetTable(request->tid(), request->pid());
     if (!table) {
@@ -1303,15 +2072,13 @@ void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::Trav
         response->set_msg("table is loading");
         return;
     }
-    uint32_t index = 0;
     std::string index_name;
     if (request->has_idx_name() && !request->idx_name().empty()) {
         index_name = request->idx_name();
     } else {
         index_name = table->GetPkIndex()->GetName();
     }
-    std::shared_ptr<IndexDef> index_def;
-    index_def = table->GetIndex(index_name);
+    std::shared_ptr<IndexDef> index_def = table->GetIndex(index_name);
     if (!index_def || !index_def->IsReady()) {
         PDLOG(WARNING, "idx name %s not found in table. tid %u, pid %u", index_name.c_str(), request->tid(),
               request->pid());
@@ -1319,97 +2086,78 @@ void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::Trav
         response->set_msg("idx name not found");
         return;
     }
-    index = index_def->GetId();
-    ::openmldb::storage::TableIterator* it = NULL;
-    it = table->NewTraverseIterator(index);
-    if (it == NULL) {
-        response->set_code(::openmldb::base::ReturnCode::kTsNameNotFound);
-        response->set_msg("ts name not found, when create iterator");
+    auto* cntl = dynamic_cast<brpc::Controller*>(controller);
+    brpc::StreamOptions options;
+    options.max_buf_size = FLAGS_stream_scan_max_buf_size;
+    brpc::StreamId stream;
+    if (cntl == NULL || brpc::StreamAccept(&stream, *cntl, &options) != 0) {
+        PDLOG(WARNING, "fail to accept stream. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+        response->set_msg("fail to accept stream");
         return;
     }
+    auto traverse_request = std::make_shared<::openmldb::api::TraverseRequest>(*request);
+    stream_scan_pool_.AddTask(boost::bind(&TabletImpl::TraverseStreamInternal, this, stream, traverse_request, table,
+                                          index_def->GetId()));
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    response->set_msg("ok");
+}
 
+void TabletImpl::TraverseStreamInternal(brpc::StreamId stream,
+                                        std::shared_ptr<::openmldb::api::TraverseRequest> request,
+                                        std::shared_ptr<Table> table, uint32_t index) {
+    ScheduleGuard schedule_guard(&request_scheduler_, kBatchScan, false);
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    int64_t deadline_us = StreamDeadline();
+    std::unique_ptr<::openmldb::storage::TableIterator> it(table->NewTraverseIterator(index));
+    if (!it) {
+        CloseStream(stream, ::openmldb::base::ReturnCode::kTsNameNotFound, "ts name not found, when create iterator",
+                    deadline_us);
+        return;
+    }
     uint64_t last_time = 0;
     std::string last_pk;
     if (request->has_pk() && request->pk().size() > 0) {
-        DEBUGLOG("tid %u, pid %u seek pk %s ts %lu", request->tid(), request->pid(), request->pk().c_str(),
-                 request->ts());
         it->Seek(request->pk(), request->ts());
         last_pk = request->pk();
         last_time = request->ts();
     } else {
-        DEBUGLOG("tid %u, pid %u seek to first", request->tid(), request->pid());
         it->SeekToFirst();
     }
-    std::map<std::string, std::vector<std::pair<uint64_t, openmldb::base::Slice>>> value_map;
-    uint32_t total_block_size = 0;
-    bool remove_duplicated_record = false;
-    if (request->has_enable_remove_duplicated_record()) {
-        remove_duplicated_record = request->enable_remove_duplicated_record();
-    }
+    bool remove_duplicated_record =
+        request->has_enable_remove_duplicated_record() && request->enable_remove_duplicated_record();
+    uint32_t limit = request->limit();
     uint32_t scount = 0;
+    butil::IOBuf chunk;
+    chunk.push_back(::openmldb::client::kStreamData);
+    // the iterator is not bounded by max_traverse_cnt, the stream window bounds the memory instead
     for (; it->Valid(); it->Next()) {
-        if (request->limit() > 0 && scount > request->limit() - 1) {
-            DEBUGLOG("reache the limit %u ", request->limit());
+        if (limit > 0 && scount >= limit) {
             break;
         }
-        DEBUGLOG("traverse pk %s ts %lu", it->GetPK().c_str(), it->GetKey());
-        // skip duplicate record
         if (remove_duplicated_record && last_time == it->GetKey() && last_pk == it->GetPK()) {
-            DEBUGLOG("filter duplicate record for key %s with ts %lu", last_pk.c_str(), last_time);
             continue;
         }
         last_pk = it->GetPK();
         last_time = it->GetKey();
-        if (value_map.find(last_pk) == value_map.end()) {
-            value_map.insert(std::make_pair(last_pk, std::vector<std::pair<uint64_t, openmldb::base::Slice>>()));
-            value_map[last_pk].reserve(request->limit());
-        }
         openmldb::base::Slice value = it->GetValue();
-        value_map[last_pk].push_back(std::make_pair(it->GetKey(), value));
-        total_block_size += last_pk.length() + value.size();
+        AppendStreamRecord(&last_pk, last_time, value.data(), value.size(), &chunk, it->GetPinnableBlock());
         scount++;
-        if (it->GetCount() >= FLAGS_max_traverse_cnt) {
-            DEBUGLOG("traverse cnt %lu max %lu, key %s ts %lu", it->GetCount(), FLAGS_max_traverse_cnt, last_pk.c_str(),
-                     last_time);
-            break;
-        }
-    }
-    bool is_finish = false;
-    if (it->GetCount() >= FLAGS_max_traverse_cnt) {
-        DEBUGLOG("traverse cnt %lu is great than max %lu, key %s ts %lu", it->GetCount(), FLAGS_max_traverse_cnt,
-                 last_pk.c_str(), last_time);
-        last_pk = it->GetPK();
-        last_time = it->GetKey();
-        if (last_pk.empty()) {
-            is_finish = true;
+        if (chunk.size() >= FLAGS_stream_scan_chunk_size) {
+            if (!WriteStream(stream, &chunk, deadline_us, &schedule_guard)) {
+                brpc::StreamClose(stream);
+                return;
+            }
+            chunk.push_back(::openmldb::client::kStreamData);
         }
-    } else if (scount < request->limit()) {
-        is_finish = true;
     }
-    uint32_t total_size = scount * (8 + 4 + 4) + total_block_size;
-    std::string* pairs = response->mutable_pairs();
-    if (scount <= 0) {
-        pairs->resize(0);
-    } else {
-        pairs->resize(total_size);
-    }
-    char* rbuffer = reinterpret_cast<char*>(&((*pairs)[0]));
-    uint32_t offset = 0;
-    for (const auto& kv : value_map) {
-        for (const auto& pair : kv.second) {
-            DEBUGLOG("encode pk %s ts %lu size %u", kv.first.c_str(), pair.first, pair.second.size());
-            ::openmldb::codec::EncodeFull(kv.first, pair.first, pair.second.data(), pair.second.size(), rbuffer,
-                                          offset);
-            offset += (4 + 4 + 8 + kv.first.length() + pair.second.size());
-        }
+    if (chunk.size() > 1 && !WriteStream(stream, &chunk, deadline_us, &schedule_guard)) {
+        brpc::StreamClose(stream);
+        return;
     }
-    delete it;
-    DEBUGLOG("traverse count %d. last_pk %s last_time %lu", scount, last_pk.c_str(), last_time);
-    response->set_code(::openmldb::base::ReturnCode::kOk);
-    response->set_count(scount);
-    response->set_pk(last_pk);
-    response->set_ts(last_time);
-    response->set_is_finish(is_finish);
+    PDLOG(INFO, "stream traverse finished. tid %u, pid %u, count %u, time %lu", request->tid(), request->pid(), scount,
+          ::baidu::common::timer::get_micros() - start_time);
+    CloseStream(stream, ::openmldb::base::ReturnCode::kOk, "ok", deadline_us);
 }
 
 void TabletImpl::Delete(RpcController* controller, const ::openmldb::api::DeleteRequest* request,
@@ -1452,6 +2200,12 @@ void TabletImpl::Delete(RpcController* controller, const ::openmldb::api::Delete
         idx = index_def->GetId();
     }
     if (table->Delete(request->key(), idx)) {
+        if (key_versions_) {
+            const std::string db = table->GetDB();
+            const std::string name = table->GetName();
+            key_versions_->Update(::openmldb::catalog::SeekKeyRecorder::Hash(db, name, ""));
+            key_versions_->Update(::openmldb::catalog::SeekKeyRecorder::Hash(db, name, request->key()));
+        }
         response->set_code(::openmldb::base::ReturnCode::kOk);
         response->set_msg("ok");
         DEBUGLOG("delete ok. tid %u, pid %u, key %s", request->tid(), request->pid(), request->key().c_str());
@@ -1485,6 +2239,12 @@ void TabletImpl::Query(RpcController* ctrl, const openmldb::api::QueryRequest* r
                        openmldb::api::QueryResponse* response, Closure* done) {
     DLOG(INFO) << "handle query request begin!";
     brpc::ClosureGuard done_guard(done);
+    ScheduleGuard schedule_guard(&request_scheduler_, kOnlineQuery);
+    if (!schedule_guard.Admitted()) {
+        response->set_code(::openmldb::base::ReturnCode::kServerIsBusy);
+        response->set_msg("server is busy");
+        return;
+    }
     brpc::Controller* cntl = static_cast<brpc::Controller*>(ctrl);
     butil::IOBuf& buf = cntl->response_attachment();
     ProcessQuery(ctrl, request, response, &buf);
@@ -1566,6 +2326,10 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
         if (request->is_debug()) {
             session.EnableDebug();
         }
+        std::unique_ptr<QueryTrace> trace;
+        if (request->is_trace() || (request->is_procedure() && FLAGS_enable_procedure_trace)) {
+            trace.reset(new QueryTrace());
+        }
         if (request->is_procedure()) {
             const std::string& db_name = request->db();
             const std::string& sp_name = request->sp_name();
@@ -1582,7 +2346,35 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
             }
             session.SetCompileInfo(request_compile_info);
             session.SetSpName(sp_name);
-            RunRequestQuery(ctrl, *request, session, *response, *buf);
+            std::shared_ptr<ProcedureResultCache> result_cache;
+            if (key_versions_ && !request->has_task_id() && !request->is_debug() && !request->is_trace() &&
+                buf->empty()) {
+                result_cache = sp_cache_->GetResultCache(db_name, sp_name);
+            }
+            if (!result_cache) {
+                RunRequestQuery(ctrl, *request, session, *response, *buf, trace.get());
+            } else {
+                std::string request_row;
+                static_cast<brpc::Controller*>(ctrl)->request_attachment().copy_to(&request_row, request->row_size());
+                uint32_t byte_size = 0;
+                if (result_cache->Get(request_row, buf, &byte_size)) {
+                    response->set_schema(session.GetEncodedSchema());
+                    response->set_byte_size(byte_size);
+                    response->set_count(1);
+                    response->set_row_slices(1);
+                    response->set_code(::openmldb::base::kOk);
+                    return;
+                }
+                // the keys read by the run are recorded by the segment handlers of catalog
+                uint64_t seq = key_versions_->GetSeq();
+                ::openmldb::catalog::SeekKeyRecorder recorder;
+                ::openmldb::catalog::SeekKeyRecorder::SetCurrent(&recorder);
+                RunRequestQuery(ctrl, *request, session, *response, *buf, trace.get());
+                ::openmldb::catalog::SeekKeyRecorder::SetCurrent(nullptr);
+                if (response->code() == ::openmldb::base::kOk) {
+                    result_cache->Put(request_row, *buf, response->byte_size(), recorder.GetKeys(), seq);
+                }
+            }
         } else {
             bool ok = engine_->Get(request->sql(), request->db(), session, status);
             if (!ok || session.GetCompileInfo() == nullptr) {
@@ -1591,7 +2383,11 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
                 DLOG(WARNING) << "fail to compile sql in request mode:\n" << request->sql();
                 return;
             }
-            RunRequestQuery(ctrl, *request, session, *response, *buf);
+            RunRequestQuery(ctrl, *request, session, *response, *buf, trace.get());
+        }
+        if (trace && response->code() == ::openmldb::base::kOk) {
+            FinishQueryTrace(*trace, request->is_procedure(), request->db(), request->sp_name(), "request",
+                             request->is_trace(), response);
         }
         const std::string& sql = session.GetCompileInfo()->GetSql();
         if (response->code() != ::openmldb::base::kOk) {
@@ -1615,6 +2411,12 @@ void TabletImpl::SQLBatchRequestQuery(RpcController* ctrl, const openmldb::api::
                                       openmldb::api::SQLBatchRequestQueryResponse* response, Closure* done) {
     DLOG(INFO) << "handle query batch request begin!";
     brpc::ClosureGuard done_guard(done);
+    ScheduleGuard schedule_guard(&request_scheduler_, kOnlineQuery);
+    if (!schedule_guard.Admitted()) {
+        response->set_code(::openmldb::base::ReturnCode::kServerIsBusy);
+        response->set_msg("server is busy");
+        return;
+    }
     brpc::Controller* cntl = static_cast<brpc::Controller*>(ctrl);
     butil::IOBuf& buf = cntl->response_attachment();
     return ProcessBatchRequestQuery(ctrl, request, response, buf);
@@ -1628,6 +2430,10 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
     if (request->is_debug()) {
         session.EnableDebug();
     }
+    std::unique_ptr<QueryTrace> trace;
+    if (request->is_trace() || (request->is_procedure() && FLAGS_enable_procedure_trace)) {
+        trace.reset(new QueryTrace());
+    }
     bool is_procedure = request->is_procedure();
     if (is_procedure) {
         std::shared_ptr<hybridse::vm::CompileInfo> request_compile_info;
@@ -1658,6 +2464,10 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
         }
     }
 
+    if (trace) {
+        trace->EndStage(QueryTrace::kCompile);
+    }
+
     // fill input data
     auto compile_info = session.GetCompileInfo();
     if (compile_info == nullptr) {
@@ -1714,6 +2524,10 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
             buf_offset += non_common_size;
         }
     }
+    if (trace) {
+        trace->EndStage(QueryTrace::kDecode);
+        session.SetTrace(trace->GetRunnerTrace());
+    }
     std::vector<::hybridse::codec::Row> output_rows;
     int32_t run_ret = 0;
     if (request->has_task_id()) {
@@ -1721,6 +2535,9 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
     } else {
         run_ret = session.Run(input_rows, output_rows);
     }
+    if (trace) {
+        trace->EndStage(QueryTrace::kRun);
+    }
     if (run_ret != 0) {
         response->set_msg(status.msg);
         response->set_code(::openmldb::base::kSQLRunError);
@@ -1778,6 +2595,11 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
     response->set_schema(session.GetEncodedSchema());
     response->set_count(output_rows.size());
     response->set_code(::openmldb::base::kOk);
+    if (trace) {
+        trace->EndStage(QueryTrace::kEncode);
+        FinishQueryTrace(*trace, is_procedure, request->db(), request->sp_name(), "batch_request",
+                         request->is_trace(), response);
+    }
     DLOG(INFO) << "handle batch request sql " << request->sql() << " with record cnt " << output_rows.size()
                << " with schema size " << session.GetSchema().size();
 }
@@ -2006,6 +2828,42 @@ void TabletImpl::DelReplica(RpcController* controller, const ::openmldb::api::Re
 void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                                ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
+    ScheduleGuard schedule_guard(&request_scheduler_, kReplication);
+    if (!schedule_guard.Admitted()) {
+        response->set_code(::openmldb::base::ReturnCode::kServerIsBusy);
+        response->set_msg("server is busy");
+        return;
+    }
+    AppendEntriesInternal(request, &static_cast<brpc::Controller*>(controller)->request_attachment(), response);
+}
+
+void TabletImpl::BatchAppendEntries(RpcController* controller,
+                                    const ::openmldb::api::BatchAppendEntriesRequest* request,
+                                    ::openmldb::api::BatchAppendEntriesResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    ScheduleGuard schedule_guard(&request_scheduler_, kReplication);
+    if (!schedule_guard.Admitted()) {
+        response->set_code(::openmldb::base::ReturnCode::kServerIsBusy);
+        response->set_msg("server is busy");
+        return;
+    }
+    butil::IOBuf& attachment = static_cast<brpc::Controller*>(controller)->request_attachment();
+    for (const auto& sub_request : request->requests()) {
+        // cut the raw records of each request, so a failed request does not shift the others
+        uint64_t byte_size = 0;
+        for (uint32_t size : sub_request.raw_entry_size()) {
+            byte_size += size;
+        }
+        butil::IOBuf sub_attachment;
+        attachment.cutn(&sub_attachment, byte_size);
+        AppendEntriesInternal(&sub_request, &sub_attachment, response->add_responses());
+    }
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    response->set_msg("ok");
+}
+
+void TabletImpl::AppendEntriesInternal(const ::openmldb::api::AppendEntriesRequest* request,
+                                       butil::IOBuf* attachment, ::openmldb::api::AppendEntriesResponse* response) {
     uint32_t tid = request->tid();
     uint32_t pid = request->pid();
     std::shared_ptr<Table> table = GetTable(tid, pid);
@@ -2047,7 +2905,8 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
     uint64_t last_log_offset = replicator->GetOffset();
-    if (request->pre_log_index() == 0 && request->entries_size() == 0) {
+    bool raw_record = request->raw_entry_size_size() > 0;
+    if (request->pre_log_index() == 0 && request->entries_size() == 0 && !raw_record) {
         response->set_log_offset(last_log_offset);
         if (!FLAGS_zk_cluster.empty() && request->term() > term) {
             replicator->SetLeaderTerm(request->term());
@@ -2058,36 +2917,132 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
         PDLOG(INFO, "first sync log_index! log_offset[%lu] tid[%u] pid[%u]", last_log_offset, tid, pid);
         return;
     }
-    for (int32_t i = 0; i < request->entries_size(); i++) {
-        const auto& entry = request->entries(i);
-        if (entry.log_index() <= last_log_offset) {
-            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", request->entries(i).log_index(),
-                    last_log_offset, tid, pid);
-            continue;
-        }
-        if (!replicator->ApplyEntry(entry)) {
-            PDLOG(WARNING, "fail to write binlog. tid %u pid %u", tid, pid);
+    // the raw records are written to binlog as they are and parsed only for the table.
+    // the entries are written to binlog at once and then put to table
+    int32_t entry_cnt = raw_record ? request->raw_entry_size_size() : request->entries_size();
+    std::vector<std::pair<uint64_t, ::openmldb::base::Slice>> records;
+    std::vector<::openmldb::api::LogEntry> raw_entries;
+    std::vector<const ::openmldb::api::LogEntry*> entries;
+    std::string raw_buffer;
+    std::vector<std::string> buffers;
+    records.reserve(entry_cnt);
+    entries.reserve(entry_cnt);
+    if (raw_record) {
+        uint64_t byte_size = 0;
+        for (uint32_t size : request->raw_entry_size()) {
+            byte_size += size;
+        }
+        if (attachment->cutn(&raw_buffer, byte_size) != byte_size) {
+            PDLOG(WARNING, "bad raw record. tid %u pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
-            response->set_msg("fail to append entries to replicator");
+            response->set_msg("bad raw record");
             return;
         }
-        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
-            if (entry.dimensions_size() == 0) {
-                PDLOG(WARNING, "no dimesion. tid %u pid %u", tid, pid);
+        raw_entries.reserve(entry_cnt);
+        uint64_t pos = 0;
+        for (int32_t i = 0; i < entry_cnt; i++) {
+            ::openmldb::base::Slice record(raw_buffer.data() + pos, request->raw_entry_size(i));
+            pos += record.size();
+            uint64_t log_index = 0;
+            if (!::openmldb::replica::PeekLogIndex(record, &log_index)) {
+                PDLOG(WARNING, "bad raw record. tid %u pid %u", tid, pid);
                 response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
-                response->set_msg("fail to append entries to replicator");
+                response->set_msg("bad raw record");
                 return;
             }
-            table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
+            if (log_index <= last_log_offset) {
+                PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", log_index, last_log_offset,
+                        tid, pid);
+                continue;
+            }
+            raw_entries.emplace_back();
+            if (!raw_entries.back().ParseFromArray(record.data(), record.size())) {
+                PDLOG(WARNING, "bad raw record. tid %u pid %u", tid, pid);
+                response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+                response->set_msg("bad raw record");
+                return;
+            }
+            records.emplace_back(log_index, record);
+            entries.push_back(&raw_entries.back());
+        }
+    } else {
+        buffers.reserve(entry_cnt);
+        for (const auto& entry : request->entries()) {
+            if (entry.log_index() <= last_log_offset) {
+                PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", entry.log_index(),
+                        last_log_offset, tid, pid);
+                continue;
+            }
+            buffers.emplace_back();
+            entry.SerializeToString(&buffers.back());
+            records.emplace_back(entry.log_index(), ::openmldb::base::Slice(buffers.back()));
+            entries.push_back(&entry);
         }
-        if (!table->Put(entry)) {
+    }
+    bool ok = records.empty() || replicator->ApplyRawEntries(records);
+    if (!ok) {
+        PDLOG(WARNING, "fail to write binlog. tid %u pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+        response->set_msg("fail to append entries to replicator");
+    }
+    // the entries written to binlog are put to table even if the write fails in the middle
+    uint64_t log_offset = replicator->GetOffset();
+    uint64_t apply_offset = last_log_offset;
+    std::unique_ptr<::openmldb::storage::ShardedReplayer> replayer;
+    size_t applied_cnt = 0;
+    // the rows of disk table are put in log order, see DiskTable::WriteRows
+    if (apply_pool_ && entries.size() > 1 && !IsDiskTable(table)) {
+        replayer.reset(new ::openmldb::storage::ShardedReplayer(table, FLAGS_follower_apply_thread_num,
+                                                                apply_pool_.get()));
+    }
+    for (const auto* entry : entries) {
+        if (entry->log_index() > log_offset) {
+            break;
+        }
+        if (entry->has_method_type() && entry->method_type() == ::openmldb::api::MethodType::kDelete) {
+            if (entry->dimensions_size() == 0) {
+                PDLOG(WARNING, "no dimesion. tid %u pid %u", tid, pid);
+                response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+                response->set_msg("fail to append entries to replicator");
+                break;
+            }
+            // delete may cover keys of other shards, apply the puts before it
+            if (replayer) {
+                replayer->Flush();
+                replayer->Wait();
+            }
+            table->Delete(entry->dimensions(0).key(), entry->dimensions(0).idx());
+        } else if (replayer) {
+            // the entries of request are alive until the replayer is waited
+            replayer->Put(*entry);
+        } else if (!table->Put(*entry)) {
             PDLOG(WARNING, "fail to put entry. tid %u pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
             response->set_msg("fail to append entry to table");
-            return;
+            break;
+        }
+        apply_offset = entry->log_index();
+        applied_cnt++;
+    }
+    if (replayer) {
+        replayer->Flush();
+        replayer->Wait();
+        if (replayer->GetFailedCnt() > 0) {
+            PDLOG(WARNING, "fail to put %lu entries. tid %u pid %u", replayer->GetFailedCnt(), tid, pid);
+            response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+            response->set_msg("fail to append entry to table");
+            // the failed entries are unknown
+            apply_offset = last_log_offset;
         }
     }
-    response->set_log_offset(replicator->GetOffset());
+    // the procedure results cached on the follower are stale once the rows are visible
+    if (key_versions_) {
+        for (size_t i = 0; i < applied_cnt; i++) {
+            UpdateKeyVersions(table, entries[i]->pk(), entries[i]->dimensions());
+        }
+    }
+    response->set_log_offset(log_offset);
+    response->set_apply_offset(apply_offset);
 }
 
 void TabletImpl::GetTableSchema(RpcController* controller, const ::openmldb::api::GetTableSchemaRequest* request,
@@ -2223,6 +3178,9 @@ void TabletImpl::GetTableStatus(RpcController* controller, const ::openmldb::api
                 status->set_record_idx_byte_size(mem_table->GetRecordIdxByteSize());
                 status->set_record_pk_cnt(mem_table->GetRecordPkCnt());
                 status->set_skiplist_height(mem_table->GetKeyEntryHeight());
+                status->set_compact_saved_byte_size(mem_table->GetCompactSavedByteSize());
+                status->set_gc_lag(mem_table->GetGcLag());
+                status->set_numa_node(mem_table->GetNumaNode());
                 uint64_t record_idx_cnt = 0;
                 auto indexs = table->GetAllIndex();
                 for (const auto& index_def : indexs) {
@@ -2240,6 +3198,8 @@ void TabletImpl::GetTableStatus(RpcController* controller, const ::openmldb::api
                     delete[] stats;
                 }
                 status->set_idx_cnt(record_idx_cnt);
+            } else if (DiskTable* disk_table = dynamic_cast<DiskTable*>(table.get())) {
+                status->set_is_expire(disk_table->GetExpireStatus());
             }
         }
     }
@@ -2260,6 +3220,10 @@ void TabletImpl::SetExpire(RpcController* controller, const ::openmldb::api::Set
     if (mem_table != NULL) {
         mem_table->SetExpire(request->is_expire());
         PDLOG(INFO, "set table expire[%d]. tid[%u] pid[%u]", request->is_expire(), request->tid(), request->pid());
+    } else if (DiskTable* disk_table = dynamic_cast<DiskTable*>(table.get())) {
+        disk_table->SetExpire(request->is_expire());
+        PDLOG(INFO, "set disk table expire[%d]. tid[%u] pid[%u]", request->is_expire(), request->tid(),
+              request->pid());
     }
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
@@ -2267,6 +3231,7 @@ void TabletImpl::SetExpire(RpcController* controller, const ::openmldb::api::Set
 
 void TabletImpl::MakeSnapshotInternal(uint32_t tid, uint32_t pid, uint64_t end_offset,
                                       std::shared_ptr<::openmldb::api::TaskInfo> task) {
+    ScheduleGuard schedule_guard(&request_scheduler_, kMaintenance, false);
     PDLOG(INFO, "MakeSnapshotInternal begin, tid[%u] pid[%u]", tid, pid);
     std::shared_ptr<Table> table;
     std::shared_ptr<Snapshot> snapshot;
@@ -2594,6 +3559,8 @@ void TabletImpl::SendSnapshot(RpcController* controller, const ::openmldb::api::
 
 void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid, uint32_t pid, uint32_t remote_tid,
                                       std::shared_ptr<::openmldb::api::TaskInfo> task) {
+    // the receiver side is not limited, otherwise two tablets sending to each other can wait forever
+    ScheduleGuard schedule_guard(&request_scheduler_, kMaintenance, false);
     bool has_error = true;
     do {
         std::shared_ptr<Table> table = GetTable(tid, pid);
@@ -2635,6 +3602,7 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
         full_path.append("snapshot/");
         std::string manifest_file = full_path + "MANIFEST";
         std::string snapshot_file;
+        std::vector<std::string> delta_files;
         {
             int fd = open(manifest_file.c_str(), O_RDONLY);
             if (fd < 0) {
@@ -2650,12 +3618,27 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
                 break;
             }
             snapshot_file = manifest.name();
+            for (const auto& delta : manifest.delta()) {
+                delta_files.push_back(delta.name());
+            }
         }
         // send snapshot file
         if (sender.SendFile(snapshot_file, full_path + snapshot_file) < 0) {
             PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
             break;
         }
+        // send delta snapshot files
+        bool send_delta_failed = false;
+        for (const auto& delta_file : delta_files) {
+            if (sender.SendFile(delta_file, full_path + delta_file) < 0) {
+                PDLOG(WARNING, "send delta snapshot %s failed. tid[%u] pid[%u]", delta_file.c_str(), tid, pid);
+                send_delta_failed = true;
+                break;
+            }
+        }
+        if (send_delta_failed) {
+            break;
+        }
         // send manifest file
         file_name = "MANIFEST";
         if (sender.SendFile(file_name, full_path + file_name) < 0) {
@@ -2851,6 +3834,7 @@ void TabletImpl::LoadTable(RpcController* controller, const ::openmldb::api::Loa
 }
 
 int TabletImpl::LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::openmldb::api::TaskInfo> task_ptr) {
+    ScheduleGuard schedule_guard(&request_scheduler_, kMaintenance, false);
     do {
         // load snapshot data
         std::shared_ptr<Table> table = GetTable(tid, pid);
@@ -2882,8 +3866,24 @@ int TabletImpl::LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::
         }
         std::string binlog_path = db_root_path + "/" + std::to_string(tid) + "_" + std::to_string(pid) + "/binlog/";
         ::openmldb::storage::Binlog binlog(replicator->GetLogPart(), binlog_path);
+        uint64_t recover_start = ::baidu::common::timer::get_micros();
+        // the table which keeps the rows across restarts only replays the binlog after them
         if (snapshot->Recover(table, snapshot_offset) &&
-            binlog.RecoverFromBinlog(table, snapshot_offset, latest_offset)) {
+            binlog.RecoverFromBinlog(table, std::max(snapshot_offset, table->GetPersistedOffset()),
+                                     latest_offset)) {
+            uint64_t recover_time = ::baidu::common::timer::get_micros() - recover_start + 1;
+            uint64_t row_cnt = snapshot->GetRecoverRecordCnt() + binlog.GetRecoverRecordCnt();
+            uint64_t byte_size = snapshot->GetRecoverByteSize() + binlog.GetRecoverByteSize();
+            uint64_t rows_per_sec = row_cnt * 1000000 / recover_time;
+            double mb_per_sec = byte_size / 1024.0 / 1024.0 * 1000000 / recover_time;
+            PDLOG(INFO, "recover table tid %u pid %u with %lu rows %lu bytes in %lu ms, %lu rows/s %.2f MB/s", tid,
+                  pid, row_cnt, byte_size, recover_time / 1000, rows_per_sec, mb_per_sec);
+            if (DiskTable* disk_table = dynamic_cast<DiskTable*>(table.get())) {
+                if (!disk_table->SaveOffset(latest_offset)) {
+                    DeleteTableInternal(tid, pid, std::shared_ptr<::openmldb::api::TaskInfo>());
+                    break;
+                }
+            }
             table->SetTableStat(::openmldb::storage::kNormal);
             replicator->SetOffset(latest_offset);
             replicator->SetSnapshotLogPartIndex(snapshot->GetOffset());
@@ -2897,6 +3897,10 @@ int TabletImpl::LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::
             PDLOG(INFO, "load table success. tid %u pid %u", tid, pid);
             if (task_ptr) {
                 std::lock_guard<std::mutex> lock(mu_);
+                task_ptr->set_recover_row_cnt(row_cnt);
+                task_ptr->set_recover_time_ms(recover_time / 1000);
+                task_ptr->set_recover_rows_per_sec(rows_per_sec);
+                task_ptr->set_recover_mb_per_sec(mb_per_sec);
                 task_ptr->set_status(::openmldb::api::TaskStatus::kDone);
                 return 0;
             }
@@ -2948,6 +3952,8 @@ int32_t TabletImpl::DeleteTableInternal(uint32_t tid, uint32_t pid,
             }
         }
         if (replicator) {
+            // answer the puts queued for group commit
+            replicator->StopGroupCommit();
             replicator->DelAllReplicateNode();
             PDLOG(INFO, "drop replicator for tid %u, pid %u", tid, pid);
         }
@@ -3445,13 +4451,6 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
         msg.assign("table exists");
         return -1;
     }
-    Table* table_ptr = new MemTable(*table_meta);
-    table.reset(table_ptr);
-    if (!table->Init()) {
-        PDLOG(WARNING, "fail to init table. tid %u, pid %u", table_meta->tid(), table_meta->pid());
-        msg.assign("fail to init table");
-        return -1;
-    }
     std::string db_root_path;
     bool ok = ChooseDBRootPath(tid, pid, db_root_path);
     if (!ok) {
@@ -3460,6 +4459,24 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
         return -1;
     }
     std::string table_db_path = db_root_path + "/" + std::to_string(tid) + "_" + std::to_string(pid);
+    Table* table_ptr = NULL;
+    if (table_meta->storage_mode() == ::openmldb::type::StorageMode::kMemory) {
+        MemTable* mem_table = new MemTable(*table_meta);
+        uint32_t numa_node_cnt = ::openmldb::base::NumaTopology::Get().GetNodeCnt();
+        if (FLAGS_enable_numa && numa_node_cnt > 1) {
+            // spread the partitions of tables over the nodes
+            mem_table->SetNumaNode((tid + pid) % numa_node_cnt);
+        }
+        table_ptr = mem_table;
+    } else {
+        table_ptr = new DiskTable(*table_meta, table_db_path + "/disk_data");
+    }
+    table.reset(table_ptr);
+    if (!table->Init()) {
+        PDLOG(WARNING, "fail to init table. tid %u, pid %u", table_meta->tid(), table_meta->pid());
+        msg.assign("fail to init table");
+        return -1;
+    }
     std::shared_ptr<LogReplicator> replicator;
     if (table->IsLeader()) {
         replicator =
@@ -3473,6 +4490,8 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
         msg.assign("fail create replicator for table");
         return -1;
     }
+    replicator->SetScheduler(rep_scheduler_);
+    replicator->SetCommitPool(commit_pool_);
     ok = replicator->Init();
     if (!ok) {
         PDLOG(WARNING, "fail to init replicator for table tid %u, pid %u", tid, pid);
@@ -3708,6 +4727,23 @@ void TabletImpl::GcTable(uint32_t tid, uint32_t pid, bool execute_once) {
     std::shared_ptr<Table> table = GetTable(tid, pid);
     if (table) {
         int32_t gc_interval = FLAGS_gc_interval;
+        MemTable* mem_table = dynamic_cast<MemTable*>(table.get());
+        // the gc threads are shared by the tables, so pin it for each task and restore it after
+        ::openmldb::base::ScopedNumaPin numa_pin(mem_table != NULL ? mem_table->GetNumaNode() : -1);
+        if (!execute_once && mem_table != NULL && FLAGS_gc_slice_key_num > 0) {
+            uint64_t start_time = ::baidu::common::timer::get_micros();
+            bool finished =
+                mem_table->SchedGcSlice(FLAGS_gc_slice_key_num, FLAGS_gc_slice_free_num, FLAGS_gc_slice_time_us);
+            uint64_t consumed = ::baidu::common::timer::get_micros() - start_time;
+            // wait between the slices to keep the gc of this table within the cpu budget
+            uint32_t budget = std::min(std::max(FLAGS_gc_cpu_budget, 1u), 100u);
+            uint64_t delay = std::max(consumed * (100 - budget) / budget / 1000, (uint64_t)1);
+            if (finished) {
+                delay = gc_interval * 60 * 1000;
+            }
+            gc_pool_.DelayTask(delay, boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
+            return;
+        }
         table->SchedGc();
         if (!execute_once) {
             gc_pool_.DelayTask(gc_interval * 60 * 1000, boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
@@ -3767,17 +4803,67 @@ std::shared_ptr<Table> TabletImpl::GetTableUnLock(uint32_t tid, uint32_t pid) {
 void TabletImpl::ShowMemPool(RpcController* controller, const ::openmldb::api::HttpRequest* request,
                              ::openmldb::api::HttpResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
-#ifdef TCMALLOC_ENABLE
     brpc::Controller* cntl = static_cast<brpc::Controller*>(controller);
+    cntl->response_attachment().append("<html><head><title>Mem Stat</title></head><body><pre>");
+#ifdef TCMALLOC_ENABLE
     MallocExtension* tcmalloc = MallocExtension::instance();
     std::string stat;
     stat.resize(1024);
     char* buffer = reinterpret_cast<char*>(&(stat[0]));
     tcmalloc->GetStats(buffer, 1024);
-    cntl->response_attachment().append("<html><head><title>Mem Stat</title></head><body><pre>");
     cntl->response_attachment().append(stat);
-    cntl->response_attachment().append("</pre></body></html>");
 #endif
+    if (FLAGS_enable_numa) {
+        cntl->response_attachment().append(GetNumaStat());
+    }
+    cntl->response_attachment().append("</pre></body></html>");
+}
+
+void TabletImpl::RecordNumaAccess(const std::shared_ptr<Table>& table) {
+    if (!FLAGS_enable_numa) {
+        return;
+    }
+    MemTable* mem_table = dynamic_cast<MemTable*>(table.get());
+    if (mem_table == NULL || mem_table->GetNumaNode() < 0) {
+        return;
+    }
+    if (::openmldb::base::GetCurrentNumaNode() == mem_table->GetNumaNode()) {
+        numa_local_access_ << 1;
+    } else {
+        numa_remote_access_ << 1;
+    }
+}
+
+std::string TabletImpl::GetNumaStat() {
+    uint32_t node_cnt = ::openmldb::base::NumaTopology::Get().GetNodeCnt();
+    std::vector<uint32_t> partition_cnt(node_cnt, 0);
+    std::vector<uint64_t> arena_byte_size(node_cnt, 0);
+    {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        for (const auto& kv : tables_) {
+            for (const auto& pkv : kv.second) {
+                MemTable* mem_table = dynamic_cast<MemTable*>(pkv.second.get());
+                if (mem_table == NULL || mem_table->GetNumaNode() < 0 ||
+                    static_cast<uint32_t>(mem_table->GetNumaNode()) >= node_cnt) {
+                    continue;
+                }
+                partition_cnt[mem_table->GetNumaNode()]++;
+                arena_byte_size[mem_table->GetNumaNode()] += mem_table->GetArenaByteSize();
+            }
+        }
+    }
+    uint64_t local = numa_local_access_.get_value();
+    uint64_t remote = numa_remote_access_.get_value();
+    char line[256];
+    snprintf(line, sizeof(line), "\nnuma nodes %u, local access %lu, remote access %lu, remote rate %.2f%%\n",
+             node_cnt, local, remote, local + remote == 0 ? 0.0 : remote * 100.0 / (local + remote));
+    std::string stat(line);
+    for (uint32_t node = 0; node < node_cnt; node++) {
+        snprintf(line, sizeof(line), "node %u: partitions %u, memory %lu bytes\n", node, partition_cnt[node],
+                 arena_byte_size[node]);
+        stat.append(line);
+    }
+    return stat;
 }
 
 void TabletImpl::CheckZkClient() {
@@ -4084,6 +5170,38 @@ void TabletImpl::SetMode(RpcController* controller, const ::openmldb::api::SetMo
     response->set_code(::openmldb::base::ReturnCode::kOk);
 }
 
+void TabletImpl::SetSchedulerConfig(RpcController* controller,
+                                    const ::openmldb::api::SetSchedulerConfigRequest* request,
+                                    ::openmldb::api::GeneralResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    for (const auto& class_limit : request->class_limit()) {
+        if (!class_limit.has_request_class() || !class_limit.has_limit()) {
+            response->set_code(::openmldb::base::ReturnCode::kCheckParameterFailed);
+            response->set_msg("request class and limit are required");
+            return;
+        }
+    }
+    for (const auto& class_limit : request->class_limit()) {
+        // the classes of api are in the same order
+        request_scheduler_.SetLimit(static_cast<RequestClass>(class_limit.request_class()), class_limit.limit());
+    }
+    if (request->has_max_concurrency()) {
+        request_scheduler_.SetMaxConcurrency(request->max_concurrency());
+    }
+    if (request->has_queue_target_ms()) {
+        request_scheduler_.SetQueueTarget(request->queue_target_ms());
+    }
+    if (request->has_max_wait_ms()) {
+        request_scheduler_.SetMaxWait(request->max_wait_ms());
+    }
+    if (request->has_enable()) {
+        request_scheduler_.SetEnable(request->enable());
+    }
+    PDLOG(INFO, "set scheduler config: %s", request->ShortDebugString().c_str());
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    response->set_msg("ok");
+}
+
 void TabletImpl::DeleteIndex(RpcController* controller, const ::openmldb::api::DeleteIndexRequest* request,
                              ::openmldb::api::GeneralResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -4104,6 +5222,12 @@ void TabletImpl::DeleteIndex(RpcController* controller, const ::openmldb::api::D
         return;
     }
     MemTable* mem_table = dynamic_cast<MemTable*>(table.get());
+    if (mem_table == NULL) {
+        PDLOG(WARNING, "table is not memtable. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableTypeMismatch);
+        response->set_msg("table is not memtable");
+        return;
+    }
     if (!mem_table->DeleteIndex(request->idx_name())) {
         response->set_code(::openmldb::base::ReturnCode::kDeleteIndexFailed);
         response->set_msg("delete index failed");
@@ -4755,7 +5879,7 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
     }
 
     sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info_impl, session.GetCompileInfo(),
-                                            batch_session.GetCompileInfo());
+                                            batch_session.GetCompileInfo(), NewResultCache(db_name, sp_name));
 
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
@@ -4768,6 +5892,7 @@ void TabletImpl::DropProcedure(RpcController* controller, const ::openmldb::api:
     const std::string& db_name = request->db_name();
     const std::string& sp_name = request->sp_name();
     sp_cache_->DropSQLProcedureCacheEntry(db_name, sp_name);
+    procedure_trace_stat_.Remove(db_name, sp_name);
     if (!catalog_->DropProcedure(db_name, sp_name)) {
         LOG(WARNING) << "drop procedure" << db_name << "." << sp_name << " in catalog failed";
     }
@@ -4778,10 +5903,14 @@ void TabletImpl::DropProcedure(RpcController* controller, const ::openmldb::api:
 
 void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::QueryRequest& request,
                                  ::hybridse::vm::RequestRunSession& session, openmldb::api::QueryResponse& response,
-                                 butil::IOBuf& buf) {
+                                 butil::IOBuf& buf, QueryTrace* trace) {
     if (request.is_debug()) {
         session.EnableDebug();
     }
+    if (trace != nullptr) {
+        trace->EndStage(QueryTrace::kCompile);
+        session.SetTrace(trace->GetRunnerTrace());
+    }
     ::hybridse::codec::Row row;
     auto& request_buf = dynamic_cast<brpc::Controller*>(ctrl)->request_attachment();
     size_t input_slices = request.row_slices();
@@ -4790,6 +5919,9 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
         response.set_msg("fail to decode input row");
         return;
     }
+    if (trace != nullptr) {
+        trace->EndStage(QueryTrace::kDecode);
+    }
     ::hybridse::codec::Row output;
     int32_t ret = 0;
     if (request.has_task_id()) {
@@ -4797,6 +5929,9 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     } else {
         ret = session.Run(row, &output);
     }
+    if (trace != nullptr) {
+        trace->EndStage(QueryTrace::kRun);
+    }
     if (ret != 0) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("fail to run sql");
@@ -4812,6 +5947,9 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
         response.set_msg("fail to encode sql output row");
         return;
     }
+    if (trace != nullptr) {
+        trace->EndStage(QueryTrace::kEncode);
+    }
     if (!request.has_task_id()) {
         response.set_schema(session.GetEncodedSchema());
     }
@@ -4821,6 +5959,22 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     response.set_code(::openmldb::base::kOk);
 }
 
+template <class Response>
+void TabletImpl::FinishQueryTrace(const QueryTrace& trace, bool is_procedure, const std::string& db,
+                                  const std::string& sp_name, const std::string& mode, bool is_trace,
+                                  Response* response) {
+    if (is_procedure && FLAGS_enable_procedure_trace) {
+        procedure_trace_stat_.Add(db, sp_name, mode, trace);
+    }
+    if (is_trace) {
+        response->set_trace(trace.ToString());
+    }
+    if (trace.GetTotalTime() > FLAGS_query_slow_log_threshold) {
+        PDLOG(INFO, "slow log[%s]. db %s sp_name %s trace: %s", mode.c_str(), db.c_str(), sp_name.c_str(),
+              trace.ToString().c_str());
+    }
+}
+
 void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info) {
     const std::string& db_name = sp_info->GetDbName();
     const std::string& sp_name = sp_info->GetSpName();
@@ -4847,10 +6001,20 @@ void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureI
         return;
     }
     sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info, session.GetCompileInfo(),
-                                            batch_session.GetCompileInfo());
+                                            batch_session.GetCompileInfo(), NewResultCache(db_name, sp_name));
     LOG(INFO) << "refresh procedure success! sp_name: " << sp_name << ", db: " << db_name << ", sql: " << sql;
 }
 
+std::shared_ptr<ProcedureResultCache> TabletImpl::NewResultCache(const std::string& db, const std::string& sp_name) {
+    if (!key_versions_ || (result_cache_procedures_.count("*") == 0 &&
+                           result_cache_procedures_.count(db + "." + sp_name) == 0)) {
+        return std::shared_ptr<ProcedureResultCache>();
+    }
+    LOG(INFO) << "enable result cache for procedure " << db << "." << sp_name;
+    return std::make_shared<ProcedureResultCache>(db, sp_name, FLAGS_procedure_result_cache_capacity,
+                                                  FLAGS_procedure_result_cache_ttl_ms, key_versions_);
+}
+
 void TabletImpl::GetBulkLoadInfo(RpcController* controller, const ::openmldb::api::BulkLoadInfoRequest* request,
                                  ::openmldb::api::BulkLoadInfoResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -4884,6 +6048,12 @@ void TabletImpl::GetBulkLoadInfo(RpcController* controller, const ::openmldb::ap
     //  TableIndex is inside Table, so let table fulfill the response for us.
     DLOG(INFO) << "GetBulkLoadInfo for " << table->GetId() << "-" << table->GetPid();
     auto* mem_table = dynamic_cast<MemTable*>(table.get());
+    if (mem_table == NULL) {
+        PDLOG(WARNING, "table is not memtable. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kTableTypeMismatch);
+        response->set_msg("table is not memtable");
+        return;
+    }
     mem_table->GetBulkLoadInfo(response);
 
     response->set_code(::openmldb::base::kOk);
@@ -4923,6 +6093,12 @@ void TabletImpl::BulkLoad(RpcController* controller, const ::openmldb::api::Bulk
         response->set_msg("table is loading");
         return;
     }
+    if (dynamic_cast<MemTable*>(table.get()) == NULL) {
+        PDLOG(WARNING, "table %u-%u is not memtable.", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kTableTypeMismatch);
+        response->set_msg("table is not memtable");
+        return;
+    }
 
     // first DataRegion, then IndexRegion, when we get IndexRegion rpc, empty DataRegion is available
     auto* cntl = dynamic_cast<brpc::Controller*>(controller);
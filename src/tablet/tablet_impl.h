@@ -18,6 +18,8 @@
 #define SRC_TABLET_TABLET_IMPL_H_
 
 #include <brpc/server.h>
+#include <brpc/stream.h>
+#include <bvar/bvar.h>
 
 #include <list>
 #include <map>
@@ -29,17 +31,22 @@
 #include <vector>
 
 #include "base/set.h"
+#include "base/taskpool.hpp"
 #include "base/spinlock.h"
 #include "catalog/schema_adapter.h"
 #include "catalog/tablet_catalog.h"
 #include "common/thread_pool.h"
 #include "proto/tablet.pb.h"
 #include "replica/log_replicator.h"
+#include "replica/replication_scheduler.h"
+#include "storage/disk_table.h"
 #include "storage/mem_table.h"
 #include "storage/mem_table_snapshot.h"
 #include "tablet/bulk_load_mgr.h"
 #include "tablet/combine_iterator.h"
 #include "tablet/file_receiver.h"
+#include "tablet/query_trace.h"
+#include "tablet/request_scheduler.h"
 #include "tablet/sp_cache.h"
 #include "vm/engine.h"
 #include "zk/zk_client.h"
@@ -50,6 +57,7 @@ using ::google::protobuf::RpcController;
 using ::openmldb::base::SpinMutex;
 using ::openmldb::replica::LogReplicator;
 using ::openmldb::replica::ReplicatorRole;
+using ::openmldb::storage::DiskTable;
 using ::openmldb::storage::IndexDef;
 using ::openmldb::storage::MemTable;
 using ::openmldb::storage::Snapshot;
@@ -81,6 +89,10 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void Put(RpcController* controller, const ::openmldb::api::PutRequest* request,
              ::openmldb::api::PutResponse* response, Closure* done);
 
+    // put the rows of one partition with a single binlog append
+    void PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                  ::openmldb::api::PutBatchResponse* response, Closure* done);
+
     void Get(RpcController* controller, const ::openmldb::api::GetRequest* request,
              ::openmldb::api::GetResponse* response, Closure* done);
 
@@ -96,6 +108,13 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void Traverse(RpcController* controller, const ::openmldb::api::TraverseRequest* request,
                   ::openmldb::api::TraverseResponse* response, Closure* done);
 
+    // accept the stream created by the client and push the records to it by stream_scan_pool_
+    void ScanStream(RpcController* controller, const ::openmldb::api::ScanRequest* request,
+                    ::openmldb::api::ScanResponse* response, Closure* done);
+
+    void TraverseStream(RpcController* controller, const ::openmldb::api::TraverseRequest* request,
+                        ::openmldb::api::TraverseResponse* response, Closure* done);
+
     void CreateTable(RpcController* controller, const ::openmldb::api::CreateTableRequest* request,
                      ::openmldb::api::CreateTableResponse* response, Closure* done);
 
@@ -117,6 +136,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                        ::openmldb::api::AppendEntriesResponse* response, Closure* done);
 
+    void BatchAppendEntries(RpcController* controller, const ::openmldb::api::BatchAppendEntriesRequest* request,
+                            ::openmldb::api::BatchAppendEntriesResponse* response, Closure* done);
+
     void UpdateTableMetaForAddField(RpcController* controller,
                                     const ::openmldb::api::UpdateTableMetaForAddFieldRequest* request,
                                     ::openmldb::api::GeneralResponse* response, Closure* done);
@@ -193,6 +215,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void SetMode(RpcController* controller, const ::openmldb::api::SetModeRequest* request,
                  ::openmldb::api::GeneralResponse* response, Closure* done);
 
+    void SetSchedulerConfig(RpcController* controller, const ::openmldb::api::SetSchedulerConfigRequest* request,
+                            ::openmldb::api::GeneralResponse* response, Closure* done);
+
     void DeleteIndex(RpcController* controller, const ::openmldb::api::DeleteIndexRequest* request,
                      ::openmldb::api::GeneralResponse* response, Closure* done);
 
@@ -243,6 +268,22 @@ class TabletImpl : public ::openmldb::api::TabletServer {
                       const std::map<int32_t, std::shared_ptr<Schema>>& vers_schema, CombineIterator* combine_it,
                       butil::IOBuf* buf, uint32_t* count);
 
+    // write the records to the stream in chunks of stream_scan_chunk_size, the slot of guard is
+    // released while waiting for the client. fail if the client has not consumed them before deadline_us
+    int32_t StreamScanIndex(const ::openmldb::api::ScanRequest* request, const ::openmldb::api::TableMeta& meta,
+                            const std::map<int32_t, std::shared_ptr<Schema>>& vers_schema, CombineIterator* combine_it,
+                            brpc::StreamId stream, int64_t deadline_us, ScheduleGuard* guard, uint32_t* count);
+
+    // set the response and return false if any partition of the request is not ready
+    bool GetScanIterators(const ::openmldb::api::ScanRequest* request, ::openmldb::api::ScanResponse* response,
+                          std::vector<QueryIt>* query_its, ::openmldb::storage::TTLSt* expired_value);
+
+    void ScanStreamInternal(brpc::StreamId stream, std::shared_ptr<::openmldb::api::ScanRequest> request,
+                            std::shared_ptr<Table> table, std::shared_ptr<CombineIterator> combine_it);
+
+    void TraverseStreamInternal(brpc::StreamId stream, std::shared_ptr<::openmldb::api::TraverseRequest> request,
+                                std::shared_ptr<Table> table, uint32_t index);
+
     int32_t CountIndex(uint64_t expire_time, uint64_t expire_cnt, ::openmldb::storage::TTLType ttl_type,
                        ::openmldb::storage::TableIterator* it, const ::openmldb::api::CountRequest* request,
                        uint32_t* count);
@@ -276,11 +317,20 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     void GcTable(uint32_t tid, uint32_t pid, bool execute_once);
 
+    // count the access to the table from the current thread if the table is bound to a numa node
+    void RecordNumaAccess(const std::shared_ptr<Table>& table);
+
+    std::string GetNumaStat();
+
     void GcTableSnapshot(uint32_t tid, uint32_t pid);
 
     int CheckTableMeta(const openmldb::api::TableMeta* table_meta,
                        std::string& msg);  // NOLINT
 
+    // the raw records of request are cut from the front of attachment
+    void AppendEntriesInternal(const ::openmldb::api::AppendEntriesRequest* request, butil::IOBuf* attachment,
+                               ::openmldb::api::AppendEntriesResponse* response);
+
     int CreateTableInternal(const ::openmldb::api::TableMeta* table_meta,
                             std::string& msg);  // NOLINT
 
@@ -345,6 +395,16 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     int CheckDimessionPut(const ::openmldb::api::PutRequest* request, uint32_t idx_cnt);
 
+    bool PutToTable(const std::shared_ptr<Table>& table, const ::openmldb::api::PutRequest& row);
+
+    bool IsDiskTable(const std::shared_ptr<Table>& table);
+
+    // put the row to disk table and append it to binlog with one log index, entry is built from row
+    bool PutToDiskTable(const std::shared_ptr<Table>& table, const std::shared_ptr<LogReplicator>& replicator,
+                        const ::openmldb::api::PutRequest& row, ::openmldb::api::LogEntry* entry);
+
+    void BuildLogEntry(const ::openmldb::api::PutRequest& row, uint64_t term, ::openmldb::api::LogEntry* entry);
+
     // sync log data from page cache to disk
     void SchedSyncDisk(uint32_t tid, uint32_t pid);
 
@@ -386,12 +446,26 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     }
 
  private:
+    // trace is null if disabled
     void RunRequestQuery(RpcController* controller, const openmldb::api::QueryRequest& request,
                          ::hybridse::vm::RequestRunSession& session,                  // NOLINT
-                         openmldb::api::QueryResponse& response, butil::IOBuf& buf);  // NOLINT
+                         openmldb::api::QueryResponse& response, butil::IOBuf& buf,  // NOLINT
+                         QueryTrace* trace);
+
+    // aggregate the trace of procedure, attach it to the response if requested and log it if slow
+    template <class Response>
+    void FinishQueryTrace(const QueryTrace& trace, bool is_procedure, const std::string& db,
+                          const std::string& sp_name, const std::string& mode, bool is_trace, Response* response);
 
     void CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info);
 
+    // null if the result cache is not enabled for the procedure
+    std::shared_ptr<ProcedureResultCache> NewResultCache(const std::string& db, const std::string& sp_name);
+
+    // invalidate the cached results which read the keys of the row
+    void UpdateKeyVersions(const std::shared_ptr<Table>& table, const std::string& pk,
+                           const ::google::protobuf::RepeatedPtrField<::openmldb::api::Dimension>& dimensions);
+
     Tables tables_;
     std::mutex mu_;
     SpinMutex spin_mutex_;
@@ -403,6 +477,7 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     ThreadPool task_pool_;
     ThreadPool io_pool_;
     ThreadPool snapshot_pool_;
+    ThreadPool stream_scan_pool_;
     std::map<uint64_t, std::list<std::shared_ptr<::openmldb::api::TaskInfo>>> task_map_;
     std::set<std::string> sync_snapshot_set_;
     std::map<std::string, std::shared_ptr<FileReceiver>> file_receiver_map_;
@@ -421,6 +496,20 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     std::string zk_path_;
     std::string endpoint_;
     std::shared_ptr<SpCache> sp_cache_;
+    ProcedureTraceStat procedure_trace_stat_;
+    // null if the result cache is not enabled for any procedure
+    std::shared_ptr<KeyVersionTable> key_versions_;
+    std::set<std::string> result_cache_procedures_;
+    RequestScheduler request_scheduler_;
+    // the accesses to the memory tables from the cpus of their own numa nodes or the others
+    bvar::Adder<uint64_t> numa_local_access_;
+    bvar::Adder<uint64_t> numa_remote_access_;
+    // null if the replicate nodes run their own sync threads
+    std::shared_ptr<::openmldb::replica::ReplicationScheduler> rep_scheduler_;
+    // null if group commit is off
+    std::shared_ptr<ThreadPool> commit_pool_;
+    // null if the replicated entries are put by the rpc thread
+    std::unique_ptr<::openmldb::base::TaskPool> apply_pool_;
     std::string notify_path_;
     std::string sp_root_path_;
     ::openmldb::type::StartupMode startup_mode_;
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <brpc/server.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include "base/glog_wapper.h"
+#include "client/tablet_client.h"
+#include "common/timer.h"
+#include "proto/tablet.pb.h"
+#include "tablet/tablet_impl.h"
+
+DECLARE_string(db_root_path);
+DECLARE_uint32(stream_scan_chunk_size);
+DECLARE_uint32(stream_scan_client_queue_size);
+DECLARE_uint32(max_traverse_cnt);
+
+namespace openmldb {
+namespace tablet {
+
+class TabletImplStreamTest : public ::testing::Test {
+ public:
+    TabletImplStreamTest() {}
+    ~TabletImplStreamTest() {}
+};
+
+TEST_F(TabletImplStreamTest, TraverseAndScan) {
+    // small chunks and window to make the tablet wait for the client
+    FLAGS_stream_scan_chunk_size = 1024;
+    FLAGS_stream_scan_client_queue_size = 2;
+    FLAGS_max_traverse_cnt = 100;
+    TabletImpl* tablet = new TabletImpl();
+    ASSERT_TRUE(tablet->Init(""));
+    brpc::Server server;
+    ASSERT_EQ(0, server.AddService(tablet, brpc::SERVER_OWNS_SERVICE));
+    brpc::ServerOptions options;
+    std::string endpoint = "127.0.0.1:18541";
+    ASSERT_EQ(0, server.Start(endpoint.c_str(), &options));
+
+    uint32_t tid = 3;
+    uint32_t pid = 1;
+    ::openmldb::client::TabletClient client(endpoint, "");
+    ASSERT_EQ(0, client.Init());
+    std::vector<std::string> endpoints;
+    ASSERT_TRUE(client.CreateTable("table1", tid, pid, 0, 0, true, endpoints,
+                                   ::openmldb::type::TTLType::kAbsoluteTime, 8, 0,
+                                   ::openmldb::type::CompressType::kNoCompress));
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    for (int i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(i);
+        for (int j = 0; j < 10; j++) {
+            ASSERT_TRUE(client.Put(tid, pid, key, cur_time + j, std::string(100, static_cast<char>('a' + j))));
+        }
+    }
+
+    std::string msg;
+    // the stream is not bounded by max_traverse_cnt
+    auto it = client.TraverseStream(tid, pid, "", 0, &msg);
+    ASSERT_TRUE(it);
+    uint32_t count = 0;
+    for (; it->Valid(); it->Next()) {
+        ASSERT_FALSE(it->GetPK().empty());
+        ASSERT_EQ(100u, it->GetValue().size());
+        count++;
+    }
+    ASSERT_EQ(1000u, count);
+    ASSERT_EQ(0, it->GetCode());
+
+    it = client.TraverseStream(tid, pid, "", 15, &msg);
+    ASSERT_TRUE(it);
+    count = 0;
+    for (; it->Valid(); it->Next()) {
+        count++;
+    }
+    ASSERT_EQ(15u, count);
+    ASSERT_EQ(0, it->GetCode());
+
+    ::openmldb::api::ScanRequest request;
+    request.set_tid(tid);
+    request.set_pid(pid);
+    request.set_pk("key1");
+    request.set_st(cur_time + 100);
+    request.set_et(0);
+    it = client.ScanStream(request, &msg);
+    ASSERT_TRUE(it);
+    count = 0;
+    for (; it->Valid(); it->Next()) {
+        ASSERT_EQ(cur_time + 9 - count, it->GetKey());
+        ASSERT_EQ(std::string(100, static_cast<char>('a' + 9 - count)), it->GetValue().ToString());
+        count++;
+    }
+    ASSERT_EQ(10u, count);
+    ASSERT_EQ(0, it->GetCode());
+
+    // the iterator can be dropped before the end
+    it = client.TraverseStream(tid, pid, "", 0, &msg);
+    ASSERT_TRUE(it);
+    ASSERT_TRUE(it->Valid());
+    it.reset();
+
+    it = client.TraverseStream(tid, pid + 1, "", 0, &msg);
+    ASSERT_FALSE(it);
+    ASSERT_EQ("table is not exist", msg);
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    srand(time(NULL));
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    FLAGS_db_root_path = "/tmp/" + std::to_string(rand() % 10000000 + 1);  // NOLINT
+    return RUN_ALL_TESTS();
+}
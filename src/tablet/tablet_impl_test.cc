@@ -53,6 +53,7 @@ DECLARE_string(db_root_path);
 DECLARE_string(recycle_bin_root_path);
 DECLARE_string(endpoint);
 DECLARE_uint32(recycle_ttl);
+DECLARE_uint32(follower_apply_thread_num);
 
 namespace openmldb {
 namespace tablet {
@@ -1715,6 +1716,129 @@ TEST_F(TabletImplTest, Scan) {
     ASSERT_EQ(1, (signed)srp.count());
 }
 
+TEST_F(TabletImplTest, PutBatch) {
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ::openmldb::api::CreateTableRequest request;
+    ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+    table_meta->set_name("t0");
+    table_meta->set_tid(id);
+    table_meta->set_pid(1);
+    AddDefaultSchema(0, 0, ::openmldb::type::TTLType::kAbsoluteTime, table_meta);
+    ::openmldb::api::CreateTableResponse response;
+    MockClosure closure;
+    tablet.CreateTable(NULL, &request, &response, &closure);
+    ASSERT_EQ(0, response.code());
+    ::openmldb::api::PutBatchRequest prequest;
+    prequest.set_tid(id);
+    prequest.set_pid(1);
+    for (int i = 0; i < 100; i++) {
+        ::openmldb::api::PutRequest* row = prequest.add_rows();
+        row->set_pk("test" + std::to_string(i % 10));
+        row->set_time(9527 + i);
+        row->set_value("value" + std::to_string(i));
+    }
+    {
+        // the batch with an invalid row is rejected
+        ::openmldb::api::PutBatchRequest bad_request(prequest);
+        bad_request.mutable_rows(50)->set_time(0);
+        ::openmldb::api::PutBatchResponse presponse;
+        tablet.PutBatch(NULL, &bad_request, &presponse, &closure);
+        ASSERT_EQ(::openmldb::base::ReturnCode::kTsMustBeGreaterThanZero, presponse.code());
+        ASSERT_EQ(0u, presponse.put_cnt());
+    }
+    {
+        ::openmldb::api::PutBatchResponse presponse;
+        prequest.set_tid(id + 10000);
+        tablet.PutBatch(NULL, &prequest, &presponse, &closure);
+        ASSERT_EQ(::openmldb::base::ReturnCode::kTableIsNotExist, presponse.code());
+        prequest.set_tid(id);
+        tablet.PutBatch(NULL, &prequest, &presponse, &closure);
+        ASSERT_EQ(0, presponse.code());
+        ASSERT_EQ(100u, presponse.put_cnt());
+        ASSERT_EQ(0, presponse.failed_idx_size());
+    }
+    for (int i = 0; i < 10; i++) {
+        ::openmldb::api::ScanRequest sr;
+        sr.set_tid(id);
+        sr.set_pid(1);
+        sr.set_pk("test" + std::to_string(i));
+        sr.set_st(10000);
+        sr.set_et(0);
+        ::openmldb::api::ScanResponse srp;
+        tablet.Scan(NULL, &sr, &srp, &closure);
+        ASSERT_EQ(0, srp.code());
+        ASSERT_EQ(10, (signed)srp.count());
+    }
+    // the rows are appended to binlog
+    ::openmldb::api::GetTableStatusRequest status_request;
+    status_request.set_tid(id);
+    status_request.set_pid(1);
+    ::openmldb::api::GetTableStatusResponse status_response;
+    tablet.GetTableStatus(NULL, &status_request, &status_response, &closure);
+    ASSERT_EQ(0, status_response.code());
+    ASSERT_EQ(1, status_response.all_table_status_size());
+    ASSERT_EQ(100u, status_response.all_table_status(0).offset());
+}
+
+TEST_F(TabletImplTest, PutBatchFailedRows) {
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ::openmldb::api::CreateTableRequest request;
+    ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+    table_meta->set_name("t0");
+    table_meta->set_tid(id);
+    table_meta->set_pid(1);
+    ::openmldb::common::ColumnDesc* desc = table_meta->add_column_desc();
+    desc->set_name("card");
+    desc->set_data_type(::openmldb::type::kString);
+    desc = table_meta->add_column_desc();
+    desc->set_name("ts1");
+    desc->set_data_type(::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta->add_column_key(), "index1", "card", "ts1", ::openmldb::type::kAbsoluteTime, 0, 0);
+    ::openmldb::api::CreateTableResponse response;
+    MockClosure closure;
+    tablet.CreateTable(NULL, &request, &response, &closure);
+    ASSERT_EQ(0, response.code());
+    ::openmldb::api::PutBatchRequest prequest;
+    prequest.set_tid(id);
+    prequest.set_pid(1);
+    for (int i = 0; i < 20; i++) {
+        ::openmldb::api::PutRequest* row = prequest.add_rows();
+        ::openmldb::api::Dimension* d = row->add_dimensions();
+        d->set_key("card" + std::to_string(i % 5));
+        d->set_idx(0);
+        row->set_value("value" + std::to_string(i));
+        // the rows without the ts of index fail to put
+        if (i % 3 == 0) {
+            row->set_time(9527 + i);
+        } else {
+            ::openmldb::api::TSDimension* tsd = row->add_ts_dimensions();
+            tsd->set_ts(9527 + i);
+            tsd->set_idx(0);
+        }
+    }
+    ::openmldb::api::PutBatchResponse presponse;
+    tablet.PutBatch(NULL, &prequest, &presponse, &closure);
+    ASSERT_EQ(::openmldb::base::ReturnCode::kPutFailed, presponse.code());
+    ASSERT_EQ(13u, presponse.put_cnt());
+    // the indexes are in request order though the rows are put by segment
+    ASSERT_EQ(7, presponse.failed_idx_size());
+    for (int i = 0; i < presponse.failed_idx_size(); i++) {
+        ASSERT_EQ((uint32_t)i * 3, presponse.failed_idx(i));
+    }
+    // only the rows put are appended to binlog
+    ::openmldb::api::GetTableStatusRequest status_request;
+    status_request.set_tid(id);
+    status_request.set_pid(1);
+    ::openmldb::api::GetTableStatusResponse status_response;
+    tablet.GetTableStatus(NULL, &status_request, &status_response, &closure);
+    ASSERT_EQ(0, status_response.code());
+    ASSERT_EQ(13u, status_response.all_table_status(0).offset());
+}
+
 TEST_F(TabletImplTest, GC_WITH_UPDATE_LATEST) {
     int32_t old_gc_interval = FLAGS_gc_interval;
     // 1 minute
@@ -2498,6 +2622,77 @@ TEST_F(TabletImplTest, DropTableFollower) {
     ASSERT_EQ(0, response.code());
 }
 
+TEST_F(TabletImplTest, AppendEntries) {
+    const int record_num = 50000;
+    const int batch_size = 1000;
+    std::string value(128, 'a');
+    uint32_t apply_thread_num = FLAGS_follower_apply_thread_num;
+    for (uint32_t thread_num : {0, 4}) {
+        FLAGS_follower_apply_thread_num = thread_num;
+        std::string mode = thread_num > 1 ? "parallel" : "serial";
+        uint32_t id = counter++;
+        TabletImpl tablet;
+        tablet.Init("");
+        MockClosure closure;
+        ::openmldb::api::CreateTableRequest request;
+        ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+        table_meta->set_name("t0");
+        table_meta->set_tid(id);
+        table_meta->set_pid(1);
+        AddDefaultSchema(0, 0, ::openmldb::type::TTLType::kAbsoluteTime, table_meta);
+        table_meta->set_mode(::openmldb::api::TableMode::kTableFollower);
+        ::openmldb::api::CreateTableResponse response;
+        tablet.CreateTable(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+        uint64_t consumed = 0;
+        for (int i = 0; i < record_num; i += batch_size) {
+            ::openmldb::api::AppendEntriesRequest arequest;
+            arequest.set_tid(id);
+            arequest.set_pid(1);
+            arequest.set_pre_log_index(i);
+            for (int j = i; j < i + batch_size; j++) {
+                ::openmldb::api::LogEntry* entry = arequest.add_entries();
+                entry->set_log_index(j + 1);
+                ::openmldb::api::Dimension* dim = entry->add_dimensions();
+                dim->set_key("key" + std::to_string(j % 1000));
+                dim->set_idx(0);
+                entry->set_value(value);
+                entry->set_ts(9527 + j);
+            }
+            // delete a key in the middle of the batch
+            if (i == batch_size) {
+                ::openmldb::api::LogEntry* entry = arequest.mutable_entries(batch_size / 2);
+                entry->clear_value();
+                entry->set_method_type(::openmldb::api::MethodType::kDelete);
+                entry->mutable_dimensions(0)->set_key("key0");
+            }
+            ::openmldb::api::AppendEntriesResponse aresponse;
+            brpc::Controller cntl;
+            uint64_t start = ::baidu::common::timer::get_micros();
+            tablet.AppendEntries(&cntl, &arequest, &aresponse, &closure);
+            consumed += ::baidu::common::timer::get_micros() - start;
+            ASSERT_EQ(0, aresponse.code());
+            ASSERT_EQ((uint64_t)i + batch_size, aresponse.log_offset());
+            ASSERT_EQ((uint64_t)i + batch_size, aresponse.apply_offset());
+        }
+        // key0 is deleted after its second row, the delete entry is not put
+        ::openmldb::api::CountRequest crequest;
+        crequest.set_tid(id);
+        crequest.set_pid(1);
+        crequest.set_key("key0");
+        ::openmldb::api::CountResponse cresponse;
+        tablet.Count(NULL, &crequest, &cresponse, &closure);
+        ASSERT_EQ(0, cresponse.code());
+        ASSERT_EQ((uint64_t)(record_num / 1000 - 2), cresponse.count());
+        crequest.set_key("key1");
+        tablet.Count(NULL, &crequest, &cresponse, &closure);
+        ASSERT_EQ(0, cresponse.code());
+        ASSERT_EQ((uint64_t)(record_num / 1000), cresponse.count());
+        RecordProperty(mode + "_entries_per_sec", static_cast<int>(record_num * 1000000ul / (consumed + 1)));
+    }
+    FLAGS_follower_apply_thread_num = apply_thread_num;
+}
+
 TEST_F(TabletImplTest, TestGetType) {
     TabletImpl tablet;
     uint32_t id = counter++;